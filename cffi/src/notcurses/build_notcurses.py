@@ -53,6 +53,9 @@ void notcurses_version_components(int* major, int* minor, int* patch, int* tweak
 int notcurses_lex_margins(const char* op, notcurses_options* opts);
 int notcurses_stop(struct notcurses*);
 int notcurses_render(struct notcurses* nc);
+int notcurses_render_request(struct notcurses* nc);
+int notcurses_render_drain(struct notcurses* nc);
+int notcurses_set_target_fps(struct notcurses* nc, unsigned fps);
 int ncpile_render(struct ncplane* n);
 int ncpile_rasterize(struct ncplane* n);
 int notcurses_render_to_buffer(struct notcurses* nc, char** buf, size_t* buflen);
@@ -100,6 +103,8 @@ int ncplane_destroy(struct ncplane* ncp);
 int ncplane_mergedown(struct ncplane* src, struct ncplane* dst, int begsrcy, int begsrcx, int leny, int lenx, int dsty, int dstx);
 int ncplane_mergedown_simple(struct ncplane* restrict src, struct ncplane* restrict dst);
 void ncplane_erase(struct ncplane* n);
+int ncplane_compact(struct ncplane* n);
+size_t notcurses_set_cache_limit(struct notcurses* nc, size_t bytes);
 int ncplane_cursor_move_yx(struct ncplane* n, int y, int x);
 void ncplane_cursor_yx(struct ncplane* n, int* y, int* x);
 int ncplane_move_yx(struct ncplane* n, int y, int x);
@@ -213,9 +218,11 @@ void ncvisual_destroy(struct ncvisual* ncv);
 int ncvisual_decode(struct ncvisual* nc);
 int ncvisual_decode_loop(struct ncvisual* nc);
 int ncvisual_rotate(struct ncvisual* n, double rads);
+int ncvisual_rotate_bilinear(struct ncvisual* n, double rads);
 int ncvisual_resize(struct ncvisual* n, int rows, int cols);
 int ncvisual_polyfill_yx(struct ncvisual* n, int y, int x, uint32_t rgba);
 struct ncplane* ncvisual_render(struct notcurses* nc, struct ncvisual* ncv, const struct ncvisual_options* vopts);
+unsigned notcurses_set_blit_threshold(struct notcurses* nc, unsigned cells);
 char* ncvisual_subtitle(const struct ncvisual* ncv);
 int ncvisual_at_yx(const struct ncvisual* n, int y, int x, uint32_t* pixel);
 int ncvisual_set_yx(const struct ncvisual* n, int y, int x, uint32_t pixel);
@@ -376,6 +383,8 @@ int ncdplot_sample(const struct ncdplot* n, uint64_t x, double* y);
 void ncuplot_destroy(struct ncuplot* n);
 void ncdplot_destroy(struct ncdplot* n);
 bool ncplane_set_scrolling(struct ncplane* n, bool scrollp);
+int ncplane_set_cached_layer(struct ncplane* n, bool cached);
+int ncplane_cached_layer_stats(const struct ncplane* n, uint64_t* hits, uint64_t* misses);
 typedef struct ncfdplane_options {
   void* curry; // parameter provided to callbacks
   bool follow; // keep reading after hitting end? (think tail -f)
@@ -16,6 +16,9 @@ NCOPTION_NO_QUIT_SIGHANDLERS = 0x0008
 NCOPTION_SUPPRESS_BANNERS = 0x0020
 NCOPTION_NO_ALTERNATE_SCREEN = 0x0040
 NCOPTION_NO_FONT_CHANGES = 0x0080
+NCOPTION_PARALLEL_RENDER = 0x0100
+NCOPTION_ASYNC_OUTPUT = 0x0200
+NCOPTION_COALESCE_OUTPUT = 0x0400
 CELL_WIDEASIAN_MASK = 0x8000000000000000
 CELL_NOBACKGROUND_MASK = 0x0400000000000000
 CELL_BGDEFAULT_MASK = 0x0000000040000000
@@ -200,6 +200,26 @@ namespace ncpp
 			return error_guard (notcurses_render (nc), -1);
 		}
 
+		bool render_request () const NOEXCEPT_MAYBE
+		{
+			return error_guard (notcurses_render_request (nc), -1);
+		}
+
+		bool render_drain () const NOEXCEPT_MAYBE
+		{
+			return error_guard (notcurses_render_drain (nc), -1);
+		}
+
+		size_t set_cache_limit (size_t bytes) const noexcept
+		{
+			return notcurses_set_cache_limit (nc, bytes);
+		}
+
+		unsigned set_blit_threshold (unsigned cells) const noexcept
+		{
+			return notcurses_set_blit_threshold (nc, cells);
+		}
+
 		bool render_to_buffer (char** buf, size_t* buflen) const NOEXCEPT_MAYBE
 		{
 			return error_guard (notcurses_render_to_buffer (nc, buf, buflen), -1);
@@ -72,6 +72,16 @@ namespace ncpp
 
 			return map_plane (ret);
 		}
+
+		Plane* plane_at (int y, int x) const noexcept
+		{
+			ncplane* ret = ncpile_plane_at_yx (to_ncplane (), y, x);
+			if (ret == nullptr) {
+				return nullptr;
+			}
+
+			return map_plane (ret);
+		}
 	};
 }
 #endif
@@ -288,6 +288,11 @@ namespace ncpp
 			ncplane_erase (plane);
 		}
 
+		bool compact () const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncplane_compact (plane), -1);
+		}
+
 		int get_abs_x () const noexcept
 		{
 			return ncplane_abs_x (plane);
@@ -938,6 +943,16 @@ namespace ncpp
 			return ncplane_set_scrolling (plane, scrollp);
 		}
 
+		bool set_cached_layer (bool cached) const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncplane_set_cached_layer (plane, cached), -1);
+		}
+
+		bool get_cached_layer_stats (uint64_t *hits, uint64_t *misses) const noexcept
+		{
+			return ncplane_cached_layer_stats (plane, hits, misses) != -1;
+		}
+
 		unsigned get_styles () const noexcept
 		{
 			return ncplane_styles (plane);
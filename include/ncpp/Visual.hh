@@ -86,6 +86,11 @@ namespace ncpp
 			return error_guard (ncvisual_rotate (visual, rads), -1);
 		}
 
+		bool rotate_bilinear (double rads) const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncvisual_rotate_bilinear (visual, rads), -1);
+		}
+
 		bool simple_streamer (ncvisual_options* vopts, const timespec* tspec, void* curry = nullptr) const NOEXCEPT_MAYBE
 		{
 			return error_guard (ncvisual_simple_streamer (visual, vopts, tspec, curry), -1);
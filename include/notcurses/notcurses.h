@@ -871,6 +871,28 @@ typedef enum {
 // anything but the virtual console/terminal in which Notcurses is running.
 #define NCOPTION_NO_FONT_CHANGES     0x0080ull
 
+// Split the rendering of large piles into row bands, and paint those bands
+// concurrently using a small pool of helper threads (one fewer than the
+// number of online processors). Output is identical to a serial render.
+// Small piles, and single-core machines, are always rendered serially. Large
+// cell blits are likewise split (see notcurses_set_blit_threshold()).
+#define NCOPTION_PARALLEL_RENDER     0x0100ull
+
+// Write rasterized frames to the terminal from a dedicated thread, so that
+// notcurses_render() can return (and the next frame can be prepared) while
+// the previous frame is still being written. notcurses_render() blocks only
+// if two earlier frames are still in flight. Frames are written synchronously
+// while the cursor is enabled.
+#define NCOPTION_ASYNC_OUTPUT        0x0200ull
+
+// As NCOPTION_ASYNC_OUTPUT, but should a frame still be being written when
+// the next is rasterized, the unwritten remainder of the former is discarded
+// (at a row boundary), and the latter redraws whatever it failed to update.
+// The terminal is thus never more than a frame behind, at the cost of frames
+// which appear only in part (or not at all). The tty is made nonblocking.
+// Frames containing bitmap graphics are always written in full.
+#define NCOPTION_COALESCE_OUTPUT     0x0400ull
+
 // Configuration for notcurses_init().
 typedef struct notcurses_options {
   // The name of the terminfo database entry describing this terminal. If NULL,
@@ -930,6 +952,11 @@ API struct ncplane* ncpile_top(struct ncplane* n);
 // Return the bottommost plane of the pile containing 'n'.
 API struct ncplane* ncpile_bottom(struct ncplane* n);
 
+// Return the topmost plane of the pile containing 'n' which covers the cell at
+// 'y', 'x', relative to the terminal origin (as reported by mouse events).
+// Transparency is not considered. Returns NULL if no plane covers the cell.
+API struct ncplane* ncpile_plane_at_yx(struct ncplane* n, int y, int x);
+
 // Renders the pile of which 'n' is a part. Rendering this pile again will blow
 // away the render. To actually write out the render, call ncpile_rasterize().
 API int ncpile_render(struct ncplane* n);
@@ -942,6 +969,29 @@ API int ncpile_rasterize(struct ncplane* n);
 // Renders and rasterizes the standard pile in one shot. Blocking call.
 API int notcurses_render(struct notcurses* nc);
 
+// Request that the standard pile be rendered and rasterized. If a target frame
+// rate has been set with notcurses_set_target_fps(), the frame is rendered
+// only if a frame interval has passed since the last such frame, and is
+// otherwise deferred; requests made in the meantime are satisfied by a single
+// frame, rendered by the first request or notcurses_getc() made after the
+// interval (a blocking notcurses_getc() wakes to render it), or by
+// notcurses_render_drain(). The standard pile thus mustn't be modified while
+// another thread polls for input. Otherwise, this is equivalent to
+// notcurses_render(). Any rendering happens on the calling thread. Returns -1
+// if a frame was rendered, and failed.
+API int notcurses_render_request(struct notcurses* nc);
+
+// Render any frame deferred by notcurses_render_request(), first sleeping out
+// the remainder of its frame interval. Returns 0 immediately if no frame is
+// pending, and -1 if the frame failed.
+API int notcurses_render_drain(struct notcurses* nc);
+
+// Render frames requested with notcurses_render_request() no more than 'fps'
+// times per second, or (if 'fps' is 0, the default) whenever requested. Any
+// frame deferred at the previous rate is first rendered. Returns -1 on
+// failure, or if that frame failed.
+API int notcurses_set_target_fps(struct notcurses* nc, unsigned fps);
+
 // Perform the rendering and rasterization portion of notcurses_render(), but
 // do not write the resulting buffer out to the terminal. Using this function,
 // the user can control the writeout process, and render a second frame while
@@ -1151,6 +1201,11 @@ API char* notcurses_at_yx(struct notcurses* nc, int yoff, int xoff,
 // when this flag is used. 'rows' and 'cols' must be 0 when this flag is
 // used. This flag is exclusive with both of the alignment flags.
 #define NCPLANE_OPTION_MARGINALIZED 0x0004ull
+// Allocate the plane's storage lazily, in bands of rows, as they are first
+// written. Unwritten cells are (and render as) the base cell. Memory then
+// scales with the written area, suiting very large, mostly-empty planes
+// (e.g. scrollback buffers). Access is slightly slower than a dense plane's.
+#define NCPLANE_OPTION_SPARSE 0x0008ull
 
 typedef struct ncplane_options {
   int y;            // vertical placement relative to parent plane
@@ -1233,6 +1288,21 @@ API bool ncplane_translate_abs(const struct ncplane* n, int* RESTRICT y, int* RE
 // previously enabled, or false if it was disabled.
 API bool ncplane_set_scrolling(struct ncplane* n, bool scrollp);
 
+// Mark 'n' and the planes bound to it (recursively, up to any plane marked
+// itself) as a cached layer, or remove the mark if 'cached' is false. A cached
+// layer is composited once, and its composition reused by subsequent renders
+// until some plane of the layer changes. This is worthwhile for static
+// subtrees beneath frequently-changing planes. The layer's planes must be
+// contiguous on the z-axis for the composition to be used. Returns -1 on
+// allocation failure.
+API int ncplane_set_cached_layer(struct ncplane* n, bool cached);
+
+// Retrieve the number of paints of the cached layer rooted at 'n' served from
+// its composition ('hits'), and the number requiring its recomposition
+// ('misses'). Either may be NULL. Returns -1 if 'n' is not a cached layer.
+API int ncplane_cached_layer_stats(const struct ncplane* n, uint64_t* hits,
+                                   uint64_t* misses);
+
 // Capabilities
 
 // Returns a 16-bit bitmask of supported curses-style attributes
@@ -1319,6 +1389,32 @@ typedef struct ncstats {
   int64_t raster_min_ns;     // min ns spent in raster for a frame
   uint64_t sprixelemissions; // sprixel draw count
   uint64_t sprixelelisions;  // sprixel elision count
+  uint64_t parallel_renders; // renders split into row bands across threads
+  uint64_t render_bands;     // row bands painted in parallel renders
+  uint64_t band_ns;          // ns spent painting bands, summed over all bands
+  int64_t band_max_ns;       // max ns spent painting a single band
+  uint64_t band_span_ns;     // ns of the slowest band, summed over renders
+  uint64_t rowelisions;      // undamaged rows skipped during rasterization
+  uint64_t rowemissions;     // damaged rows scanned during rasterization
+  uint64_t writer_waits;     // frames which waited on the writer thread
+  uint64_t writer_wait_ns;   // ns spent waiting on the writer thread
+  uint64_t coalesced_frames; // frames cut short by their successors
+  uint64_t dropped_frames;   // frames discarded without any row written
+  uint64_t dropped_bytes;    // bytes discarded from such frames
+  uint64_t motion_bytes_saved; // cursor motion bytes saved by the cost model
+  uint64_t scrolls_accelerated; // scrolls performed by the terminal
+  uint64_t run_bytes_saved;  // bytes saved by encoding runs of cells
+  uint64_t frames_requested; // calls to notcurses_render_request()
+  uint64_t frames_delivered; // frames rendered to satisfy such requests
+  uint64_t pool_compactions; // egcpools rebuilt to shed dead space
+  uint64_t pool_bytes_reclaimed; // bytes returned by such compactions
+  uint64_t slab_hits;        // planes and framebuffers recycled, not allocated
+  uint64_t slab_bytes;       // bytes retained for such recycling
+  uint64_t layer_hits;       // cached layers painted from their composition
+  uint64_t layer_misses;     // cached layers recomposited before painting
+  uint64_t parallel_blits;   // cell blits split into row bands across threads
+  uint64_t blitelisions;     // cells left untouched by delta blits
+  uint64_t blitemissions;    // cells written by delta blits
 } ncstats;
 
 // Allocate an ncstats object. Use this rather than allocating your own, since
@@ -1335,6 +1431,12 @@ API void notcurses_stats(struct notcurses* nc, ncstats* stats)
 API void notcurses_stats_reset(struct notcurses* nc, ncstats* stats)
   __attribute__ ((nonnull (1)));
 
+// Freed planes and framebuffers are retained for reuse, up to some total
+// number of bytes (by default 4MiB). Set this limit, shedding anything
+// beyond it, and return the previous limit. A limit of 0 disables recycling.
+API size_t notcurses_set_cache_limit(struct notcurses* nc, size_t bytes)
+  __attribute__ ((nonnull (1)));
+
 // Resize the specified ncplane. The four parameters 'keepy', 'keepx',
 // 'keepleny', and 'keeplenx' define a subset of the ncplane to keep,
 // unchanged. This may be a section of size 0, though none of these four
@@ -1981,6 +2083,13 @@ API int ncplane_mergedown(struct ncplane* RESTRICT src,
 // The cursor is homed. The plane's active attributes are unaffected.
 API void ncplane_erase(struct ncplane* n);
 
+// Rebuild the plane's egcpool, discarding the space of released EGCs, and
+// shrinking it if possible. This happens automatically when the pool is mostly
+// dead space, but only if every nccell loaded against the plane has been
+// released or placed into it; the same is true here. Returns -1 if some nccell
+// outside the plane still refers to its pool, or on allocation failure.
+API int ncplane_compact(struct ncplane* n);
+
 // Extract 24 bits of foreground RGB from 'cl', shifted to LSBs.
 static inline uint32_t
 nccell_fg_rgb(const nccell* cl){
@@ -2424,6 +2533,7 @@ API ALLOC struct ncvisual* ncvisual_from_plane(const struct ncplane* n,
 #define NCVISUAL_OPTION_HORALIGNED 0x0004ull // x is an alignment, not absolute
 #define NCVISUAL_OPTION_VERALIGNED 0x0008ull // y is an alignment, not absolute
 #define NCVISUAL_OPTION_ADDALPHA   0x0010ull // transcolor is in effect
+#define NCVISUAL_OPTION_DELTA      0x0020ull // skip cells whose source is unchanged
 
 struct ncvisual_options {
   // if no ncplane is provided, one will be created using the exact size
@@ -2493,11 +2603,16 @@ API int ncvisual_decode(struct ncvisual* nc)
 API int ncvisual_decode_loop(struct ncvisual* nc)
   __attribute__ ((nonnull (1)));
 
-// Rotate the visual 'rads' radians. Only M_PI/2 and -M_PI/2 are
-// supported at the moment, but this will change FIXME.
+// Rotate the visual 'rads' radians. Multiples of M_PI/2 are exact; other
+// angles sample the nearest source pixel.
 API int ncvisual_rotate(struct ncvisual* n, double rads)
   __attribute__ ((nonnull (1)));
 
+// As ncvisual_rotate(), but sampling bilinearly for angles other than
+// multiples of M_PI/2, yielding smoother edges at some cost in speed.
+API int ncvisual_rotate_bilinear(struct ncvisual* n, double rads)
+  __attribute__ ((nonnull (1)));
+
 // Scale the visual to 'rows' X 'columns' pixels, using the best scheme
 // available. This is a lossy transformation, unless the size is unchanged.
 API int ncvisual_resize(struct ncvisual* n, int rows, int cols)
@@ -2530,6 +2645,12 @@ API struct ncplane* ncvisual_render(struct notcurses* nc, struct ncvisual* ncv,
                                     const struct ncvisual_options* vopts)
   __attribute__ ((nonnull (2)));
 
+// With NCOPTION_PARALLEL_RENDER, cell blits covering at least 'cells' cells
+// (4096 by default) are split into bands of rows, blitted concurrently by the
+// render threads. Returns the previous threshold. 0 disables parallel blits.
+API unsigned notcurses_set_blit_threshold(struct notcurses* nc, unsigned cells)
+  __attribute__ ((nonnull (1)));
+
 __attribute__ ((nonnull (1, 2, 3))) static inline struct ncplane*
 ncvisualplane_create(struct ncplane* n, const struct ncplane_options* opts,
                      struct ncvisual* ncv, struct ncvisual_options* vopts){
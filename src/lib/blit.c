@@ -1,6 +1,11 @@
 #include <stddef.h>
 #include "internal.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLITSOLVE_X86
+#include <immintrin.h>
+#endif
+
 static const uint32_t zeroes32;
 static const unsigned char zeroes[] = "\x00\x00\x00\x00";
 
@@ -36,6 +41,66 @@ rgba_trans_q(const unsigned char* p, uint32_t transcolor){
   return rgba_trans_p(*(const uint32_t*)p, transcolor);
 }
 
+// move to the start of row 'y' of the blit. bands of a parallel blit mustn't
+// race on the cursor, so they only check the move, and remember it.
+static inline int
+blit_cursor_move(ncplane* nc, int y, int x, const blitterargs* bargs){
+  blitstage* bs = bargs->u.cell.stage;
+  if(bs == NULL){
+    return ncplane_cursor_move_yx(nc, y, x);
+  }
+  if(y >= nc->leny || x >= nc->lenx || y < -1 || x < -1){
+    return -1;
+  }
+  bs->lasty = y;
+  bs->lastx = x;
+  return 0;
+}
+
+// write the EGC 'egc' of 'bytes' bytes to the single-column cell 'c'. bands
+// of a parallel blit stage any cell requiring the egcpool, returning 'bytes'
+// on success just as pool_blit_direct() would.
+static inline int
+blit_egc(ncplane* nc, nccell* c, const char* egc, int bytes,
+         const blitterargs* bargs){
+  blitstage* bs = bargs->u.cell.stage;
+  if(bs == NULL || (bytes <= 4 && !cell_extended_p(c))){
+    return pool_blit_direct(&nc->pool, c, egc, bytes, 1);
+  }
+  if(bs->count == bs->alloc){
+    unsigned nalloc = bs->alloc ? bs->alloc * 2 : 16;
+    stagedegc* tmp = realloc(bs->cells, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    bs->cells = tmp;
+    bs->alloc = nalloc;
+  }
+  stagedegc* se = &bs->cells[bs->count];
+  if((se->egc = malloc(bytes)) == NULL){
+    return -1;
+  }
+  memcpy(se->egc, egc, bytes);
+  se->bytes = bytes;
+  se->c = c;
+  ++bs->count;
+  return bytes;
+}
+
+// can the cell at 'y', 'x' of a delta blit be left as it is?
+static inline bool
+blit_unchanged(const blitterargs* bargs, int y, int x){
+  const blitdelta* bd = bargs->u.cell.bdelta;
+  return bd && !bd->redraw[(y - bd->y0) * bd->cols + (x - bd->x0)];
+}
+
+// can all of row 'y' of a delta blit be left as it is?
+static inline bool
+blit_row_unchanged(const blitterargs* bargs, int y){
+  const blitdelta* bd = bargs->u.cell.bdelta;
+  return bd && !bd->rowredraw[y - bd->y0];
+}
+
 // Retarded RGBA blitter (ASCII only).
 static inline int
 tria_blit_ascii(ncplane* nc, int linesize, const void* data,
@@ -52,17 +117,23 @@ tria_blit_ascii(ncplane* nc, int linesize, const void* data,
     if(y < 0){
       continue;
     }
-    if(ncplane_cursor_move_yx(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex)){
+    if(blit_cursor_move(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex, bargs)){
       return -1;
     }
+    if(blit_row_unchanged(bargs, y)){
+      continue;
+    }
     int visx = bargs->begx;
     for(x = bargs->u.cell.placex ; visx < (bargs->begx + lenx) && x < dimx ; ++x, ++visx){
-      if(x < 0){
+      if(x < 0 || blit_unchanged(bargs, y, x)){
         continue;
       }
       const unsigned char* rgbbase_up = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -79,7 +150,7 @@ tria_blit_ascii(ncplane* nc, int linesize, const void* data,
         nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
         nccell_set_bg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
         cell_set_blitquadrants(c, 1, 1, 1, 1);
-        if(pool_blit_direct(&nc->pool, c, " ", 1, 1) <= 0){
+        if(blit_egc(nc, c, " ", 1, bargs) <= 0){
           return -1;
         }
         ++total;
@@ -107,12 +178,15 @@ tria_blit(ncplane* nc, int linesize, const void* data,
     if(y < 0){
       continue;
     }
-    if(ncplane_cursor_move_yx(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex)){
+    if(blit_cursor_move(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex, bargs)){
       return -1;
     }
+    if(blit_row_unchanged(bargs, y)){
+      continue;
+    }
     int visx = bargs->begx;
     for(x = bargs->u.cell.placex ; visx < (bargs->begx + lenx) && x < dimx ; ++x, ++visx){
-      if(x < 0){
+      if(x < 0 || blit_unchanged(bargs, y, x)){
         continue;
       }
       const unsigned char* rgbbase_up = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
@@ -122,6 +196,9 @@ tria_blit(ncplane* nc, int linesize, const void* data,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -135,7 +212,7 @@ tria_blit(ncplane* nc, int linesize, const void* data,
         if(rgba_trans_q(rgbbase_up, transcolor) && rgba_trans_q(rgbbase_down, transcolor)){
           nccell_set_fg_alpha(c, CELL_ALPHA_TRANSPARENT);
         }else if(rgba_trans_q(rgbbase_up, transcolor)){ // down has the color
-          if(pool_blit_direct(&nc->pool, c, "\u2584", strlen("\u2584"), 1) <= 0){
+          if(blit_egc(nc, c, "\u2584", strlen("\u2584"), bargs) <= 0){
             return -1;
           }
           nccell_set_fg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
@@ -143,7 +220,7 @@ tria_blit(ncplane* nc, int linesize, const void* data,
           ++total;
         }else{ // up has the color
           // upper half block
-          if(pool_blit_direct(&nc->pool, c, "\u2580", strlen("\u2580"), 1) <= 0){
+          if(blit_egc(nc, c, "\u2580", strlen("\u2580"), bargs) <= 0){
             return -1;
           }
           nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
@@ -155,14 +232,14 @@ tria_blit(ncplane* nc, int linesize, const void* data,
           nccell_set_fg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           nccell_set_bg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           cell_set_blitquadrants(c, 0, 0, 0, 0);
-          if(pool_blit_direct(&nc->pool, c, " ", 1, 1) <= 0){
+          if(blit_egc(nc, c, " ", 1, bargs) <= 0){
             return -1;
           }
         }else{
           nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
           nccell_set_bg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           cell_set_blitquadrants(c, 1, 1, 1, 1);
-          if(pool_blit_direct(&nc->pool, c, "\u2580", strlen("\u2580"), 1) <= 0){
+          if(blit_egc(nc, c, "\u2580", strlen("\u2580"), bargs) <= 0){
             return -1;
           }
         }
@@ -173,6 +250,11 @@ tria_blit(ncplane* nc, int linesize, const void* data,
   return total;
 }
 
+// the EGCs which can result from a quadrant solver, indexed by its results
+static const char* const quadrant_egcs[] = {
+  " ", "▀", "▌", "▚", "▞", "▐", "▄", "▛", "▜", "▙", "▟",
+};
+
 // once we find the closest pair of colors, we need look at the other two
 // colors, and determine whether either belongs with us rather with them.
 // if so, take the closer, and trilerp it in with us. otherwise, lerp the
@@ -180,18 +262,17 @@ tria_blit(ncplane* nc, int linesize, const void* data,
 static const struct qdriver {
   int pair[2];      // indices of contributing pair
   int others[2];    // indices of excluded pair
-  const char* egc;  // EGC corresponding to contributing pair
-  const char* oth0egc; // EGC upon absorbing others[0]
-  const char* oth1egc; // EGC upon absorbing others[1]
+  unsigned egc;     // EGC corresponding to contributing pair
+  unsigned oth0egc; // EGC upon absorbing others[0]
+  unsigned oth1egc; // EGC upon absorbing others[1]
 } quadrant_drivers[6] = {
-  { .pair = { 0, 1 }, .others = { 2, 3 }, .egc = "▀", .oth0egc = "▛", .oth1egc = "▜", },
-  { .pair = { 0, 2 }, .others = { 1, 3 }, .egc = "▌", .oth0egc = "▛", .oth1egc = "▙", },
-  { .pair = { 0, 3 }, .others = { 1, 2 }, .egc = "▚", .oth0egc = "▜", .oth1egc = "▙", },
-  { .pair = { 1, 2 }, .others = { 0, 3 }, .egc = "▞", .oth0egc = "▛", .oth1egc = "▟", },
-  { .pair = { 1, 3 }, .others = { 0, 2 }, .egc = "▐", .oth0egc = "▜", .oth1egc = "▟", },
-  { .pair = { 2, 3 }, .others = { 0, 1 }, .egc = "▄", .oth0egc = "▙", .oth1egc = "▟", },
+  { .pair = { 0, 1 }, .others = { 2, 3 }, .egc = 1, .oth0egc = 7, .oth1egc = 8, },  // ▀ ▛ ▜
+  { .pair = { 0, 2 }, .others = { 1, 3 }, .egc = 2, .oth0egc = 7, .oth1egc = 9, },  // ▌ ▛ ▙
+  { .pair = { 0, 3 }, .others = { 1, 2 }, .egc = 3, .oth0egc = 8, .oth1egc = 9, },  // ▚ ▜ ▙
+  { .pair = { 1, 2 }, .others = { 0, 3 }, .egc = 4, .oth0egc = 7, .oth1egc = 10, }, // ▞ ▛ ▟
+  { .pair = { 1, 3 }, .others = { 0, 2 }, .egc = 5, .oth0egc = 8, .oth1egc = 10, }, // ▐ ▜ ▟
+  { .pair = { 2, 3 }, .others = { 0, 1 }, .egc = 6, .oth0egc = 9, .oth1egc = 10, }, // ▄ ▙ ▟
 };
-
 // get the six distances between four colors. diffs must be an array of
 // at least 6 uint32_t values.
 static void
@@ -212,9 +293,9 @@ rgb_4diff(uint32_t* diffs, uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br){
   }
 }
 
-// solve for the EGC and two colors to best represent four colors at top
-// left, top right, bot left, bot right
-static inline const char*
+// solve for the EGC (as an index into quadrant_egcs[]) and two colors to best
+// represent four colors at top left, top right, bot left, bot right
+static inline unsigned
 quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
                 uint32_t* fore, uint32_t* back){
   const uint32_t colors[4] = { tl, tr, bl, br };
@@ -238,7 +319,7 @@ quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
   }
   if(allzerodiffs){
     *fore = *back = tl;
-    return " ";
+    return 0;
   }
   // at this point, 0 <= mindiffidx <= 5. foreground color will be the
   // lerp of this nearest pair. we then check the other two. if they are
@@ -251,7 +332,7 @@ quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
   *fore = lerp(colors[qd->pair[0]], colors[qd->pair[1]]);
   *back = lerp(colors[qd->others[0]], colors[qd->others[1]]);
 //fprintf(stderr, "mindiff: %u[%zu] fore: %08x back: %08x %d+%d/%d+%d\n", mindiff, mindiffidx, *fore, *back, qd->pair[0], qd->pair[1], qd->others[0], qd->others[1]);
-  const char* egc = qd->egc;
+  unsigned egc = qd->egc;
   // break down the excluded pair and lerp
   unsigned r0, r1, r2, g0, g1, g2, b0, b1, b2;
   unsigned roth, goth, both, rlerp, glerp, blerp;
@@ -419,6 +500,375 @@ qtrans_check(nccell* c, unsigned blendcolors,
   return egc;
 }
 
+// quadrant solver kernels. the vector kernels solve four (SSE4.1) or eight
+// (AVX2) cells at a time, one per 32-bit lane, carrying each color channel
+// in its own vector. they follow quadrant_solver() step for step, including
+// its handling of ties, so that their results are identical. any remainder
+// is left to the scalar kernel.
+static void
+quadsolve_scalar(const unsigned char* top, const unsigned char* bot, int n,
+                 unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  for(int i = 0 ; i < n ; ++i){
+    const unsigned char* t = top + i * 8;
+    const unsigned char* b = bot + i * 8;
+    uint32_t tl = 0, tr = 0, bl = 0, br = 0;
+    ncchannel_set_rgb8(&tl, t[0], t[1], t[2]);
+    ncchannel_set_rgb8(&tr, t[4], t[5], t[6]);
+    ncchannel_set_rgb8(&bl, b[0], b[1], b[2]);
+    ncchannel_set_rgb8(&br, b[4], b[5], b[6]);
+    egcs[i] = quadrant_solver(tl, tr, bl, br, &fg[i], &bg[i]);
+  }
+}
+
+// the EGC of a vector-solved cell, from the driver index 'idx' it selected,
+// whether it absorbed others[0] ('use0') or others[1], whether the absorption
+// was an improvement ('swap'), and whether all four colors were equal ('same')
+static inline unsigned char
+quadsolve_egc(unsigned idx, bool use0, bool swap, bool same){
+  if(same){
+    return 0;
+  }
+  const struct qdriver* qd = &quadrant_drivers[idx];
+  if(swap){
+    return use0 ? qd->oth0egc : qd->oth1egc;
+  }
+  return qd->egc;
+}
+
+#ifdef BLITSOLVE_X86
+__attribute__((target("sse4.1"))) static inline __m128i
+absdiff_sse41(__m128i a, __m128i b){
+  return _mm_sub_epi32(_mm_max_epi32(a, b), _mm_min_epi32(a, b));
+}
+
+// rgb_diff() across the three channel vectors of 'a' and 'b'
+__attribute__((target("sse4.1"))) static inline __m128i
+rgbdiff_sse41(const __m128i* a, const __m128i* b){
+  return _mm_add_epi32(_mm_add_epi32(absdiff_sse41(a[0], b[0]),
+                                     absdiff_sse41(a[1], b[1])),
+                       absdiff_sse41(a[2], b[2]));
+}
+
+__attribute__((target("sse4.1"))) static inline __m128i
+blend_sse41(__m128i a, __m128i b, __m128i mask){
+  return _mm_blendv_epi8(a, b, mask);
+}
+
+// split four RGBA pixels into r, g, and b vectors
+__attribute__((target("sse4.1"))) static inline void
+rgbsplit_sse41(__m128i px, __m128i* c){
+  const __m128i lo = _mm_set1_epi32(0xff);
+  c[0] = _mm_and_si128(px, lo);
+  c[1] = _mm_and_si128(_mm_srli_epi32(px, 8), lo);
+  c[2] = _mm_and_si128(_mm_srli_epi32(px, 16), lo);
+}
+
+// load the left and right pixels of four cells from a row of eight pixels
+__attribute__((target("sse4.1"))) static inline void
+pairload_sse41(const unsigned char* row, __m128i* left, __m128i* right){
+  __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)row));
+  __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(row + 16)));
+  *left = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+  *right = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// pack r, g, and b vectors into non-default channels
+__attribute__((target("sse4.1"))) static inline __m128i
+rgbpack_sse41(const __m128i* c){
+  return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(c[0], 16), _mm_slli_epi32(c[1], 8)),
+                      _mm_or_si128(c[2], _mm_set1_epi32(CELL_BGDEFAULT_MASK)));
+}
+
+__attribute__((target("sse4.1"))) static void
+quadsolve_sse41(const unsigned char* top, const unsigned char* bot, int n,
+                unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  const int drivers = sizeof(quadrant_drivers) / sizeof(*quadrant_drivers);
+  int i;
+  for(i = 0 ; i + 4 <= n ; i += 4){
+    __m128i px[4];
+    __m128i c[4][3]; // tl, tr, bl, br; r, g, b
+    pairload_sse41(top + i * 8, &px[0], &px[1]);
+    pairload_sse41(bot + i * 8, &px[2], &px[3]);
+    for(int p = 0 ; p < 4 ; ++p){
+      rgbsplit_sse41(px[p], c[p]);
+    }
+    // find the closest pair, preferring the first on ties
+    __m128i mindiff = rgbdiff_sse41(c[quadrant_drivers[0].pair[0]], c[quadrant_drivers[0].pair[1]]);
+    __m128i anydiff = mindiff;
+    __m128i idx = _mm_setzero_si128();
+    __m128i sel[4][3]; // pair[0], pair[1], others[0], others[1] of each lane
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      sel[0][ch] = c[quadrant_drivers[0].pair[0]][ch];
+      sel[1][ch] = c[quadrant_drivers[0].pair[1]][ch];
+      sel[2][ch] = c[quadrant_drivers[0].others[0]][ch];
+      sel[3][ch] = c[quadrant_drivers[0].others[1]][ch];
+    }
+    for(int d = 1 ; d < drivers ; ++d){
+      const struct qdriver* qd = &quadrant_drivers[d];
+      __m128i diff = rgbdiff_sse41(c[qd->pair[0]], c[qd->pair[1]]);
+      __m128i lt = _mm_cmplt_epi32(diff, mindiff);
+      mindiff = blend_sse41(mindiff, diff, lt);
+      idx = blend_sse41(idx, _mm_set1_epi32(d), lt);
+      anydiff = _mm_or_si128(anydiff, diff);
+    }
+    for(int d = 1 ; d < drivers ; ++d){
+      const struct qdriver* qd = &quadrant_drivers[d];
+      __m128i eq = _mm_cmpeq_epi32(idx, _mm_set1_epi32(d));
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        sel[0][ch] = blend_sse41(sel[0][ch], c[qd->pair[0]][ch], eq);
+        sel[1][ch] = blend_sse41(sel[1][ch], c[qd->pair[1]][ch], eq);
+        sel[2][ch] = blend_sse41(sel[2][ch], c[qd->others[0]][ch], eq);
+        sel[3][ch] = blend_sse41(sel[3][ch], c[qd->others[1]][ch], eq);
+      }
+    }
+    // lerp each pair, and consider absorbing the closer of the others
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i fore[3], back[3], absorbed[3], kept[3], tri[3];
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      fore[ch] = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(sel[0][ch], sel[1][ch]), one), 1);
+      back[ch] = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(sel[2][ch], sel[3][ch]), one), 1);
+    }
+    __m128i curdiff = _mm_add_epi32(_mm_add_epi32(rgbdiff_sse41(sel[2], back),
+                                                  rgbdiff_sse41(sel[3], back)),
+                                    _mm_add_epi32(rgbdiff_sse41(sel[0], fore),
+                                                  rgbdiff_sse41(sel[1], fore)));
+    __m128i use0 = _mm_cmplt_epi32(rgbdiff_sse41(sel[2], fore), rgbdiff_sse41(sel[3], fore));
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      absorbed[ch] = blend_sse41(sel[3][ch], sel[2][ch], use0);
+      kept[ch] = blend_sse41(sel[2][ch], sel[3][ch], use0);
+      // (sum + 2) / 3, exact for sums below 2^16
+      __m128i sum = _mm_add_epi32(_mm_add_epi32(sel[0][ch], sel[1][ch]),
+                                  _mm_add_epi32(absorbed[ch], _mm_set1_epi32(2)));
+      tri[ch] = _mm_srli_epi32(_mm_mullo_epi32(sum, _mm_set1_epi32(0xaaab)), 17);
+    }
+    __m128i tridiff = _mm_add_epi32(_mm_add_epi32(rgbdiff_sse41(sel[0], tri),
+                                                  rgbdiff_sse41(sel[1], tri)),
+                                    rgbdiff_sse41(absorbed, tri));
+    __m128i swap = _mm_cmplt_epi32(tridiff, curdiff);
+    __m128i same = _mm_cmpeq_epi32(anydiff, _mm_setzero_si128());
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      fore[ch] = blend_sse41(blend_sse41(fore[ch], tri[ch], swap), c[0][ch], same);
+      back[ch] = blend_sse41(blend_sse41(back[ch], kept[ch], swap), c[0][ch], same);
+    }
+    _mm_storeu_si128((__m128i*)(fg + i), rgbpack_sse41(fore));
+    _mm_storeu_si128((__m128i*)(bg + i), rgbpack_sse41(back));
+    uint32_t idxs[4];
+    _mm_storeu_si128((__m128i*)idxs, idx);
+    const unsigned use0s = _mm_movemask_ps(_mm_castsi128_ps(use0));
+    const unsigned swaps = _mm_movemask_ps(_mm_castsi128_ps(swap));
+    const unsigned sames = _mm_movemask_ps(_mm_castsi128_ps(same));
+    for(int l = 0 ; l < 4 ; ++l){
+      egcs[i + l] = quadsolve_egc(idxs[l], use0s & (1u << l), swaps & (1u << l),
+                                  sames & (1u << l));
+    }
+  }
+  quadsolve_scalar(top + i * 8, bot + i * 8, n - i, egcs + i, fg + i, bg + i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+absdiff_avx2(__m256i a, __m256i b){
+  return _mm256_sub_epi32(_mm256_max_epi32(a, b), _mm256_min_epi32(a, b));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+rgbdiff_avx2(const __m256i* a, const __m256i* b){
+  return _mm256_add_epi32(_mm256_add_epi32(absdiff_avx2(a[0], b[0]),
+                                           absdiff_avx2(a[1], b[1])),
+                          absdiff_avx2(a[2], b[2]));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+blend_avx2(__m256i a, __m256i b, __m256i mask){
+  return _mm256_blendv_epi8(a, b, mask);
+}
+
+__attribute__((target("avx2"))) static inline void
+rgbsplit_avx2(__m256i px, __m256i* c){
+  const __m256i lo = _mm256_set1_epi32(0xff);
+  c[0] = _mm256_and_si256(px, lo);
+  c[1] = _mm256_and_si256(_mm256_srli_epi32(px, 8), lo);
+  c[2] = _mm256_and_si256(_mm256_srli_epi32(px, 16), lo);
+}
+
+// shuffles work within 128-bit lanes, leaving the 64-bit halves of each
+// result out of order; the permute restores them.
+__attribute__((target("avx2"))) static inline void
+pairload_avx2(const unsigned char* row, __m256i* left, __m256i* right){
+  __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)row));
+  __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(row + 32)));
+  __m256i l = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+  __m256i r = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  *left = _mm256_permute4x64_epi64(l, _MM_SHUFFLE(3, 1, 2, 0));
+  *right = _mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+rgbpack_avx2(const __m256i* c){
+  return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(c[0], 16), _mm256_slli_epi32(c[1], 8)),
+                         _mm256_or_si256(c[2], _mm256_set1_epi32(CELL_BGDEFAULT_MASK)));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+cmplt_avx2(__m256i a, __m256i b){
+  return _mm256_cmpgt_epi32(b, a);
+}
+
+__attribute__((target("avx2"))) static void
+quadsolve_avx2(const unsigned char* top, const unsigned char* bot, int n,
+               unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  const int drivers = sizeof(quadrant_drivers) / sizeof(*quadrant_drivers);
+  int i;
+  for(i = 0 ; i + 8 <= n ; i += 8){
+    __m256i px[4];
+    __m256i c[4][3];
+    pairload_avx2(top + i * 8, &px[0], &px[1]);
+    pairload_avx2(bot + i * 8, &px[2], &px[3]);
+    for(int p = 0 ; p < 4 ; ++p){
+      rgbsplit_avx2(px[p], c[p]);
+    }
+    __m256i mindiff = rgbdiff_avx2(c[quadrant_drivers[0].pair[0]], c[quadrant_drivers[0].pair[1]]);
+    __m256i anydiff = mindiff;
+    __m256i idx = _mm256_setzero_si256();
+    __m256i sel[4][3];
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      sel[0][ch] = c[quadrant_drivers[0].pair[0]][ch];
+      sel[1][ch] = c[quadrant_drivers[0].pair[1]][ch];
+      sel[2][ch] = c[quadrant_drivers[0].others[0]][ch];
+      sel[3][ch] = c[quadrant_drivers[0].others[1]][ch];
+    }
+    for(int d = 1 ; d < drivers ; ++d){
+      const struct qdriver* qd = &quadrant_drivers[d];
+      __m256i diff = rgbdiff_avx2(c[qd->pair[0]], c[qd->pair[1]]);
+      __m256i lt = cmplt_avx2(diff, mindiff);
+      mindiff = blend_avx2(mindiff, diff, lt);
+      idx = blend_avx2(idx, _mm256_set1_epi32(d), lt);
+      anydiff = _mm256_or_si256(anydiff, diff);
+    }
+    for(int d = 1 ; d < drivers ; ++d){
+      const struct qdriver* qd = &quadrant_drivers[d];
+      __m256i eq = _mm256_cmpeq_epi32(idx, _mm256_set1_epi32(d));
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        sel[0][ch] = blend_avx2(sel[0][ch], c[qd->pair[0]][ch], eq);
+        sel[1][ch] = blend_avx2(sel[1][ch], c[qd->pair[1]][ch], eq);
+        sel[2][ch] = blend_avx2(sel[2][ch], c[qd->others[0]][ch], eq);
+        sel[3][ch] = blend_avx2(sel[3][ch], c[qd->others[1]][ch], eq);
+      }
+    }
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i fore[3], back[3], absorbed[3], kept[3], tri[3];
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      fore[ch] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(sel[0][ch], sel[1][ch]), one), 1);
+      back[ch] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(sel[2][ch], sel[3][ch]), one), 1);
+    }
+    __m256i curdiff = _mm256_add_epi32(_mm256_add_epi32(rgbdiff_avx2(sel[2], back),
+                                                        rgbdiff_avx2(sel[3], back)),
+                                       _mm256_add_epi32(rgbdiff_avx2(sel[0], fore),
+                                                        rgbdiff_avx2(sel[1], fore)));
+    __m256i use0 = cmplt_avx2(rgbdiff_avx2(sel[2], fore), rgbdiff_avx2(sel[3], fore));
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      absorbed[ch] = blend_avx2(sel[3][ch], sel[2][ch], use0);
+      kept[ch] = blend_avx2(sel[2][ch], sel[3][ch], use0);
+      __m256i sum = _mm256_add_epi32(_mm256_add_epi32(sel[0][ch], sel[1][ch]),
+                                     _mm256_add_epi32(absorbed[ch], _mm256_set1_epi32(2)));
+      tri[ch] = _mm256_srli_epi32(_mm256_mullo_epi32(sum, _mm256_set1_epi32(0xaaab)), 17);
+    }
+    __m256i tridiff = _mm256_add_epi32(_mm256_add_epi32(rgbdiff_avx2(sel[0], tri),
+                                                        rgbdiff_avx2(sel[1], tri)),
+                                       rgbdiff_avx2(absorbed, tri));
+    __m256i swap = cmplt_avx2(tridiff, curdiff);
+    __m256i same = _mm256_cmpeq_epi32(anydiff, _mm256_setzero_si256());
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      fore[ch] = blend_avx2(blend_avx2(fore[ch], tri[ch], swap), c[0][ch], same);
+      back[ch] = blend_avx2(blend_avx2(back[ch], kept[ch], swap), c[0][ch], same);
+    }
+    _mm256_storeu_si256((__m256i*)(fg + i), rgbpack_avx2(fore));
+    _mm256_storeu_si256((__m256i*)(bg + i), rgbpack_avx2(back));
+    uint32_t idxs[8];
+    _mm256_storeu_si256((__m256i*)idxs, idx);
+    const unsigned use0s = _mm256_movemask_ps(_mm256_castsi256_ps(use0));
+    const unsigned swaps = _mm256_movemask_ps(_mm256_castsi256_ps(swap));
+    const unsigned sames = _mm256_movemask_ps(_mm256_castsi256_ps(same));
+    for(int l = 0 ; l < 8 ; ++l){
+      egcs[i + l] = quadsolve_egc(idxs[l], use0s & (1u << l), swaps & (1u << l),
+                                  sames & (1u << l));
+    }
+  }
+  quadsolve_scalar(top + i * 8, bot + i * 8, n - i, egcs + i, fg + i, bg + i);
+}
+#endif
+
+quadsolve_fxn quadsolve_kernel(blitsolve_e isa){
+  switch(isa){
+    case BLITSOLVE_SCALAR:
+      return quadsolve_scalar;
+#ifdef BLITSOLVE_X86
+    case BLITSOLVE_SSE41:
+      if(__builtin_cpu_supports("sse4.1")){
+        return quadsolve_sse41;
+      }
+      break;
+    case BLITSOLVE_AVX2:
+      if(__builtin_cpu_supports("avx2")){
+        return quadsolve_avx2;
+      }
+      break;
+#else
+    default:
+      break;
+#endif
+  }
+  return NULL;
+}
+
+// the fastest quadrant solver supported by this processor
+static quadsolve_fxn
+quadsolve_best(void){
+  quadsolve_fxn ret;
+  if( (ret = quadsolve_kernel(BLITSOLVE_AVX2)) ){
+    return ret;
+  }
+  if( (ret = quadsolve_kernel(BLITSOLVE_SSE41)) ){
+    return ret;
+  }
+  return quadsolve_kernel(BLITSOLVE_SCALAR);
+}
+
+// the results of a solver kernel for a row of cells, namely the 'n' cells
+// from the blit's first visible column onwards which take both of their
+// columns from the image. the first of these begins at image column 'visx'.
+typedef struct blitsolve_scratch {
+  int n, visx;
+  unsigned char* egcs;
+  uint32_t* fg;
+  uint32_t* bg;
+} blitsolve_scratch;
+
+static int
+blitsolve_scratch_init(blitsolve_scratch* bs, const blitterargs* bargs,
+                       int xstart, int lenx, int dimx){
+  int xend = bargs->u.cell.placex + lenx / 2;
+  if(xend > dimx){
+    xend = dimx;
+  }
+  bs->n = xend > xstart ? xend - xstart : 0;
+  bs->visx = bargs->begx + (xstart - bargs->u.cell.placex) * 2;
+  bs->egcs = NULL;
+  bs->fg = bs->bg = NULL;
+  if(bs->n){
+    if((bs->fg = malloc(bs->n * (sizeof(*bs->fg) + sizeof(*bs->bg) + sizeof(*bs->egcs)))) == NULL){
+      return -1;
+    }
+    bs->bg = bs->fg + bs->n;
+    bs->egcs = (unsigned char*)(bs->bg + bs->n);
+  }
+  return 0;
+}
+
+static inline void
+blitsolve_scratch_free(blitsolve_scratch* bs){
+  free(bs->fg);
+}
+
 // quadrant blitter. maps 2x2 to each cell. since we only have two colors at
 // our disposal (foreground and background), we lose some fidelity.
 static inline int
@@ -431,17 +881,35 @@ quadrant_blit(ncplane* nc, int linesize, const void* data,
 //fprintf(stderr, "quadblitter %dx%d -> %d/%d+%d/%d\n", leny, lenx, dimy, dimx, bargs->u.cell.placey, bargs->u.cell.placex);
   // FIXME not going to necessarily be safe on all architectures hrmmm
   const unsigned char* dat = data;
+  const int xstart = bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex;
+  // cells taking both columns from the image are solved a row at a time by a
+  // vector kernel, whenever both of their rows are available.
+  blitsolve_scratch scratch;
+  if(blitsolve_scratch_init(&scratch, bargs, xstart, lenx, dimx)){
+    return -1;
+  }
+  const quadsolve_fxn solve = quadsolve_best();
   int visy = bargs->begy;
   for(y = bargs->u.cell.placey ; visy < (bargs->begy + leny) && y < dimy ; ++y, visy += 2){
     if(y < 0){
       continue;
     }
-    if(ncplane_cursor_move_yx(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex)){
+    if(blit_cursor_move(nc, y, xstart, bargs)){
+      blitsolve_scratch_free(&scratch);
       return -1;
     }
+    if(blit_row_unchanged(bargs, y)){
+      continue;
+    }
+    int solved = 0;
+    if(scratch.n && visy < bargs->begy + leny - 1){
+      const unsigned char* top = dat + (linesize * visy) + (scratch.visx * bpp / CHAR_BIT);
+      solve(top, top + linesize, scratch.n, scratch.egcs, scratch.fg, scratch.bg);
+      solved = scratch.n;
+    }
     int visx = bargs->begx;
     for(x = bargs->u.cell.placex ; visx < (bargs->begx + lenx) && x < dimx ; ++x, visx += 2){
-      if(x < 0){
+      if(x < 0 || blit_unchanged(bargs, y, x)){
         continue;
       }
       const unsigned char* rgbbase_tl = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
@@ -459,19 +927,28 @@ quadrant_blit(ncplane* nc, int linesize, const void* data,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_tl[0], rgbbase_tr[1], rgbbase_bl[2], rgbbase_br[3]);
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        blitsolve_scratch_free(&scratch);
+        return -1;
+      }
       c->channels = 0;
       c->stylemask = 0;
       const char* egc = qtrans_check(c, bargs->u.cell.blendcolors, rgbbase_tl, rgbbase_tr, rgbbase_bl, rgbbase_br, bargs->transcolor);
       if(egc == NULL){
-        uint32_t tl = 0, tr = 0, bl = 0, br = 0;
-        ncchannel_set_rgb8(&tl, rgbbase_tl[0], rgbbase_tl[1], rgbbase_tl[2]);
-        ncchannel_set_rgb8(&tr, rgbbase_tr[0], rgbbase_tr[1], rgbbase_tr[2]);
-        ncchannel_set_rgb8(&bl, rgbbase_bl[0], rgbbase_bl[1], rgbbase_bl[2]);
-        ncchannel_set_rgb8(&br, rgbbase_br[0], rgbbase_br[1], rgbbase_br[2]);
         uint32_t bg, fg;
+        if(x - xstart < solved){
+          egc = quadrant_egcs[scratch.egcs[x - xstart]];
+          fg = scratch.fg[x - xstart];
+          bg = scratch.bg[x - xstart];
+        }else{
+          uint32_t tl = 0, tr = 0, bl = 0, br = 0;
+          ncchannel_set_rgb8(&tl, rgbbase_tl[0], rgbbase_tl[1], rgbbase_tl[2]);
+          ncchannel_set_rgb8(&tr, rgbbase_tr[0], rgbbase_tr[1], rgbbase_tr[2]);
+          ncchannel_set_rgb8(&bl, rgbbase_bl[0], rgbbase_bl[1], rgbbase_bl[2]);
+          ncchannel_set_rgb8(&br, rgbbase_br[0], rgbbase_br[1], rgbbase_br[2]);
+          egc = quadrant_egcs[quadrant_solver(tl, tr, bl, br, &fg, &bg)];
+        }
 //fprintf(stderr, "qtrans check: %d/%d\n%08x %08x\n%08x %08x\n", y, x, *(const uint32_t*)rgbbase_tl, *(const uint32_t*)rgbbase_tr, *(const uint32_t*)rgbbase_bl, *(const uint32_t*)rgbbase_br);
-        egc = quadrant_solver(tl, tr, bl, br, &fg, &bg);
-        assert(egc);
 //fprintf(stderr, "%d/%d %08x/%08x\n", y, x, fg, bg);
         cell_set_fchannel(c, fg);
         cell_set_bchannel(c, bg);
@@ -482,13 +959,15 @@ quadrant_blit(ncplane* nc, int linesize, const void* data,
         cell_set_blitquadrants(c, 1, 1, 1, 1);
       }
       if(*egc){
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
+        if(blit_egc(nc, c, egc, strlen(egc), bargs) <= 0){
+          blitsolve_scratch_free(&scratch);
           return -1;
         }
         ++total;
       }
     }
   }
+  blitsolve_scratch_free(&scratch);
   return total;
 }
 
@@ -506,47 +985,53 @@ generalerp(unsigned rsum, unsigned gsum, unsigned bsum, int count){
                                  (bsum + (count - 1)) / count);
 }
 
-// Solve for the cell rendered by this 3x2 sample. None of the input pixels may
-// be transparent (that ought already have been handled). We use exhaustive
-// search, which might be quite computationally intensive for the worst case
-// (all six pixels are different colors). We want to solve for the 2-partition
-// of pixels that minimizes total source distance from the resulting lerps.
-static const char*
-sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors){
-  // each element within the set of 64 has an inverse element within the set,
-  // for which we would calculate the same total differences, so just handle
-  // the first 32. the partition[] bit masks represent combinations of
-  // sextants, and their indices correspond to sex[].
-  static const char* sex[32] = {
-    " ", "🬀", "🬁", "🬃", "🬇", "🬏", "🬞", "🬂", // 0..7
+// each element within the set of 64 sextant combinations has an inverse
+// element within the set, for which we would calculate the same total
+// differences, so the solvers consider only the first 32. the partition bit
+// masks represent combinations of sextants, and their indices correspond to
+// sextant_egcs[].
+static const char* const sextant_egcs[32] = {
+  " ", "🬀", "🬁", "🬃", "🬇", "🬏", "🬞", "🬂", // 0..7
 
-    "🬄", "🬈", "🬐", "🬟", "🬅", "🬉", "🬑", "🬠", // 8..15
+  "🬄", "🬈", "🬐", "🬟", "🬅", "🬉", "🬑", "🬠", // 8..15
 
-    "🬋", "🬓", "🬢", "🬖", "🬦", "🬭", "🬆", "🬊", // 16..23
+  "🬋", "🬓", "🬢", "🬖", "🬦", "🬭", "🬆", "🬊", // 16..23
 
-    "🬒", "🬡", "🬌", "▌", "🬣", "🬗", "🬧", "🬍", // 24..31
+  "🬒", "🬡", "🬌", "▌", "🬣", "🬗", "🬧", "🬍", // 24..31
 
-  };
-  static const unsigned partitions[32] = {
-    0, // 1 way to arrange 0
-    1, 2, 4, 8, 16, 32, // 6 ways to arrange 1
-    3, 5, 9, 17, 33, 6, 10, 18, 34, 12, 20, 36, 24, 40, 48, // 15 ways for 2
-    //  16 ways to arrange 3, *but* six of them are inverses, so 10
-    7, 11, 19, 35, 13, 21, 37, 25, 41, 14 //  10 + 15 + 6 + 1 == 32
-  };
+};
+
+static const unsigned sextant_partitions[32] = {
+  0, // 1 way to arrange 0
+  1, 2, 4, 8, 16, 32, // 6 ways to arrange 1
+  3, 5, 9, 17, 33, 6, 10, 18, 34, 12, 20, 36, 24, 40, 48, // 15 ways for 2
+  //  16 ways to arrange 3, *but* six of them are inverses, so 10
+  7, 11, 19, 35, 13, 21, 37, 25, 41, 14 //  10 + 15 + 6 + 1 == 32
+};
+
+// Solve for the cell rendered by this 3x2 sample, returning its EGC as an
+// index into sextant_egcs[], and writing its foreground and background
+// channels. None of the input pixels may be transparent (that ought already
+// have been handled). We use exhaustive search, which might be quite
+// computationally intensive for the worst case (all six pixels are different
+// colors). We want to solve for the 2-partition of pixels that minimizes
+// total source distance from the resulting lerps.
+static unsigned
+sex_solver(const uint32_t rgbas[6], uint32_t* fg, uint32_t* bg){
   // we loop over the bitstrings, dividing the pixels into two sets, and then
   // taking a general lerp over each set. we then compute the sum of absolute
   // differences, and see if it's the new minimum.
   int best = -1;
   uint32_t mindiff = UINT_MAX;
 //fprintf(stderr, "%06x %06x\n%06x %06x\n%06x %06x\n", rgbas[0], rgbas[1], rgbas[2], rgbas[3], rgbas[4], rgbas[5]);
-  for(size_t glyph = 0 ; glyph < sizeof(partitions) / sizeof(*partitions) ; ++glyph){
+  for(size_t glyph = 0 ; glyph < sizeof(sextant_partitions) / sizeof(*sextant_partitions) ; ++glyph){
+    const unsigned partition = sextant_partitions[glyph];
     unsigned rsum0 = 0, rsum1 = 0;
     unsigned gsum0 = 0, gsum1 = 0;
     unsigned bsum0 = 0, bsum1 = 0;
     int insum = 0;
     for(unsigned mask = 0 ; mask < 6 ; ++mask){
-      if(partitions[glyph] & (1u << mask)){
+      if(partition & (1u << mask)){
         rsum0 += ncpixel_r(rgbas[mask]);
         gsum0 += ncpixel_g(rgbas[mask]);
         bsum0 += ncpixel_b(rgbas[mask]);
@@ -563,7 +1048,7 @@ sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors){
     uint32_t totaldiff = 0;
     for(unsigned mask = 0 ; mask < 6 ; ++mask){
       unsigned r, g, b;
-      if(partitions[glyph] & (1u << mask)){
+      if(partition & (1u << mask)){
         ncchannel_rgb8(l0, &r, &g, &b);
       }else{
         ncchannel_rgb8(l1, &r, &g, &b);
@@ -573,12 +1058,12 @@ sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors){
       totaldiff += rdiff;
 //fprintf(stderr, "mask: %u totaldiff: %u insum: %d (%08x / %08x)\n", mask, totaldiff, insum, l0, l1);
     }
-//fprintf(stderr, "bits: %u %zu totaldiff: %f best: %f (%d)\n", partitions[glyph], glyph, totaldiff, mindiff, best);
+//fprintf(stderr, "bits: %u %zu totaldiff: %f best: %f (%d)\n", partition, glyph, totaldiff, mindiff, best);
     if(totaldiff < mindiff){
       mindiff = totaldiff;
       best = glyph;
-      ncchannels_set_fchannel(channels, l0);
-      ncchannels_set_bchannel(channels, l1);
+      *fg = l0;
+      *bg = l1;
     }
     if(totaldiff == 0){ // can't beat that!
       break;
@@ -586,11 +1071,7 @@ sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors){
   }
 //fprintf(stderr, "solved for best: %d (%u)\n", best, mindiff);
   assert(best >= 0 && best < 32);
-  if(blendcolors){
-    ncchannels_set_fg_alpha(channels, CELL_ALPHA_BLEND);
-    ncchannels_set_bg_alpha(channels, CELL_ALPHA_BLEND);
-  }
-  return sex[best];
+  return best;
 }
 
 static const char*
@@ -648,6 +1129,219 @@ sex_trans_check(cell* c, const uint32_t rgbas[6], unsigned blendcolors,
   return egc;
 }
 
+// sextant solver kernels. the vector kernels evaluate each partition for four
+// (SSE4.1) or eight (AVX2) cells at once, one per 32-bit lane. a partition's
+// pixel counts don't vary by lane, so the generalerp() divisions become
+// multiplications by a constant reciprocal, exact over our range of sums.
+// we keep the first strictly best partition, as does sex_solver().
+static void
+sexsolve_scalar(const unsigned char* const rows[3], int n,
+                unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  for(int i = 0 ; i < n ; ++i){
+    uint32_t rgbas[6];
+    for(int r = 0 ; r < 3 ; ++r){
+      memcpy(&rgbas[r * 2], rows[r] + i * 8, sizeof(*rgbas) * 2);
+    }
+    egcs[i] = sex_solver(rgbas, &fg[i], &bg[i]);
+  }
+}
+
+// ceiling division of sums of up to six channels by 'count' takes the form
+// ((sum + count - 1) * sexsolve_recip(count)) >> 16
+static inline uint32_t
+sexsolve_recip(unsigned count){
+  return (65536 + count - 1) / count;
+}
+
+#ifdef BLITSOLVE_X86
+__attribute__((target("sse4.1"))) static void
+sexsolve_sse41(const unsigned char* const rows[3], int n,
+               unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  const int parts = sizeof(sextant_partitions) / sizeof(*sextant_partitions);
+  int i;
+  for(i = 0 ; i + 4 <= n ; i += 4){
+    __m128i c[6][3]; // pixels in sextant bit order; r, g, b
+    __m128i total[3];
+    for(int r = 0 ; r < 3 ; ++r){
+      __m128i px[2];
+      pairload_sse41(rows[r] + i * 8, &px[0], &px[1]);
+      rgbsplit_sse41(px[0], c[r * 2]);
+      rgbsplit_sse41(px[1], c[r * 2 + 1]);
+    }
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      total[ch] = c[0][ch];
+      for(int p = 1 ; p < 6 ; ++p){
+        total[ch] = _mm_add_epi32(total[ch], c[p][ch]);
+      }
+    }
+    __m128i mindiff = _mm_set1_epi32(INT_MAX);
+    __m128i best = _mm_setzero_si128();
+    __m128i l0best[3], l1best[3];
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      l0best[ch] = l1best[ch] = _mm_setzero_si128();
+    }
+    for(int glyph = 0 ; glyph < parts ; ++glyph){
+      const unsigned partition = sextant_partitions[glyph];
+      const unsigned insum = __builtin_popcount(partition);
+      const __m128i recip0 = _mm_set1_epi32(insum ? sexsolve_recip(insum) : 0);
+      const __m128i recip1 = _mm_set1_epi32(sexsolve_recip(6 - insum));
+      const __m128i bias0 = _mm_set1_epi32(insum ? insum - 1 : 0);
+      const __m128i bias1 = _mm_set1_epi32(6 - insum - 1);
+      __m128i l0[3], l1[3];
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        __m128i sum0 = _mm_setzero_si128();
+        for(int p = 0 ; p < 6 ; ++p){
+          if(partition & (1u << p)){
+            sum0 = _mm_add_epi32(sum0, c[p][ch]);
+          }
+        }
+        __m128i sum1 = _mm_sub_epi32(total[ch], sum0);
+        l0[ch] = _mm_srli_epi32(_mm_mullo_epi32(_mm_add_epi32(sum0, bias0), recip0), 16);
+        l1[ch] = _mm_srli_epi32(_mm_mullo_epi32(_mm_add_epi32(sum1, bias1), recip1), 16);
+      }
+      __m128i totaldiff = _mm_setzero_si128();
+      for(int p = 0 ; p < 6 ; ++p){
+        totaldiff = _mm_add_epi32(totaldiff,
+                                  rgbdiff_sse41(c[p], (partition & (1u << p)) ? l0 : l1));
+      }
+      __m128i lt = _mm_cmplt_epi32(totaldiff, mindiff);
+      mindiff = blend_sse41(mindiff, totaldiff, lt);
+      best = blend_sse41(best, _mm_set1_epi32(glyph), lt);
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        l0best[ch] = blend_sse41(l0best[ch], l0[ch], lt);
+        l1best[ch] = blend_sse41(l1best[ch], l1[ch], lt);
+      }
+      if(_mm_testz_si128(mindiff, mindiff)){ // can't beat that!
+        break;
+      }
+    }
+    // the empty partition's lerp is 0, not an RGB value
+    __m128i fore = _mm_andnot_si128(_mm_cmpeq_epi32(best, _mm_setzero_si128()),
+                                    rgbpack_sse41(l0best));
+    _mm_storeu_si128((__m128i*)(fg + i), fore);
+    _mm_storeu_si128((__m128i*)(bg + i), rgbpack_sse41(l1best));
+    uint32_t bests[4];
+    _mm_storeu_si128((__m128i*)bests, best);
+    for(int l = 0 ; l < 4 ; ++l){
+      egcs[i + l] = bests[l];
+    }
+  }
+  const unsigned char* const tail[3] = { rows[0] + i * 8, rows[1] + i * 8, rows[2] + i * 8, };
+  sexsolve_scalar(tail, n - i, egcs + i, fg + i, bg + i);
+}
+
+__attribute__((target("avx2"))) static void
+sexsolve_avx2(const unsigned char* const rows[3], int n,
+              unsigned char* egcs, uint32_t* fg, uint32_t* bg){
+  const int parts = sizeof(sextant_partitions) / sizeof(*sextant_partitions);
+  int i;
+  for(i = 0 ; i + 8 <= n ; i += 8){
+    __m256i c[6][3];
+    __m256i total[3];
+    for(int r = 0 ; r < 3 ; ++r){
+      __m256i px[2];
+      pairload_avx2(rows[r] + i * 8, &px[0], &px[1]);
+      rgbsplit_avx2(px[0], c[r * 2]);
+      rgbsplit_avx2(px[1], c[r * 2 + 1]);
+    }
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      total[ch] = c[0][ch];
+      for(int p = 1 ; p < 6 ; ++p){
+        total[ch] = _mm256_add_epi32(total[ch], c[p][ch]);
+      }
+    }
+    __m256i mindiff = _mm256_set1_epi32(INT_MAX);
+    __m256i best = _mm256_setzero_si256();
+    __m256i l0best[3], l1best[3];
+    for(int ch = 0 ; ch < 3 ; ++ch){
+      l0best[ch] = l1best[ch] = _mm256_setzero_si256();
+    }
+    for(int glyph = 0 ; glyph < parts ; ++glyph){
+      const unsigned partition = sextant_partitions[glyph];
+      const unsigned insum = __builtin_popcount(partition);
+      const __m256i recip0 = _mm256_set1_epi32(insum ? sexsolve_recip(insum) : 0);
+      const __m256i recip1 = _mm256_set1_epi32(sexsolve_recip(6 - insum));
+      const __m256i bias0 = _mm256_set1_epi32(insum ? insum - 1 : 0);
+      const __m256i bias1 = _mm256_set1_epi32(6 - insum - 1);
+      __m256i l0[3], l1[3];
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        __m256i sum0 = _mm256_setzero_si256();
+        for(int p = 0 ; p < 6 ; ++p){
+          if(partition & (1u << p)){
+            sum0 = _mm256_add_epi32(sum0, c[p][ch]);
+          }
+        }
+        __m256i sum1 = _mm256_sub_epi32(total[ch], sum0);
+        l0[ch] = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi32(sum0, bias0), recip0), 16);
+        l1[ch] = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi32(sum1, bias1), recip1), 16);
+      }
+      __m256i totaldiff = _mm256_setzero_si256();
+      for(int p = 0 ; p < 6 ; ++p){
+        totaldiff = _mm256_add_epi32(totaldiff,
+                                     rgbdiff_avx2(c[p], (partition & (1u << p)) ? l0 : l1));
+      }
+      __m256i lt = cmplt_avx2(totaldiff, mindiff);
+      mindiff = blend_avx2(mindiff, totaldiff, lt);
+      best = blend_avx2(best, _mm256_set1_epi32(glyph), lt);
+      for(int ch = 0 ; ch < 3 ; ++ch){
+        l0best[ch] = blend_avx2(l0best[ch], l0[ch], lt);
+        l1best[ch] = blend_avx2(l1best[ch], l1[ch], lt);
+      }
+      if(_mm256_testz_si256(mindiff, mindiff)){
+        break;
+      }
+    }
+    __m256i fore = _mm256_andnot_si256(_mm256_cmpeq_epi32(best, _mm256_setzero_si256()),
+                                       rgbpack_avx2(l0best));
+    _mm256_storeu_si256((__m256i*)(fg + i), fore);
+    _mm256_storeu_si256((__m256i*)(bg + i), rgbpack_avx2(l1best));
+    uint32_t bests[8];
+    _mm256_storeu_si256((__m256i*)bests, best);
+    for(int l = 0 ; l < 8 ; ++l){
+      egcs[i + l] = bests[l];
+    }
+  }
+  const unsigned char* const tail[3] = { rows[0] + i * 8, rows[1] + i * 8, rows[2] + i * 8, };
+  sexsolve_scalar(tail, n - i, egcs + i, fg + i, bg + i);
+}
+#endif
+
+sexsolve_fxn sexsolve_kernel(blitsolve_e isa){
+  switch(isa){
+    case BLITSOLVE_SCALAR:
+      return sexsolve_scalar;
+#ifdef BLITSOLVE_X86
+    case BLITSOLVE_SSE41:
+      if(__builtin_cpu_supports("sse4.1")){
+        return sexsolve_sse41;
+      }
+      break;
+    case BLITSOLVE_AVX2:
+      if(__builtin_cpu_supports("avx2")){
+        return sexsolve_avx2;
+      }
+      break;
+#else
+    default:
+      break;
+#endif
+  }
+  return NULL;
+}
+
+// the fastest sextant solver supported by this processor
+static sexsolve_fxn
+sexsolve_best(void){
+  sexsolve_fxn ret;
+  if( (ret = sexsolve_kernel(BLITSOLVE_AVX2)) ){
+    return ret;
+  }
+  if( (ret = sexsolve_kernel(BLITSOLVE_SSE41)) ){
+    return ret;
+  }
+  return sexsolve_kernel(BLITSOLVE_SCALAR);
+}
+
 // sextant blitter. maps 3x2 to each cell. since we only have two colors at
 // our disposal (foreground and background), we lose some fidelity.
 static inline int
@@ -659,17 +1353,35 @@ sextant_blit(ncplane* nc, int linesize, const void* data,
   ncplane_dim_yx(nc, &dimy, &dimx);
 //fprintf(stderr, "sexblitter %dx%d -> %d/%d+%d/%d\n", leny, lenx, dimy, dimx, bargs->u.cell.placey, bargs->u.cell.placex);
   const unsigned char* dat = data;
+  const int xstart = bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex;
+  // as in quadrant_blit(), solve complete cells a row at a time
+  blitsolve_scratch scratch;
+  if(blitsolve_scratch_init(&scratch, bargs, xstart, lenx, dimx)){
+    return -1;
+  }
+  const sexsolve_fxn solve = sexsolve_best();
   int visy = bargs->begy;
   for(y = bargs->u.cell.placey ; visy < (bargs->begy + leny) && y < dimy ; ++y, visy += 3){
     if(y < 0){
       continue;
     }
-    if(ncplane_cursor_move_yx(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex)){
+    if(blit_cursor_move(nc, y, xstart, bargs)){
+      blitsolve_scratch_free(&scratch);
       return -1;
     }
+    if(blit_row_unchanged(bargs, y)){
+      continue;
+    }
+    int solved = 0;
+    if(scratch.n && visy < bargs->begy + leny - 2){
+      const unsigned char* top = dat + (linesize * visy) + (scratch.visx * bpp / CHAR_BIT);
+      const unsigned char* const rows[3] = { top, top + linesize, top + linesize * 2, };
+      solve(rows, scratch.n, scratch.egcs, scratch.fg, scratch.bg);
+      solved = scratch.n;
+    }
     int visx = bargs->begx;
     for(x = bargs->u.cell.placex ; visx < (bargs->begx + lenx) && x < dimx ; ++x, visx += 2){
-      if(x < 0){
+      if(x < 0 || blit_unchanged(bargs, y, x)){
         continue;
       }
       uint32_t rgbas[6] = { 0, 0, 0, 0, 0, 0 };
@@ -690,22 +1402,41 @@ sextant_blit(ncplane* nc, int linesize, const void* data,
         }
       }
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        blitsolve_scratch_free(&scratch);
+        return -1;
+      }
       c->channels = 0;
       c->stylemask = 0;
       const char* egc = sex_trans_check(c, rgbas, bargs->u.cell.blendcolors, bargs->transcolor);
       if(egc == NULL){ // no transparency; run a full solver
-        egc = sex_solver(rgbas, &c->channels, bargs->u.cell.blendcolors);
+        uint32_t fg, bg;
+        if(x - xstart < solved){
+          egc = sextant_egcs[scratch.egcs[x - xstart]];
+          fg = scratch.fg[x - xstart];
+          bg = scratch.bg[x - xstart];
+        }else{
+          egc = sextant_egcs[sex_solver(rgbas, &fg, &bg)];
+        }
+        cell_set_fchannel(c, fg);
+        cell_set_bchannel(c, bg);
+        if(bargs->u.cell.blendcolors){
+          nccell_set_bg_alpha(c, CELL_ALPHA_BLEND);
+          nccell_set_fg_alpha(c, CELL_ALPHA_BLEND);
+        }
         cell_set_blitquadrants(c, 1, 1, 1, 1);
       }
 //fprintf(stderr, "sex EGC: %s channels: %016lx\n", egc, c->channels);
       if(*egc){
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
+        if(blit_egc(nc, c, egc, strlen(egc), bargs) <= 0){
+          blitsolve_scratch_free(&scratch);
           return -1;
         }
         ++total;
       }
     }
   }
+  blitsolve_scratch_free(&scratch);
   return total;
 }
 
@@ -738,12 +1469,15 @@ braille_blit(ncplane* nc, int linesize, const void* data,
     if(y < 0){
       continue;
     }
-    if(ncplane_cursor_move_yx(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex)){
+    if(blit_cursor_move(nc, y, bargs->u.cell.placex < 0 ? 0 : bargs->u.cell.placex, bargs)){
       return -1;
     }
+    if(blit_row_unchanged(bargs, y)){
+      continue;
+    }
     int visx = bargs->begx;
     for(x = bargs->u.cell.placex ; visx < (bargs->begx + lenx) && x < dimx ; ++x, visx += 2){
-      if(x < 0){
+      if(x < 0 || blit_unchanged(bargs, y, x)){
         continue;
       }
       const uint32_t* rgbbase_l0 = (const uint32_t*)(dat + (linesize * visy) + (visx * bpp / CHAR_BIT));
@@ -813,6 +1547,9 @@ braille_blit(ncplane* nc, int linesize, const void* data,
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
+      if(c == NULL){
+        return -1;
+      }
       // use the default for the background, as that's the only way it's
       // effective in that case anyway
       c->channels = 0;
@@ -836,7 +1573,7 @@ braille_blit(ncplane* nc, int linesize, const void* data,
         char egc[4] = { 0xe2, 0xa0, 0x80, 0x00 };
         egc[2] += egcidx % 64;
         egc[1] += egcidx / 64;
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
+        if(blit_egc(nc, c, egc, strlen(egc), bargs) <= 0){
           return -1;
         }
       }
@@ -846,6 +1583,345 @@ braille_blit(ncplane* nc, int linesize, const void* data,
   return total;
 }
 
+// a parallel blit, split into bands of cell rows. each band is blitted as a
+// job of the workpool, into its own blitstage.
+typedef struct blitbands {
+  ncplane* n;
+  const struct blitset* bset;
+  int linesize;
+  const void* data;
+  int leny, lenx;
+  const blitterargs* bargs;
+  int rows;          // rows of cells in the blit, from placey
+  unsigned bands;
+  blitstage* stages; // one per band
+} blitbands;
+
+static void
+blit_band(void* vbb, unsigned band){
+  blitbands* bb = vbb;
+  const int height = bb->bset->height;
+  const int r0 = bb->rows * band / bb->bands;
+  const int r1 = bb->rows * (band + 1) / bb->bands;
+  blitterargs bargs = *bb->bargs;
+  bargs.begy += r0 * height;
+  bargs.u.cell.placey += r0;
+  bargs.u.cell.stage = &bb->stages[band];
+  int leny = bb->leny - r0 * height;
+  if(leny > (r1 - r0) * height){
+    leny = (r1 - r0) * height;
+  }
+  bb->stages[band].total = bb->bset->blit(bb->n, bb->linesize, bb->data,
+                                          leny, bb->lenx, &bargs);
+}
+
+// can this blitter be split into bands? each must advance exactly 'height'
+// rows of pixels per row of cells.
+static inline bool
+blit_bandable(const struct blitset* bset){
+  switch(bset->geom){
+    case NCBLIT_1x1: case NCBLIT_2x1: case NCBLIT_2x2:
+    case NCBLIT_3x2: case NCBLIT_BRAILLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// blit cells, in bands across the workpool if the blit is large enough
+static int
+blit_cells(ncplane* n, const struct blitset* bset, int linesize,
+           const void* data, int leny, int lenx, const blitterargs* bargs){
+  const ncpile* pile = ncplane_pile(n);
+  notcurses* nc = pile ? pile->nc : NULL;
+  if(nc == NULL || nc->workpool == NULL || nc->blitthreshold == 0 ||
+     bargs->u.cell.stage || !blit_bandable(bset)){
+    return bset->blit(n, linesize, data, leny, lenx, bargs);
+  }
+  const int placey = bargs->u.cell.placey;
+  const int placex = bargs->u.cell.placex;
+  int rows = leny / bset->height + !!(leny % bset->height);
+  if(rows > n->leny - placey){
+    rows = n->leny - placey;
+  }
+  int cols = lenx / bset->width + !!(lenx % bset->width);
+  if(cols > n->lenx - placex){
+    cols = n->lenx - placex;
+  }
+  const int y0 = placey < 0 ? 0 : placey;
+  const int x0 = placex < 0 ? 0 : placex;
+  // a delta blit only does the work of the cells it's to write
+  const blitdelta* bd = bargs->u.cell.bdelta;
+  const int64_t cells = bd ? bd->writes : (int64_t)(placey + rows - y0) * (placex + cols - x0);
+  if(rows < 2 || placey + rows <= y0 || placex + cols <= x0 ||
+     cells < nc->blitthreshold){
+    return bset->blit(n, linesize, data, leny, lenx, bargs);
+  }
+  unsigned bands = nc->workpool->threads + 1;
+  if(bands > (unsigned)rows){
+    bands = rows;
+  }
+  blitstage* stages = calloc(bands, sizeof(*stages));
+  if(stages == NULL){
+    return bset->blit(n, linesize, data, leny, lenx, bargs);
+  }
+  // allocate any storage, and mark the rows dirty, before the bands run. the
+  // bands' own such calls are then free of side effects. a delta blit has
+  // already done so for each cell it's to write.
+  if(bd == NULL){
+    for(int y = y0 ; y < placey + rows ; ++y){
+      if(ncplane_row(n, y) == NULL){
+        free(stages);
+        return -1;
+      }
+    }
+    ncplane_dirty_rows(n, y0, placey + rows - y0);
+  }
+  for(unsigned b = 0 ; b < bands ; ++b){
+    stages[b].lasty = stages[b].lastx = -1;
+  }
+  blitbands bb = {
+    .n = n,
+    .bset = bset,
+    .linesize = linesize,
+    .data = data,
+    .leny = leny,
+    .lenx = lenx,
+    .bargs = bargs,
+    .rows = rows,
+    .bands = bands,
+    .stages = stages,
+  };
+  workpool_run(nc->workpool, bands, blit_band, &bb);
+  // write the staged EGCs in band order, and leave the cursor where a serial
+  // blit would have
+  int total = 0;
+  for(unsigned b = 0 ; b < bands ; ++b){
+    blitstage* bs = &stages[b];
+    if(bs->total < 0){
+      total = -1;
+    }else if(total >= 0){
+      total += bs->total;
+    }
+    for(unsigned i = 0 ; i < bs->count ; ++i){
+      stagedegc* se = &bs->cells[i];
+      if(total >= 0 && pool_blit_direct(&n->pool, se->c, se->egc, se->bytes, 1) < 0){
+        total = -1;
+      }
+      free(se->egc);
+    }
+    free(bs->cells);
+    if(bs->lasty >= 0){
+      n->y = bs->lasty;
+      n->x = bs->lastx;
+    }
+  }
+  free(stages);
+  pthread_mutex_lock(&nc->statlock);
+  ++nc->stats.parallel_blits;
+  pthread_mutex_unlock(&nc->statlock);
+  return total;
+}
+
+// hash the source pixels of the cell at row 'r', column 'c' of the blit
+// (relative to its placement). pixels beyond the source aren't included.
+static inline uint64_t
+blitdelta_hash(const struct blitset* bset, int linesize, const unsigned char* dat,
+               int leny, int lenx, const blitterargs* bargs, int r, int c){
+  const int visy = bargs->begy + r * bset->height;
+  const int visx = bargs->begx + c * bset->width;
+  int ylim = visy + bset->height;
+  if(ylim > bargs->begy + leny){
+    ylim = bargs->begy + leny;
+  }
+  int xlim = visx + bset->width;
+  if(xlim > bargs->begx + lenx){
+    xlim = bargs->begx + lenx;
+  }
+  uint64_t h = 0xcbf29ce484222325ull;
+  for(int y = visy ; y < ylim ; ++y){
+    const unsigned char* row = dat + linesize * y;
+    for(int x = visx ; x < xlim ; ++x){
+      uint32_t px;
+      memcpy(&px, row + x * 4, sizeof(px));
+      h = (h ^ px) * 0x100000001b3ull;
+    }
+  }
+  return h ^ (h >> 29);
+}
+
+static inline bool
+blitdelta_same(const nccell* c, const nccell* was){
+  return c->gcluster == was->gcluster && c->channels == was->channels &&
+         c->stylemask == was->stylemask && c->width == was->width &&
+         c->gcluster_backstop == was->gcluster_backstop && cell_simple_p(c);
+}
+
+// clear any cells of the previous delta blit's region lying outside the
+// region [y0, y0 + rows) x [x0, x0 + cols) of the coming one
+static int
+blitdelta_vacate(ncplane* n, const blitdelta* bd, int y0, int x0, int rows, int cols){
+  for(int y = bd->y0 ; y < bd->y0 + bd->rows && y < n->leny ; ++y){
+    const bool inrows = y >= y0 && y < y0 + rows;
+    for(int x = bd->x0 ; x < bd->x0 + bd->cols && x < n->lenx ; ++x){
+      if(inrows && x >= x0 && x < x0 + cols){
+        continue;
+      }
+      nccell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c == NULL){
+        return -1;
+      }
+      nccell_release(n, c);
+      nccell_init(c);
+    }
+  }
+  return 0;
+}
+
+// prepare a delta blit into 'n', hashing each cell's source pixels to
+// determine which cells must be written. those cells are cleared, just as
+// ncplane_erase() would have, as are those of the previous delta blit which
+// this one won't cover. returns NULL on allocation failure.
+static blitdelta*
+blitdelta_prep(ncplane* n, const struct blitset* bset, int linesize,
+               const void* data, int leny, int lenx, const blitterargs* bargs){
+  const int placey = bargs->u.cell.placey;
+  const int placex = bargs->u.cell.placex;
+  const int y0 = placey < 0 ? 0 : placey;
+  const int x0 = placex < 0 ? 0 : placex;
+  int yend = placey + leny / bset->height + !!(leny % bset->height);
+  if(yend > n->leny){
+    yend = n->leny;
+  }
+  int xend = placex + lenx / bset->width + !!(lenx % bset->width);
+  if(xend > n->lenx){
+    xend = n->lenx;
+  }
+  const int rows = yend > y0 ? yend - y0 : 0;
+  const int cols = xend > x0 ? xend - x0 : 0;
+  blitdelta* bd = n->blitdelta;
+  bool fresh = bd == NULL || !bd->valid || bd->geom != bset->geom ||
+               bd->placey != placey || bd->placex != placex ||
+               bd->begy != bargs->begy || bd->begx != bargs->begx ||
+               bd->leny != leny || bd->lenx != lenx ||
+               bd->transcolor != bargs->transcolor ||
+               bd->blendcolors != bargs->u.cell.blendcolors ||
+               bd->rows != rows || bd->cols != cols;
+  if(fresh && bd && bd->valid){
+    if(blitdelta_vacate(n, bd, y0, x0, rows, cols)){
+      return NULL;
+    }
+  }
+  const size_t count = (size_t)rows * cols;
+  const size_t need = sizeof(*bd) + count * (sizeof(*bd->hashes) + sizeof(*bd->cells) +
+                                             sizeof(*bd->redraw)) + rows;
+  if(bd == NULL || bd->alloc < need){
+    if((bd = realloc(n->blitdelta, need)) == NULL){
+      return NULL;
+    }
+    n->blitdelta = bd;
+    bd->alloc = need;
+    fresh = true;
+  }
+  bd->hashes = (uint64_t*)(bd + 1);
+  bd->cells = (nccell*)(bd->hashes + count);
+  bd->redraw = (unsigned char*)(bd->cells + count);
+  bd->rowredraw = bd->redraw + count;
+  if(fresh){
+    bd->geom = bset->geom;
+    bd->placey = placey;
+    bd->placex = placex;
+    bd->begy = bargs->begy;
+    bd->begx = bargs->begx;
+    bd->leny = leny;
+    bd->lenx = lenx;
+    bd->transcolor = bargs->transcolor;
+    bd->blendcolors = bargs->u.cell.blendcolors;
+    bd->y0 = y0;
+    bd->x0 = x0;
+    bd->rows = rows;
+    bd->cols = cols;
+  }
+  bd->valid = false; // until the blit has succeeded
+  bd->writes = 0;
+  for(int r = 0 ; r < rows ; ++r){
+    const nccell* row = ncplane_row_const(n, y0 + r);
+    bd->rowredraw[r] = 0;
+    for(int c = 0 ; c < cols ; ++c){
+      const size_t i = (size_t)r * cols + c;
+      const uint64_t h = blitdelta_hash(bset, linesize, data, leny, lenx, bargs,
+                                        y0 + r - placey, x0 + c - placex);
+      bd->redraw[i] = fresh || h != bd->hashes[i] ||
+                      !blitdelta_same(&row[x0 + c], &bd->cells[i]);
+      bd->hashes[i] = h;
+      if(bd->redraw[i]){
+        nccell* cl = ncplane_cell_ref_yx(n, y0 + r, x0 + c);
+        if(cl == NULL){
+          return NULL;
+        }
+        nccell_release(n, cl);
+        nccell_init(cl);
+        bd->rowredraw[r] = 1;
+        ++bd->writes;
+      }
+    }
+  }
+  return bd;
+}
+
+// remember the cells written by a successful delta blit
+static void
+blitdelta_record(const ncplane* n, blitdelta* bd){
+  for(int r = 0 ; r < bd->rows ; ++r){
+    if(!bd->rowredraw[r]){
+      continue;
+    }
+    const nccell* row = ncplane_row_const(n, bd->y0 + r);
+    for(int c = 0 ; c < bd->cols ; ++c){
+      const size_t i = (size_t)r * bd->cols + c;
+      if(bd->redraw[i]){
+        bd->cells[i] = row[bd->x0 + c];
+      }
+    }
+  }
+  bd->valid = true;
+}
+
+int cell_blit_dispatch(ncplane* n, const struct blitset* bset,
+                       int linesize, const void* data,
+                       int leny, int lenx, const blitterargs* bargs){
+  if(!bargs->u.cell.delta || bargs->u.cell.bdelta ||
+     !delta_blit_p(bset->geom, NCVISUAL_OPTION_DELTA)){
+    return blit_cells(n, bset, linesize, data, leny, lenx, bargs);
+  }
+  blitdelta* bd = blitdelta_prep(n, bset, linesize, data, leny, lenx, bargs);
+  if(bd == NULL){
+    return -1;
+  }
+  blitterargs dargs = *bargs;
+  dargs.u.cell.bdelta = bd;
+  const int total = blit_cells(n, bset, linesize, data, leny, lenx, &dargs);
+  if(total < 0){
+    return total;
+  }
+  blitdelta_record(n, bd);
+  const ncpile* pile = ncplane_pile(n);
+  if(pile && pile->nc){
+    notcurses* nc = pile->nc;
+    pthread_mutex_lock(&nc->statlock);
+    nc->stats.blitelisions += (int64_t)bd->rows * bd->cols - bd->writes;
+    nc->stats.blitemissions += bd->writes;
+    pthread_mutex_unlock(&nc->statlock);
+  }
+  return total;
+}
+
+unsigned notcurses_set_blit_threshold(notcurses* nc, unsigned cells){
+  unsigned ret = nc->blitthreshold;
+  nc->blitthreshold = cells;
+  return ret;
+}
+
 // NCBLIT_DEFAULT is not included, as it has no defined properties. It ought
 // be replaced with some real blitter implementation by the calling widget.
 static struct blitset notcurses_blitters[] = {
@@ -975,7 +2051,8 @@ int ncblit_bgrx(const void* data, int linesize, const struct ncvisual_options* v
 }
 
 int ncblit_rgba(const void* data, int linesize, const struct ncvisual_options* vopts){
-  if(vopts->flags > NCVISUAL_OPTION_BLEND){
+  if(vopts->flags & ~(NCVISUAL_OPTION_NODEGRADE | NCVISUAL_OPTION_BLEND |
+                      NCVISUAL_OPTION_DELTA)){
     fprintf(stderr, "Warning: unknown ncvisual options %016jx\n", (uintmax_t)vopts->flags);
   }
   if(linesize <= 0 || (size_t)linesize < vopts->lenx * sizeof(uint32_t)){
@@ -1011,10 +2088,11 @@ int ncblit_rgba(const void* data, int linesize, const struct ncvisual_options* v
         .placey = vopts->y,
         .placex = vopts->x,
         .blendcolors = (vopts->flags & NCVISUAL_OPTION_BLEND),
+        .delta = (vopts->flags & NCVISUAL_OPTION_DELTA),
       },
     },
   };
-  return bset->blit(nc, linesize, data, leny, lenx, &bargs);
+  return rgba_blit_dispatch(nc, bset, linesize, data, leny, lenx, &bargs);
 }
 
 ncblitter_e ncvisual_media_defblitter(const notcurses* nc, ncscale_e scale){
@@ -0,0 +1,108 @@
+#include "internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DAMAGESCAN_X86
+#include <immintrin.h>
+#endif
+
+// postpaint() must see any cell which is flagged for high contrast (it has yet
+// to be locked in), already damaged (we need record it in the damage map), or
+// which spills its EGC into the plane's pool (the index is meaningless when
+// compared against lastframe's pool). everything else is a plain cell, and
+// is undamaged iff it is bitwise identical to its lastframe counterpart.
+// lastframe never holds transparent channels, so such a match further implies
+// that lock_in_highcontrast() would be a no-op.
+static inline bool
+damagescan_plain_p(const struct crender* r, const nccell* c){
+  return !r->s.damaged && !r->s.highcontrast && !cell_extended_p(c);
+}
+
+static int
+damagescan_scalar(const struct crender* crender, const nccell* cells,
+                  const nccell* lastframe, int n){
+  int i;
+  for(i = 0 ; i < n ; ++i){
+    if(!damagescan_plain_p(&crender[i], &cells[i])){
+      break;
+    }
+    if(memcmp(&cells[i], &lastframe[i], sizeof(*lastframe))){
+      break;
+    }
+  }
+  return i;
+}
+
+#ifdef DAMAGESCAN_X86
+// each nccell is 16 bytes, so SSE2 compares one cell per operation, and AVX2
+// compares two.
+__attribute__((target("sse2"))) static int
+damagescan_sse2(const struct crender* crender, const nccell* cells,
+                const nccell* lastframe, int n){
+  int i;
+  for(i = 0 ; i < n ; ++i){
+    if(!damagescan_plain_p(&crender[i], &cells[i])){
+      break;
+    }
+    __m128i r = _mm_loadu_si128((const __m128i*)&cells[i]);
+    __m128i l = _mm_loadu_si128((const __m128i*)&lastframe[i]);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(r, l)) != 0xffff){
+      break;
+    }
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static int
+damagescan_avx2(const struct crender* crender, const nccell* cells,
+                const nccell* lastframe, int n){
+  int i;
+  for(i = 0 ; i + 1 < n ; i += 2){
+    if(!damagescan_plain_p(&crender[i], &cells[i]) ||
+       !damagescan_plain_p(&crender[i + 1], &cells[i + 1])){
+      break;
+    }
+    __m256i r = _mm256_loadu_si256((const __m256i*)&cells[i]);
+    __m256i l = _mm256_loadu_si256((const __m256i*)&lastframe[i]);
+    if((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, l)) != 0xffffffffu){
+      break;
+    }
+  }
+  // the scalar kernel determines which cell of a failed pair stopped us, and
+  // handles any odd cell at the end.
+  return i + damagescan_scalar(crender + i, cells + i, lastframe + i, n - i);
+}
+#endif
+
+damagescan_fxn damagescan_kernel(damagescan_e isa){
+  switch(isa){
+    case DAMAGESCAN_SCALAR:
+      return damagescan_scalar;
+#ifdef DAMAGESCAN_X86
+    case DAMAGESCAN_SSE2:
+      if(__builtin_cpu_supports("sse2")){
+        return damagescan_sse2;
+      }
+      break;
+    case DAMAGESCAN_AVX2:
+      if(__builtin_cpu_supports("avx2")){
+        return damagescan_avx2;
+      }
+      break;
+#else
+    default:
+      break;
+#endif
+  }
+  return NULL;
+}
+
+damagescan_fxn damagescan_best(void){
+  damagescan_fxn ret;
+  if( (ret = damagescan_kernel(DAMAGESCAN_AVX2)) ){
+    return ret;
+  }
+  if( (ret = damagescan_kernel(DAMAGESCAN_SSE2)) ){
+    return ret;
+  }
+  return damagescan_kernel(DAMAGESCAN_SCALAR);
+}
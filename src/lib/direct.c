@@ -1163,7 +1163,13 @@ int ncdirect_stream(ncdirect* n, const char* filename, ncstreamcb streamer,
     ncdirect_raster_frame(n, v, (vopts->flags & NCVISUAL_OPTION_HORALIGNED) ? vopts->x : 0);
     if(lastid > -1){
       if(n->tcache.pixel_remove){
-        if(n->tcache.pixel_remove(lastid, n->ttyfp)){
+        fbuf f = {};
+        if(n->tcache.pixel_remove(lastid, &f)){
+          fbuf_free(&f);
+          ncvisual_destroy(ncv);
+          return -1;
+        }
+        if(fbuf_finalize(&f, n->ttyfp)){
           ncvisual_destroy(ncv);
           return -1;
         }
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <wctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,14 +20,40 @@ extern "C" {
 
 // cells only provide storage for a single 7-bit character. if there's anything
 // more than that, it's spilled into the egcpool, and the cell is given an
-// offset. when a cell is released, the memory it owned is zeroed out, and
-// recognizable as use for another cell.
+// offset. the pool is carved into blocks from a set of size classes: multiples
+// of four bytes up through 64, and powers of two thereafter. a released block
+// is threaded onto the free list for its class, whence it serves the next
+// cluster of that class, so both stashing and releasing are constant-time. the
+// class of a block is recovered from the length of the cluster it holds; a
+// free block is recognizable by its leading NUL, and carries the 24-bit link
+// to its successor in its next three bytes. offsets thus remain suitable for
+// nccell's 24-bit gcluster encoding.
+//
+// if 'intern' is set, identical clusters share a single block, tracked by a
+// hash table with a reference count per cluster. releases must then balance
+// stashes exactly, as is already required by the nccell API.
+
+#define EGCPOOL_SMALL_CLASSES 16 // 4, 8, ..., 64 bytes
+#define EGCPOOL_CLASSES (EGCPOOL_SMALL_CLASSES + 18) // 128, 256, ..., 16MiB
+
+typedef struct egcintern {
+  uint32_t hash;      // hash of the cluster, to avoid rehashing on moves
+  uint32_t offset;    // offset of the interned cluster in the pool
+  uint32_t refs;      // number of stashes outstanding, 0 if slot is empty
+} egcintern;
 
 typedef struct egcpool {
-  char* pool;         // ringbuffer of attached extension storage
+  char* pool;         // block storage for attached extension clusters
   int poolsize;       // total number of bytes in pool
-  int poolused;       // bytes actively used, grow when this gets too large
-  int poolwrite;      // next place to *look for* a place to write
+  int poolused;       // bytes actively used by clusters, with NUL terminators
+  int poolwrite;      // high-water mark; no block has been cut past this
+  unsigned stashes;   // outstanding stashes, counting each interned reference
+  int compactfail;    // poolsize at last failed automatic compaction
+  uint32_t freelists[EGCPOOL_CLASSES]; // first free block + 1, 0 if none
+  egcintern* interns; // open-addressed table of interned clusters, or NULL
+  unsigned internsize;  // slots in 'interns', a power of 2
+  unsigned interncount; // occupied slots in 'interns'
+  bool intern;        // share identical clusters
 } egcpool;
 
 #define POOL_MINIMUM_ALLOC BUFSIZ
@@ -37,17 +64,63 @@ egcpool_init(egcpool* p){
   memset(p, 0, sizeof(*p));
 }
 
+// size class for a block holding 'len' bytes (including the NUL terminator).
+// 'len' must not exceed POOL_MAXIMUM_BYTES.
+static inline unsigned
+egcpool_class(size_t len){
+  if(len <= 64){
+    return (len + 3) / 4 - 1;
+  }
+  unsigned bits = 32 - __builtin_clz(len - 1); // 7 for [65, 128]
+  return EGCPOOL_SMALL_CLASSES + bits - 7;
+}
+
+static inline size_t
+egcpool_class_size(unsigned sc){
+  if(sc < EGCPOOL_SMALL_CLASSES){
+    return (sc + 1) * 4;
+  }
+  return 1ul << (sc - EGCPOOL_SMALL_CLASSES + 7);
+}
+
+// place the free block at 'offset' on the free list for class 'sc'
+static inline void
+egcpool_free_push(egcpool* pool, unsigned sc, uint32_t offset){
+  unsigned char* b = (unsigned char*)pool->pool + offset;
+  uint32_t next = pool->freelists[sc];
+  b[0] = '\0';
+  b[1] = next & 0xff;
+  b[2] = (next >> 8u) & 0xff;
+  b[3] = (next >> 16u) & 0xff;
+  pool->freelists[sc] = offset + 1;
+}
+
+// take the first block from the free list for class 'sc', returning -1 if empty
+static inline int
+egcpool_free_pop(egcpool* pool, unsigned sc){
+  uint32_t head = pool->freelists[sc];
+  if(head == 0){
+    return -1;
+  }
+  const unsigned char* b = (const unsigned char*)pool->pool + head - 1;
+  pool->freelists[sc] = b[1] | ((uint32_t)b[2] << 8u) | ((uint32_t)b[3] << 16u);
+  return head - 1;
+}
+
 static inline int
 egcpool_grow(egcpool* pool, size_t len){
   size_t newsize = pool->poolsize * 2;
   if(newsize < POOL_MINIMUM_ALLOC){
     newsize = POOL_MINIMUM_ALLOC;
   }
-  while(len > newsize - pool->poolsize){ // ensure we make enough space
+  while(len > newsize - pool->poolwrite){ // ensure we make enough space
     newsize *= 2;
   }
   if(newsize > POOL_MAXIMUM_BYTES){
-    return -1;
+    if(len > POOL_MAXIMUM_BYTES - pool->poolwrite){
+      return -1;
+    }
+    newsize = POOL_MAXIMUM_BYTES;
   }
   // nasty cast here because c++ source might include this header :/
   char* tmp = (char*)realloc(pool->pool, newsize);
@@ -55,11 +128,108 @@ egcpool_grow(egcpool* pool, size_t len){
     return -1;
   }
   pool->pool = tmp;
-  memset(pool->pool + pool->poolsize, 0, newsize - pool->poolsize);
   pool->poolsize = newsize;
   return 0;
 }
 
+// the pool can't be grown to hold a block of class 'sc'. carve one from the
+// smallest larger free block, returning the remainder to the free lists in
+// blocks of the largest classes which fit. returns -1 if there are none.
+static inline int
+egcpool_split(egcpool* pool, unsigned sc){
+  for(unsigned c = sc + 1 ; c < EGCPOOL_CLASSES ; ++c){
+    int offset = egcpool_free_pop(pool, c);
+    if(offset >= 0){
+      size_t used = egcpool_class_size(sc);
+      size_t rem = egcpool_class_size(c) - used;
+      while(rem){
+        unsigned rc = rem > 64 ? egcpool_class(rem + 1) - 1 : egcpool_class(rem);
+        egcpool_free_push(pool, rc, offset + used);
+        used += egcpool_class_size(rc);
+        rem -= egcpool_class_size(rc);
+      }
+      return offset;
+    }
+  }
+  return -1;
+}
+
+// FNV-1a over the cluster's bytes
+static inline uint32_t
+egcpool_hash(const char* egc, size_t ulen){
+  uint32_t h = 2166136261lu;
+  while(ulen--){
+    h = (h ^ (unsigned char)*egc++) * 16777619lu;
+  }
+  return h;
+}
+
+// find the intern slot for 'egc' in the table, or the empty slot where it
+// would be placed. the table must exist.
+static inline egcintern*
+egcpool_intern_slot(const egcpool* pool, const char* egc, size_t ulen, uint32_t hash){
+  unsigned mask = pool->internsize - 1;
+  for(unsigned i = hash & mask ; ; i = (i + 1) & mask){
+    egcintern* e = &pool->interns[i];
+    if(e->refs == 0){
+      return e;
+    }
+    if(e->hash == hash){
+      const char* cand = pool->pool + e->offset;
+      if(strncmp(cand, egc, ulen) == 0 && cand[ulen] == '\0'){
+        return e;
+      }
+    }
+  }
+}
+
+// ensure there's room in the intern table for another entry, keeping the
+// load factor at or below 3/4.
+static inline int
+egcpool_intern_reserve(egcpool* pool){
+  if((pool->interncount + 1) * 4 <= pool->internsize * 3){
+    return 0;
+  }
+  unsigned newsize = pool->internsize ? pool->internsize * 2 : 64;
+  egcintern* tmp = (egcintern*)calloc(newsize, sizeof(*tmp));
+  if(tmp == NULL){
+    return -1;
+  }
+  for(unsigned i = 0 ; i < pool->internsize ; ++i){
+    const egcintern* e = &pool->interns[i];
+    if(e->refs){
+      unsigned j = e->hash & (newsize - 1);
+      while(tmp[j].refs){
+        j = (j + 1) & (newsize - 1);
+      }
+      tmp[j] = *e;
+    }
+  }
+  free(pool->interns);
+  pool->interns = tmp;
+  pool->internsize = newsize;
+  return 0;
+}
+
+// remove the occupied slot 'e' from the intern table, shifting back any
+// successors which would otherwise become unreachable.
+static inline void
+egcpool_intern_remove(egcpool* pool, egcintern* e){
+  unsigned mask = pool->internsize - 1;
+  unsigned hole = e - pool->interns;
+  for(unsigned i = (hole + 1) & mask ; pool->interns[i].refs ; i = (i + 1) & mask){
+    unsigned home = pool->interns[i].hash & mask;
+    // can the entry at i move into the hole? only if its home doesn't lie
+    // cyclically within (hole, i].
+    if(((i - home) & mask) >= ((i - hole) & mask)){
+      pool->interns[hole] = pool->interns[i];
+      hole = i;
+    }
+  }
+  pool->interns[hole].refs = 0;
+  --pool->interncount;
+}
+
 // Eat an EGC from the UTF-8 string input, counting bytes and columns. We use
 // libunistring's uc_is_grapheme_break() to segment EGCs. Writes the number of
 // columns to '*colcount'. Returns the number of bytes consumed, not including
@@ -98,97 +268,78 @@ utf8_egc_len(const char* gcluster, int* colcount){
   return ret;
 }
 
-// if we're inserting a EGC of |len| bytes, ought we proactively realloc?
-static inline bool
-egcpool_alloc_justified(const egcpool* pool, int len){
-  const int poolfree = pool->poolsize - pool->poolused;
-  // proactively get more space if we have less than 10% free. this doesn't
-  // guarantee that we'll have enough space to insert the string -- we could
-  // theoretically have every 10th byte free, and be unable to write even a
-  // two-byte egc -- so we might have to allocate after an expensive search :/.
-  if(poolfree >= len && poolfree * 10 > pool->poolsize){
-    return false;
-  }
-  return true;
-}
-
 // stash away the provided UTF8, NUL-terminated grapheme cluster. the cluster
 // should not be less than 2 bytes (such a cluster should be directly stored in
 // the cell). returns -1 on error, and otherwise a non-negative offset. 'ulen'
 // must be the number of bytes to lift from egc (utf8_egc_len()).
 __attribute__ ((nonnull (1, 2))) static inline int
 egcpool_stash(egcpool* pool, const char* egc, size_t ulen){
-  int len = ulen + 1; // count the NUL terminator
+  size_t len = ulen + 1; // count the NUL terminator
   if(len <= 2){ // should never be empty, nor a single byte + NUL
     return -1;
   }
-  // the first time through, we don't force a grow unless we expect ourselves
-  // to have too little space. once we've done a search, we do force the grow.
-  // we should thus never have more than two iterations of this loop.
-  bool searched = false;
-  // we might have to realloc our underlying pool. it is possible that this EGC
-  // is actually *in* that pool, in which case our pointer will be invalidated.
-  // to be safe, duplicate prior to a realloc, and free along all paths.
-  char* duplicated = NULL;
-  do{
-    if(egcpool_alloc_justified(pool, len) || searched){
-      if(!duplicated){
+  if(len > POOL_MAXIMUM_BYTES){
+    return -1;
+  }
+  egcintern* e = NULL;
+  uint32_t hash = 0;
+  if(pool->intern){
+    if(egcpool_intern_reserve(pool)){
+      return -1;
+    }
+    hash = egcpool_hash(egc, ulen);
+    e = egcpool_intern_slot(pool, egc, ulen, hash);
+    if(e->refs){
+      ++e->refs;
+      ++pool->stashes;
+      return e->offset;
+    }
+  }
+  const unsigned sc = egcpool_class(len);
+  const size_t bsize = egcpool_class_size(sc);
+  int offset = egcpool_free_pop(pool, sc);
+  if(offset < 0){
+    if(bsize > (size_t)(pool->poolsize - pool->poolwrite)){
+      // we might have to realloc our underlying pool. it is possible that this
+      // EGC is actually *in* that pool, in which case our pointer will be
+      // invalidated. to be safe, copy it out prior to a realloc.
+      char* duplicated = NULL;
+      if(egc >= pool->pool && egc < pool->pool + pool->poolsize){
         if((duplicated = strndup(egc, ulen)) == NULL){
           return -1;
         }
+        egc = duplicated;
       }
-      if(egcpool_grow(pool, len) && searched){
+      if(egcpool_grow(pool, bsize) == 0){
+        offset = pool->poolwrite;
+        pool->poolwrite += bsize;
+      }else if((offset = egcpool_split(pool, sc)) < 0){
         free(duplicated);
         return -1;
       }
-      egc = duplicated;
-    }
-    // we now look for a place to lay out this egc. we need |len| zeroes in a
-    // row. starting at pool->poolwrite, look for such a range of unused
-    // memory. if we find it, write it out, and update used count. if we come
-    // back to where we started, force a growth and try again.
-    int curpos = pool->poolwrite;
-//fprintf(stderr, "Stashing [%s] %d starting at %d\n", egc, len, curpos);
-    do{
-      if(curpos == pool->poolsize){
-        curpos = 0;
-      }
-      if(pool->pool[curpos]){ // can't write if there's stuff here
-        ++curpos;
-      }else if(curpos && pool->pool[curpos - 1]){ // don't kill someone's NUL
-        ++curpos;
-      }else if(pool->poolsize - curpos < len){ // can't wrap around
-        if(pool->poolwrite > curpos){
-          break;
-        }
-        curpos = 0; // can this skip pool->poolwrite?
-      }else{ // promising! let's see if there's enough space
-        int need = len;
-        size_t trial = curpos;
-        while(--need){
-          if(pool->pool[++trial]){ // alas, not enough space here
-            break;
-          }
-        }
-        if(need == 0){ // found a suitable space, copy it!
-          memcpy(pool->pool + curpos, egc, len - 1);
-          pool->pool[curpos + len - 1] = '\0';
-          pool->poolwrite = curpos + len;
-          pool->poolused += len;
-          free(duplicated);
-//fprintf(stderr, "Stashing AT %d\n", curpos);
-          return curpos;
-        }
-        if(pool->poolwrite > curpos && pool->poolwrite - (len - need) < curpos){
-          break;
-        }
-        curpos += len - need;
+      if(duplicated){
+        memcpy(pool->pool + offset, egc, ulen);
+        free(duplicated);
+        egc = NULL;
       }
-    }while(curpos != pool->poolwrite);
-  }while( (searched = !searched) );
-  free(duplicated);
-  assert(false);
-  return -1; // should never get here
+    }else{
+      offset = pool->poolwrite;
+      pool->poolwrite += bsize;
+    }
+  }
+  if(egc){
+    memcpy(pool->pool + offset, egc, ulen);
+  }
+  pool->pool[offset + ulen] = '\0';
+  pool->poolused += len;
+  ++pool->stashes;
+  if(e){
+    e->hash = hash;
+    e->offset = offset;
+    e->refs = 1;
+    ++pool->interncount;
+  }
+  return offset;
 }
 
 // Run a consistency check on the offset; ensure it's a valid, non-empty EGC.
@@ -218,29 +369,42 @@ egcpool_check_validity(const egcpool* pool, int offset){
   return true;
 }
 
-// remove the egc from the pool. start at offset, and zero out everything until
-// we find a zero (our own NUL terminator). remove that number of bytes from
-// the usedcount.
+// remove the egc from the pool, returning its block to the free list for its
+// class, and removing its length from the usedcount. an interned cluster is
+// only removed once its last reference is released. releasing a free block
+// is a no-op.
 static inline void
 egcpool_release(egcpool* pool, int offset){
-  size_t freed = 1; // account for free(d) NUL terminator
-  while(pool->pool[offset]){
-    pool->pool[offset] = '\0';
-    ++freed;
-    ++offset;
-    assert(offset < pool->poolsize);
+  assert(offset < pool->poolwrite);
+  if(pool->pool[offset] == '\0'){
+    return;
   }
-  pool->poolused -= freed;
-  // FIXME ought we update pool->poolwrite?
+  size_t len = strlen(pool->pool + offset) + 1;
+  --pool->stashes;
+  if(pool->interns){
+    egcintern* e = egcpool_intern_slot(pool, pool->pool + offset, len - 1,
+                                       egcpool_hash(pool->pool + offset, len - 1));
+    if(e->refs && e->offset == (uint32_t)offset){
+      if(e->refs > 1){
+        --e->refs;
+        return;
+      }
+      egcpool_intern_remove(pool, e);
+    }
+  }
+  egcpool_free_push(pool, egcpool_class(len), offset);
+  pool->poolused -= len;
 }
 
+// release all storage. whether the pool interns is a matter of policy rather
+// than contents, and is retained.
 static inline void
 egcpool_dump(egcpool* pool){
+  bool intern = pool->intern;
   free(pool->pool);
-  pool->pool = NULL;
-  pool->poolsize = 0;
-  pool->poolwrite = 0;
-  pool->poolused = 0;
+  free(pool->interns);
+  egcpool_init(pool);
+  pool->intern = intern;
 }
 
 // get the offset into the egcpool for this cell's EGC. returns meaningless and
@@ -291,13 +455,99 @@ egcpool_dup(egcpool* dst, const egcpool* src){
     return -1;
   }
   dst->pool = tmp;
+  egcintern* interns = NULL;
+  if(src->interns){
+    if((interns = (egcintern*)malloc(sizeof(*interns) * src->internsize)) == NULL){
+      return -1;
+    }
+    memcpy(interns, src->interns, sizeof(*interns) * src->internsize);
+  }
+  free(dst->interns);
+  dst->interns = interns;
+  dst->internsize = src->internsize;
+  dst->interncount = src->interncount;
+  dst->intern = src->intern;
   dst->poolsize = src->poolsize;
   dst->poolused = src->poolused;
   dst->poolwrite = src->poolwrite;
-  memcpy(dst->pool, src->pool, src->poolsize);
+  dst->stashes = src->stashes;
+  dst->compactfail = src->compactfail;
+  memcpy(dst->freelists, src->freelists, sizeof(dst->freelists));
+  memcpy(dst->pool, src->pool, src->poolwrite);
   return 0;
 }
 
+// is the pool mostly dead space? such a pool is worth compacting, unless an
+// automatic compaction has already failed at this size.
+static inline bool
+egcpool_sparse_p(const egcpool* pool){
+  return pool->poolsize > POOL_MINIMUM_ALLOC && pool->poolused * 4 < pool->poolsize
+         && pool->compactfail != pool->poolsize;
+}
+
+// rebuild 'pool' as small as possible, holding only the clusters of the cells
+// of 'spancount' spans (span i being 'lens[i]' cells at 'spans[i]', or nothing
+// if 'spans[i]' is NULL) and of 'extra' (if not NULL), and rewrite their
+// offsets. this is only safe if these cells account for every outstanding
+// stash; otherwise, some nccell elsewhere refers to the pool, and -1 is
+// returned without change (as it is on allocation failure). returns the number
+// of bytes by which the pool shrank.
+static inline int
+egcpool_compact(egcpool* pool, nccell* const* spans, const size_t* lens,
+                size_t spancount, nccell* extra){
+  unsigned refs = extra && cell_extended_p(extra);
+  for(size_t s = 0 ; s < spancount ; ++s){
+    if(spans[s]){
+      for(size_t i = 0 ; i < lens[s] ; ++i){
+        refs += cell_extended_p(&spans[s][i]);
+      }
+    }
+  }
+  if(refs != pool->stashes){
+    return -1;
+  }
+  egcpool newpool;
+  egcpool_init(&newpool);
+  newpool.intern = pool->intern;
+  uint32_t* offsets = NULL;
+  if(refs && (offsets = (uint32_t*)malloc(sizeof(*offsets) * refs)) == NULL){
+    return -1;
+  }
+  // 'extra' is handled as a final span of one cell
+  unsigned o = 0;
+  for(size_t s = 0 ; s <= spancount ; ++s){
+    const nccell* span = s < spancount ? spans[s] : extra;
+    const size_t len = s < spancount ? lens[s] : 1;
+    for(size_t i = 0 ; span && i < len ; ++i){
+      if(cell_extended_p(&span[i])){
+        const char* egc = egcpool_extended_gcluster(pool, &span[i]);
+        int off = egcpool_stash(&newpool, egc, strlen(egc));
+        if(off < 0){
+          free(offsets);
+          egcpool_dump(&newpool);
+          return -1;
+        }
+        offsets[o++] = off;
+      }
+    }
+  }
+  o = 0;
+  for(size_t s = 0 ; s <= spancount ; ++s){
+    nccell* span = s < spancount ? spans[s] : extra;
+    const size_t len = s < spancount ? lens[s] : 1;
+    for(size_t i = 0 ; span && i < len ; ++i){
+      if(cell_extended_p(&span[i])){
+        span[i].gcluster = htole(0x01000000ul) + htole(offsets[o++]);
+      }
+    }
+  }
+  free(offsets);
+  int reclaimed = pool->poolsize - newpool.poolsize;
+  egcpool_dump(pool);
+  *pool = newpool;
+  return reclaimed;
+}
+
 #ifdef __cplusplus
 }
 #endif
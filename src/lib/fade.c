@@ -34,8 +34,9 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   uint64_t channels;
   int y, x;
   for(y = 0 ; y < pp->rows ; ++y){
+    const nccell* row = ncplane_row_const(n, y);
     for(x = 0 ; x < pp->cols ; ++x){
-      channels = n->fb[nfbcellidx(n, y, x)].channels;
+      channels = row[x].channels;
       pp->channels[y * pp->cols + x] = channels;
       ncchannels_fg_rgb8(channels, &r, &g, &b);
       if(r > pp->maxr){
@@ -113,13 +114,19 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
   // possibility of a resize event :/
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
+  ncplane_dirty(n);
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
+    // unwritten rows of sparse planes have only default channels
+    nccell* row = ncplane_row_extant(n, y);
+    if(row == NULL){
+      continue;
+    }
     for(x = 0 ; x < nctx->cols && x < dimx; ++x){
       unsigned r, g, b;
       ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
       unsigned br, bg, bb;
       ncchannels_bg_rgb8(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-      nccell* c = &n->fb[dimx * y + x];
+      nccell* c = &row[x];
       if(!nccell_fg_default_p(c)){
         r = r * iter / nctx->maxsteps;
         g = g * iter / nctx->maxsteps;
@@ -180,9 +187,14 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
   // possibility of a resize event :/
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
+  ncplane_dirty(n);
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
+    nccell* row = ncplane_row_extant(n, y);
+    if(row == NULL){
+      continue;
+    }
     for(x = 0 ; x < nctx->cols && x < dimx; ++x){
-      nccell* c = &n->fb[dimx * y + x];
+      nccell* c = &row[x];
       if(!nccell_fg_default_p(c)){
         ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
         r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
@@ -0,0 +1,184 @@
+#ifndef NOTCURSES_FBUF
+#define NOTCURSES_FBUF
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a growable output buffer, into which escapes and glyphs are rasterized. it
+// replaces a POSIX memstream, avoiding stdio's locking and formatting on every
+// write. the buffer is never NUL-terminated; 'used' is its length. a zeroed
+// fbuf is empty and valid, and acquires storage on first write.
+typedef struct fbuf {
+  char* buf;
+  size_t size;    // bytes allocated for buf
+  size_t used;    // bytes written to buf
+} fbuf;
+
+#define FBUF_MINSIZE 64
+
+// ensure that at least 'n' more bytes can be written to 'f' without growing.
+// returns -1 on allocation failure, in which case 'f' is unchanged.
+static inline int
+fbuf_reserve(fbuf* f, size_t n){
+  if(f->size - f->used >= n){
+    return 0;
+  }
+  size_t size = f->size ? f->size : FBUF_MINSIZE;
+  while(size - f->used < n){
+    if(size * 2 < size){
+      return -1;
+    }
+    size *= 2;
+  }
+  char* tmp = (char*)realloc(f->buf, size); // cast for C++ callers
+  if(tmp == NULL){
+    return -1;
+  }
+  f->buf = tmp;
+  f->size = size;
+  return 0;
+}
+
+// discard anything written, retaining the storage
+static inline void
+fbuf_reset(fbuf* f){
+  f->used = 0;
+}
+
+static inline int
+fbuf_putc(fbuf* f, char c){
+  if(f->used == f->size && fbuf_reserve(f, 1)){
+    return -1;
+  }
+  f->buf[f->used++] = c;
+  return 0;
+}
+
+static inline int
+fbuf_putn(fbuf* f, const char* s, size_t len){
+  if(fbuf_reserve(f, len)){
+    return -1;
+  }
+  memcpy(f->buf + f->used, s, len);
+  f->used += len;
+  return 0;
+}
+
+static inline int
+fbuf_puts(fbuf* f, const char* s){
+  return fbuf_putn(f, s, strlen(s));
+}
+
+// write the decimal representation of 'u'. this is the hot path for
+// coordinates and RGB components, so we avoid printf() machinery.
+static inline int
+fbuf_putuint(fbuf* f, unsigned u){
+  char digits[10];
+  unsigned dcount = 0;
+  do{
+    digits[dcount++] = '0' + u % 10;
+    u /= 10;
+  }while(u);
+  if(fbuf_reserve(f, dcount)){
+    return -1;
+  }
+  while(dcount){
+    f->buf[f->used++] = digits[--dcount];
+  }
+  return 0;
+}
+
+static inline int
+fbuf_putint(fbuf* f, int i){
+  if(i < 0){
+    if(fbuf_putc(f, '-')){
+      return -1;
+    }
+    return fbuf_putuint(f, -(unsigned)i);
+  }
+  return fbuf_putuint(f, i);
+}
+
+// formatted output, for the cold paths which need it
+__attribute__ ((format (printf, 2, 3)))
+static inline int
+fbuf_printf(fbuf* f, const char* fmt, ...){
+  va_list va;
+  va_start(va, fmt);
+  int len = vsnprintf(f->buf ? f->buf + f->used : NULL, f->size - f->used, fmt, va);
+  va_end(va);
+  if(len < 0){
+    return -1;
+  }
+  if((size_t)len >= f->size - f->used){
+    if(fbuf_reserve(f, len + 1)){
+      return -1;
+    }
+    va_start(va, fmt);
+    len = vsnprintf(f->buf + f->used, f->size - f->used, fmt, va);
+    va_end(va);
+    if(len < 0){
+      return -1;
+    }
+  }
+  f->used += len;
+  return 0;
+}
+
+// write the escape 'seq', which ought have been checked for NULL by the
+// caller. returns -1 if it wasn't.
+static inline int
+fbuf_emit(fbuf* f, const char* seq){
+  if(seq == NULL){
+    return -1;
+  }
+  return fbuf_puts(f, seq);
+}
+
+// write the contents of 'f' to 'fp' and flush it, resetting 'f'. returns -1
+// on a write error, in which case 'f' is left intact.
+static inline int
+fbuf_flush(fbuf* f, FILE* fp){
+  if(f->used){
+    if(fwrite(f->buf, f->used, 1, fp) != 1){
+      return -1;
+    }
+  }
+  while(fflush(fp) == EOF){
+    if(errno != EAGAIN && errno != EINTR && errno != EBUSY){
+      return -1;
+    }
+  }
+  f->used = 0;
+  return 0;
+}
+
+static inline void
+fbuf_free(fbuf* f){
+  free(f->buf);
+  f->buf = NULL;
+  f->size = 0;
+  f->used = 0;
+}
+
+// flush 'f' to 'fp' and release it, for one-shot buffers
+static inline int
+fbuf_finalize(fbuf* f, FILE* fp){
+  int ret = fbuf_flush(f, fp);
+  fbuf_free(f);
+  return ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
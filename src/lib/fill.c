@@ -1,9 +1,15 @@
 #include "internal.h"
 
 void ncplane_greyscale(ncplane *n){
+  ncplane_dirty(n);
   for(int y = 0 ; y < n->leny ; ++y){
+    // unwritten rows of sparse planes have only default channels
+    nccell* row = ncplane_row_extant(n, y);
+    if(row == NULL){
+      continue;
+    }
     for(int x = 0 ; x < n->lenx ; ++x){
-      nccell* c = &n->fb[nfbcellidx(n, y, x)];
+      nccell* c = &row[x];
       unsigned r, g, b;
       nccell_fg_rgb8(c, &r, &g, &b);
       int gy = rgb_greyscale(r, g, b);
@@ -28,16 +34,20 @@ ncplane_polyfill_recurse(ncplane* n, int y, int x, const nccell* c, const char*
   if(y < 0 || x < 0){
     return 0; // not fillable
   }
-  nccell* cur = &n->fb[nfbcellidx(n, y, x)];
-  if(cell_sprixel_p(cur)){
+  const nccell* ccur = ncplane_cell_const(n, y, x);
+  if(cell_sprixel_p(ccur)){
     logerror(nc, "Won't polyfill a sprixel at %d/%d\n", y, x);
     return -1;
   }
-  const char* glust = nccell_extended_gcluster(n, cur);
+  const char* glust = nccell_extended_gcluster(n, ccur);
 //fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, glust, filltarg);
   if(strcmp(glust, filltarg)){
     return 0;
   }
+  nccell* cur = ncplane_cell_ref_yx(n, y, x);
+  if(cur == NULL){
+    return -1;
+  }
   if(nccell_duplicate(n, cur, c) < 0){
     return -1;
   }
@@ -73,7 +83,7 @@ int ncplane_polyfill_yx(ncplane* n, int y, int x, const nccell* c){
       if(y < 0 || x < 0){
         return -1; // not fillable
       }
-      const nccell* cur = &n->fb[nfbcellidx(n, y, x)];
+      const nccell* cur = ncplane_cell_const(n, y, x);
       const char* targ = nccell_extended_gcluster(n, cur);
       const char* fillegc = nccell_extended_gcluster(n, c);
 //fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, targ, fillegc);
@@ -183,6 +193,9 @@ int ncplane_highgradient(ncplane* n, uint32_t ul, uint32_t ur,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       nccell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->channels = 0;
       if(pool_blit_direct(&n->pool, targc, "▀", strlen("▀"), 1) <= 0){
         return -1;
@@ -256,6 +269,9 @@ int ncplane_gradient(ncplane* n, const char* egc, uint32_t stylemask,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       nccell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->channels = 0;
       if(nccell_load(n, targc, egc) < 0){
         return -1;
@@ -298,6 +314,9 @@ int ncplane_stain(ncplane* n, int ystop, int xstop,
   for(int y = yoff ; y <= ystop ; ++y){
     for(int x = xoff ; x <= xstop ; ++x){
       nccell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       if(targc->gcluster){
         calc_gradient_channels(&targc->channels, tl, tr, bl, br,
                                y - yoff, x - xoff, ylen, xlen);
@@ -327,6 +346,9 @@ int ncplane_format(ncplane* n, int ystop, int xstop, uint32_t stylemask){
   for(int y = yoff ; y < ystop + 1 ; ++y){
     for(int x = xoff ; x < xstop + 1 ; ++x){
       nccell* targc = ncplane_cell_ref_yx(n, y, x);
+      if(targc == NULL){
+        return -1;
+      }
       targc->stylemask = stylemask;
       ++total;
     }
@@ -469,9 +491,14 @@ rotate_merge(ncplane* n, ncplane* newp){
   int ret = ncplane_resize(n, 0, 0, 0, 0, 0, 0, dimy, dimx);
   if(ret == 0){
     for(int y = 0 ; y < dimy ; ++y){
+      const nccell* srcrow = ncplane_row_const(newp, y);
+      nccell* targrow = ncplane_row(n, y);
+      if(targrow == NULL){
+        return -1;
+      }
       for(int x = 0 ; x < dimx ; ++x){
-        const nccell* src = &newp->fb[fbcellidx(y, dimx, x)];
-        nccell* targ = &n->fb[fbcellidx(y, dimx, x)];
+        const nccell* src = &srcrow[x];
+        nccell* targ = &targrow[x];
         if(cell_duplicate_far(&n->pool, targ, newp, src) < 0){
           return -1;
         }
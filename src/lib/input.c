@@ -461,11 +461,44 @@ ncinputlayer_prestamp(ncinputlayer* nc, const struct timespec *ts,
   return -1;
 }
 
-// infp has already been set non-blocking
+// infp has already been set non-blocking. with a target frame rate, a frame
+// deferred by notcurses_render_request() is rendered once its interval has
+// passed, the poll being cut short at its deadline if necessary, so that an
+// application blocking on input needn't deliver it.
 char32_t notcurses_getc(notcurses* nc, const struct timespec *ts,
                         const sigset_t* sigmask, ncinput* ni){
-  char32_t r = ncinputlayer_prestamp(&nc->input, ts, sigmask, ni,
-                                     nc->margin_l, nc->margin_t);
+  char32_t r;
+  if(nc->scheduler == NULL){
+    r = ncinputlayer_prestamp(&nc->input, ts, sigmask, ni,
+                              nc->margin_l, nc->margin_t);
+  }else{
+    struct timespec now, left;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t untilns = ts ? timespec_to_ns(&now) + timespec_to_ns(ts) : 0;
+    while(true){
+      uint64_t framens;
+      if(scheduler_service(nc->scheduler, &framens)){
+        logwarn(nc, "Error rendering requested frame\n");
+      }
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      const uint64_t nowns = timespec_to_ns(&now);
+      if(framens == 0 || (ts && untilns <= framens)){
+        if(ts){
+          ns_to_timespec(untilns > nowns ? untilns - nowns : 0, &left);
+        }
+        r = ncinputlayer_prestamp(&nc->input, ts ? &left : NULL, sigmask, ni,
+                                  nc->margin_l, nc->margin_t);
+        break;
+      }
+      // wake at the frame's deadline, and then return to waiting for input
+      ns_to_timespec(framens > nowns ? framens - nowns : 0, &left);
+      r = ncinputlayer_prestamp(&nc->input, &left, sigmask, ni,
+                                nc->margin_l, nc->margin_t);
+      if(r != (char32_t)-1 || errno){
+        break;
+      }
+    }
+  }
   if(r != (char32_t)-1){
     uint64_t stamp = nc->input.input_events++; // need increment even if !ni
     if(ni){
@@ -27,6 +27,7 @@ extern "C" {
 #include "notcurses/notcurses.h"
 #include "compat/compat.h"
 #include "egcpool.h"
+#include "fbuf.h"
 
 #define API __attribute__((visibility("default")))
 #define ALLOC __attribute__((malloc)) __attribute__((warn_unused_result))
@@ -200,7 +201,12 @@ typedef struct sprixel {
 // circular buffer of rows. 'logrow' is the index of the row at the logical top
 // of the plane. It only changes from 0 if the plane is scrollable.
 typedef struct ncplane {
-  nccell* fb;            // "framebuffer" of character cells
+  nccell* fb;            // "framebuffer" of character cells, NULL if sparse
+  // sparse planes (NCPLANE_OPTION_SPARSE) instead keep their virtual rows in
+  // bands of NCPLANE_TILE_ROWS, allocated only once written. unwritten bands
+  // read as zerorow, a row of zeroed cells (i.e. the base cell).
+  nccell** tiles;        // NULL unless sparse
+  nccell* zerorow;       // NULL unless sparse
   int logrow;            // logical top row, starts at 0, add one for each scroll
   int x, y;              // current cursor location within this plane
   // ncplane_yx() etc. use coordinates relative to the plane to which this
@@ -240,17 +246,33 @@ typedef struct ncplane {
   uint16_t stylemask;    // same deal as in a cell
   int margin_b, margin_r;// bottom and right margins, stored for resize
   bool scrolling;        // is scrolling enabled? always disabled by default
+  int scrolled;          // rows scrolled since our pile was last rasterized
+
+  // rows [dirtymin, dirtymax] (plane coordinates) have been written since we
+  // were last rendered. the plane is clean when dirtymin > dirtymax.
+  int dirtymin, dirtymax;
+  // absolute origin and geometry as of our last render, so that the region
+  // we vacate can be repainted. rendleny is 0 if we've not been rendered in
+  // this pile.
+  int rendabsy, rendabsx, rendleny, rendlenx;
+  // our place in the pile's spatial index (see pileindex.c). when indexed,
+  // and not a large plane, we're listed in buckets [iby0..iby1]x[ibx0..ibx1].
+  bool indexed, indexlarge;
+  int iby0, ibx0, iby1, ibx1;
+  unsigned indexmark;    // query generation in which we were last collected
+  int64_t zrank;         // ordinal on the z-axis, smaller is higher
+  struct nclayer* layer; // non-NULL if we root a cached layer (see render.c)
+  struct blitdelta* blitdelta; // state of our last delta blit (see blit.c)
 } ncplane;
 
 // current presentation state of the terminal. it is carried across render
 // instances. initialize everything to 0 on a terminal reset / startup.
 typedef struct rasterstate {
-  // we assemble the encoded (rasterized) output in a POSIX memstream, and keep
-  // it around between uses. this could be a problem if it ever tremendously
-  // spiked, but that's a highly unlikely situation.
-  char* mstream;  // buffer for rasterizing memstream, see open_memstream(3)
-  FILE* mstreamfp;// FILE* for rasterizing memstream
-  size_t mstrsize;// size of rendering memstream
+  // we assemble the encoded (rasterized) output in an fbuf, and keep it
+  // around between uses. when frames are handed to the writer, it trades us
+  // the buffer of a frame it has finished writing.
+  fbuf f;
+  size_t framelen; // decaying estimate of recent frame sizes, reserved ahead
 
   // the current cursor position. this is independent of whether the cursor is
   // visible. it is the cell at which the next write will take place. this is
@@ -274,6 +296,25 @@ typedef struct rasterstate {
 
   // need we do a hard cursor update (i.e. did we just emit a pixel graphic)?
   bool hardcursorpos;
+
+  // can't we trust our column for relative moves (i.e. did we just emit a
+  // glyph whose width the terminal might see differently)?
+  bool hardxpos;
+
+  // the most recently emitted cell (from lastframe), whose style and colors
+  // are current. NULL if there is none this frame.
+  const nccell* lastcell;
+
+  // rows [scrolltop, scrollbot] of lastframe have been scrolled up by
+  // scrollrows, and the terminal must follow before the frame is written.
+  int scrolltop, scrollbot, scrollrows;
+
+  // when coalescing output, we mark where each row's output begins, so that
+  // the frame can be cut short there.
+  bool markrows;
+  struct ncrowmark* rowmarks;
+  unsigned rowmarkcount;
+  unsigned rowmarkalloc;
 } rasterstate;
 
 // Tablets are the toplevel entitites within an ncreel. Each corresponds to
@@ -397,6 +438,32 @@ typedef struct nctabbed {
   nctabbed_options opts; // copied in nctabbed_create()
 } nctabbed;
 
+// longest expansion of an esctemplate
+#define ESCTEMPLATE_MAXLEN 32
+
+// a parameterized capability, compiled when its string merely prints (possibly
+// %i-incremented) decimal parameters between literals, as do cup, hpa, vpa,
+// and the relative motions almost everywhere. such a template is expanded
+// without consulting terminfo; anything more exotic falls back to tiparm().
+typedef struct esctemplate {
+  const char* cap;          // the capability itself, NULL if absent
+  bool compiled;            // false if we must fall back to tiparm()
+  unsigned char incr;       // added to each parameter (1 if %i was seen)
+  unsigned char slots;      // number of parameters printed, at most 2
+  unsigned char param[2];   // which parameter (0-based) each slot prints
+  unsigned char litlen[3];  // literal preceding each slot, then the trailer
+  char lit[3][ESCTEMPLATE_MAXLEN / 2];
+} esctemplate;
+
+// a capability taking a single parameter in [0..256), expanded ahead of time
+// for each of them (for setaf and setab, the palette index; for sgr, the
+// eight styles it controls, indexed by their NCSTYLE_* bits).
+typedef struct esctable {
+  char* arena;              // the expansions, back to back, NULL if absent
+  uint32_t off[256];        // offset of each expansion within 'arena'
+  uint8_t len[256];         // length of each expansion
+} esctable;
+
 // terminfo cache. FIXME shrink this and kill a pointer deref by writing them
 // all into one buffer, and storing 1-biased indices with 0 for NULL.
 typedef struct tinfo {
@@ -439,6 +506,23 @@ typedef struct tinfo {
   char* getm;     // get mouse events
   char* smcup;    // enter alternate mode
   char* rmcup;    // restore primary mode
+  char* csr;      // set the scrolling region
+  char* indn;     // scroll N lines up within the scrolling region
+  char* dl;       // delete N lines, pulling up those below
+  char* ech;      // erase N cells, leaving the cursor in place
+  char* el;       // erase to the end of the line
+  char* rep;      // repeat a glyph N times (only if ECMA-48 REP)
+  // the length of each cursor motion capability, less its numeric parameters,
+  // used by goto_location() to estimate the cost of a move. 0 when absent.
+  struct {
+    unsigned cup, hpa, vpa, cuf, cub, cud, cuu, cuf1, home;
+  } motioncost;
+  // the parameterized motion capabilities compiled for goto_location(), those
+  // used to scroll and erase, and setaf, setab, and sgr expanded for the
+  // rasterizer, so that the render loop needn't interpret terminfo strings.
+  esctemplate cuptmpl, hpatmpl, vpatmpl, cuftmpl, cubtmpl, cudtmpl, cuutmpl;
+  esctemplate csrtmpl, indntmpl, dltmpl, echtmpl;
+  esctable setaftab, setabtab, sgrtab;
   // we use the cell's size in pixels for pixel blitting. this information can
   // be acquired on all terminals with pixel support.
   int cellpixy;   // cell pixel height, might be 0
@@ -457,16 +541,16 @@ typedef struct tinfo {
   pthread_mutex_t pixel_query; // only query for pixel support once
   int color_registers; // sixel color registers (post pixel_query_done)
   int sixel_maxx, sixel_maxy; // sixel size maxima (post pixel_query_done)
-  int (*pixel_destroy)(const struct notcurses* nc, const struct ncpile* p, FILE* out, sprixel* s);
+  int (*pixel_destroy)(const struct notcurses* nc, const struct ncpile* p, fbuf* f, sprixel* s);
   // wipe out a cell's worth of pixels from within a sprixel. for sixel, this
   // means leaving out the pixels (and likely resizes the string). for kitty,
   // this means dialing down their alpha to 0 (in equivalent space).
   int (*pixel_wipe)(sprixel* s, int y, int x);
   // perform the inverse of pixel_wipe, restoring an annihilated sprixcell.
   int (*pixel_rebuild)(sprixel* s, int y, int x, uint8_t* auxvec);
-  int (*pixel_remove)(int id, FILE* out); // kitty only, issue actual delete command
+  int (*pixel_remove)(int id, fbuf* f); // kitty only, issue actual delete command
   int (*pixel_init)(int fd);      // called when support is detected
-  int (*pixel_draw)(const struct ncpile* p, sprixel* s, FILE* out);
+  int (*pixel_draw)(const struct ncpile* p, sprixel* s, fbuf* f);
   int (*pixel_shutdown)(int fd);  // called during context shutdown
   int (*pixel_clear_all)(int fd); // called during startup, kitty only
   int sprixel_scale_height; // sprixel must be a multiple of this many rows
@@ -528,12 +612,11 @@ typedef struct ncdirect {
 } ncdirect;
 
 // Extracellular state for a cell during the render process. There is one
-// crender per rendered cell, and they are initialized to all zeroes.
+// crender per rendered cell, and they are initialized to all zeroes. The
+// solved nccell and the rarely-needed crenderaux live in parallel arrays; see
+// rendervec.
 struct crender {
   const ncplane *p; // source of glyph for this cell
-  nccell c;
-  uint32_t hcfg;       // fg channel prior to HIGHCONTRAST (need full channel)
-  sprixel* sprixel;    // bitmap encountered during traversal
   struct {
     // If the glyph we render is from an ncvisual, and has a transparent or
     // blended background, blitter stacking is in effect. This is a complicated
@@ -557,23 +640,253 @@ struct crender {
     // and then reapply any foreground shading from above the highcontrast
     // declaration. save the foreground state when we go highcontrast.
     unsigned hcfgblends: 8; // number of foreground blends prior to HIGHCONTRAST
-    unsigned sprixeled: 1; // have we passed through a sprixel?
+    unsigned sprixeled: 1; // have we passed through a sprixel? (aux.sprixel)
     unsigned p_beats_sprixel: 1; // did we solve for our glyph above the bitmap?
   } s;
 };
 
+// Render state only needed for sprixels and CELL_ALPHA_HIGHCONTRAST, kept out
+// of the way of the hot loops. Only valid when s.sprixeled (for sprixel) or
+// s.highcontrast (for hcfg) is set in the corresponding crender.
+struct crenderaux {
+  sprixel* sprixel;    // bitmap encountered during traversal
+  uint32_t hcfg;       // fg channel prior to HIGHCONTRAST (need full channel)
+};
+
+// A render vector holds one element per rendered cell in each of several
+// parallel arrays, so that each pass over it touches only what it needs.
+// paint() works mostly on the cells and crenders, postpaint() compares the
+// cells against lastframe, and rasterization checks only s.damaged.
+typedef struct rendervec {
+  nccell* cells;              // solved cells
+  struct crender* crender;    // glyph source and solver state
+  struct crenderaux* aux;     // sprixel and highcontrast state
+} rendervec;
+
+static inline void
+rendervec_free(rendervec* rvec){
+  free(rvec->cells);
+  free(rvec->crender);
+  free(rvec->aux);
+}
+
+// a cached layer is a plane and those planes bound to it (recursively, up
+// to any plane rooting a cached layer of its own), composited in isolation
+// and retained. where the layer's planes are contiguous on the z-axis, paint
+// copies the composition into the render vector wherever nothing above has
+// touched the cell, rather than painting each plane. the composition covers
+// only the visible portion of the layer's bounding box.
+typedef struct nclayer {
+  rendervec rvec;             // composition of the box (leny * lenx cells)
+  size_t cells;               // cells allocated in each array of rvec
+  int absy, absx, leny, lenx; // the box, in absolute coordinates
+  struct ncplane* top;        // topmost plane, as of the last validation
+  unsigned planes;            // planes in the layer, as of the same
+  bool valid;                 // rvec reflects the current planes
+  bool usable;                // painted from rvec in the current query
+  unsigned mark;              // layer generation of our last validation
+  uint64_t hits, misses;      // uses without, and with, recomposition
+} nclayer;
+
+// the damaged columns [minx, maxx] of one row of a rendered frame, as
+// determined by postpaint(). the row is undamaged if minx > maxx.
+typedef struct damagespan {
+  int minx, maxx;
+} damagespan;
+
+// a pile's spatial index of its planes, see pileindex.c
+typedef struct pileindex {
+  struct pilebucket** buckets; // chained hash of nonempty buckets
+  unsigned slots;              // hash slots, a power of 2 (or 0)
+  unsigned bucketcount;        // buckets in the hash
+  ncplane** large;             // planes spanning too many buckets to list
+  unsigned largecount, largealloc;
+  ncplane** hits;              // results of the last query, in z-order
+  unsigned hitcount, hitalloc;
+  unsigned querygen;           // generation of the last query
+  bool zstale;                 // z-axis changed; plane zranks are invalid
+  bool broken;                 // allocation failed; rebuild before use
+} pileindex;
+
 typedef struct ncpile {
   ncplane* top;               // topmost plane, never NULL
   ncplane* bottom;            // bottommost plane, never NULL
   ncplane* roots;             // head of root plane list
-  struct crender* crender;    // array (rows * cols crender objects)
+  rendervec rvec;             // render vector (rows * cols of each array)
   struct notcurses* nc;       // notcurses context
   struct ncpile *prev, *next; // circular list
-  size_t crenderlen;          // size of crender vector
+  size_t crenderlen;          // cells in each array of rvec
   int dimy, dimx;             // rows and cols at time of render
+  int cellpixy, cellpixx;     // cell geometry in pixels at time of render
   sprixel* sprixelcache;      // list of sprixels
+  // per-row render state (dimy entries), see ROW_* in render.c. rows which
+  // are neither dirty nor unposted reuse the previous render's crenders.
+  unsigned char* rowflags;
+  damagespan* damage;         // per-row damage (dimy entries), NULL for all
+  // absolute rows [orphanmin, orphanmax] were covered by planes which have
+  // since left the pile; they must be repainted on the next render.
+  int orphanmin, orphanmax;
+  bool repaint;               // repaint every row on the next render
+  pileindex index;            // spatial index of our planes
+  unsigned layergen;          // generation of cached layer validation
 } ncpile;
 
+// a small pool of helper threads for splitting embarrassingly parallel work
+// (i.e. row bands of a render) into jobs. the thread calling workpool_run()
+// participates in the work, and returns once every job has completed. only
+// one batch runs at a time; concurrent callers do their work alone.
+typedef struct ncworkpool {
+  pthread_t* tids;            // helper threads
+  unsigned threads;           // number of helper threads actually launched
+  pthread_mutex_t runlock;    // held by the workpool_run() caller, if any
+  pthread_mutex_t lock;       // guards everything below
+  pthread_cond_t cond;        // signals helpers that jobs are available
+  pthread_cond_t donecond;    // signals the caller that all jobs completed
+  void (*fxn)(void*, unsigned); // job function, called with curry and job
+  void* curry;
+  unsigned jobs;              // jobs in the current batch
+  unsigned nextjob;           // next unclaimed job
+  unsigned outstanding;       // jobs not yet completed
+  bool shutdown;              // helpers exit when they see this
+} ncworkpool;
+
+// no escape sequence is in progress where a row's rasterized output begins,
+// so a frame can be cut short at any such mark.
+typedef struct ncrowmark {
+  size_t offset;              // byte offset at which the row's output begins
+  int y;                      // row of lastframe
+} ncrowmark;
+
+// with NCOPTION_ASYNC_OUTPUT, a writer thread drains rasterized frames to the
+// terminal while the next frame is rendered. it has two output buffers: one
+// being written, and one queued behind it. only when both are in flight must
+// a new frame wait. with NCOPTION_COALESCE_OUTPUT, a frame still being
+// written when its successor is rasterized is instead cut short at its next
+// row mark (frames without row marks are always written in full).
+struct ncwriterframe {
+  fbuf f;                     // f.used bytes to write
+  ncrowmark* marks;           // row marks, in order of increasing offset
+  unsigned markcount;
+  unsigned markalloc;
+};
+
+typedef struct ncwriter {
+  pthread_t tid;
+  pthread_mutex_t lock;       // guards everything below
+  pthread_cond_t cond;        // signals the writer that a frame was queued
+  pthread_cond_t donecond;    // signals submitters that a frame was written
+  struct ncwriterframe frames[2];
+  unsigned queued;            // frames in flight (queued or being written)
+  unsigned next;              // index of the oldest frame in flight
+  int fd;                     // destination of all writes
+  bool failed;                // a write failed since we last reported one
+  bool shutdown;              // writer exits once it sees this and is idle
+  bool coalesce;              // may frames be cut short? fixed at creation
+  bool cut;                   // cut the frame in progress at its next mark
+  const struct ncwriterframe* cutframe; // most recent frame cut short
+  size_t cutat;               // bytes of 'cutframe' actually written
+} ncwriter;
+
+// the outcome of cutting short a frame in flight
+typedef struct ncwritercut {
+  const ncrowmark* lost;      // marks of the rows which weren't written
+  unsigned lostcount;
+  bool dropped;               // none of the frame's rows were written
+  size_t lostbytes;           // bytes discarded
+  int64_t waitns;             // ns spent waiting for the writer to stop
+} ncwritercut;
+
+// with a target frame rate (see notcurses_set_target_fps()),
+// notcurses_render_request() renders the standard pile only if a frame
+// interval has passed since the last frame it rendered. otherwise, the frame
+// is marked pending, to be rendered by the next request or input poll made
+// after the interval (input polls wake for it), by notcurses_render_drain(),
+// or by notcurses_stop(), so any number of requests within an interval result
+// in a single frame. all rendering happens on the caller's thread.
+typedef struct ncscheduler {
+  struct notcurses* nc;
+  pthread_mutex_t lock;       // guards everything below
+  uint64_t intervalns;        // minimum ns between the start of frames
+  uint64_t lastns;            // CLOCK_MONOTONIC start of the last frame
+  bool rendered;              // has any frame been rendered (is lastns valid)?
+  bool pending;               // a frame was requested, and not yet begun
+} ncscheduler;
+
+// a damage scanning kernel returns the number of leading cells among the 'n'
+// 'cells' which are bitwise identical to the corresponding cells of
+// 'lastframe', and which postpaint() can thus (according to the parallel
+// 'crender' states) skip without further ado.
+typedef int (*damagescan_fxn)(const struct crender* crender, const nccell* cells,
+                              const nccell* lastframe, int n);
+
+typedef enum {
+  DAMAGESCAN_SCALAR,
+  DAMAGESCAN_SSE2,
+  DAMAGESCAN_AVX2,
+} damagescan_e;
+
+// a quadrant solver kernel solves 'n' cells of the quadrant blitter from a
+// band of two rows of RGBA pixels, 'top' and 'bot', each supplying 2 * 'n'
+// pixels. alpha is ignored (transparency must be handled by the caller). each
+// cell's EGC is written to 'egcs' (as an index into the quadrant blitter's
+// EGCs), and its foreground and background channels to 'fg' and 'bg'.
+typedef void (*quadsolve_fxn)(const unsigned char* top, const unsigned char* bot,
+                              int n, unsigned char* egcs, uint32_t* fg, uint32_t* bg);
+
+// a sextant solver kernel does likewise for the sextant blitter, from a band
+// of three rows of RGBA pixels.
+typedef void (*sexsolve_fxn)(const unsigned char* const rows[3], int n,
+                             unsigned char* egcs, uint32_t* fg, uint32_t* bg);
+
+typedef enum {
+  BLITSOLVE_SCALAR,
+  BLITSOLVE_SSE41,
+  BLITSOLVE_AVX2,
+} blitsolve_e;
+
+// kernels of the built-in RGBA resampler (see scale.c), each working along a
+// row of 'n' output pixels. gather() copies the source pixels indexed by
+// 'idx'. hlerp() interpolates each pair of source pixels starting at 'idx',
+// weighting the second by 'frac'/256, into 16-bit channels with 7 fractional
+// bits. vlerp() interpolates two such rows into RGBA, weighting 'bot' by
+// 'w'/256. boxacc() adds each source channel, times 'w', to 'acc'. boxsum()
+// sums the accumulated channels of each output's taps, as weighted by
+// 'weights', into RGBA.
+typedef struct resampler {
+  void (*gather)(const uint32_t* src, const int32_t* idx, uint32_t* dst, int n);
+  void (*hlerp)(const uint32_t* src, const int32_t* idx, const uint16_t* frac,
+                uint16_t* dst, int n);
+  void (*vlerp)(const uint16_t* top, const uint16_t* bot, unsigned w,
+                uint32_t* dst, int n);
+  void (*boxacc)(const uint32_t* src, unsigned w, uint32_t* acc, int n);
+  void (*boxsum)(const uint32_t* acc, const int32_t* idx, const int32_t* taps,
+                 const uint16_t* weights, uint32_t* dst, int n);
+} resampler;
+
+typedef enum {
+  RESAMPLEISA_SCALAR,
+  RESAMPLEISA_SSE41,
+  RESAMPLEISA_AVX2,
+} resampleisa_e;
+
+typedef enum {
+  RESAMPLE_NEAREST,
+  RESAMPLE_BOX,      // area average
+  RESAMPLE_BILINEAR,
+} resample_e;
+
+// freed ncplane structs and framebuffers are retained for reuse, up to 'cap'
+// bytes in total (see slab.c).
+#define SLAB_FB_CLASSES 112
+
+typedef struct ncslab {
+  pthread_mutex_t lock;
+  struct slabobj* planes;               // cached ncplane structs
+  struct slabobj* fbs[SLAB_FB_CLASSES]; // cached framebuffers, by size class
+  size_t cached;                        // bytes held for reuse
+  size_t cap;                           // most bytes we'll hold
+} ncslab;
+
 // the standard pile can be reached through ->stdplane.
 typedef struct notcurses {
   ncplane* stdplane; // standard plane, covers screen
@@ -611,8 +924,66 @@ typedef struct notcurses {
   palette256 palette; // 256-indexed palette can be used instead of/with RGB
   bool palette_damage[NCPALETTESIZE];
   unsigned stdio_blocking_save; // was stdio blocking at entry? restore on stop.
+  unsigned ttyfd_blocking_save; // likewise for ttyfd, when coalescing output
+  // helper threads for banded rendering, NULL unless NCOPTION_PARALLEL_RENDER
+  // was provided (and we have more than one core).
+  ncworkpool* workpool;
+  // the pile most recently postpainted into lastframe, or NULL if lastframe
+  // has since been invalidated. only this pile can skip postpainting rows it
+  // didn't repaint.
+  const ncpile* lastpile;
+  damagescan_fxn damagescan; // best kernel for this processor
+  // writer thread for NCOPTION_ASYNC_OUTPUT (or NCOPTION_COALESCE_OUTPUT),
+  // otherwise NULL. anything writing directly to the terminal must
+  // writer_drain() first.
+  ncwriter* writer;
+  // render request governor for a non-zero target frame rate, otherwise NULL.
+  ncscheduler* scheduler;
+  ncslab slab; // recycled planes and framebuffers
+  // cell blits of at least this many cells are split across the workpool,
+  // if we have one. 0 disables parallel blitting.
+  unsigned blitthreshold;
 } notcurses;
 
+// each band of a parallel blit runs without touching its plane's egcpool.
+// cells whose EGC must be stashed in the pool, or whose previous EGC must be
+// released from it, are instead staged, to be written once the bands have
+// all completed.
+typedef struct stagedegc {
+  nccell* c;
+  char* egc;           // heap copy of the EGC, not NUL-terminated
+  int bytes;
+} stagedegc;
+
+typedef struct blitstage {
+  stagedegc* cells;
+  unsigned count, alloc;
+  int lasty, lastx;    // where the cursor would have ended, or -1
+  int total;           // cells written by the band, or -1 on error
+} blitstage;
+
+// a delta blit (NCVISUAL_OPTION_DELTA) skips any cell whose source pixels are
+// unchanged since the previous delta blit into the plane, so long as the cell
+// still holds what that blit wrote. the plane keeps a hash of each cell's
+// source pixels, and a copy of each cell as written, for the clipped region
+// of its last delta blit. a single allocation holds the arrays and header.
+typedef struct blitdelta {
+  // the blit which last wrote the region. a blit differing in any of these
+  // starts afresh, as does any following a failed blit.
+  bool valid;
+  ncblitter_e geom;
+  int placey, placex, begy, begx, leny, lenx;
+  uint32_t transcolor;
+  int blendcolors;
+  int y0, x0, rows, cols;  // the clipped region of cells
+  int writes;              // cells of the region to be written by this blit
+  size_t alloc;            // bytes allocated, including this header
+  uint64_t* hashes;        // rows * cols hashes of source pixels
+  nccell* cells;           // rows * cols cells as last written
+  unsigned char* redraw;   // rows * cols: must the cell be written?
+  unsigned char* rowredraw; // rows: must any cell of the row be written?
+} blitdelta;
+
 typedef struct blitterargs {
   // FIXME begy/begx are really only of interest to scaling; they ought be
   // consumed there, and blitters ought always work with the scaled output.
@@ -624,6 +995,9 @@ typedef struct blitterargs {
       int placey;      // placement within ncplane
       int placex;
       int blendcolors; // use CELL_ALPHA_BLEND
+      blitstage* stage; // non-NULL iff this is a band of a parallel blit
+      bool delta;      // skip unchanged cells (NCVISUAL_OPTION_DELTA)
+      const blitdelta* bdelta; // non-NULL once a delta blit is prepared
     } cell;            // for cells
     struct {
       int celldimx;    // horizontal pixels per cell
@@ -688,6 +1062,116 @@ void update_raster_stats(const struct timespec* time1, const struct timespec* ti
 void update_render_stats(const struct timespec* time1, const struct timespec* time0, ncstats* stats);
 void update_render_bytes(ncstats* stats, int bytes);
 void update_write_stats(const struct timespec* time1, const struct timespec* time0, ncstats* stats, int bytes);
+void update_band_stats(ncstats* stats, unsigned bands, const int64_t* bandns);
+
+// launch up to |threads| helper threads. returns NULL on failure.
+ncworkpool* workpool_create(unsigned threads);
+
+// run |fxn|(|curry|, j) for each j in [0..|jobs|), spread across the pool's
+// helpers and the calling thread, returning once all have completed. a NULL
+// |pool| runs the jobs serially on the calling thread, as does a |pool| busy
+// with another caller's batch.
+void workpool_run(ncworkpool* pool, unsigned jobs,
+                  void (*fxn)(void*, unsigned), void* curry);
+
+void workpool_destroy(ncworkpool* pool);
+
+// launch a writer thread for 'fd'. if 'coalesce' is set, frames can be cut
+// short with writer_coalesce(), and 'fd' ought be O_NONBLOCK, lest the writer
+// not notice until a large write completes. returns NULL on failure.
+ncwriter* writer_create(int fd, bool coalesce);
+
+// queue the contents of 'f' (along with its 'markcount' row 'marks') for the
+// writer, first waiting for a frame to become free if both are in flight. 'f'
+// is exchanged with the free frame's buffer rather than copied, and is returned
+// empty. the time spent waiting is written to 'waitns'. returns -1 if 'f'
+// couldn't be queued, or if a previous write failed (in which case 'f' is
+// queued).
+int writer_submit(ncwriter* w, fbuf* f, const ncrowmark* marks,
+                  unsigned markcount, int64_t* waitns);
+
+// if 'w' coalesces, cut short any frame still in flight at its next row mark,
+// discarding the remainder, and wait for the writer to stop. rows which
+// weren't written are described in 'cut', and remain valid until the next
+// writer_submit(). returns -1 if a write has failed since last reported.
+int writer_coalesce(ncwriter* w, ncwritercut* cut);
+
+// wait until every queued frame has been written. returns -1 if a write has
+// failed since last reported. a NULL 'w' returns 0 immediately.
+int writer_drain(ncwriter* w);
+
+// drain and join the writer thread, and free it. returns -1 if a write has
+// failed since last reported.
+int writer_destroy(ncwriter* w);
+
+// create a scheduler rendering no more than 'fps' frames per second of 'nc'.
+// returns NULL on failure.
+ncscheduler* scheduler_create(struct notcurses* nc, unsigned fps);
+
+// request a frame from 's', rendering it immediately if a frame interval has
+// passed since the last, and otherwise leaving it pending. returns -1 if a
+// frame was rendered, and failed.
+int scheduler_request(ncscheduler* s);
+
+// render any pending frame whose interval has passed. should a frame remain
+// pending, its CLOCK_MONOTONIC deadline is written to '*deadline' (otherwise
+// 0), by which time this ought be called again. returns -1 if a frame was
+// rendered, and failed. a NULL 's' returns 0 immediately.
+int scheduler_service(ncscheduler* s, uint64_t* deadline);
+
+// render any pending frame, first sleeping out the remainder of the frame
+// interval if 'wait' is set. returns -1 if a frame was rendered, and failed.
+// a NULL 's' returns 0 immediately.
+int scheduler_drain(ncscheduler* s, bool wait);
+
+// render any pending frame without delay, and free the scheduler. returns -1
+// if that frame failed.
+int scheduler_destroy(ncscheduler* s);
+
+// write(2) until we've written it all, polling on EAGAIN.
+int blocking_write(int fd, const char* buf, size_t buflen);
+
+// the damage scanning kernel for 'isa', or NULL if either this build or this
+// processor lacks it. used directly by tests and benchmarks, which link
+// against the static libraries to reach it.
+damagescan_fxn damagescan_kernel(damagescan_e isa);
+
+// the fastest damage scanning kernel supported by this processor.
+damagescan_fxn damagescan_best(void);
+
+// the quadrant and sextant solver kernels for 'isa', or NULL if either this
+// build or this processor lacks it. every kernel produces results identical
+// to those of the scalar kernel, which the tests verify through these.
+quadsolve_fxn quadsolve_kernel(blitsolve_e isa);
+sexsolve_fxn sexsolve_kernel(blitsolve_e isa);
+
+// the resampler kernels for 'isa', or NULL if this CPU doesn't support it.
+const resampler* resampler_kernels(resampleisa_e isa);
+
+// the resampling used when none is specified: box when shrinking along both
+// axes, and bilinear otherwise.
+resample_e resample_default(int srcy, int srcx, int dsty, int dstx);
+
+// scale 'srcy'x'srcx' RGBA pixels at 'src' to 'dsty'x'dstx' pixels at 'dst'
+// using 'mode', with the best kernels available (or those of 'rs'). strides
+// are in bytes. returns -1 on invalid geometry or allocation failure.
+int rgba_resample(const uint32_t* src, int srcy, int srcx, int srcstride,
+                  uint32_t* dst, int dsty, int dstx, int dststride,
+                  resample_e mode);
+int rgba_resample_via(const resampler* rs, const uint32_t* src, int srcy,
+                      int srcx, int srcstride, uint32_t* dst, int dsty,
+                      int dstx, int dststride, resample_e mode);
+
+// rgba_blit_dispatch(), first scaling the 'srcy'x'srcx' 'data' to 'rows'x
+// 'cols' with the built-in resampler, for backends which can't scale.
+// exported only for the multimedia backends in libnotcurses.
+API int resample_blit(ncplane* n, const struct blitset* bset, int linesize,
+                      const void* data, int srcy, int srcx, int rows,
+                      int cols, const blitterargs* bargs);
+
+// scale 'ncv' in place to 'rows'x'cols' with the built-in resampler.
+// exported only for the multimedia backends in libnotcurses.
+API int resample_visual(struct ncvisual* ncv, int rows, int cols);
 
 void sigwinch_handler(int signo);
 
@@ -752,9 +1236,82 @@ logical_to_virtual(const ncplane* n, int y){
   return (y + n->logrow) % n->leny;
 }
 
+#define NCPLANE_TILE_ROWS 64
+
+static inline int
+ncplane_tilecount(int leny){
+  return (leny + NCPLANE_TILE_ROWS - 1) / NCPLANE_TILE_ROWS;
+}
+
+// the number of cells in tile 't' of a sparse plane of 'leny' by 'lenx'. the
+// final tile is short unless 'leny' is a multiple of NCPLANE_TILE_ROWS.
 static inline int
-nfbcellidx(const ncplane* n, int row, int col){
-  return fbcellidx(logical_to_virtual(n, row), n->lenx, col);
+ncplane_tilecells(int leny, int lenx, int t){
+  int rows = leny - t * NCPLANE_TILE_ROWS;
+  if(rows > NCPLANE_TILE_ROWS){
+    rows = NCPLANE_TILE_ROWS;
+  }
+  return rows * lenx;
+}
+
+// a read-only view of virtual row 'v'. for unwritten rows of a sparse plane,
+// this is the shared zerorow.
+static inline const nccell*
+ncplane_vrow_const(const ncplane* n, int v){
+  if(n->tiles == NULL){
+    return n->fb + fbcellidx(v, n->lenx, 0);
+  }
+  const nccell* t = n->tiles[v / NCPLANE_TILE_ROWS];
+  if(t == NULL){
+    return n->zerorow;
+  }
+  return t + fbcellidx(v % NCPLANE_TILE_ROWS, n->lenx, 0);
+}
+
+// a read-only view of logical row 'y'
+static inline const nccell*
+ncplane_row_const(const ncplane* n, int y){
+  return ncplane_vrow_const(n, logical_to_virtual(n, y));
+}
+
+static inline const nccell*
+ncplane_cell_const(const ncplane* n, int y, int x){
+  return ncplane_row_const(n, y) + x;
+}
+
+// allocate (zeroed) tile 't' of sparse plane 'n'. returns NULL on failure.
+nccell* ncplane_tile_alloc(ncplane* n, int t);
+
+// a writable view of logical row 'y', allocating its storage if 'n' is sparse
+// and the row has not yet been written. returns NULL on allocation failure.
+static inline nccell*
+ncplane_row(ncplane* n, int y){
+  const int v = logical_to_virtual(n, y);
+  if(n->tiles == NULL){
+    return n->fb + fbcellidx(v, n->lenx, 0);
+  }
+  nccell* t = n->tiles[v / NCPLANE_TILE_ROWS];
+  if(t == NULL){
+    if((t = ncplane_tile_alloc(n, v / NCPLANE_TILE_ROWS)) == NULL){
+      return NULL;
+    }
+  }
+  return t + fbcellidx(v % NCPLANE_TILE_ROWS, n->lenx, 0);
+}
+
+// a writable view of logical row 'y' if it has storage, otherwise (i.e. for
+// unwritten rows of sparse planes, which hold only zeroed cells) NULL.
+static inline nccell*
+ncplane_row_extant(ncplane* n, int y){
+  const int v = logical_to_virtual(n, y);
+  if(n->tiles == NULL){
+    return n->fb + fbcellidx(v, n->lenx, 0);
+  }
+  nccell* t = n->tiles[v / NCPLANE_TILE_ROWS];
+  if(t == NULL){
+    return NULL;
+  }
+  return t + fbcellidx(v % NCPLANE_TILE_ROWS, n->lenx, 0);
 }
 
 // For our first attempt, O(1) uniform conversion from 8-bit r/g/b down to
@@ -886,20 +1443,92 @@ term_emit(const char* seq, FILE* out, bool flush){
   return 0;
 }
 
+// expand 't' with 'p1' and 'p2' (insofar as it takes them) into the 'size'
+// bytes at 'buf', without NUL termination. returns the length, or -1 if the
+// capability is unavailable or the expansion doesn't fit.
+static inline int
+esctemplate_expand(const esctemplate* t, char* buf, size_t size, int p1, int p2){
+  if(t->cap == NULL){
+    return -1;
+  }
+  if(!t->compiled){
+    const char* seq = tiparm(t->cap, p1, p2);
+    if(seq == NULL){
+      return -1;
+    }
+    size_t len = strlen(seq);
+    if(len > size){
+      return -1;
+    }
+    memcpy(buf, seq, len);
+    return len;
+  }
+  const int params[2] = { p1 + t->incr, p2 + t->incr, };
+  size_t len = 0;
+  for(unsigned i = 0 ; i <= t->slots ; ++i){
+    if(len + t->litlen[i] > size){
+      return -1;
+    }
+    memcpy(buf + len, t->lit[i], t->litlen[i]);
+    len += t->litlen[i];
+    if(i < t->slots){
+      int v = params[t->param[i]];
+      char digits[12];
+      unsigned dcount = 0;
+      unsigned u = v < 0 ? -(unsigned)v : (unsigned)v;
+      do{
+        digits[dcount++] = '0' + u % 10;
+        u /= 10;
+      }while(u);
+      if(len + dcount + (v < 0) > size){
+        return -1;
+      }
+      if(v < 0){
+        buf[len++] = '-';
+      }
+      while(dcount){
+        buf[len++] = digits[--dcount];
+      }
+    }
+  }
+  return len;
+}
+
+// write 'cap' with the single parameter 'idx' to 'f', taking the expansion
+// from 't' if it was built.
+static inline int
+term_emit_indexed(const esctable* t, const char* cap, fbuf* f, unsigned idx){
+  if(t->arena == NULL || idx >= sizeof(t->len) / sizeof(*t->len)){
+    return fbuf_emit(f, tiparm(cap, idx));
+  }
+  return fbuf_putn(f, t->arena + t->off[idx], t->len[idx]);
+}
+
 static inline int
-term_bg_palindex(const notcurses* nc, FILE* out, unsigned pal){
+term_bg_palindex(const notcurses* nc, fbuf* f, unsigned pal){
   if(nc->tcache.setab == NULL){
     return 0;
   }
-  return term_emit(tiparm(nc->tcache.setab, pal), out, false);
+  return term_emit_indexed(&nc->tcache.setabtab, nc->tcache.setab, f, pal);
 }
 
 static inline int
-term_fg_palindex(const notcurses* nc, FILE* out, unsigned pal){
+term_fg_palindex(const notcurses* nc, fbuf* f, unsigned pal){
   if(nc->tcache.setaf == NULL){
     return 0;
   }
-  return term_emit(tiparm(nc->tcache.setaf, pal), out, false);
+  return term_emit_indexed(&nc->tcache.setaftab, nc->tcache.setaf, f, pal);
+}
+
+// as term_fg_palindex(), but written to a stdio stream, for the banners
+static inline int
+term_fg_palindex_file(const notcurses* nc, FILE* fp, unsigned pal){
+  fbuf f = {};
+  if(term_fg_palindex(nc, &f, pal)){
+    fbuf_free(&f);
+    return -1;
+  }
+  return fbuf_finalize(&f, fp);
 }
 
 static inline const char*
@@ -910,9 +1539,33 @@ pool_extended_gcluster(const egcpool* pool, const nccell* c){
   return egcpool_extended_gcluster(pool, c);
 }
 
+// note that rows [y, y + rows) of 'n' have changed since it was last rendered.
+static inline void
+ncplane_dirty_rows(ncplane* n, int y, int rows){
+  if(y < n->dirtymin){
+    n->dirtymin = y;
+  }
+  if(y + rows - 1 > n->dirtymax){
+    n->dirtymax = y + rows - 1;
+  }
+}
+
+// note that all of 'n' has changed since it was last rendered.
+static inline void
+ncplane_dirty(ncplane* n){
+  ncplane_dirty_rows(n, 0, n->leny);
+}
+
+// a writable reference to the cell at 'y', 'x'. the row is marked dirty.
+// returns NULL if storage could not be allocated for a sparse plane's row.
 static inline nccell*
 ncplane_cell_ref_yx(ncplane* n, int y, int x){
-  return &n->fb[nfbcellidx(n, y, x)];
+  nccell* row = ncplane_row(n, y);
+  if(row == NULL){
+    return NULL;
+  }
+  ncplane_dirty_rows(n, y, 1);
+  return row + x;
 }
 
 static inline void
@@ -929,7 +1582,7 @@ plane_debug(const ncplane* n, bool details){
   if(details){
     for(int y = 0 ; y < 1 ; ++y){
       for(int x = 0 ; x < 10 ; ++x){
-        const nccell* c = &n->fb[fbcellidx(y, dimx, x)];
+        const nccell* c = ncplane_cell_const(n, y, x);
         fprintf(stderr, "[%03d/%03d] ", y, x);
         cell_debug(&n->pool, c);
       }
@@ -950,16 +1603,16 @@ int kitty_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec);
 void sprixel_free(sprixel* s);
 void sprixel_hide(sprixel* s);
 
-int kitty_draw(const ncpile *p, sprixel* s, FILE* out);
-int sixel_draw(const ncpile *p, sprixel* s, FILE* out);
+int kitty_draw(const ncpile *p, sprixel* s, fbuf* f);
+int sixel_draw(const ncpile *p, sprixel* s, fbuf* f);
 // dimy and dimx are cell geometry, not pixel.
 sprixel* sprixel_alloc(ncplane* n, int dimy, int dimx);
 sprixel* sprixel_recycle(ncplane* n);
 // takes ownership of s on success.
 int sprixel_load(sprixel* spx, char* s, int bytes, int pixy, int pixx, int parse_start);
-int sixel_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s);
-int kitty_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s);
-int kitty_remove(int id, FILE* out);
+int sixel_destroy(const notcurses* nc, const ncpile* p, fbuf* f, sprixel* s);
+int kitty_destroy(const notcurses* nc, const ncpile* p, fbuf* f, sprixel* s);
+int kitty_remove(int id, fbuf* f);
 int kitty_clear_all(int fd);
 int sixel_init(int fd);
 int sprite_init(const tinfo* t, int fd);
@@ -986,15 +1639,15 @@ int kitty_blit(ncplane* nc, int linesize, const void* data,
                int leny, int lenx, const blitterargs* bargs);
 
 static inline int
-sprite_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s){
-  return nc->tcache.pixel_destroy(nc, p, out, s);
+sprite_destroy(const notcurses* nc, const ncpile* p, fbuf* f, sprixel* s){
+  return nc->tcache.pixel_destroy(nc, p, f, s);
 }
 
 // precondition: s->invalidated is SPRIXEL_INVALIDATED or SPRIXEL_MOVED.
 static inline int
-sprite_draw(const notcurses* n, const ncpile* p, sprixel* s, FILE* out){
+sprite_draw(const notcurses* n, const ncpile* p, sprixel* s, fbuf* f){
 //sprixel_debug(stderr, s);
-  return n->tcache.pixel_draw(p, s, out);
+  return n->tcache.pixel_draw(p, s, f);
 }
 
 static inline int
@@ -1128,6 +1781,81 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
 
 int update_term_dimensions(int fd, int* rows, int* cols, tinfo* tcache);
 
+// compact the plane's egcpool if it's mostly dead space.
+void ncplane_compact_sparse(ncplane* n);
+
+int pileindex_init(pileindex* pi);
+void pileindex_destroy(pileindex* pi);
+
+// (re)index 'n' under its current geometry within its pile. call whenever
+// a plane's origin or size changes, or it joins a pile.
+void ncplane_index_update(ncplane* n);
+
+// remove 'n' from its pile's index. call before it leaves the pile.
+void ncplane_index_remove(ncplane* n);
+
+// collect the planes of 'pile' intersecting the 'leny'x'lenx' region at
+// absolute 'y', 'x' into pile->index.hits, in z-order (topmost first).
+// returns their number, or -1 on allocation failure.
+int ncpile_index_query(ncpile* pile, int y, int x, int leny, int lenx);
+
+// collect every plane of 'pile' into pile->index.hits, in z-order. returns
+// their number, or -1 on allocation failure.
+int ncpile_index_all(ncpile* pile);
+
+// note that 'pile's z-axis has been rearranged.
+static inline void
+ncpile_zaxis_changed(ncpile* pile){
+  pile->index.zstale = true;
+}
+
+// the root of the innermost cached layer containing 'n', or NULL
+static inline ncplane*
+ncplane_layer_root(const ncplane* n){
+  for(;;){
+    if(n->layer){
+      return (ncplane*)n;
+    }
+    if(n->boundto == n){
+      return NULL;
+    }
+    n = n->boundto;
+  }
+}
+
+// the cached layer containing 'n' (if any) must be recomposited
+static inline void
+ncplane_layer_invalidate(const ncplane* n){
+  ncplane* root = ncplane_layer_root(n);
+  if(root){
+    root->layer->valid = false;
+  }
+}
+
+// replace the contents of 'n' with 'fb', a framebuffer of n->leny by n->lenx
+// cells in logical row order, referring to n's egcpool. the old contents are
+// released. sparse planes copy out those rows of 'fb' which aren't zeroed, and
+// free 'fb'; should that fail, the remaining rows are lost, and -1 returned.
+int ncplane_adopt_fb(ncplane* n, nccell* fb);
+
+int slab_init(ncslab* s);
+void slab_destroy(ncslab* s);
+// allocate or free a plane struct or framebuffer of 'cells' cells, recycling
+// through the slab of 'nc'. 'nc' may be NULL, in which case these simply wrap
+// malloc() and free(). the contents of a new framebuffer are undefined. a
+// framebuffer must be freed with the same number of cells as it was allocated.
+// slab_fb_bytes() is the number of bytes slab_fb_alloc() devotes to it.
+ncplane* slab_plane_alloc(notcurses* nc);
+void slab_plane_free(notcurses* nc, ncplane* p);
+size_t slab_fb_bytes(notcurses* nc, int cells);
+nccell* slab_fb_alloc(notcurses* nc, int cells);
+void slab_fb_free(notcurses* nc, nccell* fb, int cells);
+
+// the terminal's geometry in cells, and that of its cells in pixels (0 if
+// unknown). any of the outputs may be NULL. as this touches no shared state,
+// it's safe to call while rendering concurrently.
+int term_geometry(int fd, int* rows, int* cols, int* cellpixy, int* cellpixx);
+
 ALLOC static inline void*
 memdup(const void* src, size_t len){
   void* ret = malloc(len);
@@ -1490,6 +2218,9 @@ plane_blit_sixel(sprixel* spx, char* s, int bytes, int rows, int cols,
   for(int y = 0 ; y < rows ; ++y){
     for(int x = 0 ; x < cols ; ++x){
       nccell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c == NULL){
+        return -1;
+      }
       memcpy(&c->gcluster, &gcluster, sizeof(gcluster));
       c->width = cols;
     }
@@ -1666,15 +2397,39 @@ ncdirect_bg_default_p(const struct ncdirect* nc){
   return ncchannels_bg_default_p(ncdirect_channels(nc));
 }
 
-int term_fg_rgb8(bool RGBflag, const char* setaf, int colors, FILE* out,
-                 unsigned r, unsigned g, unsigned b);
+int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b);
 
 const struct blitset* lookup_blitset(const tinfo* tcache, ncblitter_e setid, bool may_degrade);
 
+// blit cells with 'bset', splitting the blit into bands of rows across the
+// workpool if it's sufficiently large (see notcurses_set_blit_threshold()).
+API int cell_blit_dispatch(ncplane* nc, const struct blitset* bset,
+                           int linesize, const void* data,
+                           int leny, int lenx, const blitterargs* bargs);
+
+// will a cell blit using 'blitter' with 'flags' be a delta blit? only those
+// blitters consuming exactly their geometry's pixels per cell are supported.
+static inline bool
+delta_blit_p(ncblitter_e blitter, uint64_t flags){
+  if(!(flags & NCVISUAL_OPTION_DELTA)){
+    return false;
+  }
+  switch(blitter){
+    case NCBLIT_1x1: case NCBLIT_2x1: case NCBLIT_2x2:
+    case NCBLIT_3x2: case NCBLIT_BRAILLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
 static inline int
 rgba_blit_dispatch(ncplane* nc, const struct blitset* bset,
                    int linesize, const void* data,
                    int leny, int lenx, const blitterargs* bargs){
+  if(bset->geom != NCBLIT_PIXEL){
+    return cell_blit_dispatch(nc, bset, linesize, data, leny, lenx, bargs);
+  }
   return bset->blit(nc, linesize, data, leny, lenx, bargs);
 }
 
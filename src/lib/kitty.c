@@ -561,9 +561,9 @@ int kitty_blit(ncplane* n, int linesize, const void* data,
   return 1;
 }
 
-int kitty_remove(int id, FILE* out){
+int kitty_remove(int id, fbuf* f){
 //fprintf(stderr, "DESTROYING KITTY %d\n", id);
-  if(fprintf(out, "\e_Ga=d,d=i,i=%d\e\\", id) < 0){
+  if(fbuf_printf(f, "\e_Ga=d,d=i,i=%d\e\\", id) < 0){
     return -1;
   }
   return 0;
@@ -571,15 +571,15 @@ int kitty_remove(int id, FILE* out){
 
 // removes the kitty bitmap graphic identified by s->id, and damages those
 // cells which weren't SPRIXCEL_OPAQUE
-int kitty_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s){
-  if(kitty_remove(s->id, out)){
+int kitty_destroy(const notcurses* nc, const ncpile* p, fbuf* f, sprixel* s){
+  if(kitty_remove(s->id, f)){
     return -1;
   }
 //fprintf(stderr, "FROM: %d/%d state: %d s->n: %p\n", s->movedfromy, s->movedfromx, s->invalidated, s->n);
   for(int yy = s->movedfromy ; yy < s->movedfromy + s->dimy && yy < p->dimy ; ++yy){
     for(int xx = s->movedfromx ; xx < s->movedfromx + s->dimx && xx < p->dimx ; ++xx){
-      struct crender *r = &p->crender[yy * p->dimx + xx];
-      if(!r->sprixel){
+      struct crender *r = &p->rvec.crender[yy * p->dimx + xx];
+      if(!r->s.sprixeled){
         if(s->n){
           const ncplane* stdn = notcurses_stdplane_const(nc);
 //fprintf(stderr, "CHECKING %d/%d\n", yy - s->movedfromy, xx - s->movedfromx);
@@ -602,11 +602,11 @@ int kitty_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s){
   return 0;
 }
 
-int kitty_draw(const ncpile* p, sprixel* s, FILE* out){
+int kitty_draw(const ncpile* p, sprixel* s, fbuf* f){
 //fprintf(stderr, "DRAWING %d\n", s->id);
   (void)p;
   int ret = 0;
-  if(fwrite(s->glyph, s->glyphlen, 1, out) != 1){
+  if(fbuf_putn(f, s->glyph, s->glyphlen)){
     ret = -1;
   }
   s->invalidated = SPRIXEL_QUIESCENT;
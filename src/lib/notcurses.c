@@ -27,6 +27,13 @@
 static const int DEFAULT_ROWS = 24;
 static const int DEFAULT_COLS = 80;
 
+// beyond this many threads, banded rendering is bound by memory bandwidth
+// rather than computation, and more threads just mean more synchronization.
+static const long RENDER_MAX_THREADS = 8;
+
+// default minimum number of cells in a parallel blit
+static const unsigned BLIT_PARALLEL_CELLS = 4096;
+
 void notcurses_version_components(int* major, int* minor, int* patch, int* tweak){
   *major = NOTCURSES_VERNUM_MAJOR;
   *minor = NOTCURSES_VERNUM_MINOR;
@@ -157,7 +164,7 @@ char* ncplane_at_cursor(ncplane* n, uint16_t* stylemask, uint64_t* channels){
 char* ncplane_at_yx(const ncplane* n, int y, int x, uint16_t* stylemask, uint64_t* channels){
   if(y < n->leny && x < n->lenx){
     if(y >= 0 && x >= 0){
-      return nccell_extract(n, &n->fb[nfbcellidx(n, y, x)], stylemask, channels);
+      return nccell_extract(n, ncplane_cell_const(n, y, x), stylemask, channels);
     }
   }
   return NULL;
@@ -170,7 +177,7 @@ int ncplane_at_cursor_cell(ncplane* n, nccell* c){
 int ncplane_at_yx_cell(ncplane* n, int y, int x, nccell* c){
   if(y < n->leny && x < n->lenx){
     if(y >= 0 && x >= 0){
-      nccell* targ = ncplane_cell_ref_yx(n, y, x);
+      const nccell* targ = ncplane_cell_const(n, y, x);
       if(nccell_duplicate(n, c, targ) == 0){
         return strlen(nccell_extended_gcluster(n, targ));
       }
@@ -188,9 +195,7 @@ void ncplane_dim_yx(const ncplane* n, int* rows, int* cols){
   }
 }
 
-// anyone calling this needs ensure the ncplane's framebuffer is updated
-// to reflect changes in geometry. also called at startup for standard plane.
-int update_term_dimensions(int fd, int* rows, int* cols, tinfo* tcache){
+int term_geometry(int fd, int* rows, int* cols, int* cellpixy, int* cellpixx){
   // if we're not a real tty, we presumably haven't changed geometry, return
   if(fd < 0){
     if(rows){
@@ -199,9 +204,11 @@ int update_term_dimensions(int fd, int* rows, int* cols, tinfo* tcache){
     if(cols){
       *cols = DEFAULT_COLS;
     }
-    if(tcache){
-      tcache->cellpixy = 0;
-      tcache->cellpixx = 0;
+    if(cellpixy){
+      *cellpixy = 0;
+    }
+    if(cellpixx){
+      *cellpixx = 0;
     }
     return 0;
   }
@@ -222,13 +229,24 @@ int update_term_dimensions(int fd, int* rows, int* cols, tinfo* tcache){
   if(cols){
     *cols = ws.ws_col;
   }
-  if(tcache){
-    tcache->cellpixy = ws.ws_row ? ws.ws_ypixel / ws.ws_row : 0;
-    tcache->cellpixx = ws.ws_col ? ws.ws_xpixel / ws.ws_col : 0;
+  if(cellpixy){
+    *cellpixy = ws.ws_ypixel / ws.ws_row;
+  }
+  if(cellpixx){
+    *cellpixx = ws.ws_xpixel / ws.ws_col;
   }
   return 0;
 }
 
+// anyone calling this needs ensure the ncplane's framebuffer is updated
+// to reflect changes in geometry. also called at startup for standard plane.
+int update_term_dimensions(int fd, int* rows, int* cols, tinfo* tcache){
+  if(tcache){
+    return term_geometry(fd, rows, cols, &tcache->cellpixy, &tcache->cellpixx);
+  }
+  return term_geometry(fd, rows, cols, NULL, NULL);
+}
+
 // destroy the sprixels of an ncpile (this will not hide the sprixels)
 static void
 free_sprixels(ncpile* n){
@@ -246,20 +264,123 @@ ncpile_destroy(ncpile* pile){
     pile->prev->next = pile->next;
     pile->next->prev = pile->prev;
     free_sprixels(pile);
-    free(pile->crender);
+    if(pile->nc->lastpile == pile){
+      pile->nc->lastpile = NULL;
+    }
+    rendervec_free(&pile->rvec);
+    free(pile->rowflags);
+    free(pile->damage);
+    pileindex_destroy(&pile->index);
     free(pile);
   }
 }
 
+// a zeroed framebuffer of 'cells' cells
+static nccell*
+fb_new(notcurses* nc, int cells){
+  nccell* fb = slab_fb_alloc(nc, cells);
+  if(fb){
+    memset(fb, 0, sizeof(*fb) * cells);
+  }
+  return fb;
+}
+
+// free the tiles of a sparse plane of 'leny' by 'lenx', and the tile array
+static void
+tiles_free(notcurses* nc, nccell** tiles, int leny, int lenx){
+  if(tiles){
+    for(int t = 0 ; t < ncplane_tilecount(leny) ; ++t){
+      slab_fb_free(nc, tiles[t], ncplane_tilecells(leny, lenx, t));
+    }
+    free(tiles);
+  }
+}
+
+// bytes of cell storage held by 'n'
+static size_t
+ncplane_fbbytes(notcurses* nc, const ncplane* n){
+  if(n->tiles == NULL){
+    return slab_fb_bytes(nc, n->leny * n->lenx);
+  }
+  size_t ret = 0;
+  for(int t = 0 ; t < ncplane_tilecount(n->leny) ; ++t){
+    if(n->tiles[t]){
+      ret += slab_fb_bytes(nc, ncplane_tilecells(n->leny, n->lenx, t));
+    }
+  }
+  return ret;
+}
+
+nccell* ncplane_tile_alloc(ncplane* n, int t){
+  // ncdirect fakes an ncplane with no ->pile
+  notcurses* nc = ncplane_pile(n) ? ncplane_notcurses(n) : NULL;
+  const int cells = ncplane_tilecells(n->leny, n->lenx, t);
+  if((n->tiles[t] = fb_new(nc, cells)) == NULL){
+    return NULL;
+  }
+  if(nc){
+    pthread_mutex_lock(&nc->statlock);
+    nc->stats.fbbytes += slab_fb_bytes(nc, cells);
+    pthread_mutex_unlock(&nc->statlock);
+  }
+  return n->tiles[t];
+}
+
+int ncplane_adopt_fb(ncplane* n, nccell* fb){
+  // ncdirect fakes an ncplane with no ->pile
+  notcurses* nc = ncplane_pile(n) ? ncplane_notcurses(n) : NULL;
+  for(int y = 0 ; y < n->leny ; ++y){
+    nccell* row = ncplane_row_extant(n, y);
+    for(int x = 0 ; row && x < n->lenx ; ++x){
+      pool_release(&n->pool, &row[x]);
+    }
+  }
+  n->logrow = 0;
+  if(n->tiles == NULL){
+    slab_fb_free(nc, n->fb, n->leny * n->lenx);
+    n->fb = fb;
+    return 0;
+  }
+  if(nc){
+    pthread_mutex_lock(&nc->statlock);
+    nc->stats.fbbytes -= ncplane_fbbytes(nc, n);
+    pthread_mutex_unlock(&nc->statlock);
+  }
+  for(int t = 0 ; t < ncplane_tilecount(n->leny) ; ++t){
+    slab_fb_free(nc, n->tiles[t], ncplane_tilecells(n->leny, n->lenx, t));
+    n->tiles[t] = NULL;
+  }
+  int ret = 0;
+  for(int y = 0 ; y < n->leny ; ++y){
+    const nccell* src = fb + y * n->lenx;
+    if(memcmp(src, n->zerorow, sizeof(*src) * n->lenx) == 0){
+      continue;
+    }
+    nccell* row = ret ? NULL : ncplane_row(n, y);
+    if(row == NULL){ // drop what we can't store
+      for(int x = 0 ; x < n->lenx ; ++x){
+        pool_release(&n->pool, &fb[y * n->lenx + x]);
+      }
+      ret = -1;
+      continue;
+    }
+    memcpy(row, src, sizeof(*src) * n->lenx);
+  }
+  slab_fb_free(nc, fb, n->leny * n->lenx);
+  return ret;
+}
+
 void free_plane(ncplane* p){
   if(p){
     // ncdirect fakes an ncplane with no ->pile
+    notcurses* nc = NULL;
     if(ncplane_pile(p)){
-      notcurses* nc = ncplane_notcurses(p);
+      nc = ncplane_notcurses(p);
       pthread_mutex_lock(&nc->statlock);
       --ncplane_notcurses(p)->stats.planes;
-      ncplane_notcurses(p)->stats.fbbytes -= sizeof(*p->fb) * p->leny * p->lenx;
+      ncplane_notcurses(p)->stats.fbbytes -= ncplane_fbbytes(nc, p);
       pthread_mutex_unlock(&nc->statlock);
+      ncplane_index_remove(p);
       if(p->above == NULL && p->below == NULL){
         pthread_mutex_lock(&nc->pilelock);
         ncpile_destroy(ncplane_pile(p));
@@ -278,10 +399,20 @@ void free_plane(ncplane* p){
       }
     }
     free(p->tam);
+    if(p->layer){
+      rendervec_free(&p->layer->rvec);
+      free(p->layer);
+    }
+    free(p->blitdelta);
     egcpool_dump(&p->pool);
     free(p->name);
-    free(p->fb);
-    free(p);
+    if(p->tiles){
+      tiles_free(nc, p->tiles, p->leny, p->lenx);
+      free(p->zerorow);
+    }else{
+      slab_fb_free(nc, p->fb, p->leny * p->lenx);
+    }
+    slab_plane_free(nc, p);
   }
 }
 
@@ -309,13 +440,42 @@ make_ncpile(notcurses* nc, ncplane* n){
     n->below = NULL;
     ret->dimy = 0;
     ret->dimx = 0;
-    ret->crender = NULL;
+    ret->cellpixy = 0;
+    ret->cellpixx = 0;
+    ret->rvec.cells = NULL;
+    ret->rvec.crender = NULL;
+    ret->rvec.aux = NULL;
     ret->crenderlen = 0;
     ret->sprixelcache = NULL;
+    ret->rowflags = NULL;
+    ret->damage = NULL;
+    ret->orphanmin = INT_MAX;
+    ret->orphanmax = INT_MIN;
+    ret->repaint = true;
+    n->rendleny = 0;
+    pileindex_init(&ret->index);
+    n->zrank = 0;
+    ncplane_index_update(n);
   }
   return ret;
 }
 
+// 'n' is leaving its pile, either through destruction or reparenting. the
+// region into which it was last rendered must be repainted.
+static void
+ncplane_orphan(ncplane* n){
+  ncpile* pile = ncplane_pile(n);
+  if(n->rendleny){
+    if(n->rendabsy < pile->orphanmin){
+      pile->orphanmin = n->rendabsy;
+    }
+    if(n->rendabsy + n->rendleny - 1 > pile->orphanmax){
+      pile->orphanmax = n->rendabsy + n->rendleny - 1;
+    }
+    n->rendleny = 0;
+  }
+}
+
 // create a new ncplane at the specified location (relative to the true screen,
 // having origin at 0,0), having the specified size, and put it at the top of
 // the planestack. its cursor starts at its origin; its style starts as null.
@@ -330,7 +490,7 @@ make_ncpile(notcurses* nc, ncplane* n){
 // (as once more is n).
 ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
                               const ncplane_options* nopts){
-  if(nopts->flags >= (NCPLANE_OPTION_MARGINALIZED << 1u)){
+  if(nopts->flags >= (NCPLANE_OPTION_SPARSE << 1u)){
     logwarn(nc, "Provided unsupported flags %016jx\n", (uintmax_t)nopts->flags);
   }
   if(nopts->flags & NCPLANE_OPTION_HORALIGNED || nopts->flags & NCPLANE_OPTION_VERALIGNED){
@@ -350,7 +510,7 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
              nopts->rows, nopts->cols);
     return NULL;
   }
-  ncplane* p = malloc(sizeof(*p));
+  ncplane* p = slab_plane_alloc(nc);
   if(p == NULL){
     return NULL;
   }
@@ -374,14 +534,25 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
     p->leny = nopts->rows;
     p->lenx = nopts->cols;
   }
-  size_t fbsize = sizeof(*p->fb) * (p->leny * p->lenx);
-  if((p->fb = malloc(fbsize)) == NULL){
+  size_t fbsize = 0;
+  p->fb = NULL;
+  p->tiles = NULL;
+  p->zerorow = NULL;
+  if(nopts->flags & NCPLANE_OPTION_SPARSE){
+    p->tiles = calloc(ncplane_tilecount(p->leny), sizeof(*p->tiles));
+    p->zerorow = calloc(p->lenx, sizeof(*p->zerorow));
+  }else{
+    fbsize = slab_fb_bytes(nc, p->leny * p->lenx);
+    p->fb = fb_new(nc, p->leny * p->lenx);
+  }
+  if(p->fb == NULL && (p->tiles == NULL || p->zerorow == NULL)){
     logerror(nc, "Error allocating cellmatrix (r=%d, c=%d)\n",
              p->leny, p->lenx);
-    free(p);
+    free(p->tiles);
+    free(p->zerorow);
+    slab_plane_free(nc, p);
     return NULL;
   }
-  memset(p->fb, 0, fbsize);
   p->x = p->y = 0;
   p->logrow = 0;
   p->sprite = NULL;
@@ -390,6 +561,15 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
   p->halign = NCALIGN_UNALIGNED;
   p->valign = NCALIGN_UNALIGNED;
   p->tam = NULL;
+  p->dirtymin = INT_MAX;
+  p->dirtymax = INT_MIN;
+  p->scrolled = 0;
+  p->rendabsy = p->rendabsx = 0;
+  p->rendleny = p->rendlenx = 0;
+  p->indexed = false;
+  p->indexmark = 0;
+  p->layer = NULL;
+  p->blitdelta = NULL;
   if(!n){ // new root/standard plane
     p->absy = nopts->y;
     p->absx = nopts->x;
@@ -423,6 +603,7 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
   p->stylemask = 0;
   p->channels = 0;
   egcpool_init(&p->pool);
+  p->pool.intern = true;
   nccell_init(&p->basecell);
   p->userptr = nopts->userptr;
   if(nc == NULL){ // fake ncplane backing ncdirect object
@@ -440,6 +621,8 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
         pile->bottom = p;
       }
       pile->top = p;
+      p->zrank = p->below ? p->below->zrank - 1 : 0;
+      ncplane_index_update(p);
     }else{ // new pile
       make_ncpile(nc, p);
     }
@@ -552,7 +735,7 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
     .userptr = opaque,
     .name = n->name,
     .resizecb = ncplane_resizecb(n),
-    .flags = 0,
+    .flags = n->tiles ? NCPLANE_OPTION_SPARSE : 0,
   };
   ncplane* newn = ncplane_create(n->boundto, &nopts);
   if(newn){
@@ -567,7 +750,22 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
       newn->halign = n->halign;
       newn->stylemask = ncplane_styles(n);
       newn->channels = ncplane_channels(n);
-      memmove(newn->fb, n->fb, sizeof(*n->fb) * dimx * dimy);
+      if(n->tiles){
+        for(int t = 0 ; t < ncplane_tilecount(dimy) ; ++t){
+          if(n->tiles[t]){
+            if(ncplane_tile_alloc(newn, t) == NULL){
+              ncplane_destroy(newn);
+              return NULL;
+            }
+            memcpy(newn->tiles[t], n->tiles[t],
+                   sizeof(*n->fb) * ncplane_tilecells(dimy, dimx, t));
+          }
+        }
+      }else{
+        memmove(newn->fb, n->fb, sizeof(*n->fb) * dimx * dimy);
+      }
+      // we copied the storage verbatim, so adopt its row rotation
+      newn->logrow = n->logrow;
       // we dupd the egcpool, so just dup the goffset
       newn->basecell = n->basecell;
     }
@@ -635,16 +833,105 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
   if(n->sprite){
     sprixel_hide(n->sprite);
   }
-  // we're good to resize. we'll need alloc up a new framebuffer, and copy in
-  // those elements we're retaining, zeroing out the rest. alternatively, if
-  // we've shrunk, we will be filling the new structure.
-  int keptarea = keepleny * keeplenx;
-  int newarea = ylen * xlen;
-  size_t fbsize = sizeof(nccell) * newarea;
-  nccell* fb = malloc(fbsize);
-  if(fb == NULL){
-    return -1;
+  // we're good to resize. we'll need alloc up new storage, and copy in those
+  // elements we're retaining, zeroing out the rest. alternatively, if we've
+  // shrunk, we will be filling the new structure. a sparse plane gets new
+  // tiles only where it has something to copy; the rest remain unwritten.
+  const int keptarea = keepleny * keeplenx;
+  nccell* fb = NULL;
+  nccell** tiles = NULL;
+  nccell* zerorow = NULL;
+  size_t fbsize = 0;
+  if(n->tiles){
+    tiles = calloc(ncplane_tilecount(ylen), sizeof(*tiles));
+    zerorow = calloc(xlen, sizeof(*zerorow));
+    if(tiles == NULL || zerorow == NULL){
+      free(tiles);
+      free(zerorow);
+      return -1;
+    }
+  }else{
+    if((fb = slab_fb_alloc(nc, ylen * xlen)) == NULL){
+      return -1;
+    }
+    fbsize = slab_fb_bytes(nc, ylen * xlen);
   }
+  // we currently have rows x cols cells. we will be keeping rows
+  // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1.
+  // anything else is zerod out. itery is the row we're writing *to*, and we
+  // must write to each (and every cell in each) of a dense plane. the copied
+  // cells take over the references of the originals.
+  for(int itery = 0 ; itery < ylen ; ++itery){
+    const int sourceoffy = itery + keepy + yoff;
+    // NULL if we have nothing copied to this line
+    const nccell* src = NULL;
+    if(keptarea && sourceoffy >= keepy && sourceoffy < keepy + keepleny){
+      src = ncplane_row_extant(n, sourceoffy);
+    }
+    nccell* dst;
+    if(fb){
+      dst = fb + itery * xlen;
+    }else{
+      if(src == NULL){
+        continue;
+      }
+      const int t = itery / NCPLANE_TILE_ROWS;
+      if(tiles[t] == NULL){
+        const int tcells = ncplane_tilecells(ylen, xlen, t);
+        if((tiles[t] = fb_new(nc, tcells)) == NULL){
+          tiles_free(nc, tiles, ylen, xlen);
+          free(zerorow);
+          return -1;
+        }
+        fbsize += slab_fb_bytes(nc, tcells);
+      }
+      dst = tiles[t] + (itery % NCPLANE_TILE_ROWS) * xlen;
+    }
+    // zero it out in one go
+    if(src == NULL){
+      memset(dst, 0, sizeof(*dst) * xlen);
+      continue;
+    }
+    // we do have something to copy, and zero, one, or two regions to zero out
+    int copied = 0;
+    if(xoff < 0){
+      memset(dst, 0, sizeof(*dst) * -xoff);
+      copied += -xoff;
+    }
+    memcpy(dst + copied, src + keepx, sizeof(*dst) * keeplenx);
+    copied += keeplenx;
+    if(xlen > copied){
+      memset(dst + copied, 0, sizeof(*dst) * (xlen - copied));
+    }
+  }
+  // we can no longer fail. release whatever we're not keeping, so that its
+  // pool space can be reused.
+  for(int y = 0 ; y < rows ; ++y){
+    nccell* row = ncplane_row_extant(n, y);
+    if(row == NULL){
+      continue;
+    }
+    for(int x = 0 ; x < cols ; ++x){
+      if(y < keepy || y >= keepy + keepleny || x < keepx || x >= keepx + keeplenx){
+        pool_release(&n->pool, &row[x]);
+      }
+    }
+  }
+  pthread_mutex_lock(&nc->statlock);
+  nc->stats.fbbytes -= ncplane_fbbytes(nc, n);
+  nc->stats.fbbytes += fbsize;
+  pthread_mutex_unlock(&nc->statlock);
+  if(n->tiles){
+    tiles_free(nc, n->tiles, rows, cols);
+    free(n->zerorow);
+  }else{
+    slab_fb_free(nc, n->fb, rows * cols);
+  }
+  n->fb = fb;
+  n->tiles = tiles;
+  n->zerorow = zerorow;
+  // the new storage starts at logical row 0
+  n->logrow = 0;
   // update the cursor, if it would otherwise be off-plane
   if(n->y >= ylen){
     n->y = ylen - 1;
@@ -652,63 +939,15 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
   if(n->x >= xlen){
     n->x = xlen - 1;
   }
-  nccell* preserved = n->fb;
-  pthread_mutex_lock(&nc->statlock);
-  ncplane_notcurses(n)->stats.fbbytes -= sizeof(*preserved) * (rows * cols);
-  ncplane_notcurses(n)->stats.fbbytes += fbsize;
-  pthread_mutex_unlock(&nc->statlock);
-  n->fb = fb;
-  const int oldabsy = n->absy;
-  // go ahead and move. we can no longer fail at this point. but don't yet
-  // resize, because n->len[xy] are used in fbcellidx() in the loop below. we
-  // don't use ncplane_move_yx(), because we want to planebinding-invariant.
+  // we don't use ncplane_move_yx(), because we want to planebinding-invariant.
   n->absy += keepy + yoff;
   n->absx += keepx + xoff;
 //fprintf(stderr, "absx: %d keepx: %d xoff: %d\n", n->absx, keepx, xoff);
-  if(keptarea == 0){ // keep nothing, resize/move only
-    // if we're keeping nothing, dump the old egcspool. otherwise, we go ahead
-    // and keep it. perhaps we ought compact it?
-    memset(fb, 0, sizeof(*fb) * newarea);
-    egcpool_dump(&n->pool);
-    n->lenx = xlen;
-    n->leny = ylen;
-    free(preserved);
-    return resize_callbacks_children(n);
-  }
-  // we currently have maxy rows of maxx cells each. we will be keeping rows
-  // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1.
-  // anything else is zerod out. itery is the row we're writing *to*, and we
-  // must write to each (and every cell in each).
-  for(int itery = 0 ; itery < ylen ; ++itery){
-    int truey = itery + n->absy;
-    int sourceoffy = truey - oldabsy;
-//fprintf(stderr, "sourceoffy: %d keepy: %d ylen: %d\n", sourceoffy, keepy, ylen);
-    // if we have nothing copied to this line, zero it out in one go
-    if(sourceoffy < keepy || sourceoffy >= keepy + keepleny){
-//fprintf(stderr, "writing 0s to line %d of %d\n", itery, ylen);
-      memset(fb + (itery * xlen), 0, sizeof(*fb) * xlen);
-    }else{
-      int copyoff = itery * xlen; // our target at any given time
-      // we do have something to copy, and zero, one, or two regions to zero out
-      int copied = 0;
-      if(xoff < 0){
-        memset(fb + copyoff, 0, sizeof(*fb) * -xoff);
-        copyoff += -xoff;
-        copied += -xoff;
-      }
-      const int sourceidx = nfbcellidx(n, sourceoffy, keepx);
-//fprintf(stderr, "copying line %d (%d) to %d (%d)\n", sourceoffy, sourceidx, copyoff / xlen, copyoff);
-      memcpy(fb + copyoff, preserved + sourceidx, sizeof(*fb) * keeplenx);
-      copyoff += keeplenx;
-      copied += keeplenx;
-      if(xlen > copied){
-        memset(fb + copyoff, 0, sizeof(*fb) * (xlen - copied));
-      }
-    }
-  }
   n->lenx = xlen;
   n->leny = ylen;
-  free(preserved);
+  ncplane_index_update(n);
+  ncplane_dirty(n);
+  ncplane_compact_sparse(n);
   return resize_callbacks_children(n);
 }
 
@@ -734,6 +973,7 @@ int ncplane_destroy(ncplane* ncp){
   loginfo(ncplane_notcurses_const(ncp), "Destroying %dx%d plane \"%s\" @ %dx%d\n",
           ncp->leny, ncp->lenx, ncp->name ? ncp->name : NULL, ncp->absy, ncp->absx);
   int ret = 0;
+  ncplane_layer_invalidate(ncp->boundto);
   // dissolve our binding from behind (->bprev is either NULL, or its
   // predecessor on the bound list's ->bnext, or &ncp->boundto->blist)
   if(ncp->bprev){
@@ -754,6 +994,7 @@ int ncplane_destroy(ncplane* ncp){
   // extract ourselves from the z-axis. do this *after* reparenting, in case
   // reparenting shifts up the z-axis somehow (though i don't think it can,
   // at least not within a pile?).
+  ncplane_orphan(ncp);
   if(ncp->above){
     ncp->above->below = ncp->below;
   }else{
@@ -784,6 +1025,17 @@ int ncplane_genocide(ncplane *ncp){
   return ret;
 }
 
+// as term_fg_palindex_file(), for the RGB flourish in the banner
+static int
+banner_fg_rgb8(const notcurses* nc, FILE* out, unsigned r, unsigned g, unsigned b){
+  fbuf f = {};
+  if(term_fg_rgb8(&nc->tcache, &f, r, g, b)){
+    fbuf_free(&f);
+    return -1;
+  }
+  return fbuf_finalize(&f, out);
+}
+
 // only invoked without suppress banners flag. prints various warnings based on
 // the environment / terminal definition.
 static void
@@ -791,7 +1043,7 @@ init_banner_warnings(const notcurses* nc, FILE* out){
   // might be using stderr, so don't just reuse stdout decision
   const bool tty = isatty(fileno(out));
   if(tty){
-    term_fg_palindex(nc, out, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
+    term_fg_palindex_file(nc, out, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
   }
   if(!nc->tcache.RGBflag){ // FIXME
     fprintf(out, "\n Warning! Colors subject to https://github.com/dankamongmen/notcurses/issues/4");
@@ -820,31 +1072,33 @@ static void
 init_banner(const notcurses* nc, const char* shortname_term){
   if(!nc->suppress_banner){
     char prefixbuf[BPREFIXSTRLEN + 1];
-    term_fg_palindex(nc, stdout, 50 % nc->tcache.colors);
+    term_fg_palindex_file(nc, stdout, 50 % nc->tcache.colors);
     printf("\n notcurses %s by nick black et al", notcurses_version());
     printf(" on %s", shortname_term ? shortname_term : "?");
-    term_fg_palindex(nc, stdout, 12 % nc->tcache.colors);
+    term_fg_palindex_file(nc, stdout, 12 % nc->tcache.colors);
     if(nc->tcache.cellpixy && nc->tcache.cellpixx){
       printf("\n  %d rows (%dpx) %d cols (%dpx) (%sB) %zuB crend %d colors",
              nc->stdplane->leny, nc->tcache.cellpixy,
              nc->stdplane->lenx, nc->tcache.cellpixx,
              bprefix(nc->stats.fbbytes, 1, prefixbuf, 0),
-             sizeof(struct crender), nc->tcache.colors);
+             sizeof(nccell) + sizeof(struct crender) + sizeof(struct crenderaux),
+             nc->tcache.colors);
     }else{
       printf("\n  %d rows %d cols (%sB) %zuB crend %d colors",
              nc->stdplane->leny, nc->stdplane->lenx,
              bprefix(nc->stats.fbbytes, 1, prefixbuf, 0),
-             sizeof(struct crender), nc->tcache.colors);
+             sizeof(nccell) + sizeof(struct crender) + sizeof(struct crenderaux),
+             nc->tcache.colors);
     }
     if(nc->tcache.RGBflag){
       putc('+', stdout);
-      term_fg_rgb8(true, nc->tcache.setaf, nc->tcache.colors, stdout, 0xe0, 0x60, 0x60);
+      banner_fg_rgb8(nc, stdout, 0xe0, 0x60, 0x60);
       putc('R', stdout);
-      term_fg_rgb8(true, nc->tcache.setaf, nc->tcache.colors, stdout, 0x60, 0xe0, 0x60);
+      banner_fg_rgb8(nc, stdout, 0x60, 0xe0, 0x60);
       putc('G', stdout);
-      term_fg_rgb8(true, nc->tcache.setaf, nc->tcache.colors, stdout, 0x20, 0x80, 0xff);
+      banner_fg_rgb8(nc, stdout, 0x20, 0x80, 0xff);
       putc('B', stdout);
-      term_fg_palindex(nc, stdout, nc->tcache.colors <= 256 ? 12 % nc->tcache.colors : 0x2080e0);
+      term_fg_palindex_file(nc, stdout, nc->tcache.colors <= 256 ? 12 % nc->tcache.colors : 0x2080e0);
     }
     printf("\n  compiled with gcc-%s, %zuB %s-endian cells\n"
            "  terminfo from %s\n",
@@ -961,15 +1215,18 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     fprintf(stderr, "Provided an illegal negative margin, refusing to start\n");
     return NULL;
   }
-  if(opts->flags >= (NCOPTION_NO_FONT_CHANGES << 1u)){
+  if(opts->flags >= (NCOPTION_COALESCE_OUTPUT << 1u)){
     fprintf(stderr, "Warning: unknown Notcurses options %016jx\n", (uintmax_t)opts->flags);
   }
   notcurses* ret = malloc(sizeof(*ret));
   if(ret == NULL){
     return ret;
   }
-  ret->rstate.mstream = NULL;
-  ret->rstate.mstreamfp = NULL;
+  memset(&ret->rstate.f, 0, sizeof(ret->rstate.f));
+  ret->rstate.framelen = 0;
+  ret->rstate.markrows = false;
+  ret->rstate.rowmarks = NULL;
+  ret->rstate.rowmarkcount = ret->rstate.rowmarkalloc = 0;
   ret->loglevel = opts->loglevel;
   if(!(opts->flags & NCOPTION_INHIBIT_SETLOCALE)){
     init_lang(ret);
@@ -1005,7 +1262,14 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
   ret->lastframe = NULL;
   ret->lfdimy = 0;
   ret->lfdimx = 0;
+  ret->workpool = NULL;
+  ret->lastpile = NULL;
+  ret->damagescan = damagescan_best();
+  ret->blitthreshold = BLIT_PARALLEL_CELLS;
+  ret->writer = NULL;
+  ret->scheduler = NULL;
   egcpool_init(&ret->pool);
+  ret->pool.intern = true;
   if((ret->loglevel = opts->loglevel) > NCLOGLEVEL_TRACE || ret->loglevel < 0){
     fprintf(stderr, "Invalid loglevel %d\n", ret->loglevel);
     free(ret);
@@ -1036,9 +1300,16 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     free(ret);
     return NULL;
   }
+  if(slab_init(&ret->slab)){
+    pthread_mutex_destroy(&ret->statlock);
+    pthread_mutex_destroy(&ret->pilelock);
+    free(ret);
+    return NULL;
+  }
   if(setup_signals(ret, (opts->flags & NCOPTION_NO_QUIT_SIGHANDLERS),
                    (opts->flags & NCOPTION_NO_WINCH_SIGHANDLER),
                    notcurses_stop_minimal)){
+    slab_destroy(&ret->slab);
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->statlock);
     free(ret);
@@ -1095,11 +1366,33 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
       goto err;
     }
   }
-  if((ret->rstate.mstreamfp = open_memstream(&ret->rstate.mstream, &ret->rstate.mstrsize)) == NULL){
-    free_plane(ret->stdplane);
-    goto err;
-  }
   ret->rstate.x = ret->rstate.y = -1;
+  if(opts->flags & NCOPTION_PARALLEL_RENDER){
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus > 1){
+      if(cpus > RENDER_MAX_THREADS){
+        cpus = RENDER_MAX_THREADS;
+      }
+      // failure here just leaves us rendering serially
+      if((ret->workpool = workpool_create(cpus - 1)) == NULL){
+        logwarn(ret, "Couldn't launch render threads, rendering serially\n");
+      }
+    }
+  }
+  if(opts->flags & (NCOPTION_ASYNC_OUTPUT | NCOPTION_COALESCE_OUTPUT)){
+    const bool coalesce = opts->flags & NCOPTION_COALESCE_OUTPUT;
+    // failure here just leaves us writing synchronously
+    if((ret->writer = writer_create(ret->ttyfd, coalesce)) == NULL){
+      logwarn(ret, "Couldn't launch writer thread, writing synchronously\n");
+    }else if(coalesce){
+      // the writer can only notice a request to cut a frame short between
+      // writes, which mustn't block until the entire frame is written.
+      if(set_fd_nonblocking(ret->ttyfd, 1, &ret->ttyfd_blocking_save)){
+        logwarn(ret, "Couldn't make tty nonblocking, not coalescing output\n");
+        ret->writer->coalesce = false;
+      }
+    }
+  }
   init_banner(ret, shortname_term);
   // flush on the switch to alternate screen, lest initial output be swept away
   if(ret->ttyfd >= 0){
@@ -1126,12 +1419,15 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
 err:
   fprintf(stderr, "Alas, you will not be going to space today.\n");
   // FIXME looks like we have some memory leaks on this error path?
-  if(ret->rstate.mstreamfp){
-    fclose(ret->rstate.mstreamfp);
+  fbuf_free(&ret->rstate.f);
+  workpool_destroy(ret->workpool);
+  if(ret->writer && ret->writer->coalesce){
+    set_fd_nonblocking(ret->ttyfd, ret->ttyfd_blocking_save, NULL);
   }
-  free(ret->rstate.mstream);
+  writer_destroy(ret->writer);
   tcsetattr(ret->ttyfd, TCSANOW, &ret->tpreserved);
   drop_signals(ret);
+  slab_destroy(&ret->slab);
   pthread_mutex_destroy(&ret->statlock);
   pthread_mutex_destroy(&ret->pilelock);
   free(ret);
@@ -1155,6 +1451,7 @@ ncpile_drop(notcurses* nc, ncpile** pile){
   }
   *pile = next;
   if(sawstdplane){
+    ncplane_pile(nc->stdplane)->repaint = true;
     ncplane_pile(nc->stdplane)->top = nc->stdplane;
     ncplane_pile(nc->stdplane)->bottom = nc->stdplane;
     nc->stdplane->above = nc->stdplane->below = NULL;
@@ -1176,15 +1473,23 @@ void notcurses_drop_planes(notcurses* nc){
 int notcurses_stop(notcurses* nc){
   int ret = 0;
   if(nc){
+    // render any requested frame, and flush any frames still in flight,
+    // before we write anything else
+    ret |= scheduler_destroy(nc->scheduler);
+    nc->scheduler = NULL;
+    if(nc->writer && nc->writer->coalesce){
+      ret |= set_fd_nonblocking(nc->ttyfd, nc->ttyfd_blocking_save, NULL);
+    }
+    ret |= writer_destroy(nc->writer);
+    nc->writer = NULL;
     ret |= notcurses_stop_minimal(nc);
     ret |= set_fd_nonblocking(nc->input.ttyinfd, nc->stdio_blocking_save, NULL);
     if(nc->stdplane){
       notcurses_drop_planes(nc);
       free_plane(nc->stdplane);
     }
-    if(nc->rstate.mstreamfp){
-      fclose(nc->rstate.mstreamfp);
-    }
+    workpool_destroy(nc->workpool);
+    slab_destroy(&nc->slab);
     // if we were not using the alternate screen, our cursor's wherever we last
     // wrote. move it to the bottom left of the screen.
     if(!nc->tcache.smcup){
@@ -1198,7 +1503,8 @@ int notcurses_stop(notcurses* nc){
     }
     egcpool_dump(&nc->pool);
     free(nc->lastframe);
-    free(nc->rstate.mstream);
+    fbuf_free(&nc->rstate.f);
+    free(nc->rstate.rowmarks);
     input_free_esctrie(&nc->input.inputescapes);
     // get any current stats loaded into stash_stats
     notcurses_stats_reset(nc, NULL);
@@ -1302,10 +1608,12 @@ int ncplane_set_base_cell(ncplane* ncp, const nccell* c){
   if(nccell_wide_right_p(c)){
     return -1;
   }
+  ncplane_dirty(ncp);
   return nccell_duplicate(ncp, &ncp->basecell, c);
 }
 
 int ncplane_set_base(ncplane* ncp, const char* egc, uint32_t stylemask, uint64_t channels){
+  ncplane_dirty(ncp);
   return nccell_prime(ncp, &ncp->basecell, egc, stylemask, channels);
 }
 
@@ -1354,6 +1662,8 @@ int ncplane_move_above(ncplane* restrict n, ncplane* restrict above){
     }
     above->above = n;
     n->below = above;
+    ncpile_zaxis_changed(ncplane_pile(n));
+    ncplane_dirty(n);
   }
   return 0;
 }
@@ -1384,6 +1694,8 @@ int ncplane_move_below(ncplane* restrict n, ncplane* restrict below){
     }
     below->below = n;
     n->above = below;
+    ncpile_zaxis_changed(ncplane_pile(n));
+    ncplane_dirty(n);
   }
   return 0;
 }
@@ -1400,6 +1712,8 @@ void ncplane_move_top(ncplane* n){
       n->below->above = n;
     }
     ncplane_pile(n)->top = n;
+    n->zrank = n->below->zrank - 1;
+    ncplane_dirty(n);
   }
 }
 
@@ -1415,6 +1729,8 @@ void ncplane_move_bottom(ncplane* n){
       n->above->below = n;
     }
     ncplane_pile(n)->bottom = n;
+    n->zrank = n->above->zrank + 1;
+    ncplane_dirty(n);
   }
 }
 
@@ -1438,11 +1754,16 @@ void scroll_down(ncplane* n){
   n->x = 0;
   if(n->y == n->leny - 1){
     n->logrow = (n->logrow + 1) % n->leny;
-    nccell* row = n->fb + nfbcellidx(n, n->y, 0);
-    for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
-      nccell_release(n, &row[clearx]);
+    ++n->scrolled;
+    // an unwritten row of a sparse plane is already clear
+    nccell* row = ncplane_row_extant(n, n->y);
+    if(row){
+      for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
+        nccell_release(n, &row[clearx]);
+      }
+      memset(row, 0, sizeof(*row) * n->lenx);
     }
-    memset(row, 0, sizeof(*row) * n->lenx);
+    ncplane_dirty(n); // every row has moved up
   }else{
     ++n->y;
   }
@@ -1513,13 +1834,17 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
   // obliterates the other half. Note that a wide char can thus obliterate two
   // wide chars, totalling four columns.
   nccell* targ = ncplane_cell_ref_yx(n, n->y, n->x);
+  if(targ == NULL){
+    return -1;
+  }
+  nccell* row = targ - n->x;
   if(n->x > 0){
     if(nccell_double_wide_p(targ)){ // replaced cell is half of a wide char
       nccell* sacrifice = targ->gcluster == 0 ?
         // right half will never be on the first column of a row
-        &n->fb[nfbcellidx(n, n->y, n->x - 1)] :
+        &row[n->x - 1] :
         // left half will never be on the last column of a row
-        &n->fb[nfbcellidx(n, n->y, n->x + 1)];
+        &row[n->x + 1];
       nccell_obliterate(n, sacrifice);
     }
   }
@@ -1532,9 +1857,9 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
   // must set our right hand sides wide, and check for further damage
   ++n->x;
   for(int i = 1 ; i < cols ; ++i){
-    nccell* candidate = &n->fb[nfbcellidx(n, n->y, n->x)];
+    nccell* candidate = &row[n->x];
     if(nccell_wide_left_p(candidate)){
-      nccell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 1)]);
+      nccell_obliterate(n, &row[n->x + 1]);
     }
     nccell_release(n, candidate);
     candidate->channels = targ->channels;
@@ -1567,7 +1892,7 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes)
 int ncplane_putchar_stained(ncplane* n, char c){
   uint64_t channels = n->channels;
   uint32_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putchar(n, c);
@@ -1579,7 +1904,7 @@ int ncplane_putchar_stained(ncplane* n, char c){
 int ncplane_putwegc_stained(ncplane* n, const wchar_t* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putwegc(n, gclust, sbytes);
@@ -1591,7 +1916,7 @@ int ncplane_putwegc_stained(ncplane* n, const wchar_t* gclust, int* sbytes){
 int ncplane_putegc_stained(ncplane* n, const char* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putegc(n, gclust, sbytes);
@@ -1604,7 +1929,7 @@ int ncplane_cursor_at(const ncplane* n, nccell* c, char** gclust){
   if(n->y == n->leny && n->x == n->lenx){
     return -1;
   }
-  const nccell* src = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* src = ncplane_cell_const(n, n->y, n->x);
   memcpy(c, src, sizeof(*src));
   if(cell_simple_p(c)){
     *gclust = NULL;
@@ -1965,6 +2290,7 @@ move_bound_planes(ncplane* n, int dy, int dx){
     }
     n->absy += dy;
     n->absx += dx;
+    ncplane_index_update(n);
     move_bound_planes(n->blist, dy, dx);
     n = n->bnext;
   }
@@ -1983,6 +2309,7 @@ int ncplane_move_yx(ncplane* n, int y, int x){
     }
     n->absx += dx;
     n->absy += dy;
+    ncplane_index_update(n);
     move_bound_planes(n->blist, dy, dx);
   }
   return 0;
@@ -2019,15 +2346,87 @@ void ncplane_erase(ncplane* n){
   // wiped out by the egcpool_dump(). do a duplication (to get the stylemask
   // and channels), and then reload.
   char* egc = nccell_strdup(n, &n->basecell);
-  memset(n->fb, 0, sizeof(*n->fb) * n->leny * n->lenx);
+  if(n->tiles){
+    // a sparse plane drops all its tiles, returning to the unwritten state
+    notcurses* nc = ncplane_pile(n) ? ncplane_notcurses(n) : NULL;
+    if(nc){
+      pthread_mutex_lock(&nc->statlock);
+      nc->stats.fbbytes -= ncplane_fbbytes(nc, n);
+      pthread_mutex_unlock(&nc->statlock);
+    }
+    for(int t = 0 ; t < ncplane_tilecount(n->leny) ; ++t){
+      slab_fb_free(nc, n->tiles[t], ncplane_tilecells(n->leny, n->lenx, t));
+      n->tiles[t] = NULL;
+    }
+  }else{
+    memset(n->fb, 0, sizeof(*n->fb) * n->leny * n->lenx);
+  }
+  ncplane_dirty(n);
+  const int oldsize = n->pool.poolsize;
   egcpool_dump(&n->pool);
-  egcpool_init(&n->pool);
   // we need to zero out the EGC before handing this off to cell_load, but
   // we don't want to lose the channels/attributes, so explicit gcluster load.
   n->basecell.gcluster = 0;
   nccell_load(n, &n->basecell, egc);
   free(egc);
   n->y = n->x = 0;
+  // dumping the pool amounts to the most thorough of compactions
+  if(oldsize > n->pool.poolsize && n->pile){
+    notcurses* nc = ncplane_notcurses(n);
+    pthread_mutex_lock(&nc->statlock);
+    ++nc->stats.pool_compactions;
+    nc->stats.pool_bytes_reclaimed += oldsize - n->pool.poolsize;
+    pthread_mutex_unlock(&nc->statlock);
+  }
+}
+
+// rebuild the egcpool of 'n' (see egcpool_compact()). an automatic compaction
+// which fails won't be retried until the pool has grown.
+static int
+ncplane_compact_internal(ncplane* n, bool automatic){
+  int reclaimed;
+  if(n->tiles){
+    const int tcount = ncplane_tilecount(n->leny);
+    size_t* lens = malloc(sizeof(*lens) * tcount);
+    if(lens == NULL){
+      reclaimed = -1;
+    }else{
+      for(int t = 0 ; t < tcount ; ++t){
+        lens[t] = ncplane_tilecells(n->leny, n->lenx, t);
+      }
+      reclaimed = egcpool_compact(&n->pool, n->tiles, lens, tcount, &n->basecell);
+      free(lens);
+    }
+  }else{
+    const size_t len = n->leny * n->lenx;
+    reclaimed = egcpool_compact(&n->pool, &n->fb, &len, 1, &n->basecell);
+  }
+  if(reclaimed < 0){
+    if(automatic){
+      n->pool.compactfail = n->pool.poolsize;
+    }
+    return -1;
+  }
+  // cells in the rendered frame may carry the old offsets
+  ncplane_dirty(n);
+  if(n->pile){
+    notcurses* nc = ncplane_notcurses(n);
+    pthread_mutex_lock(&nc->statlock);
+    ++nc->stats.pool_compactions;
+    nc->stats.pool_bytes_reclaimed += reclaimed;
+    pthread_mutex_unlock(&nc->statlock);
+  }
+  return 0;
+}
+
+int ncplane_compact(ncplane* n){
+  return ncplane_compact_internal(n, false);
+}
+
+void ncplane_compact_sparse(ncplane* n){
+  if(egcpool_sparse_p(&n->pool)){
+    ncplane_compact_internal(n, true);
+  }
 }
 
 ncplane* notcurses_top(notcurses* n){
@@ -2059,6 +2458,9 @@ ncplane* ncplane_above(ncplane* n){
 #define SET_SGR_MODE_MOUSE    "1006"
 int notcurses_mouse_enable(notcurses* n){
   if(n->ttyfd >= 0){
+    if(writer_drain(n->writer)){
+      return -1;
+    }
     return tty_emit(ESC "[?" SET_BTN_EVENT_MOUSE ";"
                     /*SET_FOCUS_EVENT_MOUSE ";" */SET_SGR_MODE_MOUSE "h",
                     n->ttyfd);
@@ -2070,6 +2472,9 @@ int notcurses_mouse_enable(notcurses* n){
 // the sequences 1000 etc?
 int notcurses_mouse_disable(notcurses* n){
   if(n->ttyfd >= 0){
+    if(writer_drain(n->writer)){
+      return -1;
+    }
     return tty_emit(ESC "[?" SET_BTN_EVENT_MOUSE ";"
                     /*SET_FOCUS_EVENT_MOUSE ";" */SET_SGR_MODE_MOUSE "l",
                     n->ttyfd);
@@ -2342,6 +2747,8 @@ ncplane* ncplane_reparent(ncplane* n, ncplane* newparent){
 // to be called before unbinding 'n' from old pile.
 static void
 unsplice_zaxis_recursive(ncplane* n){
+  ncplane_orphan(n);
+  ncplane_index_remove(n);
   if(ncplane_pile(n)->top == n){
     ncplane_pile(n)->top = n->below;
   }else{
@@ -2358,8 +2765,9 @@ unsplice_zaxis_recursive(ncplane* n){
 }
 
 // unsplice our sprixel from the pile's sprixellist, and then unsplice all
-// children, recursively. call before unbinding. returns a doubly-linked
-// list of any sprixels found.
+// children, recursively. call before unbinding. any sprixels found are
+// appended to the doubly-linked list ending at 'prev', and its new tail
+// is returned.
 static sprixel*
 unsplice_sprixels_recursive(ncplane* n, sprixel* prev){
   sprixel* s = n->sprite;
@@ -2379,19 +2787,18 @@ unsplice_sprixels_recursive(ncplane* n, sprixel* prev){
     prev = s;
   }
   for(ncplane* child = n->blist ; child ; child = child->bnext){
-    unsplice_sprixels_recursive(child, prev);
-    while(prev->next){ // FIXME lame
-      prev = prev->next;
-    }
+    prev = unsplice_sprixels_recursive(child, prev);
   }
   return prev;
 }
 
 // recursively splice 'n' and children into the z-axis, above 'n->boundto'.
 // handles 'n' == 'n->boundto'. to be called after binding 'n' into new pile.
+// the children join the pile of 'n', as does 'n' that of its new parent.
 static void
 splice_zaxis_recursive(ncplane* n){
   if(n != n->boundto){
+    n->pile = ncplane_pile(n->boundto);
     if((n->above = n->boundto->above) == NULL){
       n->pile->top = n;
     }else{
@@ -2399,6 +2806,8 @@ splice_zaxis_recursive(ncplane* n){
     }
     n->below = n->boundto;
     n->boundto->above = n;
+    ncpile_zaxis_changed(n->pile);
+    ncplane_index_update(n);
   }
   for(ncplane* child = n->blist ; child ; child = child->bnext){
     splice_zaxis_recursive(child);
@@ -2416,6 +2825,9 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
   if(n->boundto == newparent){ // no-op
     return n;
   }
+  // we leave any cached layer containing us, and possibly join another
+  ncplane_layer_invalidate(n);
+  ncplane_layer_invalidate(n->boundto);
   if(n->bprev){ // extract from sibling list
     if( (*n->bprev = n->bnext) ){
       n->bnext->bprev = n->bprev;
@@ -2426,21 +2838,28 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
   notcurses* nc = ncplane_notcurses(n);
   // if leaving a pile, extract n from the old zaxis, and also any sprixel
   sprixel* s = NULL;
-  if(n == newparent || ncplane_pile(n) != ncplane_pile(newparent)){
+  ncpile* oldpile = ncplane_pile(n);
+  if(n == newparent || oldpile != ncplane_pile(newparent)){
     unsplice_zaxis_recursive(n);
-    s = unsplice_sprixels_recursive(n, NULL);
+    // we get the tail of the list, but want its head
+    if( (s = unsplice_sprixels_recursive(n, NULL)) ){
+      while(s->prev){
+        s = s->prev;
+      }
+    }
   }
   n->boundto = newparent;
   if(n == n->boundto){ // we're a new root plane
     n->bnext = NULL;
     n->bprev = NULL;
-    splice_zaxis_recursive(n);
     pthread_mutex_lock(&nc->pilelock);
-    if(ncplane_pile(n)->top == NULL){ // did we just empty our pile?
-      ncpile_destroy(ncplane_pile(n));
+    if(oldpile->top == NULL){ // did we just empty our pile?
+      ncpile_destroy(oldpile);
     }
-    make_ncpile(ncplane_notcurses(n), n);
+    make_ncpile(nc, n);
     pthread_mutex_unlock(&nc->pilelock);
+    // our children follow us into the new pile
+    splice_zaxis_recursive(n);
   }else{ // establish ourselves as a sibling of new parent's children
     if( (n->bnext = newparent->blist) ){
       n->bnext->bprev = &n->bnext;
@@ -2448,13 +2867,12 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
     n->bprev = &newparent->blist;
     newparent->blist = n;
     // place it immediately above the new binding plane if crossing piles
-    if(n->pile != ncplane_pile(n->boundto)){
+    if(oldpile != ncplane_pile(n->boundto)){
       splice_zaxis_recursive(n);
       pthread_mutex_lock(&nc->pilelock);
-      if(ncplane_pile(n)->top == NULL){ // did we just empty our pile?
-        ncpile_destroy(ncplane_pile(n));
+      if(oldpile->top == NULL){ // did we just empty our pile?
+        ncpile_destroy(oldpile);
       }
-      n->pile = ncplane_pile(n->boundto);
       pthread_mutex_unlock(&nc->pilelock);
     }
   }
@@ -2468,6 +2886,7 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
     }
     n->pile->sprixelcache = s;
   }
+  ncplane_layer_invalidate(n->boundto);
   return n;
 }
 
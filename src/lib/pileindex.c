@@ -0,0 +1,367 @@
+#include "internal.h"
+
+// each pile keeps a spatial index of its planes, so that rendering and hit
+// testing needn't walk the entire z-axis. the absolute plane is divided into
+// buckets of PILEINDEX_ROWS by PILEINDEX_COLS cells, each listing the planes
+// which intersect it. buckets live in a chained hash keyed on their
+// coordinates, and exist only while nonempty. a plane spanning more than
+// PILEINDEX_MAXSPAN buckets is instead kept on the list of large planes, which
+// every query considers. results are sorted into z-order using a rank on each
+// plane, renumbered lazily following arbitrary changes to the z-axis.
+
+#define PILEINDEX_ROWS 16
+#define PILEINDEX_COLS 32
+#define PILEINDEX_MAXSPAN 64
+
+typedef struct pilebucket {
+  struct pilebucket* next; // hash chain
+  int by, bx;              // bucket coordinates
+  unsigned count, alloc;   // planes in use and allocated
+  ncplane** planes;
+} pilebucket;
+
+// floor of n / d, even for negative n
+static inline int
+floordiv(int n, int d){
+  int q = n / d;
+  if(n % d && n < 0){
+    --q;
+  }
+  return q;
+}
+
+static inline unsigned
+bucket_hash(const pileindex* pi, int by, int bx){
+  return ((unsigned)by * 2654435761u ^ (unsigned)bx * 40503u) & (pi->slots - 1);
+}
+
+static pilebucket*
+bucket_find(const pileindex* pi, int by, int bx){
+  if(pi->slots == 0){
+    return NULL;
+  }
+  for(pilebucket* b = pi->buckets[bucket_hash(pi, by, bx)] ; b ; b = b->next){
+    if(b->by == by && b->bx == bx){
+      return b;
+    }
+  }
+  return NULL;
+}
+
+// double the hash's slots (starting from 64), rechaining all buckets
+static int
+index_grow(pileindex* pi){
+  unsigned slots = pi->slots ? pi->slots * 2 : 64;
+  pilebucket** buckets = calloc(slots, sizeof(*buckets));
+  if(buckets == NULL){
+    return -1;
+  }
+  pileindex npi = *pi;
+  npi.buckets = buckets;
+  npi.slots = slots;
+  for(unsigned i = 0 ; i < pi->slots ; ++i){
+    pilebucket* b = pi->buckets[i];
+    while(b){
+      pilebucket* next = b->next;
+      const unsigned h = bucket_hash(&npi, b->by, b->bx);
+      b->next = buckets[h];
+      buckets[h] = b;
+      b = next;
+    }
+  }
+  free(pi->buckets);
+  pi->buckets = buckets;
+  pi->slots = slots;
+  return 0;
+}
+
+static int
+planelist_add(ncplane*** list, unsigned* count, unsigned* alloc, ncplane* p){
+  if(*count == *alloc){
+    unsigned nalloc = *alloc ? *alloc * 2 : 4;
+    ncplane** tmp = realloc(*list, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    *list = tmp;
+    *alloc = nalloc;
+  }
+  (*list)[(*count)++] = p;
+  return 0;
+}
+
+// remove 'p' from the list, if present. order is not preserved.
+static void
+planelist_del(ncplane** list, unsigned* count, const ncplane* p){
+  for(unsigned i = 0 ; i < *count ; ++i){
+    if(list[i] == p){
+      list[i] = list[--*count];
+      return;
+    }
+  }
+}
+
+static int
+bucket_add(pileindex* pi, int by, int bx, ncplane* p){
+  pilebucket* b = bucket_find(pi, by, bx);
+  if(b == NULL){
+    if(pi->bucketcount >= pi->slots * 2){
+      if(index_grow(pi)){
+        return -1;
+      }
+    }
+    if((b = malloc(sizeof(*b))) == NULL){
+      return -1;
+    }
+    b->by = by;
+    b->bx = bx;
+    b->count = 0;
+    b->alloc = 0;
+    b->planes = NULL;
+    const unsigned h = bucket_hash(pi, by, bx);
+    b->next = pi->buckets[h];
+    pi->buckets[h] = b;
+    ++pi->bucketcount;
+  }
+  return planelist_add(&b->planes, &b->count, &b->alloc, p);
+}
+
+static void
+bucket_del(pileindex* pi, int by, int bx, const ncplane* p){
+  if(pi->slots == 0){
+    return;
+  }
+  pilebucket** prev = &pi->buckets[bucket_hash(pi, by, bx)];
+  for(pilebucket* b = *prev ; b ; prev = &b->next, b = b->next){
+    if(b->by == by && b->bx == bx){
+      planelist_del(b->planes, &b->count, p);
+      if(b->count == 0){
+        *prev = b->next;
+        free(b->planes);
+        free(b);
+        --pi->bucketcount;
+      }
+      return;
+    }
+  }
+}
+
+int pileindex_init(pileindex* pi){
+  memset(pi, 0, sizeof(*pi));
+  return 0;
+}
+
+void pileindex_destroy(pileindex* pi){
+  for(unsigned i = 0 ; i < pi->slots ; ++i){
+    pilebucket* b = pi->buckets[i];
+    while(b){
+      pilebucket* next = b->next;
+      free(b->planes);
+      free(b);
+      b = next;
+    }
+  }
+  free(pi->buckets);
+  free(pi->large);
+  free(pi->hits);
+  memset(pi, 0, sizeof(*pi));
+}
+
+void ncplane_index_remove(ncplane* n){
+  ncpile* pile = ncplane_pile(n);
+  if(pile == NULL || !n->indexed){
+    return;
+  }
+  pileindex* pi = &pile->index;
+  if(n->indexlarge){
+    planelist_del(pi->large, &pi->largecount, n);
+  }else{
+    for(int by = n->iby0 ; by <= n->iby1 ; ++by){
+      for(int bx = n->ibx0 ; bx <= n->ibx1 ; ++bx){
+        bucket_del(pi, by, bx, n);
+      }
+    }
+  }
+  n->indexed = false;
+}
+
+// index 'n' under its current geometry. on failure, the index is marked
+// broken, to be rebuilt by the next query.
+static void
+index_insert(pileindex* pi, ncplane* n){
+  const int by0 = floordiv(n->absy, PILEINDEX_ROWS);
+  const int bx0 = floordiv(n->absx, PILEINDEX_COLS);
+  const int by1 = floordiv(n->absy + n->leny - 1, PILEINDEX_ROWS);
+  const int bx1 = floordiv(n->absx + n->lenx - 1, PILEINDEX_COLS);
+  n->iby0 = by0;
+  n->ibx0 = bx0;
+  n->iby1 = by1;
+  n->ibx1 = bx1;
+  n->indexed = true;
+  n->indexmark = 0; // might carry a generation from another pile
+  if((int64_t)(by1 - by0 + 1) * (bx1 - bx0 + 1) > PILEINDEX_MAXSPAN){
+    n->indexlarge = true;
+    if(planelist_add(&pi->large, &pi->largecount, &pi->largealloc, n)){
+      pi->broken = true;
+    }
+    return;
+  }
+  n->indexlarge = false;
+  for(int by = by0 ; by <= by1 ; ++by){
+    for(int bx = bx0 ; bx <= bx1 ; ++bx){
+      if(bucket_add(pi, by, bx, n)){
+        pi->broken = true;
+      }
+    }
+  }
+}
+
+void ncplane_index_update(ncplane* n){
+  ncpile* pile = ncplane_pile(n);
+  if(pile == NULL){
+    return;
+  }
+  if(n->indexed && !n->indexlarge){
+    // a move within our buckets needn't touch the index
+    if(floordiv(n->absy, PILEINDEX_ROWS) == n->iby0 &&
+       floordiv(n->absx, PILEINDEX_COLS) == n->ibx0 &&
+       floordiv(n->absy + n->leny - 1, PILEINDEX_ROWS) == n->iby1 &&
+       floordiv(n->absx + n->lenx - 1, PILEINDEX_COLS) == n->ibx1){
+      return;
+    }
+  }
+  ncplane_index_remove(n);
+  index_insert(&pile->index, n);
+}
+
+// reindex every plane of a broken index from scratch
+static int
+index_rebuild(ncpile* pile){
+  pileindex* pi = &pile->index;
+  pi->broken = false;
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    ncplane_index_remove(p);
+    index_insert(pi, p);
+  }
+  return pi->broken ? -1 : 0;
+}
+
+// renumber the z-axis, if it has changed other than at its ends
+static void
+index_rank(ncpile* pile){
+  if(pile->index.zstale){
+    int64_t rank = 0;
+    for(ncplane* p = pile->top ; p ; p = p->below){
+      p->zrank = rank++;
+    }
+    pile->index.zstale = false;
+  }
+}
+
+static int
+zrank_cmp(const void* va, const void* vb){
+  const ncplane* a = *(ncplane* const*)va;
+  const ncplane* b = *(ncplane* const*)vb;
+  return a->zrank < b->zrank ? -1 : a->zrank > b->zrank;
+}
+
+static inline bool
+plane_intersects(const ncplane* p, int y, int x, int leny, int lenx){
+  return p->absy < y + leny && y < p->absy + p->leny &&
+         p->absx < x + lenx && x < p->absx + p->lenx;
+}
+
+// add 'p' to the hits, unless it's already there or misses the region
+static int
+index_hit(pileindex* pi, ncplane* p, int y, int x, int leny, int lenx){
+  if(p->indexmark == pi->querygen){
+    return 0;
+  }
+  p->indexmark = pi->querygen;
+  if(!plane_intersects(p, y, x, leny, lenx)){
+    return 0;
+  }
+  return planelist_add(&pi->hits, &pi->hitcount, &pi->hitalloc, p);
+}
+
+// walk the z-axis, collecting those planes intersecting the region
+static int
+index_walk(ncpile* pile, int y, int x, int leny, int lenx){
+  pileindex* pi = &pile->index;
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    if(plane_intersects(p, y, x, leny, lenx)){
+      if(planelist_add(&pi->hits, &pi->hitcount, &pi->hitalloc, p)){
+        return -1;
+      }
+    }
+  }
+  return pi->hitcount;
+}
+
+int ncpile_index_query(ncpile* pile, int y, int x, int leny, int lenx){
+  pileindex* pi = &pile->index;
+  pi->hitcount = 0;
+  if(leny <= 0 || lenx <= 0){
+    return 0;
+  }
+  if(pi->broken && index_rebuild(pile)){
+    return index_walk(pile, y, x, leny, lenx);
+  }
+  const int by0 = floordiv(y, PILEINDEX_ROWS);
+  const int bx0 = floordiv(x, PILEINDEX_COLS);
+  const int by1 = floordiv(y + leny - 1, PILEINDEX_ROWS);
+  const int bx1 = floordiv(x + lenx - 1, PILEINDEX_COLS);
+  // if the region spans more buckets than we hold, walking is cheaper
+  if((int64_t)(by1 - by0 + 1) * (bx1 - bx0 + 1) > pi->bucketcount + PILEINDEX_MAXSPAN){
+    return index_walk(pile, y, x, leny, lenx);
+  }
+  if(++pi->querygen == 0){ // wrapped; no mark may match a new generation
+    for(ncplane* p = pile->top ; p ; p = p->below){
+      p->indexmark = 0;
+    }
+    pi->querygen = 1;
+  }
+  for(unsigned i = 0 ; i < pi->largecount ; ++i){
+    if(index_hit(pi, pi->large[i], y, x, leny, lenx)){
+      return -1;
+    }
+  }
+  for(int by = by0 ; by <= by1 ; ++by){
+    for(int bx = bx0 ; bx <= bx1 ; ++bx){
+      const pilebucket* b = bucket_find(pi, by, bx);
+      for(unsigned i = 0 ; b && i < b->count ; ++i){
+        if(index_hit(pi, b->planes[i], y, x, leny, lenx)){
+          return -1;
+        }
+      }
+    }
+  }
+  index_rank(pile);
+  qsort(pi->hits, pi->hitcount, sizeof(*pi->hits), zrank_cmp);
+  return pi->hitcount;
+}
+
+int ncpile_index_all(ncpile* pile){
+  pileindex* pi = &pile->index;
+  pi->hitcount = 0;
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    if(planelist_add(&pi->hits, &pi->hitcount, &pi->hitalloc, p)){
+      return -1;
+    }
+  }
+  return pi->hitcount;
+}
+
+ncplane* ncpile_plane_at_yx(ncplane* n, int y, int x){
+  ncpile* pile = ncplane_pile(n);
+  int hits = ncpile_index_query(pile, y, x, 1, 1);
+  if(hits < 0){ // allocation failure; walk the z-axis
+    for(ncplane* p = pile->top ; p ; p = p->below){
+      if(plane_intersects(p, y, x, 1, 1)){
+        return p;
+      }
+    }
+    return NULL;
+  }
+  return hits ? pile->index.hits[0] : NULL;
+}
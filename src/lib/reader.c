@@ -61,12 +61,18 @@ ncreader_redraw(ncreader* n){
   assert(n->xproject >= 0);
   assert(n->textarea->lenx >= n->ncp->lenx);
   assert(n->textarea->leny >= n->ncp->leny);
+  ncplane_dirty(n->ncp);
   for(int y = 0 ; y < n->ncp->leny ; ++y){
     const int texty = y;
+    const nccell* srcrow = ncplane_row_const(n->textarea, texty);
+    nccell* dstrow = ncplane_row(n->ncp, y);
+    if(dstrow == NULL){
+      return -1;
+    }
     for(int x = 0 ; x < n->ncp->lenx ; ++x){
       const int textx = x + n->xproject;
-      const nccell* src = &n->textarea->fb[nfbcellidx(n->textarea, texty, textx)];
-      nccell* dst = &n->ncp->fb[nfbcellidx(n->ncp, y, x)];
+      const nccell* src = &srcrow[textx];
+      nccell* dst = &dstrow[x];
 //fprintf(stderr, "projecting %d/%d [%s] to %d/%d [%s]\n", texty, textx, cell_extended_gcluster(n->textarea, src), y, x, cell_extended_gcluster(n->ncp, dst));
       if(cellcmp_and_dupfar(&n->ncp->pool, dst, n->textarea, src) < 0){
         ret = -1;
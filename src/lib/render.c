@@ -5,28 +5,14 @@
 #include <notcurses/direct.h>
 #include "internal.h"
 
-// Check whether the terminal geometry has changed, and if so, copies what can
-// be copied from the old lastframe. Assumes that the screen is always anchored
-// at the same origin. Initiates a resize cascade for the pile containing |pp|.
-// The current terminal geometry, changed or not, is written to |rows|/|cols|.
-static int
-notcurses_resize_internal(ncplane* pp, int* restrict rows, int* restrict cols){
-  notcurses* n = ncplane_notcurses(pp);
-  int r, c;
-  if(rows == NULL){
-    rows = &r;
-  }
-  if(cols == NULL){
-    cols = &c;
-  }
-  ncpile* pile = ncplane_pile(pp);
-  int oldrows = pile->dimy;
-  int oldcols = pile->dimx;
-  *rows = oldrows;
-  *cols = oldcols;
-  if(update_term_dimensions(n->ttyfd, rows, cols, &n->tcache)){
-    return -1;
-  }
+// per-row render state, tracked in ncpile->rowflags
+#define ROW_DIRTY    0x01u // must be repainted in the current render
+#define ROW_UNPOSTED 0x02u // repainted, but not yet postpainted to lastframe
+
+// the area available to us within the terminal's 'rows' x 'cols', less the
+// margins, but never less than a single cell.
+static void
+usable_geometry(const notcurses* n, int* restrict rows, int* restrict cols){
   *rows -= n->margin_t + n->margin_b;
   if(*rows <= 0){
     *rows = 1;
@@ -35,28 +21,45 @@ notcurses_resize_internal(ncplane* pp, int* restrict rows, int* restrict cols){
   if(*cols <= 0){
     *cols = 1;
   }
-  if(*rows != n->lfdimy || *cols != n->lfdimx){
-    n->lfdimy = *rows;
-    n->lfdimx = *cols;
-    const size_t size = sizeof(*n->lastframe) * (n->lfdimy * n->lfdimx);
-    nccell* fb = realloc(n->lastframe, size);
-    if(fb == NULL){
-      return -1;
-    }
-    n->lastframe = fb;
-    // FIXME more memset()tery than we need, both wasting work and wrecking
-    // damage detection for the upcoming render
-    memset(n->lastframe, 0, size);
-    egcpool_dump(&n->pool);
+}
+
+// lastframe reflects what's onscreen, and is only touched while rasterizing
+// (or refreshing), which is never done concurrently. if the geometry has
+// changed, it's discarded, and the next frame is written in its entirety.
+static int
+resize_lastframe(notcurses* n, int rows, int cols){
+  if(rows == n->lfdimy && cols == n->lfdimx){
+    return 0;
+  }
+  const size_t size = sizeof(*n->lastframe) * (rows * cols);
+  nccell* fb = realloc(n->lastframe, size);
+  if(fb == NULL){
+    return -1;
   }
-//fprintf(stderr, "r: %d or: %d c: %d oc: %d\n", *rows, oldrows, *cols, oldcols);
-  if(*rows == oldrows && *cols == oldcols){
+  n->lfdimy = rows;
+  n->lfdimx = cols;
+  n->lastframe = fb;
+  // FIXME more memset()tery than we need, both wasting work and wrecking
+  // damage detection for the upcoming render
+  memset(n->lastframe, 0, size);
+  egcpool_dump(&n->pool);
+  n->lastpile = NULL;
+  return 0;
+}
+
+// bring the pile's geometry into line with the usable area 'rows' x 'cols',
+// initiating a resize cascade if it changed. this touches only the pile, so
+// distinct piles can be rendered concurrently.
+static int
+ncpile_resize(ncpile* pile, int rows, int cols){
+//fprintf(stderr, "r: %d or: %d c: %d oc: %d\n", rows, pile->dimy, cols, pile->dimx);
+  if(rows == pile->dimy && cols == pile->dimx){
     return 0; // no change
   }
-  pile->dimy = *rows;
-  pile->dimx = *cols;
+  pile->dimy = rows;
+  pile->dimx = cols;
+  pile->repaint = true;
   int ret = 0;
-//notcurses_debug(n, stderr);
   for(ncplane* rootn = pile->roots ; rootn ; rootn = rootn->bnext){
     if(rootn->resizecb){
       ret |= rootn->resizecb(rootn);
@@ -65,6 +68,34 @@ notcurses_resize_internal(ncplane* pp, int* restrict rows, int* restrict cols){
   return ret;
 }
 
+// Check whether the terminal geometry has changed, and if so, resizes the
+// lastframe and initiates a resize cascade for the pile containing |pp|.
+// The current terminal geometry, changed or not, is written to |rows|/|cols|.
+static int
+notcurses_resize_internal(ncplane* pp, int* restrict rows, int* restrict cols){
+  notcurses* n = ncplane_notcurses(pp);
+  int r, c;
+  if(rows == NULL){
+    rows = &r;
+  }
+  if(cols == NULL){
+    cols = &c;
+  }
+  ncpile* pile = ncplane_pile(pp);
+  *rows = pile->dimy;
+  *cols = pile->dimx;
+  if(update_term_dimensions(n->ttyfd, rows, cols, &n->tcache)){
+    return -1;
+  }
+  usable_geometry(n, rows, cols);
+  pile->cellpixy = n->tcache.cellpixy;
+  pile->cellpixx = n->tcache.cellpixx;
+  if(resize_lastframe(n, *rows, *cols)){
+    return -1;
+  }
+  return ncpile_resize(pile, *rows, *cols);
+}
+
 // Check for a window resize on the standard pile.
 static int
 notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
@@ -76,8 +107,7 @@ notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
 
 // write(2) until we've written it all. Uses poll(2) to avoid spinning on
 // EAGAIN, at a small cost of latency.
-static int
-blocking_write(int fd, const char* buf, size_t buflen){
+int blocking_write(int fd, const char* buf, size_t buflen){
 //fprintf(stderr, "writing %zu to %d...\n", buflen, fd);
   size_t written = 0;
   while(written < buflen){
@@ -143,7 +173,7 @@ highcontrast(uint32_t bchannel){
 // FIXME if plane is not wholly on-screen, probably need to toss plane,
 // at least for this rendering cycle
 static void
-paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
+paint_sprixel(ncplane* p, const rendervec* rvec, int starty, int startx,
               int offy, int offx, int dstleny, int dstlenx){
   const notcurses* nc = ncplane_notcurses_const(p);
   sprixel* s = p->sprite;
@@ -161,8 +191,8 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
       if(absx >= dstlenx || absx < 0){
         break;
       }
-      struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
-//fprintf(stderr, "presprixel: %p preid: %d id: %d state: %d\n", rvec->sprixel, rvec->sprixel ? rvec->sprixel->id : 0, cell_sprixel_id(vis), s->invalidated);
+      const int idx = fbcellidx(absy, dstlenx, absx);
+      struct crender* crender = &rvec->crender[idx];
       // if we already have a glyph solved (meaning said glyph is above this
       // sprixel), and we run into a bitmap cell, we need to null that cell out
       // of the bitmap.
@@ -170,15 +200,15 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
         // if sprite_wipe_cell() fails, we presumably do not have the
         // ability to wipe, and must reprint the character
         if(sprite_wipe(nc, p->sprite, y, x)){
-//fprintf(stderr, "damaging due to wipe [%s] %d/%d\n", nccell_extended_gcluster(crender->p, &crender->c), y, x);
           crender->s.damaged = 1;
         }
         crender->s.p_beats_sprixel = 1;
       }else if(!crender->p && !crender->s.bgblends){
         // if we are a bitmap, and above a cell that has changed (and
         // will thus be printed), we'll need redraw the sprixel.
-        if(crender->sprixel == NULL){
-          crender->sprixel = s;
+        if(!crender->s.sprixeled){
+          rvec->aux[idx].sprixel = s;
+          crender->s.sprixeled = 1;
         }
         sprixcell_e state = sprixel_state(s, absy, absx);
         if(state == SPRIXCELL_ANNIHILATED || state == SPRIXCELL_ANNIHILATED_TRANS){
@@ -198,9 +228,15 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
 //  dstlenx: lenx of target rendering area described by rvec
 //  dstabsy: absy of target rendering area (relative to terminal)
 //  dstabsx: absx of target rendering area (relative to terminal)
+//  miny: first row of the target rendering area to paint
+//  maxy: paint only rows less than maxy (no greater than dstleny)
+//  minx: first column of the target rendering area to paint
+//  maxx: paint only columns less than maxx (no greater than dstlenx)
 //
 // only those cells where 'p' intersects with the target rendering area are
-// rendered.
+// rendered. painting a cell depends only on the state of its own row, so
+// distinct row bands can be painted concurrently. sprixels are always painted
+// over their full extent (and must not be painted concurrently).
 //
 // the sprixelstack orders sprixels of the plane (so we needn't keep them
 // ordered between renders). each time we meet a sprixel, extract it from
@@ -210,8 +246,9 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
 // (unless we want to let sprixels live off-origin in ncplanes), eliminating
 // per-cell sprixel_by_id() check
 static void
-paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
-      int dstabsy, int dstabsx, sprixel** sprixelstack){
+paint_cols(ncplane* p, const rendervec* rvec, int dstleny, int dstlenx,
+           int dstabsy, int dstabsx, sprixel** sprixelstack, int miny, int maxy,
+           int minx, int maxx){
   int y, x, dimy, dimx, offy, offx;
   ncplane_dim_yx(p, &dimy, &dimx);
   offy = p->absy - dstabsy;
@@ -252,27 +289,34 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
     *sprixelstack = p->sprite;
     return;
   }
+  if(starty < miny - offy){
+    starty = miny - offy;
+  }
+  if(startx < minx - offx){
+    startx = minx - offx;
+  }
   for(y = starty ; y < dimy ; ++y){
     const int absy = y + offy;
-    // once we've passed the physical screen's bottom, we're done
-    if(absy >= dstleny || absy < 0){
+    // once we've passed the physical screen's (or band's) bottom, we're done
+    if(absy >= maxy || absy < 0){
       break;
     }
+    const nccell* prow = ncplane_row_const(p, y);
     for(x = startx ; x < dimx ; ++x){ // iteration for each cell
       const int absx = x + offx;
-      if(absx >= dstlenx || absx < 0){
+      if(absx >= maxx || absx < 0){
         break;
       }
-      struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
-//fprintf(stderr, "p: %p damaged: %u %d/%d\n", p, crender->s.damaged, y, x);
-      nccell* targc = &crender->c;
+      const int idx = fbcellidx(absy, dstlenx, absx);
+      struct crender* crender = &rvec->crender[idx];
+      nccell* targc = &rvec->cells[idx];
       if(nccell_wide_right_p(targc)){
         continue;
       }
-      const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+      const nccell* vis = &prow[x];
 
       if(nccell_fg_alpha(targc) > CELL_ALPHA_OPAQUE){
-        vis = &p->fb[nfbcellidx(p, y, x)];
+        vis = &prow[x];
         if(nccell_fg_default_p(vis)){
           vis = &p->basecell;
         }
@@ -284,7 +328,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
           if(nccell_fg_alpha(vis) == CELL_ALPHA_HIGHCONTRAST){
             crender->s.highcontrast = true;
             crender->s.hcfgblends = crender->s.fgblends;
-            crender->hcfg = cell_fchannel(targc);
+            rvec->aux[idx].hcfg = cell_fchannel(targc);
           }
           unsigned fgblends = crender->s.fgblends;
           cell_blend_fchannel(targc, cell_fchannel(vis), &fgblends);
@@ -304,7 +348,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // background channel and balpha.
       // Evaluate the background first, in case we have HIGHCONTRAST fg text.
       if(nccell_bg_alpha(targc) > CELL_ALPHA_OPAQUE){
-        vis = &p->fb[nfbcellidx(p, y, x)];
+        vis = &prow[x];
         // to be on the blitter stacking path, we need
         //  1) crender->s.blittedquads to be non-zero (we're below semigraphics)
         //  2) cell_blittedquadrants(vis) to be non-zero (we're semigraphics)
@@ -347,14 +391,14 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // still use a character we find here, but its color will come entirely
       // from cells underneath us.
       if(!crender->p){
-        vis = &p->fb[nfbcellidx(p, y, x)];
+        vis = &prow[x];
         if(vis->gcluster == 0 && !nccell_double_wide_p(vis)){
           vis = &p->basecell;
         }
         // if the following is true, we're a real glyph, and not the right-hand
         // side of a wide glyph (nor the null codepoint).
         if( (targc->gcluster = vis->gcluster) ){ // index copy only
-          if(crender->sprixel && crender->sprixel->invalidated == SPRIXEL_HIDE){
+          if(crender->s.sprixeled && rvec->aux[idx].sprixel->invalidated == SPRIXEL_HIDE){
             crender->s.damaged = 1;
           }
           crender->s.blittedquads = cell_blittedquadrants(vis);
@@ -366,8 +410,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
               targc->gcluster = htole(' ');
               targc->width = 1;
             // is the next cell occupied? if so, 0x20 us
-            }else if(crender[1].c.gcluster){
-//fprintf(stderr, "NULLING out %d/%d (%d/%d) due to %u\n", y, x, absy, absx, crender[1].c.gcluster);
+            }else if(targc[1].gcluster){
               targc->gcluster = htole(' ');
               targc->width = 1;
             }else{
@@ -388,23 +431,59 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
   }
 }
 
+// paint all columns of rows [miny, maxy)
+static inline void
+paint(ncplane* p, const rendervec* rvec, int dstleny, int dstlenx,
+      int dstabsy, int dstabsx, sprixel** sprixelstack, int miny, int maxy){
+  paint_cols(p, rvec, dstleny, dstlenx, dstabsy, dstabsx, sprixelstack,
+             miny, maxy, 0, dstlenx);
+}
+
+// initialize 'totalcells' cells of the render vector starting at 'first'.
 // it's not a pure memset(), because CELL_ALPHA_OPAQUE is the zero value, and
-// we need CELL_ALPHA_TRANSPARENT
+// we need CELL_ALPHA_TRANSPARENT. the aux array is only consulted where the
+// crender's flags say it's valid, and needn't be touched.
 static inline void
-init_rvec(struct crender* rvec, int totalcells){
-  struct crender c = {};
-  nccell_set_fg_alpha(&c.c, CELL_ALPHA_TRANSPARENT);
-  nccell_set_bg_alpha(&c.c, CELL_ALPHA_TRANSPARENT);
+init_rvec(const rendervec* rvec, int first, int totalcells){
+  nccell c = {};
+  nccell_set_fg_alpha(&c, CELL_ALPHA_TRANSPARENT);
+  nccell_set_bg_alpha(&c, CELL_ALPHA_TRANSPARENT);
+  memset(rvec->crender + first, 0, sizeof(*rvec->crender) * totalcells);
+  nccell* cells = rvec->cells + first;
   for(int t = 0 ; t < totalcells ; ++t){
-    memcpy(&rvec[t], &c, sizeof(c));
+    cells[t] = c;
   }
 }
 
+// resize each array of the render vector to hold 'cells' cells. contents are
+// preserved up to the lesser of the old and new sizes. on failure, the arrays
+// remain valid (though some may have been resized).
+static int
+rendervec_realloc(rendervec* rvec, size_t cells){
+  nccell* c = realloc(rvec->cells, sizeof(*c) * cells);
+  if(c == NULL){
+    return -1;
+  }
+  rvec->cells = c;
+  struct crender* cr = realloc(rvec->crender, sizeof(*cr) * cells);
+  if(cr == NULL){
+    return -1;
+  }
+  rvec->crender = cr;
+  struct crenderaux* aux = realloc(rvec->aux, sizeof(*aux) * cells);
+  if(aux == NULL){
+    return -1;
+  }
+  rvec->aux = aux;
+  return 0;
+}
+
 // adjust an otherwise locked-in cell if highcontrast has been requested. this
 // should be done at the end of rendering the cell, so that contrast is solved
 // against the real background.
 static inline void
-lock_in_highcontrast(nccell* targc, struct crender* crender){
+lock_in_highcontrast(nccell* targc, struct crender* crender,
+                     const struct crenderaux* aux){
   if(nccell_fg_alpha(targc) == CELL_ALPHA_TRANSPARENT){
     nccell_set_fg_default(targc);
   }
@@ -420,11 +499,14 @@ lock_in_highcontrast(nccell* targc, struct crender* crender){
       uint32_t hchan = channels_blend(highcontrast(bchan), fchan, &fgblends);
       cell_set_fchannel(targc, hchan);
       fgblends = crender->s.hcfgblends;
-      hchan = channels_blend(hchan, crender->hcfg, &fgblends);
+      hchan = channels_blend(hchan, aux->hcfg, &fgblends);
       cell_set_fchannel(targc, hchan);
     }else{
       nccell_set_fg_rgb(targc, highcontrast(cell_bchannel(targc)));
     }
+    // a cell might be postpainted again without being repainted (when another
+    // pile has been rasterized in the interim); don't apply contrast twice.
+    crender->s.highcontrast = false;
   }
 }
 
@@ -432,16 +514,16 @@ lock_in_highcontrast(nccell* targc, struct crender* crender){
 // checking for and locking in high-contrast, checking for damage, and updating
 // 'lastframe' for any cells which are damaged.
 static inline void
-postpaint_cell(nccell* lastframe, int dimx, struct crender* crender,
+postpaint_cell(nccell* lastframe, int dimx, const rendervec* rvec,
                egcpool* pool, int y, int* x){
-  nccell* targc = &crender->c;
-  lock_in_highcontrast(targc, crender);
-  nccell* prevcell = &lastframe[fbcellidx(y, dimx, *x)];
-//fprintf(stderr, "taking a look at %d/%d %08x\n", y, *x, crender->c.gcluster);
+  const int idx = fbcellidx(y, dimx, *x);
+  struct crender* crender = &rvec->crender[idx];
+  nccell* targc = &rvec->cells[idx];
+  lock_in_highcontrast(targc, crender, &rvec->aux[idx]);
+  nccell* prevcell = &lastframe[idx];
   if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc) > 0){
-//fprintf(stderr, "damaging due to cmp [%s] %d %d\n", nccell_extended_gcluster(crender->p, &crender->c), y, *x);
-    if(crender->sprixel){
-      sprixcell_e state = sprixel_state(crender->sprixel, y, *x);
+    if(crender->s.sprixeled){
+      sprixcell_e state = sprixel_state(rvec->aux[idx].sprixel, y, *x);
       if(!crender->s.p_beats_sprixel && state != SPRIXCELL_OPAQUE_KITTY && state != SPRIXCELL_OPAQUE_SIXEL){
         crender->s.damaged = 1;
       }
@@ -456,12 +538,11 @@ postpaint_cell(nccell* lastframe, int dimx, struct crender* crender,
       crender->p = tmpp;
       ++*x;
       ++prevcell;
-      targc = &crender->c;
+      ++targc;
       targc->gcluster = 0;
-      targc->channels = crender[-i].c.channels;
-      targc->stylemask = crender[-i].c.stylemask;
+      targc->channels = targc[-i].channels;
+      targc->stylemask = targc[-i].stylemask;
       if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc) > 0){
-//fprintf(stderr, "damaging due to cmp2\n");
         crender->s.damaged = 1;
       }
     }
@@ -471,7 +552,13 @@ postpaint_cell(nccell* lastframe, int dimx, struct crender* crender,
 
 // iterate over the rendered frame, adjusting the foreground colors for any
 // cells marked CELL_ALPHA_HIGHCONTRAST, and clearing any cell covered by a
-// wide glyph to its left.
+// wide glyph to its left. if 'rowflags' is not NULL, only those rows marked
+// ROW_UNPOSTED are visited; the others are known to match 'lastframe'. if
+// 'damage' is not NULL, it receives the span of damaged cells in each row
+// (rows not visited have none). runs of cells identical to 'lastframe' are
+// skipped by the 'scan' kernel, so that only the remainder need be compared
+// one at a time against the EGC pools. damage tends to come in runs, so the
+// kernel isn't consulted again until we see an undamaged cell.
 //
 // FIXME this cannot be performed at render time (we don't yet know the
 //       lastframe, and thus can't compute damage), but we *could* unite it
@@ -479,11 +566,39 @@ postpaint_cell(nccell* lastframe, int dimx, struct crender* crender,
 // FIXME can we not do the blend a single time here, if we track sums in
 //       paint()? tried this before and didn't get a win...
 static void
-postpaint(nccell* lastframe, int dimy, int dimx, struct crender* rvec, egcpool* pool){
+postpaint(nccell* lastframe, int dimy, int dimx, const rendervec* rvec,
+          egcpool* pool, const unsigned char* rowflags, damagespan* damage,
+          damagescan_fxn scan){
+  const struct crender* crender = rvec->crender;
   for(int y = 0 ; y < dimy ; ++y){
+    if(damage){
+      damage[y].minx = INT_MAX;
+      damage[y].maxx = -1;
+    }
+    if(rowflags && !(rowflags[y] & ROW_UNPOSTED)){
+      continue;
+    }
+    bool scanning = true;
     for(int x = 0 ; x < dimx ; ++x){
-      struct crender* crender = &rvec[fbcellidx(y, dimx, x)];
-      postpaint_cell(lastframe, dimx, crender, pool, y, &x);
+      if(scanning){
+        const int idx = fbcellidx(y, dimx, x);
+        if((x += scan(&crender[idx], &rvec->cells[idx], &lastframe[idx], dimx - x)) == dimx){
+          break;
+        }
+      }
+      const int startx = x;
+      postpaint_cell(lastframe, dimx, rvec, pool, y, &x);
+      // damage might have been applied by paint() or postpaint_cell(), to
+      // the glyph or (for multicolumn glyphs) any of its columns
+      const bool damaged = crender[fbcellidx(y, dimx, startx)].s.damaged ||
+                           crender[fbcellidx(y, dimx, x)].s.damaged;
+      scanning = !damaged;
+      if(damage && damaged){
+        if(startx < damage[y].minx){
+          damage[y].minx = startx;
+        }
+        damage[y].maxx = x;
+      }
     }
   }
 }
@@ -518,26 +633,29 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
     logerror(ncplane_notcurses_const(dst), "Can't merge sprixel planes\n");
     return -1;
   }
+  notcurses* nc = ncplane_notcurses(dst);
   const int totalcells = dst->leny * dst->lenx;
-  nccell* rendfb = calloc(sizeof(*rendfb), totalcells);
-  const size_t crenderlen = sizeof(struct crender) * totalcells;
-  struct crender* rvec = malloc(crenderlen);
-  if(!rendfb || !rvec){
-    logerror(ncplane_notcurses_const(dst), "Error allocating render state for %dx%d\n", leny, lenx);
-    free(rendfb);
-    free(rvec);
-    return -1;
-  }
-  init_rvec(rvec, totalcells);
-  paint(src, rvec, dst->leny, dst->lenx, dst->absy, dst->absx, NULL);
-  paint(dst, rvec, dst->leny, dst->lenx, dst->absy, dst->absx, NULL);
+  nccell* rendfb = slab_fb_alloc(nc, totalcells);
+  rendervec rvec = {};
+  if(!rendfb || rendervec_realloc(&rvec, totalcells)){
+    logerror(nc, "Error allocating render state for %dx%d\n", leny, lenx);
+    slab_fb_free(nc, rendfb, totalcells);
+    rendervec_free(&rvec);
+    return -1;
+  }
+  memset(rendfb, 0, sizeof(*rendfb) * totalcells);
+  init_rvec(&rvec, 0, totalcells);
+  paint(src, &rvec, dst->leny, dst->lenx, dst->absy, dst->absx, NULL, 0, dst->leny);
+  paint(dst, &rvec, dst->leny, dst->lenx, dst->absy, dst->absx, NULL, 0, dst->leny);
 //fprintf(stderr, "Postpaint start (%dx%d)\n", dst->leny, dst->lenx);
-  postpaint(rendfb, dst->leny, dst->lenx, rvec, &dst->pool);
+  postpaint(rendfb, dst->leny, dst->lenx, &rvec, &dst->pool, NULL, NULL,
+            nc->damagescan);
 //fprintf(stderr, "Postpaint done (%dx%d)\n", dst->leny, dst->lenx);
-  free(dst->fb);
-  dst->fb = rendfb;
-  free(rvec);
-  return 0;
+  // the merged cells hold their own references into dst's pool
+  int ret = ncplane_adopt_fb(dst, rendfb);
+  ncplane_dirty(dst);
+  rendervec_free(&rvec);
+  return ret;
 }
 
 int ncplane_mergedown_simple(ncplane* restrict src, ncplane* restrict dst){
@@ -550,21 +668,21 @@ int ncplane_mergedown_simple(ncplane* restrict src, ncplane* restrict dst){
   return ncplane_mergedown(src, dst, 0, 0, ncplane_dim_y(src), ncplane_dim_x(src), 0, 0);
 }
 
-// write the nccell's UTF-8 extended grapheme cluster to the provided FILE*.
+// write the nccell's UTF-8 extended grapheme cluster to the provided fbuf.
 static int
-term_putc(FILE* out, const egcpool* e, const nccell* c){
+term_putc(fbuf* f, const egcpool* e, const nccell* c){
   if(cell_simple_p(c)){
 //fprintf(stderr, "[%.4s] %08x\n", (const char*)&c->gcluster, c->gcluster); }
     // we must not have any 'cntrl' characters at this point
     if(c->gcluster == 0){
-      if(ncfputc(' ', out) == EOF){
+      if(fbuf_putc(f, ' ')){
         return -1;
       }
-    }else if(ncfputs((const char*)&c->gcluster, out) == EOF){
+    }else if(fbuf_putn(f, (const char*)&c->gcluster, strnlen((const char*)&c->gcluster, 4))){
       return -1;
     }
   }else{
-    if(ncfputs(egcpool_extended_gcluster(e, c), out) == EOF){
+    if(fbuf_puts(f, egcpool_extended_gcluster(e, c))){
       return -1;
     }
   }
@@ -572,25 +690,36 @@ term_putc(FILE* out, const egcpool* e, const nccell* c){
 }
 
 // check the current and target style bitmasks against the specified 'stylebit'.
-// if they are different, and we have the necessary capability, write the
-// applicable terminfo entry to 'out'. returns -1 only on a true error.
-int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
-                  const char* ton, const char* toff){
-  int ret = 0;
+// if they are different, and we have the necessary capability, return the
+// applicable terminfo entry. otherwise, return NULL.
+static inline const char*
+style_transition(unsigned cur, unsigned targ, unsigned stylebit,
+                 const char* ton, const char* toff){
   unsigned curon = cur & stylebit;
   unsigned targon = targ & stylebit;
-  if(curon != targon){
-    if(targon){
-      if(ton){
-        ret = term_emit(ton, out, false);
-      }
-    }else{
-      if(toff){ // how did this happen? we can turn it on, but not off?
-        ret = term_emit(toff, out, false);
-      }
-    }
+  if(curon == targon){
+    return NULL;
   }
-  if(ret < 0){
+  // toff can be NULL: how did this happen? we can turn it on, but not off?
+  return targon ? ton : toff;
+}
+
+// as style_transition(), writing any entry to 'out'. returns -1 only on a
+// true error.
+int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
+                  const char* ton, const char* toff){
+  const char* seq = style_transition(cur, targ, stylebit, ton, toff);
+  if(seq && term_emit(seq, out, false) < 0){
+    return -1;
+  }
+  return 0;
+}
+
+static inline int
+raster_setstyle(fbuf* f, unsigned cur, unsigned targ, unsigned stylebit,
+                const char* ton, const char* toff){
+  const char* seq = style_transition(cur, targ, stylebit, ton, toff);
+  if(seq && fbuf_emit(f, seq) < 0){
     return -1;
   }
   return 0;
@@ -598,7 +727,7 @@ int term_setstyle(FILE* out, unsigned cur, unsigned targ, unsigned stylebit,
 
 // write any escape sequences necessary to set the desired style
 static inline int
-term_setstyles(FILE* out, notcurses* nc, const nccell* c){
+term_setstyles(fbuf* f, notcurses* nc, const nccell* c){
   bool normalized = false;
   uint32_t cellattr = nccell_styles(c);
   if(cellattr == nc->rstate.curattr){
@@ -610,22 +739,14 @@ term_setstyles(FILE* out, notcurses* nc, const nccell* c){
   if((cellattr ^ nc->rstate.curattr) & 0xfful){
     // if everything's 0, emit the shorter sgr0
     if(nc->tcache.sgr0 && ((cellattr & NCSTYLE_MASK) == 0)){
-      if(term_emit(nc->tcache.sgr0, out, false) < 0){
+      if(fbuf_emit(f, nc->tcache.sgr0) < 0){
         ret = -1;
       }else{
         normalized = true;
       }
     }else if(nc->tcache.sgr){
-      if(term_emit(tiparm(nc->tcache.sgr,
-                          cellattr & NCSTYLE_STANDOUT,
-                          cellattr & NCSTYLE_UNDERLINE,
-                          cellattr & NCSTYLE_REVERSE,
-                          cellattr & NCSTYLE_BLINK,
-                          cellattr & NCSTYLE_DIM,
-                          cellattr & NCSTYLE_BOLD,
-                          cellattr & NCSTYLE_INVIS,
-                          cellattr & NCSTYLE_PROTECT, 0),
-                          out, false) < 0){
+      // the eight styles controlled by sgr occupy the low byte
+      if(term_emit_indexed(&nc->tcache.sgrtab, nc->tcache.sgr, f, cellattr & 0xffu) < 0){
         ret = -1;
       }else{
         normalized = true;
@@ -634,10 +755,10 @@ term_setstyles(FILE* out, notcurses* nc, const nccell* c){
     // sgr will blow away italics/struck if they were set beforehand
     nc->rstate.curattr &= ~(NCSTYLE_ITALIC | NCSTYLE_STRUCK);
   }
-  ret |= term_setstyle(out, nc->rstate.curattr, cellattr, NCSTYLE_ITALIC,
-                       nc->tcache.italics, nc->tcache.italoff);
-  ret |= term_setstyle(out, nc->rstate.curattr, cellattr, NCSTYLE_STRUCK,
-                       nc->tcache.struck, nc->tcache.struckoff);
+  ret |= raster_setstyle(f, nc->rstate.curattr, cellattr, NCSTYLE_ITALIC,
+                         nc->tcache.italics, nc->tcache.italoff);
+  ret |= raster_setstyle(f, nc->rstate.curattr, cellattr, NCSTYLE_STRUCK,
+                         nc->tcache.struck, nc->tcache.struckoff);
   nc->rstate.curattr = cellattr;
   if(normalized){
     nc->rstate.fgdefelidable = true;
@@ -650,27 +771,8 @@ term_setstyles(FILE* out, notcurses* nc, const nccell* c){
   return ret;
 }
 
-// u8->str lookup table used in term_esc_rgb below
-static const char* const NUMBERS[] = {
-"0;", "1;", "2;", "3;", "4;", "5;", "6;", "7;", "8;", "9;", "10;", "11;", "12;", "13;", "14;", "15;", "16;",
-"17;", "18;", "19;", "20;", "21;", "22;", "23;", "24;", "25;", "26;", "27;", "28;", "29;", "30;", "31;", "32;",
-"33;", "34;", "35;", "36;", "37;", "38;", "39;", "40;", "41;", "42;", "43;", "44;", "45;", "46;", "47;", "48;",
-"49;", "50;", "51;", "52;", "53;", "54;", "55;", "56;", "57;", "58;", "59;", "60;", "61;", "62;", "63;", "64;",
-"65;", "66;", "67;", "68;", "69;", "70;", "71;", "72;", "73;", "74;", "75;", "76;", "77;", "78;", "79;", "80;",
-"81;", "82;", "83;", "84;", "85;", "86;", "87;", "88;", "89;", "90;", "91;", "92;", "93;", "94;", "95;", "96;",
-"97;", "98;", "99;", "100;", "101;", "102;", "103;", "104;", "105;", "106;", "107;", "108;", "109;", "110;", "111;", "112;",
-"113;", "114;", "115;", "116;", "117;", "118;", "119;", "120;", "121;", "122;", "123;", "124;", "125;", "126;", "127;", "128;",
-"129;", "130;", "131;", "132;", "133;", "134;", "135;", "136;", "137;", "138;", "139;", "140;", "141;", "142;", "143;", "144;",
-"145;", "146;", "147;", "148;", "149;", "150;", "151;", "152;", "153;", "154;", "155;", "156;", "157;", "158;", "159;", "160;",
-"161;", "162;", "163;", "164;", "165;", "166;", "167;", "168;", "169;", "170;", "171;", "172;", "173;", "174;", "175;", "176;",
-"177;", "178;", "179;", "180;", "181;", "182;", "183;", "184;", "185;", "186;", "187;", "188;", "189;", "190;", "191;", "192;",
-"193;", "194;", "195;", "196;", "197;", "198;", "199;", "200;", "201;", "202;", "203;", "204;", "205;", "206;", "207;", "208;",
-"209;", "210;", "211;", "212;", "213;", "214;", "215;", "216;", "217;", "218;", "219;", "220;", "221;", "222;", "223;", "224;",
-"225;", "226;", "227;", "228;", "229;", "230;", "231;", "232;", "233;", "234;", "235;", "236;", "237;", "238;", "239;", "240;",
-"241;", "242;", "243;", "244;", "245;", "246;", "247;", "248;", "249;", "250;", "251;", "252;", "253;", "254;", "255;", };
-
 static inline int
-term_esc_rgb(FILE* out, bool foreground, unsigned r, unsigned g, unsigned b){
+term_esc_rgb(fbuf* f, bool foreground, unsigned r, unsigned g, unsigned b){
   // The correct way to do this is using tiparm+tputs, but doing so (at least
   // as of terminfo 6.1.20191019) both emits ~3% more bytes for a run of 'rgb'
   // and gives rise to some inaccurate colors (possibly due to special handling
@@ -682,102 +784,99 @@ term_esc_rgb(FILE* out, bool foreground, unsigned r, unsigned g, unsigned b){
   }else{
     return -1;
   }*/
-  #define RGBESC1 "\x1b" "["
   // we'd like to use the proper ITU T.416 colon syntax i.e. "8:2::", but it is
-  // not supported by several terminal emulators :/.
-  #define RGBESC2 "8;2;"
-  // fprintf() was sitting atop our profiles, so we put the effort into a fast solution
-  // here. assemble a buffer using constants and a lookup table. we can use 20
-  // bytes in the worst case.
-  char rgbbuf[20] = RGBESC1 " " RGBESC2;
-  if(foreground){
-    rgbbuf[2] = '3';
-  }else{
-    rgbbuf[2] = '4';
-  }
-  size_t offset = 7;
-  const char* s = NUMBERS[r];
-  while(*s){
-    rgbbuf[offset++] = *s++;
-  }
-  s = NUMBERS[g];
-  while(*s){
-    rgbbuf[offset++] = *s++;
-  }
-  s = NUMBERS[b];
-  while(*s != ';'){
-    rgbbuf[offset++] = *s++;
-  }
-  rgbbuf[offset++] = 'm';
-  rgbbuf[offset] = '\0';
-  if(fwrite(rgbbuf, offset, 1, out) != 1){
+  // not supported by several terminal emulators :/. fprintf() was sitting atop
+  // our profiles, so assemble it directly; we need 19 bytes in the worst case.
+  if(fbuf_reserve(f, 19)){
     return -1;
   }
+  f->buf[f->used++] = '\x1b';
+  f->buf[f->used++] = '[';
+  f->buf[f->used++] = foreground ? '3' : '4';
+  memcpy(f->buf + f->used, "8;2;", 4);
+  f->used += 4;
+  fbuf_putuint(f, r);
+  f->buf[f->used++] = ';';
+  fbuf_putuint(f, g);
+  f->buf[f->used++] = ';';
+  fbuf_putuint(f, b);
+  f->buf[f->used++] = 'm';
   return 0;
 }
 
 static inline int
-term_bg_rgb8(bool RGBflag, const char* setab, int colors, FILE* out,
-             unsigned r, unsigned g, unsigned b, uint32_t bg_collides_default){
+term_bg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   // We typically want to use tputs() and tiperm() to acquire and write the
   // escapes, as these take into account terminal-specific delays, padding,
   // etc. For the case of DirectColor, there is no suitable terminfo entry, but
   // we're also in that case working with hopefully more robust terminals.
   // If it doesn't work, eh, it doesn't work. Fuck the world; save yourself.
-  if(RGBflag){
-    if(bg_collides_default){
-      if((r == (bg_collides_default & 0xff0000lu)) &&
-         (g == (bg_collides_default & 0xff00lu)) &&
-         (b == (bg_collides_default & 0xfflu))){
+  if(ti->RGBflag){
+    if(ti->bg_collides_default){
+      if((r == (ti->bg_collides_default & 0xff0000lu)) &&
+         (g == (ti->bg_collides_default & 0xff00lu)) &&
+         (b == (ti->bg_collides_default & 0xfflu))){
         ++b; // what if it's 255 FIXME
       }
     }
-    return term_esc_rgb(out, false, r, g, b);
+    return term_esc_rgb(f, false, r, g, b);
   }else{
-    if(setab == NULL){
+    if(ti->setab == NULL){
       return 0;
     }
     // For 256-color indexed mode, start constructing a palette based off
     // the inputs *if we can change the palette*. If more than 256 are used on
     // a single screen, start... combining close ones? For 8-color mode, simple
     // interpolation. I have no idea what to do for 88 colors. FIXME
-    if(colors >= 256){
-      return term_emit(tiparm(setab, rgb_quantize_256(r, g, b)), out, false);
-    }else if(colors >= 8){
-      return term_emit(tiparm(setab, rgb_quantize_8(r, g, b)), out, false);
+    if(ti->colors >= 256){
+      return term_emit_indexed(&ti->setabtab, ti->setab, f, rgb_quantize_256(r, g, b));
+    }else if(ti->colors >= 8){
+      return term_emit_indexed(&ti->setabtab, ti->setab, f, rgb_quantize_8(r, g, b));
     }
   }
   return 0;
 }
 
-int term_fg_rgb8(bool RGBflag, const char* setaf, int colors, FILE* out,
-                 unsigned r, unsigned g, unsigned b){
+int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   // We typically want to use tputs() and tiperm() to acquire and write the
   // escapes, as these take into account terminal-specific delays, padding,
   // etc. For the case of DirectColor, there is no suitable terminfo entry, but
   // we're also in that case working with hopefully more robust terminals.
   // If it doesn't work, eh, it doesn't work. Fuck the world; save yourself.
-  if(RGBflag){
-    return term_esc_rgb(out, true, r, g, b);
+  if(ti->RGBflag){
+    return term_esc_rgb(f, true, r, g, b);
   }else{
-    if(setaf == NULL){
+    if(ti->setaf == NULL){
       return 0;
     }
     // For 256-color indexed mode, start constructing a palette based off
     // the inputs *if we can change the palette*. If more than 256 are used on
     // a single screen, start... combining close ones? For 8-color mode, simple
     // interpolation. I have no idea what to do for 88 colors. FIXME
-    if(colors >= 256){
-      return term_emit(tiparm(setaf, rgb_quantize_256(r, g, b)), out, false);
-    }else if(colors >= 8){
-      return term_emit(tiparm(setaf, rgb_quantize_8(r, g, b)), out, false);
+    if(ti->colors >= 256){
+      return term_emit_indexed(&ti->setaftab, ti->setaf, f, rgb_quantize_256(r, g, b));
+    }else if(ti->colors >= 8){
+      return term_emit_indexed(&ti->setaftab, ti->setaf, f, rgb_quantize_8(r, g, b));
     }
   }
   return 0;
 }
 
+// do we have palette changes which have not yet been written?
+static inline bool
+palette_damaged_p(const notcurses* nc){
+  if(nc->tcache.CCCflag){
+    for(size_t i = 0 ; i < sizeof(nc->palette_damage) / sizeof(*nc->palette_damage) ; ++i){
+      if(nc->palette_damage[i]){
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 static inline int
-update_palette(notcurses* nc, FILE* out){
+update_palette(notcurses* nc, fbuf* f){
   if(nc->tcache.CCCflag){
     for(size_t damageidx = 0 ; damageidx < sizeof(nc->palette.chans) / sizeof(*nc->palette.chans) ; ++damageidx){
       unsigned r, g, b;
@@ -788,7 +887,7 @@ update_palette(notcurses* nc, FILE* out){
         r = r * 1000 / 255;
         g = g * 1000 / 255;
         b = b * 1000 / 255;
-        term_emit(tiparm(nc->tcache.initc, damageidx, r, g, b), out, false);
+        fbuf_emit(f, tiparm(nc->tcache.initc, damageidx, r, g, b));
         nc->palette_damage[damageidx] = false;
       }
     }
@@ -796,43 +895,303 @@ update_palette(notcurses* nc, FILE* out){
   return 0;
 }
 
-// sync the drawing position to the specified location with as little overhead
-// as possible (with nothing, if already at the right location). we prefer
-// absolute horizontal moves (hpa) to relative ones, in the rare event that
-// our understanding of our horizontal location is faulty.
-// FIXME fall back to synthesized moves in the absence of capabilities (i.e.
-// textronix lacks cup; fake it with horiz+vert moves)
-// if hardcursorpos is non-zero, we always perform a cup
+// number of decimal digits needed to express 'n'
+static inline unsigned
+decimal_digits(unsigned n){
+  unsigned d = 1;
+  while(n >= 10){
+    n /= 10;
+    ++d;
+  }
+  return d;
+}
+
+// a cursor motion is a vertical component followed by a horizontal one.
+// VMOVE_CUP and VMOVE_HOME set both coordinates, and take no horizontal
+// component. VMOVE_CRLF leaves us in the first column.
+typedef enum {
+  VMOVE_NONE, VMOVE_CUD, VMOVE_CUU, VMOVE_VPA, VMOVE_CRLF, VMOVE_CUP, VMOVE_HOME,
+} vmove_e;
+
+typedef enum {
+  HMOVE_NONE, HMOVE_CUF1, HMOVE_CUF, HMOVE_CUB, HMOVE_HPA, HMOVE_CR, HMOVE_CRCUF,
+} hmove_e;
+
+typedef struct motion {
+  vmove_e v;
+  hmove_e h;
+} motion;
+
+// longest motion we'll build (anything longer falls back to cup)
+#define MOTION_MAXLEN (ESCTEMPLATE_MAXLEN * 2 + 2)
+
+// our horizontal position, or -1 if it can't be trusted for relative moves.
+// having emitted a glyph whose width the terminal might disagree with, or
+// having written to the last column (leaving a wrap pending), we mustn't.
 static inline int
-goto_location(notcurses* nc, FILE* out, int y, int x){
-//fprintf(stderr, "going to %d/%d from %d/%d hard: %u\n", y, x, nc->rstate.y, nc->rstate.x, hardcursorpos);
-  int ret = 0;
-  // if we don't have hpa, force a cup even if we're only 1 char away. the only
-  // terminal i know supporting cup sans hpa is vt100, and vt100 can suck it.
-  // you can't use cuf for backwards moves anyway; again, vt100 can suck it.
-  if(nc->rstate.y == y && nc->tcache.hpa && !nc->rstate.hardcursorpos){ // only need move x
-    if(nc->rstate.x == x){ // needn't move shit
-      return 0;
+trusted_x(const notcurses* nc){
+  const rasterstate* rs = &nc->rstate;
+  const int termcols = nc->lfdimx + nc->margin_l + nc->margin_r;
+  if(rs->hardxpos || rs->hardcursorpos || rs->x < 0 || rs->x >= termcols){
+    return -1;
+  }
+  return rs->x;
+}
+
+// choose the cheapest horizontal move from column 'from' (-1 if unknown) to
+// column 'x', returning its estimated cost (UINT_MAX if there is none).
+static unsigned
+plan_hmove(const tinfo* ti, int from, int x, hmove_e* h){
+  if(from == x){
+    *h = HMOVE_NONE;
+    return 0;
+  }
+  unsigned best = UINT_MAX;
+  unsigned c;
+  if(from >= 0){
+    if(x == from + 1 && ti->cuf1){
+      best = ti->motioncost.cuf1;
+      *h = HMOVE_CUF1;
     }
-    if(x == nc->rstate.x + 1 && nc->tcache.cuf1){
-      ret = term_emit(nc->tcache.cuf1, out, false);
-    }else{
-      ret = term_emit(tiparm(nc->tcache.hpa, x), out, false);
+    if(x > from && ti->cuf && (c = ti->motioncost.cuf + decimal_digits(x - from)) < best){
+      best = c;
+      *h = HMOVE_CUF;
+    }
+    if(x < from && ti->cub && (c = ti->motioncost.cub + decimal_digits(from - x)) < best){
+      best = c;
+      *h = HMOVE_CUB;
+    }
+  }
+  if(ti->hpa && (c = ti->motioncost.hpa + decimal_digits(x + 1)) < best){
+    best = c;
+    *h = HMOVE_HPA;
+  }
+  if(x == 0){
+    if(1 < best){
+      best = 1;
+      *h = HMOVE_CR;
     }
+  }else if(ti->cuf && (c = 1 + ti->motioncost.cuf + decimal_digits(x)) < best){
+    best = c;
+    *h = HMOVE_CRCUF;
+  }
+  return best;
+}
+
+// choose the cheapest motion to 'y'/'x' according to the estimated costs of
+// the available capabilities. absent a trustworthy position, only absolute
+// moves are possible. having emitted a glyph of questionable width, we might
+// have wrapped onto another row, so move vertically only by absolute means.
+static void
+plan_motion(const notcurses* nc, int y, int x, motion* m){
+  const tinfo* ti = &nc->tcache;
+  const rasterstate* rs = &nc->rstate;
+  unsigned best = ti->motioncost.cup + decimal_digits(y + 1) + decimal_digits(x + 1);
+  m->v = VMOVE_CUP;
+  m->h = HMOVE_NONE;
+  if(y == 0 && x == 0 && ti->home && ti->motioncost.home < best){
+    best = ti->motioncost.home;
+    m->v = VMOVE_HOME;
+  }
+  if(rs->y < 0 || rs->hardcursorpos){
+    return;
+  }
+  const int from = trusted_x(nc);
+  const bool vrel = !rs->hardxpos;
+  struct {
+    vmove_e v;
+    unsigned cost;
+    int col;
+  } vmoves[4];
+  unsigned vcount = 0;
+  if(y == rs->y){
+    vmoves[vcount++] = (typeof(*vmoves)){ VMOVE_NONE, 0, from, };
   }else{
-    // cup is required, no need to check for existence
-    ret = term_emit(tiparm(nc->tcache.cup, y, x), out, false);
-    nc->rstate.hardcursorpos = 0;
+    if(vrel && y > rs->y && ti->cud){
+      vmoves[vcount++] = (typeof(*vmoves)){ VMOVE_CUD, ti->motioncost.cud + decimal_digits(y - rs->y), from, };
+    }
+    if(vrel && y < rs->y && ti->cuu){
+      vmoves[vcount++] = (typeof(*vmoves)){ VMOVE_CUU, ti->motioncost.cuu + decimal_digits(rs->y - y), from, };
+    }
+    if(ti->vpa){
+      vmoves[vcount++] = (typeof(*vmoves)){ VMOVE_VPA, ti->motioncost.vpa + decimal_digits(y + 1), from, };
+    }
+    if(vrel && y == rs->y + 1){
+      vmoves[vcount++] = (typeof(*vmoves)){ VMOVE_CRLF, 2, 0, };
+    }
   }
-  nc->rstate.x = x;
-  nc->rstate.y = y;
-  return ret;
+  for(unsigned i = 0 ; i < vcount ; ++i){
+    hmove_e h;
+    unsigned hcost = plan_hmove(ti, vmoves[i].col, x, &h);
+    if(hcost != UINT_MAX && vmoves[i].cost + hcost < best){
+      best = vmoves[i].cost + hcost;
+      m->v = vmoves[i].v;
+      m->h = h;
+    }
+  }
+}
+
+// the estimated cost of the motion goto_location() used before it had a cost
+// model (cup, or hpa and cuf1 within a row), from which we reckon the bytes
+// we've saved. this is computed arithmetically, as plan_motion() does, rather
+// than by building the escapes.
+static unsigned
+legacy_motion_cost(const notcurses* nc, int y, int x){
+  const tinfo* ti = &nc->tcache;
+  const rasterstate* rs = &nc->rstate;
+  if(rs->y == y && ti->hpa && !rs->hardcursorpos){
+    if(x == rs->x + 1 && ti->cuf1){
+      return ti->motioncost.cuf1;
+    }
+    return ti->motioncost.hpa + decimal_digits(x + 1);
+  }
+  return ti->motioncost.cup + decimal_digits(y + 1) + decimal_digits(x + 1);
+}
+
+static inline int
+motion_append(char* buf, size_t* len, const char* seq){
+  if(seq == NULL){
+    return -1;
+  }
+  size_t slen = strlen(seq);
+  if(*len + slen > MOTION_MAXLEN){
+    return -1;
+  }
+  memcpy(buf + *len, seq, slen);
+  *len += slen;
+  return 0;
+}
+
+static inline int
+motion_expand(char* buf, size_t* len, const esctemplate* t, int p1, int p2){
+  int r = esctemplate_expand(t, buf + *len, MOTION_MAXLEN - *len, p1, p2);
+  if(r < 0){
+    return -1;
+  }
+  *len += r;
+  return 0;
+}
+
+// write the escapes effecting 'm' into 'buf', which must have room for
+// MOTION_MAXLEN bytes. returns the number of bytes, or -1 on failure.
+static int
+build_motion(const notcurses* nc, const motion* m, int y, int x, char* buf){
+  const tinfo* ti = &nc->tcache;
+  const rasterstate* rs = &nc->rstate;
+  size_t len = 0;
+  int from = rs->x;
+  int r = 0;
+  switch(m->v){
+    case VMOVE_NONE: break;
+    case VMOVE_CUD: r = motion_expand(buf, &len, &ti->cudtmpl, y - rs->y, 0); break;
+    case VMOVE_CUU: r = motion_expand(buf, &len, &ti->cuutmpl, rs->y - y, 0); break;
+    case VMOVE_VPA: r = motion_expand(buf, &len, &ti->vpatmpl, y, 0); break;
+    case VMOVE_CRLF: r = motion_append(buf, &len, "\r\n"); from = 0; break;
+    case VMOVE_CUP: r = motion_expand(buf, &len, &ti->cuptmpl, y, x); break;
+    case VMOVE_HOME: r = motion_append(buf, &len, ti->home); break;
+  }
+  switch(m->h){
+    case HMOVE_NONE: break;
+    case HMOVE_CUF1: r |= motion_append(buf, &len, ti->cuf1); break;
+    case HMOVE_CUF: r |= motion_expand(buf, &len, &ti->cuftmpl, x - from, 0); break;
+    case HMOVE_CUB: r |= motion_expand(buf, &len, &ti->cubtmpl, from - x, 0); break;
+    case HMOVE_HPA: r |= motion_expand(buf, &len, &ti->hpatmpl, x, 0); break;
+    case HMOVE_CR: r |= motion_append(buf, &len, "\r"); break;
+    case HMOVE_CRCUF:
+      r |= motion_append(buf, &len, "\r");
+      r |= motion_expand(buf, &len, &ti->cuftmpl, x, 0);
+      break;
+  }
+  return r ? -1 : (int)len;
+}
+
+// if each cell between the cursor and 'x' on row 'y' is already onscreen,
+// and rewriting its glyph with the current style and colors would reproduce
+// it exactly, return how many such cells there are (so long as it is less
+// than 'max'). otherwise, return -1. the current style and colors are those
+// of the most recently emitted cell, and we only consider rewriting
+// single-byte glyphs of the same style and colors.
+static int
+reemission_cost(const notcurses* nc, const ncpile* p, int y, int x, int max){
+  const rasterstate* rs = &nc->rstate;
+  const nccell* last = rs->lastcell;
+  const int from = trusted_x(nc);
+  if(last == NULL || cell_nobackground_p(last) || rs->y != y || from < 0){
+    return -1;
+  }
+  const int count = x - from;
+  const int innery = y - nc->stdplane->absy;
+  const int innerx = from - nc->stdplane->absx;
+  if(count <= 0 || count >= max || innerx < 0 || innery < 0 || innery >= p->dimy){
+    return -1;
+  }
+  for(int i = 0 ; i < count ; ++i){
+    const size_t idx = innery * nc->lfdimx + innerx + i;
+    const struct crender* r = &p->rvec.crender[idx];
+    const nccell* c = &nc->lastframe[idx];
+    if(r->s.damaged || r->s.sprixeled || !cell_simple_p(c) || c->width > 1){
+      return -1;
+    }
+    if(c->stylemask != last->stylemask || c->channels != last->channels){
+      return -1;
+    }
+    const unsigned char* egc = (const unsigned char*)&c->gcluster;
+    if(egc[0] && (egc[0] < 0x20 || egc[0] >= 0x7f || egc[1])){
+      return -1;
+    }
+  }
+  return count;
+}
+
+// sync the drawing position to the specified location with as little overhead
+// as possible (with nothing, if already at the right location). the cheapest
+// of the motions available is chosen according to a model of their costs.
+// if 'p' is not NULL, rewriting the glyphs already onscreen
+// between here and there is also considered. if hardcursorpos is non-zero, we
+// always perform an absolute move.
+static int
+goto_location(notcurses* nc, fbuf* f, int y, int x, const ncpile* p){
+//fprintf(stderr, "going to %d/%d from %d/%d hard: %u\n", y, x, nc->rstate.y, nc->rstate.x, hardcursorpos);
+  rasterstate* rs = &nc->rstate;
+  if(rs->y == y && rs->x == x && !rs->hardcursorpos){ // needn't move shit
+    return 0;
+  }
+  motion m;
+  char seq[MOTION_MAXLEN];
+  plan_motion(nc, y, x, &m);
+  const unsigned legacycost = legacy_motion_cost(nc, y, x);
+  int len = build_motion(nc, &m, y, x, seq);
+  if(len < 0){
+    return -1;
+  }
+  int reemit = p ? reemission_cost(nc, p, y, x, len) : -1;
+  if(reemit > 0){
+    const int innery = y - nc->stdplane->absy;
+    const int innerx = rs->x - nc->stdplane->absx;
+    for(int i = 0 ; i < reemit ; ++i){
+      const nccell* c = &nc->lastframe[innery * nc->lfdimx + innerx + i];
+      if(term_putc(f, &nc->pool, c)){
+        return -1;
+      }
+    }
+    len = reemit;
+  }else if(fbuf_putn(f, seq, len)){
+    return -1;
+  }
+  if(legacycost > (unsigned)len){
+    nc->stats.motion_bytes_saved += legacycost - len;
+  }
+  rs->x = x;
+  rs->y = y;
+  rs->hardcursorpos = false;
+  rs->hardxpos = false;
+  return 0;
 }
 
 // at least one of the foreground and background are the default. emit the
 // necessary return to default (if one is necessary), and update rstate.
 static inline int
-raster_defaults(notcurses* nc, bool fgdef, bool bgdef, FILE* out){
+raster_defaults(notcurses* nc, bool fgdef, bool bgdef, fbuf* f){
   if(!nc->tcache.op){ // if we don't have op, we don't have fgop/bgop
     return 0;
   }
@@ -842,7 +1201,7 @@ raster_defaults(notcurses* nc, bool fgdef, bool bgdef, FILE* out){
     ++nc->stats.defaultelisions;
     return 0;
   }else if((mustsetfg && mustsetbg) || !nc->tcache.fgop){
-    if(term_emit(nc->tcache.op, out, false)){
+    if(fbuf_emit(f, nc->tcache.op)){
       return -1;
     }
     nc->rstate.fgdefelidable = true;
@@ -852,14 +1211,14 @@ raster_defaults(notcurses* nc, bool fgdef, bool bgdef, FILE* out){
     nc->rstate.fgpalelidable = false;
     nc->rstate.bgpalelidable = false;
   }else if(mustsetfg){
-    if(term_emit(nc->tcache.fgop, out, false)){
+    if(fbuf_emit(f, nc->tcache.fgop)){
       return -1;
     }
     nc->rstate.fgdefelidable = true;
     nc->rstate.fgelidable = false;
     nc->rstate.fgpalelidable = false;
   }else{
-    if(term_emit(nc->tcache.bgop, out, false)){
+    if(fbuf_emit(f, nc->tcache.bgop)){
       return -1;
     }
     nc->rstate.bgdefelidable = true;
@@ -872,13 +1231,13 @@ raster_defaults(notcurses* nc, bool fgdef, bool bgdef, FILE* out){
 
 // these are unlikely, so we leave it uninlined
 static int
-emit_fg_palindex(notcurses* nc, FILE* out, const nccell* srccell){
+emit_fg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
   unsigned palfg = nccell_fg_palindex(srccell);
   // we overload lastr for the palette index; both are 8 bits
   if(nc->rstate.fgpalelidable && nc->rstate.lastr == palfg){
     ++nc->stats.fgelisions;
   }else{
-    if(term_fg_palindex(nc, out, palfg)){
+    if(term_fg_palindex(nc, f, palfg)){
       return -1;
     }
     ++nc->stats.fgemissions;
@@ -891,12 +1250,12 @@ emit_fg_palindex(notcurses* nc, FILE* out, const nccell* srccell){
 }
 
 static int
-emit_bg_palindex(notcurses* nc, FILE* out, const nccell* srccell){
+emit_bg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
   unsigned palbg = nccell_bg_palindex(srccell);
   if(nc->rstate.bgpalelidable && nc->rstate.lastbr == palbg){
     ++nc->stats.bgelisions;
   }else{
-    if(term_bg_palindex(nc, out, palbg)){
+    if(term_bg_palindex(nc, f, palbg)){
       return -1;
     }
     ++nc->stats.bgemissions;
@@ -911,14 +1270,14 @@ emit_bg_palindex(notcurses* nc, FILE* out, const nccell* srccell){
 // remove any sprixels which are no longer desired. for kitty, this will be
 // a pure erase; for sixel, we must overwrite.
 static int
-clean_sprixels(notcurses* nc, ncpile* p, FILE* out){
+clean_sprixels(notcurses* nc, ncpile* p, fbuf* f){
   sprixel* s;
   sprixel** parent = &p->sprixelcache;
   int ret = 0;
   while( (s = *parent) ){
     if(s->invalidated == SPRIXEL_HIDE){
 //fprintf(stderr, "OUGHT HIDE %d [%dx%d] %p\n", s->id, s->dimy, s->dimx, s);
-      if(sprite_destroy(nc, p, out, s) == 0){
+      if(sprite_destroy(nc, p, f, s) == 0){
         if( (*parent = s->next) ){
           s->next->prev = s->prev;
         }
@@ -933,10 +1292,10 @@ clean_sprixels(notcurses* nc, ncpile* p, FILE* out){
       // without this, kitty flickers
 //fprintf(stderr, "1 MOVING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, y + nc->stdplane->absy, x + nc->stdplane->absx, s->n);
       if(s->invalidated == SPRIXEL_MOVED){
-        sprite_destroy(nc, p, out, s);
+        sprite_destroy(nc, p, f, s);
       }
-      if(goto_location(nc, out, y + nc->stdplane->absy, x + nc->stdplane->absx) == 0){
-        if(sprite_draw(nc, p, s, out)){
+      if(goto_location(nc, f, y + nc->stdplane->absy, x + nc->stdplane->absx, NULL) == 0){
+        if(sprite_draw(nc, p, s, f)){
           return -1;
         }
         nc->rstate.hardcursorpos = true;
@@ -954,15 +1313,15 @@ clean_sprixels(notcurses* nc, ncpile* p, FILE* out){
 // returns -1 on error, 0 on success. draw any sprixels. any material
 // underneath them has already been updated.
 static int
-rasterize_sprixels(notcurses* nc, ncpile* p, FILE* out){
+rasterize_sprixels(notcurses* nc, ncpile* p, fbuf* f){
   int ret = 0;
   for(sprixel* s = p->sprixelcache ; s ; s = s->next){
     if(s->invalidated == SPRIXEL_INVALIDATED){
       int y, x;
       ncplane_yx(s->n, &y, &x);
 //fprintf(stderr, "3 DRAWING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, y + nc->stdplane->absy, x + nc->stdplane->absx, s->n);
-      if(goto_location(nc, out, y + nc->stdplane->absy, x + nc->stdplane->absx) == 0){
-        if(sprite_draw(nc, p, s, out)){
+      if(goto_location(nc, f, y + nc->stdplane->absy, x + nc->stdplane->absx, NULL) == 0){
+        if(sprite_draw(nc, p, s, f)){
           return -1;
         }
         nc->rstate.hardcursorpos = true;
@@ -975,6 +1334,206 @@ rasterize_sprixels(notcurses* nc, ncpile* p, FILE* out){
   return ret;
 }
 
+// record that the output of row 'y' begins at the current offset of 'f'. a
+// row which emitted nothing needn't be recorded, so its mark is reused.
+static int
+mark_row(notcurses* nc, const fbuf* f, int y){
+  const size_t offset = f->used;
+  rasterstate* rs = &nc->rstate;
+  if(rs->rowmarkcount && rs->rowmarks[rs->rowmarkcount - 1].offset == offset){
+    rs->rowmarks[rs->rowmarkcount - 1].y = y;
+    return 0;
+  }
+  if(rs->rowmarkcount == rs->rowmarkalloc){
+    unsigned alloc = rs->rowmarkalloc ? rs->rowmarkalloc * 2 : 64;
+    ncrowmark* tmp = realloc(rs->rowmarks, sizeof(*tmp) * alloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    rs->rowmarks = tmp;
+    rs->rowmarkalloc = alloc;
+  }
+  rs->rowmarks[rs->rowmarkcount].offset = offset;
+  rs->rowmarks[rs->rowmarkcount].y = y;
+  ++rs->rowmarkcount;
+  return 0;
+}
+
+// can the terminal scroll its rows [top, bot] up? we need either a scrolling
+// region (and some means of scrolling within it), or for the region to extend
+// to the bottom of the screen, so that deleting lines scrolls it.
+static bool
+scrollable_region(const notcurses* nc, int top, int bot){
+  const tinfo* ti = &nc->tcache;
+  const int rows = nc->margin_t + nc->lfdimy + nc->margin_b;
+  const bool region = top > 0 || bot < rows - 1;
+  if(ti->indn && (ti->csr || !region)){
+    return true;
+  }
+  if(!ti->dl || !ti->cup){
+    return false;
+  }
+  return ti->csr || bot == rows - 1;
+}
+
+// expand 't' with 'p1' and 'p2' into 'f'.
+static inline int
+emit_template(fbuf* f, const esctemplate* t, int p1, int p2){
+  char seq[ESCTEMPLATE_MAXLEN];
+  const int len = esctemplate_expand(t, seq, sizeof(seq), p1, p2);
+  if(len < 0){
+    return -1;
+  }
+  return fbuf_putn(f, seq, len);
+}
+
+// have the terminal scroll as recorded in rstate by accelerate_scroll(). any
+// change of scrolling region homes the cursor.
+static int
+emit_scroll(notcurses* nc, fbuf* f){
+  rasterstate* rs = &nc->rstate;
+  const tinfo* ti = &nc->tcache;
+  const int rows = nc->margin_t + nc->lfdimy + nc->margin_b;
+  const int top = rs->scrolltop + nc->margin_t;
+  const int bot = rs->scrollbot + nc->margin_t;
+  const int count = rs->scrollrows;
+  rs->scrollrows = 0;
+  rs->hardcursorpos = true;
+  const bool region = top > 0 || bot < rows - 1;
+  const bool csr = region && ti->csr;
+  if(csr && emit_template(f, &ti->csrtmpl, top, bot)){
+    return -1;
+  }
+  // indn scrolls the whole region wherever the cursor is, but without a
+  // scrolling region, only dl respects our top row.
+  if(ti->indn && (csr || !region)){
+    if(emit_template(f, &ti->indntmpl, count, 0)){
+      return -1;
+    }
+  }else{
+    if(emit_template(f, &ti->cuptmpl, top, 0)){
+      return -1;
+    }
+    if(emit_template(f, &ti->dltmpl, count, 0)){
+      return -1;
+    }
+  }
+  if(csr && emit_template(f, &ti->csrtmpl, 0, rows - 1)){
+    return -1;
+  }
+  return 0;
+}
+
+// can the terminal encode runs any more cheaply than by writing them?
+static inline bool
+run_encodable(const tinfo* ti){
+  return ti->rep || ti->echtmpl.cap || ti->el;
+}
+
+// the number of damaged cells, starting with that at 'damageidx' and running
+// no more than 'max' cells, which are identical to it and would be drawn in
+// this phase. only runs of single-column simple glyphs free of sprixels can
+// be encoded; for anything else, this is 1.
+static int
+damaged_run(const notcurses* nc, const ncpile* p, unsigned phase,
+            size_t damageidx, int max){
+  const struct crender* rvec = p->rvec.crender;
+  const nccell* c = &nc->lastframe[damageidx];
+  if(!cell_simple_p(c) || c->width > 1 || rvec[damageidx].s.sprixeled){
+    return 1;
+  }
+  int run = 1;
+  while(run < max){
+    const struct crender* r = &rvec[damageidx + run];
+    const nccell* n = &nc->lastframe[damageidx + run];
+    if(!r->s.damaged || r->s.sprixeled || (phase == 0 && r->s.p_beats_sprixel)){
+      break;
+    }
+    if(n->gcluster != c->gcluster || n->stylemask != c->stylemask ||
+       n->channels != c->channels || n->width != c->width){
+      break;
+    }
+    ++run;
+  }
+  return run;
+}
+
+// how a run of identical cells is written
+typedef enum {
+  RUN_WRITE,  // write each cell's glyph
+  RUN_REP,    // write the glyph once, and repeat it for the remainder
+  RUN_ECH,    // erase the run, leaving the cursor at its start
+  RUN_EL,     // erase from the cursor through the end of the line
+} runenc_e;
+
+// write the run of 'run' copies of 'c' starting at column 'x', for which the
+// style and colors have already been set, as cheaply as we can. the damage
+// of the row ends before 'endx'. erasures blank cells with the current
+// background, which is only what we want if the terminal has bce, or the
+// background is the default. they don't move the cursor, so unless the run
+// ends the damage, we'll have to move past it. returns the encoding used, or
+// -1 on error; RUN_WRITE means that nothing was written.
+static int
+emit_run(notcurses* nc, fbuf* f, const nccell* c, int run, int x, int endx){
+  const tinfo* ti = &nc->tcache;
+  const unsigned char* egc = (const unsigned char*)&c->gcluster;
+  const size_t glen = c->gcluster ? strnlen((const char*)egc, 4) : 1;
+  const size_t plain = glen * run;
+  runenc_e enc = RUN_WRITE;
+  size_t best = plain;
+  char ech[ESCTEMPLATE_MAXLEN];
+  int echlen = -1;
+  const bool blank = c->gcluster == 0 || c->gcluster == htole(' ');
+  if(blank && c->stylemask == 0 && !cell_nobackground_p(c) &&
+     (ti->BCEflag || nccell_bg_default_p(c))){
+    const int cols = nc->margin_l + nc->lfdimx + nc->margin_r;
+    if(ti->el && x + run == cols && strlen(ti->el) < best){
+      best = strlen(ti->el);
+      enc = RUN_EL;
+    }
+    echlen = esctemplate_expand(&ti->echtmpl, ech, sizeof(ech), run, 0);
+    if(echlen > 0){
+      size_t cost = echlen;
+      if(x + run < endx){
+        cost += ti->motioncost.cuf + decimal_digits(run);
+      }
+      if(cost < best){
+        best = cost;
+        enc = RUN_ECH;
+      }
+    }
+  }
+  if(ti->rep && run > 1){
+    // the glyph, followed by CSI Ps b
+    size_t cost = glen + 3 + decimal_digits(run - 1);
+    if(cost < best){
+      best = cost;
+      enc = RUN_REP;
+    }
+  }
+  switch(enc){
+    case RUN_WRITE: return RUN_WRITE;
+    case RUN_EL:
+      if(fbuf_emit(f, ti->el)){
+        return -1;
+      }
+      break;
+    case RUN_ECH:
+      if(fbuf_putn(f, ech, echlen)){
+        return -1;
+      }
+      break;
+    case RUN_REP:
+      if(term_putc(f, &nc->pool, c) || fbuf_putn(f, "\x1b[", 2) ||
+         fbuf_putuint(f, run - 1) || fbuf_putc(f, 'b')){
+        return -1;
+      }
+      break;
+  }
+  nc->stats.run_bytes_saved += plain - best;
+  return enc;
+}
+
 // Producing the frame requires three steps:
 //  * render -- build up a flat framebuffer from a set of ncplanes
 //  * rasterize -- build up a UTF-8/ASCII stream of escapes and EGCs
@@ -985,13 +1544,46 @@ rasterize_sprixels(notcurses* nc, ncpile* p, FILE* out){
 // spits out an optimal sequence of terminal-appropriate escapes and EGCs. There
 // should be an rvec entry for each cell, but only the 'damaged' field is used.
 // lastframe has *not yet been written to the screen*, i.e. it's only about to
-// *become* the last frame rasterized.
+// *become* the last frame rasterized. if 'damage' is not NULL, rows without
+// damage are skipped, and only the damaged span of others is scanned.
 static int
-rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
-  struct crender* rvec = p->crender;
+rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase,
+               const damagespan* damage){
+  struct crender* rvec = p->rvec.crender;
   for(int y = nc->stdplane->absy ; y < p->dimy + nc->stdplane->absy ; ++y){
     const int innery = y - nc->stdplane->absy;
-    for(int x = nc->stdplane->absx ; x < p->dimx + nc->stdplane->absx ; ++x){
+    int startx = 0;
+    int endx = p->dimx;
+    if(damage){
+      const damagespan* span = &damage[innery];
+      if(span->minx > span->maxx){
+        if(phase == 0){
+          ++nc->stats.rowelisions;
+        }
+        nc->stats.cellelisions += p->dimx;
+        continue;
+      }
+      startx = span->minx;
+      endx = span->maxx + 1;
+      // never start on the right half of a wide glyph
+      if(startx > 0 && nccell_wide_left_p(&nc->lastframe[innery * nc->lfdimx + startx - 1])){
+        --startx;
+      }
+      if(phase == 0){
+        ++nc->stats.rowemissions;
+      }
+      nc->stats.cellelisions += p->dimx - (endx - startx);
+    }
+    if(phase == 0 && nc->rstate.markrows){
+      if(mark_row(nc, f, innery)){
+        return -1;
+      }
+    }
+    // a run emit_run() found cheapest to write plainly is written cell by
+    // cell; none of its suffixes can be encoded more cheaply, so we needn't
+    // scan again until we've passed it.
+    int plainrunend = 0;
+    for(int x = startx + nc->stdplane->absx ; x < endx + nc->stdplane->absx ; ++x){
       const int innerx = x - nc->stdplane->absx;
       const size_t damageidx = innery * nc->lfdimx + innerx;
       unsigned r, g, b, br, bg, bb;
@@ -1008,12 +1600,12 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
         // was not above a sprixel (and the cell is damaged). in the second
         // phase, we draw everything that remains damaged.
         ++nc->stats.cellemissions;
-        if(goto_location(nc, out, y, x)){
+        if(goto_location(nc, f, y, x, p)){
           return -1;
         }
         // set the style. this can change the color back to the default; if it
         // does, we need update our elision possibilities.
-        if(term_setstyles(out, nc, srccell)){
+        if(term_setstyles(f, nc, srccell)){
           return -1;
         }
         // if our cell has a default foreground *or* background, we can elide
@@ -1024,7 +1616,7 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
         bool nobackground = cell_nobackground_p(srccell);
         if((nccell_fg_default_p(srccell)) || (!nobackground && nccell_bg_default_p(srccell))){
           if(raster_defaults(nc, nccell_fg_default_p(srccell),
-                            !nobackground && nccell_bg_default_p(srccell), out)){
+                            !nobackground && nccell_bg_default_p(srccell), f)){
             return -1;
           }
         }
@@ -1033,7 +1625,7 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
         //  * the previous was non-default, and matches what we have now, or
         //  * we are a no-foreground glyph (iswspace() is true)
         if(nccell_fg_palindex_p(srccell)){ // palette-indexed foreground
-          if(emit_fg_palindex(nc, out, srccell)){
+          if(emit_fg_palindex(nc, f, srccell)){
             return -1;
           }
         }else if(!nccell_fg_default_p(srccell)){ // rgb foreground
@@ -1041,7 +1633,7 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
           if(nc->rstate.fgelidable && nc->rstate.lastr == r && nc->rstate.lastg == g && nc->rstate.lastb == b){
             ++nc->stats.fgelisions;
           }else{
-            if(term_fg_rgb8(nc->tcache.RGBflag, nc->tcache.setaf, nc->tcache.colors, out, r, g, b)){
+            if(term_fg_rgb8(&nc->tcache, f, r, g, b)){
               return -1;
             }
             ++nc->stats.fgemissions;
@@ -1058,7 +1650,7 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
         if(nobackground){
           ++nc->stats.bgelisions;
         }else if(nccell_bg_palindex_p(srccell)){ // palette-indexed background
-          if(emit_bg_palindex(nc, out, srccell)){
+          if(emit_bg_palindex(nc, f, srccell)){
             return -1;
           }
         }else if(!nccell_bg_default_p(srccell)){ // rgb background
@@ -1066,9 +1658,7 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
           if(nc->rstate.bgelidable && nc->rstate.lastbr == br && nc->rstate.lastbg == bg && nc->rstate.lastbb == bb){
             ++nc->stats.bgelisions;
           }else{
-            if(term_bg_rgb8(nc->tcache.RGBflag, nc->tcache.setab,
-                            nc->tcache.colors, out, br, bg, bb,
-                            nc->tcache.bg_collides_default)){
+            if(term_bg_rgb8(&nc->tcache, f, br, bg, bb)){
               return -1;
             }
             ++nc->stats.bgemissions;
@@ -1081,19 +1671,53 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
 //fprintf(stderr, "RAST %08x [%s] to %d/%d cols: %u %016lx\n", srccell->gcluster, pool_extended_gcluster(&nc->pool, srccell), y, x, srccell->width, srccell->channels);
         // this is used to invalidate the sprixel in the first text round,
         // which is only necessary for sixel, not kitty.
-        if(rvec[damageidx].sprixel){
-          sprixcell_e scstate = sprixel_state(rvec[damageidx].sprixel, y - nc->stdplane->absy, x - nc->stdplane->absx);
+        if(rvec[damageidx].s.sprixeled){
+          sprixel* s = p->rvec.aux[damageidx].sprixel;
+          sprixcell_e scstate = sprixel_state(s, y - nc->stdplane->absy, x - nc->stdplane->absx);
           if((scstate == SPRIXCELL_MIXED_SIXEL || scstate == SPRIXCELL_OPAQUE_SIXEL)
              && !rvec[damageidx].s.p_beats_sprixel){
 //fprintf(stderr, "INVALIDATING at %d/%d (%u)\n", y, x, rvec[damageidx].s.p_beats_sprixel);
-            sprixel_invalidate(rvec[damageidx].sprixel, y, x);
+            sprixel_invalidate(s, y, x);
           }
         }
-        if(term_putc(out, &nc->pool, srccell)){
-          return -1;
+        // runs of identical cells might be cheaper to repeat or erase
+        int run = 1;
+        int enc = RUN_WRITE;
+        if(innerx >= plainrunend && run_encodable(&nc->tcache)){
+          run = damaged_run(nc, p, phase, damageidx, endx - innerx);
+          if(run > 1){
+            if((enc = emit_run(nc, f, srccell, run, x, endx + nc->stdplane->absx)) < 0){
+              return -1;
+            }
+            if(enc == RUN_WRITE){
+              plainrunend = innerx + run;
+            }
+          }
         }
+        nc->rstate.lastcell = srccell;
         rvec[damageidx].s.damaged = 0;
         rvec[damageidx].s.p_beats_sprixel = 0;
+        if(enc != RUN_WRITE){
+          for(int i = 1 ; i < run ; ++i){
+            rvec[damageidx + i].s.damaged = 0;
+            rvec[damageidx + i].s.p_beats_sprixel = 0;
+          }
+          nc->stats.cellemissions += run - 1;
+          x += run - 1;
+          // erasures leave the cursor where it was
+          if(enc == RUN_REP){
+            nc->rstate.x += run;
+          }
+          continue;
+        }
+        if(term_putc(f, &nc->pool, srccell)){
+          return -1;
+        }
+        // the terminal might disagree with us regarding the width of a wide
+        // or multicodepoint glyph; don't rely on our column to move from it.
+        if(srccell->width >= 2 || cell_extended_p(srccell)){
+          nc->rstate.hardxpos = true;
+        }
         ++nc->rstate.x;
         if(srccell->width >= 2){
           x += srccell->width - 1;
@@ -1106,73 +1730,123 @@ rasterize_core(notcurses* nc, const ncpile* p, FILE* out, unsigned phase){
   return 0;
 }
 
+// 'damage' ought be NULL unless it was computed by postpaint() for this frame.
 static int
-notcurses_rasterize_inner(notcurses* nc, ncpile* p, FILE* out){
-  fseeko(out, 0, SEEK_SET);
+notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f,
+                          const damagespan* damage){
+  rasterstate* rs = &nc->rstate;
+  fbuf_reset(f);
+  // reserve ahead for a frame like the recent ones, so that we needn't grow
+  // (and copy) the buffer in the middle of rasterizing.
+  if(fbuf_reserve(f, rs->framelen + rs->framelen / 4)){
+    return -1;
+  }
   // we only need to emit a coordinate if it was damaged. the damagemap is a
   // bit per coordinate, one per struct crender.
   // don't write a clearscreen. we only update things that have been changed.
   // we explicitly move the cursor at the beginning of each output line, so no
   // need to home it expliticly.
 //fprintf(stderr, "pile %p ymax: %d xmax: %d\n", p, p->dimy + nc->stdplane->absy, p->dimx + nc->stdplane->absx);
-  if(clean_sprixels(nc, p, out) < 0){
+  // destroying and drawing sprixels damages cells after postpaint() has
+  // computed the damage map, so it can't be trusted in their presence.
+  if(p->sprixelcache){
+    damage = NULL;
+  }
+  // lastframe might have been reallocated since we last emitted a cell
+  rs->lastcell = NULL;
+  if(rs->scrollrows && emit_scroll(nc, f)){
     return -1;
   }
-  update_palette(nc, out);
+  if(clean_sprixels(nc, p, f) < 0){
+    return -1;
+  }
+  update_palette(nc, f);
 //fprintf(stderr, "RASTERIZE CORE\n");
-  if(rasterize_core(nc, p, out, 0)){
+  if(rasterize_core(nc, p, f, 0, damage)){
     return -1;
   }
 //fprintf(stderr, "RASTERIZE SPRIXELS\n");
-  if(rasterize_sprixels(nc, p, out) < 0){
+  if(rasterize_sprixels(nc, p, f) < 0){
     return -1;
   }
 //fprintf(stderr, "RASTERIZE CORE\n");
-  if(rasterize_core(nc, p, out, 1)){
+  if(rasterize_core(nc, p, f, 1, damage)){
     return -1;
   }
-  if(fflush(out)){
-    return -1;
+  // track growth immediately, but let the estimate decay slowly, so that a
+  // single small frame doesn't cost us the reservation.
+  if(f->used > rs->framelen){
+    rs->framelen = f->used;
+  }else{
+    rs->framelen -= (rs->framelen - f->used) / 8;
   }
-  return nc->rstate.mstrsize;
+  return f->used;
 }
 
-// rasterize the rendered frame, and blockingly write it out to the terminal.
+// rasterize the rendered frame, and write it out to the terminal. if 'async'
+// is set, the frame is handed off to the writer thread, and we only block if
+// it's still busy with two earlier frames. if the writer coalesces, we mark
+// the rows of frames without sprixels, so that they can be cut short; the
+// sprixel state machines assume their output reaches the terminal.
 static int
-raster_and_write(notcurses* nc, ncpile* p, FILE* out){
-  if(notcurses_rasterize_inner(nc, p, out) < 0){
+raster_and_write(notcurses* nc, ncpile* p, fbuf* f, bool async){
+  nc->rstate.markrows = async && nc->writer->coalesce && !p->sprixelcache;
+  nc->rstate.rowmarkcount = 0;
+  int r = notcurses_rasterize_inner(nc, p, f, p->damage);
+  nc->rstate.markrows = false;
+  if(r < 0){
     return -1;
   }
+  // the writer takes ownership of the buffer, so this must come first
+  if(nc->renderfp){
+    fwrite(f->buf, f->used, 1, nc->renderfp);
+    fputc('\n', nc->renderfp);
+  }
   int ret = 0;
-  //fflush(nc->ttyfp);
-  sigset_t oldmask;
-  block_signals(&oldmask);
-  if(blocking_write(fileno(nc->ttyfp), nc->rstate.mstream, nc->rstate.mstrsize)){
-    ret = -1;
+  if(async){
+    int64_t waitns;
+    if(writer_submit(nc->writer, f, nc->rstate.rowmarks,
+                     nc->rstate.rowmarkcount, &waitns)){
+      ret = -1;
+    }
+    if(waitns){
+      pthread_mutex_lock(&nc->statlock);
+      ++nc->stats.writer_waits;
+      nc->stats.writer_wait_ns += waitns;
+      pthread_mutex_unlock(&nc->statlock);
+    }
+  }else{
+    // an earlier frame might still be draining from the writer thread
+    if(writer_drain(nc->writer)){
+      ret = -1;
+    }
+    sigset_t oldmask;
+    block_signals(&oldmask);
+    if(blocking_write(fileno(nc->ttyfp), f->buf, f->used)){
+      ret = -1;
+    }
+    unblock_signals(&oldmask);
   }
-  unblock_signals(&oldmask);
 //fprintf(stderr, "%lu/%lu %lu/%lu %lu/%lu %d\n", nc->stats.defaultelisions, nc->stats.defaultemissions, nc->stats.fgelisions, nc->stats.fgemissions, nc->stats.bgelisions, nc->stats.bgemissions, ret);
-  if(nc->renderfp){
-    fprintf(nc->renderfp, "%s\n", nc->rstate.mstream);
-  }
   if(ret < 0){
     return ret;
   }
-  return nc->rstate.mstrsize;
+  return r;
 }
 
 // if the cursor is enabled, store its location and disable it. then, once done
 // rasterizing, enable it afresh, moving it to the stored location. if left on
-// during rasterization, we'll get grotesque flicker. 'out' is a memstream
-// used to collect a buffer.
+// during rasterization, we'll get grotesque flicker. 'f' is used to collect a
+// buffer. the cursor is toggled by writing directly to the terminal, so frames
+// are written synchronously while it's enabled.
 static inline int
-notcurses_rasterize(notcurses* nc, ncpile* p, FILE* out){
+notcurses_rasterize(notcurses* nc, ncpile* p, fbuf* f){
   const int cursory = nc->cursory;
   const int cursorx = nc->cursorx;
   if(cursory >= 0){ // either both are good, or neither is
     notcurses_cursor_disable(nc);
   }
-  int ret = raster_and_write(nc, p, out);
+  int ret = raster_and_write(nc, p, f, nc->writer && cursory < 0);
   if(cursory >= 0){
     notcurses_cursor_enable(nc, cursory, cursorx);
   }
@@ -1205,6 +1879,9 @@ int notcurses_refresh(notcurses* nc, int* restrict dimy, int* restrict dimx){
   if(nc->lfdimx == 0 || nc->lfdimy == 0){
     return 0;
   }
+  if(writer_drain(nc->writer)){
+    return -1;
+  }
   if(home_cursor(nc, true)){
     return -1;
   }
@@ -1213,17 +1890,18 @@ int notcurses_refresh(notcurses* nc, int* restrict dimy, int* restrict dimx){
   p.dimx = nc->stdplane->lenx;
   const int count = (nc->lfdimx > p.dimx ? nc->lfdimx : p.dimx) *
                     (nc->lfdimy > p.dimy ? nc->lfdimy : p.dimy);
-  p.crender = malloc(count * sizeof(*p.crender));
-  if(p.crender == NULL){
+  if(rendervec_realloc(&p.rvec, count)){
+    rendervec_free(&p.rvec);
     return -1;
   }
-  init_rvec(p.crender, count);
+  init_rvec(&p.rvec, 0, count);
   for(int i = 0 ; i < count ; ++i){
-    p.crender[i].s.damaged = 1;
+    p.rvec.crender[i].s.damaged = 1;
   }
-  int ret = notcurses_rasterize(nc, &p, nc->rstate.mstreamfp);
-  free(p.crender);
-  if(ret < 0){
+  int ret = notcurses_rasterize(nc, &p, &nc->rstate.f);
+  rendervec_free(&p.rvec);
+  // a refresh is complete only once it's reached the terminal
+  if(ret < 0 || writer_drain(nc->writer)){
     return -1;
   }
   ++nc->stats.refreshes;
@@ -1234,41 +1912,388 @@ int notcurses_render_to_file(notcurses* nc, FILE* fp){
   if(nc->lfdimx == 0 || nc->lfdimy == 0){
     return 0;
   }
-  char* rastered = NULL;
-  size_t rastbytes = 0;
-  FILE* out = open_memstream(&rastered, &rastbytes);
-  if(out == NULL){
-    return -1;
-  }
-  ncpile p;
+  ncpile p = {};
   p.dimy = nc->stdplane->leny;
   p.dimx = nc->stdplane->lenx;
   const int count = (nc->lfdimx > p.dimx ? nc->lfdimx : p.dimx) *
                     (nc->lfdimy > p.dimy ? nc->lfdimy : p.dimy);
-  p.crender = malloc(count * sizeof(*p.crender));
-  if(p.crender == NULL){
-    fclose(out);
-    free(rastered);
+  if(rendervec_realloc(&p.rvec, count)){
+    rendervec_free(&p.rvec);
     return -1;
   }
-  init_rvec(p.crender, count);
+  init_rvec(&p.rvec, 0, count);
   for(int i = 0 ; i < count ; ++i){
-    p.crender[i].s.damaged = 1;
+    p.rvec.crender[i].s.damaged = 1;
+  }
+  // nothing is written to the terminal, so its presentation state mustn't
+  // change. rasterize from a reset state, so that the frame stands alone.
+  const rasterstate saved = nc->rstate;
+  memset(&nc->rstate, 0, sizeof(nc->rstate));
+  nc->rstate.hardcursorpos = true;
+  fbuf f = {};
+  int ret = notcurses_rasterize_inner(nc, &p, &f, NULL);
+  nc->rstate = saved;
+  rendervec_free(&p.rvec);
+  if(ret >= 0){
+    ret = fbuf_finalize(&f, fp);
+  }else{
+    fbuf_free(&f);
   }
-  int ret = raster_and_write(nc, &p, out);
-  free(p.crender);
-  if(ret > 0){
-    if(fprintf(fp, "%s", rastered) == ret){
-      ret = 0;
-    }else{
-      ret = -1;
+  return ret;
+}
+
+// is the cell at 'idx' of the render vector as init_rvec() left it, i.e.
+// untouched by any plane painted thus far?
+static inline bool
+rvec_fresh_p(const rendervec* rvec, int idx){
+  const struct crender* cr = &rvec->crender[idx];
+  if(cr->p || cr->s.blittedquads || cr->s.highcontrast ||
+     cr->s.fgblends || cr->s.bgblends){
+    return false;
+  }
+  nccell c = {};
+  nccell_set_fg_alpha(&c, CELL_ALPHA_TRANSPARENT);
+  nccell_set_bg_alpha(&c, CELL_ALPHA_TRANSPARENT);
+  return !memcmp(&rvec->cells[idx], &c, sizeof(c));
+}
+
+// count the planes of the cached layer rooted at 'root' (that's 'n' and the
+// planes bound to it, recursively, short of those rooting their own layers),
+// extending the absolute bounding box [*y0, *y1) x [*x0, *x1) to cover them.
+static unsigned
+layer_extent(const ncplane* n, const ncplane* root, int* y0, int* x0,
+             int* y1, int* x1){
+  if(n != root && n->layer){
+    return 0;
+  }
+  if(n->absy < *y0){
+    *y0 = n->absy;
+  }
+  if(n->absx < *x0){
+    *x0 = n->absx;
+  }
+  if(n->absy + n->leny > *y1){
+    *y1 = n->absy + n->leny;
+  }
+  if(n->absx + n->lenx > *x1){
+    *x1 = n->absx + n->lenx;
+  }
+  unsigned count = 1;
+  for(const ncplane* b = n->blist ; b ; b = b->bnext){
+    count += layer_extent(b, root, y0, x0, y1, x1);
+  }
+  return count;
+}
+
+// can the layer rooted at 'root', one of whose planes is 'member', be painted
+// from its composition over the area [absy, absy + leny) x [absx, absx +
+// lenx)? it can if its planes are contiguous on the z-axis, and it's visible.
+// the composition is rebuilt if it's been invalidated, or the visible portion
+// of the layer has changed.
+static bool
+layer_validate(ncpile* pile, ncplane* root, ncplane* member, int absy,
+               int absx, int leny, int lenx){
+  nclayer* l = root->layer;
+  int y0 = INT_MAX, x0 = INT_MAX, y1 = INT_MIN, x1 = INT_MIN;
+  const unsigned planes = layer_extent(root, root, &y0, &x0, &y1, &x1);
+  ncplane* top = member;
+  while(top->above && ncplane_layer_root(top->above) == root){
+    top = top->above;
+  }
+  unsigned run = 0;
+  for(const ncplane* p = top ; p && ncplane_layer_root(p) == root ; p = p->below){
+    ++run;
+  }
+  if(run != planes){
+    return false;
+  }
+  if(y0 < absy){
+    y0 = absy;
+  }
+  if(x0 < absx){
+    x0 = absx;
+  }
+  if(y1 > absy + leny){
+    y1 = absy + leny;
+  }
+  if(x1 > absx + lenx){
+    x1 = absx + lenx;
+  }
+  if(y0 >= y1 || x0 >= x1){
+    return false;
+  }
+  l->top = top;
+  l->planes = planes;
+  const bool hit = l->valid && l->absy == y0 && l->absx == x0 &&
+                   l->leny == y1 - y0 && l->lenx == x1 - x0;
+  if(!hit){
+    const size_t cells = (size_t)(y1 - y0) * (x1 - x0);
+    if(cells > l->cells){
+      if(rendervec_realloc(&l->rvec, cells)){
+        l->valid = false;
+        return false;
+      }
+      l->cells = cells;
+    }
+    l->absy = y0;
+    l->absx = x0;
+    l->leny = y1 - y0;
+    l->lenx = x1 - x0;
+    init_rvec(&l->rvec, 0, cells);
+    ncplane* p = top;
+    for(unsigned i = 0 ; i < planes ; ++i, p = p->below){
+      paint(p, &l->rvec, l->leny, l->lenx, l->absy, l->absx, NULL, 0, l->leny);
     }
+    l->valid = true;
+    ++l->misses;
+  }else{
+    ++l->hits;
   }
-  fclose(out);
-  free(rastered);
-  return ret;
+  notcurses* nc = pile->nc;
+  pthread_mutex_lock(&nc->statlock);
+  if(hit){
+    ++nc->stats.layer_hits;
+  }else{
+    ++nc->stats.layer_misses;
+  }
+  pthread_mutex_unlock(&nc->statlock);
+  return true;
+}
+
+// the 'count' planes of the pile's latest index query cover the area [absy,
+// absy + leny) x [absx, absx + lenx). validate each cached layer met among
+// them. the planes of a usable layer are replaced by its root, in the place
+// of its topmost plane, to be painted by paint_layer(). returns the new count.
+// layers are never used in piles with sprixels.
+static int
+ncpile_layer_hits(ncpile* pile, int count, int absy, int absx, int leny, int lenx){
+  ncplane** hits = pile->index.hits;
+  if(++pile->layergen == 0){
+    pile->layergen = 1;
+  }
+  const unsigned gen = pile->layergen;
+  int w = 0;
+  for(int r = 0 ; r < count ; ++r){
+    ncplane* p = hits[r];
+    ncplane* root = ncplane_layer_root(p);
+    if(root){
+      nclayer* l = root->layer;
+      if(l->mark != gen){
+        l->mark = gen;
+        l->usable = !pile->sprixelcache &&
+                    layer_validate(pile, root, p, absy, absx, leny, lenx);
+        if(l->usable){
+          hits[w++] = root;
+          continue;
+        }
+      }else if(l->usable){
+        continue;
+      }
+    }
+    hits[w++] = p;
+  }
+  return w;
+}
+
+// can column 'cx' of row 'cy' of the layer's composition be copied to the
+// render vector at 'idx'? it can if the target is untouched, and it isn't
+// half of a wide glyph whose other half is touched.
+static inline bool
+layer_copyable(const nclayer* l, const rendervec* rvec, int cy, int cx, int idx){
+  if(!rvec_fresh_p(rvec, idx)){
+    return false;
+  }
+  const int cidx = cy * l->lenx + cx;
+  if(l->rvec.crender[cidx].p){
+    const nccell* c = &l->rvec.cells[cidx];
+    if(c->width >= 2 && cx + 1 < l->lenx && !rvec_fresh_p(rvec, idx + 1)){
+      return false;
+    }
+    if(c->width == 0 && cx > 0 && !rvec_fresh_p(rvec, idx - 1)){
+      return false;
+    }
+  }
+  return true;
+}
+
+// paint the usable cached layer rooted at 'root' over rows [miny, maxy) of
+// the target area. untouched cells take the composition directly; runs of
+// any others are painted from the layer's planes, as they would have been.
+static void
+paint_layer(const ncplane* root, const rendervec* rvec, int dstleny, int dstlenx,
+            int dstabsy, int dstabsx, int miny, int maxy){
+  const nclayer* l = root->layer;
+  const int offy = l->absy - dstabsy;
+  const int offx = l->absx - dstabsx;
+  const int starty = offy > miny ? offy : miny;
+  const int endy = offy + l->leny < maxy ? offy + l->leny : maxy;
+  for(int y = starty ; y < endy ; ++y){
+    const int cy = y - offy;
+    const int rowidx = fbcellidx(y, dstlenx, offx);
+    int x = 0;
+    while(x < l->lenx){
+      int end = x;
+      while(end < l->lenx && layer_copyable(l, rvec, cy, end, rowidx + end)){
+        ++end;
+      }
+      if(end > x){
+        const int cidx = cy * l->lenx + x;
+        const size_t run = end - x;
+        memcpy(rvec->cells + rowidx + x, l->rvec.cells + cidx, sizeof(*rvec->cells) * run);
+        memcpy(rvec->crender + rowidx + x, l->rvec.crender + cidx, sizeof(*rvec->crender) * run);
+        memcpy(rvec->aux + rowidx + x, l->rvec.aux + cidx, sizeof(*rvec->aux) * run);
+        x = end;
+        continue;
+      }
+      while(end < l->lenx && !layer_copyable(l, rvec, cy, end, rowidx + end)){
+        ++end;
+      }
+      ncplane* p = l->top;
+      for(unsigned i = 0 ; i < l->planes ; ++i, p = p->below){
+        paint_cols(p, rvec, dstleny, dstlenx, dstabsy, dstabsx, NULL, y, y + 1,
+                   offx + x, offx + end);
+      }
+      x = end;
+    }
+  }
+}
+
+// paint an entry of a list prepared by ncpile_layer_hits()
+static inline void
+paint_entry(ncplane* p, const rendervec* rvec, int dstleny, int dstlenx,
+            int dstabsy, int dstabsx, sprixel** sprixelstack, int miny, int maxy){
+  if(p->layer && p->layer->usable){
+    paint_layer(p, rvec, dstleny, dstlenx, dstabsy, dstabsx, miny, maxy);
+  }else{
+    paint(p, rvec, dstleny, dstlenx, dstabsy, dstabsx, sprixelstack, miny, maxy);
+  }
+}
+
+int ncplane_set_cached_layer(ncplane* n, bool cached){
+  if(!cached){
+    if(n->layer){
+      rendervec_free(&n->layer->rvec);
+      free(n->layer);
+      n->layer = NULL;
+      ncplane_layer_invalidate(n); // we rejoin any enclosing layer
+    }
+    return 0;
+  }
+  if(n->layer){
+    return 0;
+  }
+  nclayer* l = malloc(sizeof(*l));
+  if(l == NULL){
+    return -1;
+  }
+  memset(l, 0, sizeof(*l));
+  ncplane_layer_invalidate(n); // we leave any enclosing layer
+  n->layer = l;
+  return 0;
+}
+
+int ncplane_cached_layer_stats(const ncplane* n, uint64_t* hits, uint64_t* misses){
+  if(n->layer == NULL){
+    return -1;
+  }
+  if(hits){
+    *hits = n->layer->hits;
+  }
+  if(misses){
+    *misses = n->layer->misses;
+  }
+  return 0;
+}
+
+// state shared by the row bands of a parallel render. each band paints the
+// same run of planes over its own rows of the crender vector.
+struct renderbands {
+  ncplane** planes;        // planes to paint, in z-order
+  unsigned first;          // first plane of the current run (topmost)
+  unsigned last;           // plane following the run (not painted)
+  const rendervec* rvec;
+  int leny, lenx, absy, absx;
+  unsigned bands;
+  int* bandy;              // band b covers rows [bandy[b], bandy[b + 1])
+  int64_t* bandns;         // accumulated paint time for each band
+};
+
+// job function for the workpool: paint one band of the current run of planes
+static void
+paint_band(void* vrb, unsigned band){
+  struct renderbands* rb = vrb;
+  struct timespec start, done;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(unsigned i = rb->first ; i < rb->last ; ++i){
+    paint_entry(rb->planes[i], rb->rvec, rb->leny, rb->lenx, rb->absy, rb->absx,
+                NULL, rb->bandy[band], rb->bandy[band + 1]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &done);
+  rb->bandns[band] += timespec_to_ns(&done) - timespec_to_ns(&start);
 }
 
+// fewer rows than this per band, and we'd spend more time synchronizing
+// threads than we'd save by painting in parallel.
+#define RENDER_MIN_BAND_ROWS 8
+
+// how many bands ought we split this render into? returns 1 for a serial
+// render. never more bands than we have threads to paint them.
+static unsigned
+render_band_count(const notcurses* nc, int leny){
+  if(nc->workpool == NULL){
+    return 1;
+  }
+  unsigned bands = nc->workpool->threads + 1;
+  if(bands > (unsigned)leny / RENDER_MIN_BAND_ROWS){
+    bands = leny / RENDER_MIN_BAND_ROWS;
+  }
+  return bands ? bands : 1;
+}
+
+// walk the 'count' planes from the top, painting runs of text planes
+// band-parallel. sprixel planes touch sprixel state shared across rows (and
+// the pile's sprixel list), so they're painted serially, in order, between
+// runs. the result is identical to that of a serial render.
+static void
+paint_banded(notcurses* nc, ncplane** planes, unsigned count, const rendervec* rvec,
+             int leny, int lenx, int absy, int absx, unsigned bands,
+             sprixel** sprixel_list){
+  int bandy[bands + 1];
+  int64_t bandns[bands];
+  for(unsigned b = 0 ; b < bands ; ++b){
+    bandy[b] = leny * b / bands;
+    bandns[b] = 0;
+  }
+  bandy[bands] = leny;
+  struct renderbands rb = {
+    .planes = planes,
+    .rvec = rvec,
+    .leny = leny,
+    .lenx = lenx,
+    .absy = absy,
+    .absx = absx,
+    .bands = bands,
+    .bandy = bandy,
+    .bandns = bandns,
+  };
+  unsigned i = 0;
+  while(i < count){
+    if(planes[i]->sprite){
+      paint(planes[i], rvec, leny, lenx, absy, absx, sprixel_list, 0, leny);
+      ++i;
+      continue;
+    }
+    rb.first = i;
+    while(i < count && !planes[i]->sprite){
+      ++i;
+    }
+    rb.last = i;
+    workpool_run(nc->workpool, bands, paint_band, &rb);
+  }
+  pthread_mutex_lock(&nc->statlock);
+  update_band_stats(&nc->stats, bands, bandns);
+  pthread_mutex_unlock(&nc->statlock);
+}
 
 // We execute the painter's algorithm, starting from our topmost plane. The
 // damagevector should be all zeros on input. On success, it will reflect
@@ -1276,14 +2301,35 @@ int notcurses_render_to_file(notcurses* nc, FILE* fp){
 // down the z-buffer, looking at intersections with ncplanes. This implies
 // locking down the EGC, the attributes, and the channels for each cell.
 static void
-ncpile_render_internal(ncplane* n, struct crender* rvec, int leny, int lenx,
+ncpile_render_internal(ncplane* n, const rendervec* rvec, int leny, int lenx,
                        int absy, int absx){
   ncpile* np = ncplane_pile(n);
-  ncplane* p = np->top;
+  notcurses* nc = ncplane_notcurses(n);
   sprixel* sprixel_list = NULL;
-  while(p){
-    paint(p, rvec, leny, lenx, absy, absx, &sprixel_list);
-    p = p->below;
+  // every sprixel plane must be painted, whether visible or not, to maintain
+  // the sprixel list. otherwise, we need only paint the planes intersecting
+  // the visible area, as found by the pile's index.
+  int count;
+  if(np->sprixelcache){
+    count = ncpile_index_all(np);
+  }else{
+    count = ncpile_index_query(np, absy, absx, leny, lenx);
+  }
+  if(count > 0){
+    count = ncpile_layer_hits(np, count, absy, absx, leny, lenx);
+  }
+  const unsigned bands = render_band_count(nc, leny);
+  if(count < 0){ // allocation failure; walk the z-axis serially
+    for(ncplane* p = np->top ; p ; p = p->below){
+      paint(p, rvec, leny, lenx, absy, absx, &sprixel_list, 0, leny);
+    }
+  }else if(bands > 1){
+    paint_banded(nc, np->index.hits, count, rvec, leny, lenx, absy, absx,
+                 bands, &sprixel_list);
+  }else{
+    for(int i = 0 ; i < count ; ++i){
+      paint_entry(np->index.hits[i], rvec, leny, lenx, absy, absx, &sprixel_list, 0, leny);
+    }
   }
   if(sprixel_list){
     if(np->sprixelcache){
@@ -1299,16 +2345,221 @@ ncpile_render_internal(ncplane* n, struct crender* rvec, int leny, int lenx,
   }
 }
 
+// a stylemask no cell can have, marking lastframe cells of unknown content
+#define STYLEMASK_UNKNOWN 0xffffu
+
+// when coalescing output, cut short any frame still being written at its next
+// row mark. the rows it failed to write no longer match lastframe, which must
+// be postpainted in its entirety. the terminal's cursor and style are likewise
+// no longer what we believe them to be.
+static int
+coalesce_output(notcurses* nc){
+  ncwritercut cut;
+  int ret = writer_coalesce(nc->writer, &cut);
+  if(cut.lostcount){
+    for(unsigned i = 0 ; i < cut.lostcount ; ++i){
+      const int y = cut.lost[i].y;
+      if(y < nc->lfdimy){
+        nccell* row = &nc->lastframe[y * nc->lfdimx];
+        for(int x = 0 ; x < nc->lfdimx ; ++x){
+          row[x].stylemask = STYLEMASK_UNKNOWN;
+        }
+      }
+    }
+    nc->lastpile = NULL;
+    nc->rstate.hardcursorpos = true;
+    nc->rstate.curattr = STYLEMASK_UNKNOWN;
+    nc->rstate.fgelidable = false;
+    nc->rstate.bgelidable = false;
+    nc->rstate.fgpalelidable = false;
+    nc->rstate.bgpalelidable = false;
+    nc->rstate.fgdefelidable = false;
+    nc->rstate.bgdefelidable = false;
+  }
+  if(cut.waitns || cut.lostcount){
+    pthread_mutex_lock(&nc->statlock);
+    if(cut.waitns){
+      ++nc->stats.writer_waits;
+      nc->stats.writer_wait_ns += cut.waitns;
+    }
+    if(cut.lostcount){
+      if(cut.dropped){
+        ++nc->stats.dropped_frames;
+      }else{
+        ++nc->stats.coalesced_frames;
+      }
+      nc->stats.dropped_bytes += cut.lostbytes;
+    }
+    pthread_mutex_unlock(&nc->statlock);
+  }
+  return ret;
+}
+
+// does row 'y' of the rendered frame match row 'lfy' of lastframe? highcontrast
+// has not yet been locked in, so such cells might not match; that only costs
+// us the acceleration.
+static bool
+rendered_row_matches(const notcurses* nc, const rendervec* rvec, int dimx,
+                     int y, int lfy){
+  const nccell* cells = &rvec->cells[y * dimx];
+  const struct crender* crender = &rvec->crender[y * dimx];
+  const nccell* last = &nc->lastframe[lfy * nc->lfdimx];
+  for(int x = 0 ; x < dimx ; ++x){
+    if(cells[x].stylemask != last[x].stylemask ||
+       cells[x].channels != last[x].channels){
+      return false;
+    }
+    if(cells[x].gcluster != last[x].gcluster || !cell_simple_p(&cells[x])){
+      if(cell_simple_p(&cells[x]) ? !cell_simple_p(&last[x]) : !crender[x].p){
+        return false;
+      }
+      if(strcmp(nccell_extended_gcluster(crender[x].p, &cells[x]),
+                pool_extended_gcluster(&nc->pool, &last[x]))){
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// scroll rows [top, bot] of lastframe up by 'count', as the terminal will.
+// the rows scrolled in are of unknown content, since the terminal fills them
+// with its current background.
+static void
+scroll_lastframe(notcurses* nc, int top, int bot, int count){
+  const int dimx = nc->lfdimx;
+  nccell* lf = nc->lastframe;
+  for(int i = top * dimx ; i < (top + count) * dimx ; ++i){
+    pool_release(&nc->pool, &lf[i]);
+  }
+  memmove(&lf[top * dimx], &lf[(top + count) * dimx],
+          sizeof(*lf) * dimx * (bot - top + 1 - count));
+  nccell* exposed = &lf[(bot + 1 - count) * dimx];
+  memset(exposed, 0, sizeof(*lf) * dimx * count);
+  for(int i = 0 ; i < dimx * count ; ++i){
+    exposed[i].stylemask = STYLEMASK_UNKNOWN;
+  }
+}
+
+// a plane which scrolled since 'pile' was last rasterized has moved its rows
+// up, and its region of the terminal can follow with a single scroll, rather
+// than rewriting every row. we only consider planes spanning the full width
+// of the terminal, and only scroll if doing so leaves more of the region
+// matching the new frame. returns true if lastframe was scrolled, in which
+// case the scroll is recorded in rstate for the rasterizer.
+static bool
+accelerate_scroll(notcurses* nc, ncpile* pile){
+  if(pile->sprixelcache || nc->margin_l || nc->margin_r){
+    return false;
+  }
+  const int dimx = pile->dimx;
+  if(dimx != nc->lfdimx){
+    return false;
+  }
+  const int absy = nc->stdplane->absy;
+  const int absx = nc->stdplane->absx;
+  const int dimy = pile->dimy < nc->lfdimy ? pile->dimy : nc->lfdimy;
+  for(const ncplane* p = pile->top ; p ; p = p->below){
+    const int count = p->scrolled;
+    if(count == 0 || p->absx > absx || p->absx + p->lenx < absx + dimx){
+      continue;
+    }
+    int top = p->absy - absy;
+    int bot = top + p->leny - 1;
+    if(top < 0){
+      top = 0;
+    }
+    if(bot >= dimy){
+      bot = dimy - 1;
+    }
+    if(bot - top + 1 <= count){
+      continue;
+    }
+    if(!scrollable_region(nc, top + nc->margin_t, bot + nc->margin_t)){
+      return false;
+    }
+    int shifted = 0;
+    int unshifted = 0;
+    for(int y = top ; y <= bot ; ++y){
+      if(y + count <= bot && rendered_row_matches(nc, &pile->rvec, dimx, y, y + count)){
+        ++shifted;
+      }
+      if(rendered_row_matches(nc, &pile->rvec, dimx, y, y)){
+        ++unshifted;
+      }
+    }
+    if(shifted <= unshifted){
+      continue;
+    }
+    scroll_lastframe(nc, top, bot, count);
+    // every row of the region must be postpainted against its new lastframe
+    memset(pile->rowflags + top, ROW_UNPOSTED, bot - top + 1);
+    nc->rstate.scrolltop = top;
+    nc->rstate.scrollbot = bot;
+    nc->rstate.scrollrows = count;
+    pthread_mutex_lock(&nc->statlock);
+    ++nc->stats.scrolls_accelerated;
+    pthread_mutex_unlock(&nc->statlock);
+    return true;
+  }
+  return false;
+}
+
+// bring lastframe up to date with the rendered pile, computing its damage.
+// returns true if nothing can have changed since 'pile' was last rasterized.
+static bool
+postpaint_pile(notcurses* nc, ncpile* pile){
+  const int miny = pile->dimy < nc->lfdimy ? pile->dimy : nc->lfdimy;
+  const int minx = pile->dimx < nc->lfdimx ? pile->dimx : nc->lfdimx;
+  if(nc->lastpile == pile){
+    accelerate_scroll(nc, pile);
+  }
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    p->scrolled = 0;
+  }
+  // if lastframe reflects our last rasterization, only repainted rows can
+  // differ from it. otherwise, check everything.
+  bool unchanged = (nc->lastpile == pile);
+  if(unchanged){
+    unchanged = !memchr(pile->rowflags, ROW_UNPOSTED, pile->dimy);
+    postpaint(nc->lastframe, miny, minx, &pile->rvec, &nc->pool,
+              pile->rowflags, pile->damage, nc->damagescan);
+  }else{
+    postpaint(nc->lastframe, miny, minx, &pile->rvec, &nc->pool,
+              NULL, pile->damage, nc->damagescan);
+  }
+  // rows beyond lastframe can't be rasterized
+  for(int y = miny ; y < pile->dimy ; ++y){
+    pile->damage[y].minx = INT_MAX;
+    pile->damage[y].maxx = -1;
+  }
+  memset(pile->rowflags, 0, pile->dimy);
+  nc->lastpile = pile;
+  return unchanged;
+}
+
 int ncpile_rasterize(ncplane* n){
   struct timespec start, rasterdone, writedone;
   clock_gettime(CLOCK_MONOTONIC, &start);
   ncpile* pile = ncplane_pile(n);
   struct notcurses* nc = ncplane_notcurses(n);
-  const int miny = pile->dimy < nc->lfdimy ? pile->dimy : nc->lfdimy;
-  const int minx = pile->dimx < nc->lfdimx ? pile->dimx : nc->lfdimx;
-  postpaint(nc->lastframe, miny, minx, pile->crender, &nc->pool);
+  // this must precede postpaint(), which ought see what's really onscreen. a
+  // write failure is reported, but doesn't prevent this frame's rasterization.
+  const int coalesced = coalesce_output(nc);
+  // lastframe follows the geometry against which the pile was rendered
+  if(resize_lastframe(nc, pile->dimy, pile->dimx)){
+    return -1;
+  }
+  nc->tcache.cellpixy = pile->cellpixy;
+  nc->tcache.cellpixx = pile->cellpixx;
+  const bool unchanged = postpaint_pile(nc, pile);
   clock_gettime(CLOCK_MONOTONIC, &rasterdone);
-  int bytes = notcurses_rasterize(nc, pile, nc->rstate.mstreamfp);
+  int bytes = 0;
+  // nothing has changed since we were last rasterized. so long as we have no
+  // sprixels or palette updates to emit, there's nothing to write.
+  if(!unchanged || pile->sprixelcache || palette_damaged_p(nc)){
+    bytes = notcurses_rasterize(nc, pile, &nc->rstate.f);
+  }
   // accepts -1 as an indication of failure
   clock_gettime(CLOCK_MONOTONIC, &writedone);
   pthread_mutex_lock(&nc->statlock);
@@ -1316,14 +2567,16 @@ int ncpile_rasterize(ncplane* n){
   update_raster_stats(&rasterdone, &start, &nc->stats);
   update_write_stats(&writedone, &rasterdone, &nc->stats, bytes);
   pthread_mutex_unlock(&nc->statlock);
-  if(bytes < 0){
+  if(bytes < 0 || coalesced){
     return -1;
   }
   return 0;
 }
 
-// ensure the crender vector of 'n' is properly sized for 'n'->dimy x 'n'->dimx,
-// and initialize the rvec afresh for a new render.
+// ensure the render vector of 'n' is properly sized for 'n'->dimy x 'n'->dimx,
+// and the row flags for 'n'->dimy. the geometry can only have changed if
+// we're about to repaint everything. the rvec is not initialized; rows which
+// aren't repainted keep their crenders from the previous render.
 static int
 engorge_crender_vector(ncpile* n){
   if(n->dimy <= 0 || n->dimx <= 0){
@@ -1332,31 +2585,160 @@ engorge_crender_vector(ncpile* n){
   const size_t crenderlen = n->dimy * n->dimx; // desired size
 //fprintf(stderr, "crlen: %d y: %d x:%d\n", crenderlen, dimy, dimx);
   if(crenderlen != n->crenderlen){
-    struct crender* tmp = realloc(n->crender, sizeof(*tmp) * crenderlen);
-    if(tmp == NULL){
+    if(rendervec_realloc(&n->rvec, crenderlen)){
       return -1;
     }
-    n->crender = tmp;
     n->crenderlen = crenderlen;
   }
-  init_rvec(n->crender, crenderlen);
+  if(n->repaint){
+    unsigned char* tmp = realloc(n->rowflags, n->dimy);
+    if(tmp == NULL){
+      return -1;
+    }
+    n->rowflags = tmp;
+    damagespan* dtmp = realloc(n->damage, sizeof(*dtmp) * n->dimy);
+    if(dtmp == NULL){
+      return -1;
+    }
+    n->damage = dtmp;
+  }
   return 0;
 }
 
+// mark pile rows [y, y + rows) dirty, clipping to the pile.
+static inline void
+ncpile_dirty_rows(ncpile* pile, int y, int rows){
+  if(y < 0){
+    rows += y;
+    y = 0;
+  }
+  if(y + rows > pile->dimy){
+    rows = pile->dimy - y;
+  }
+  for(int r = 0 ; r < rows ; ++r){
+    pile->rowflags[y + r] |= ROW_DIRTY;
+  }
+}
+
+// walk the pile's planes, marking those rows of the pile which must be
+// repainted due to changes since the last render, and resetting each plane's
+// dirt. a plane which has moved or changed size dirties both the rows it
+// used to cover, and those it now covers. 'absy' is the absolute row of the
+// pile's origin. if 'all' is set, the whole pile is being repainted anyway,
+// and we only reset the dirt. returns true if any rows need be repainted.
+static bool
+ncpile_collect_dirt(ncpile* pile, int absy, bool all){
+  bool dirty = false;
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    if(p->absy != p->rendabsy || p->absx != p->rendabsx ||
+       p->leny != p->rendleny || p->lenx != p->rendlenx ||
+       p->dirtymin <= p->dirtymax){
+      ncplane_layer_invalidate(p);
+    }
+    if(!all){
+      if(p->absy != p->rendabsy || p->absx != p->rendabsx ||
+         p->leny != p->rendleny || p->lenx != p->rendlenx){
+        ncpile_dirty_rows(pile, p->rendabsy - absy, p->rendleny);
+        ncpile_dirty_rows(pile, p->absy - absy, p->leny);
+        dirty = true;
+      }else if(p->dirtymin <= p->dirtymax){
+        ncpile_dirty_rows(pile, p->absy + p->dirtymin - absy,
+                          p->dirtymax - p->dirtymin + 1);
+        dirty = true;
+      }
+    }
+    p->dirtymin = INT_MAX;
+    p->dirtymax = INT_MIN;
+    p->rendabsy = p->absy;
+    p->rendabsx = p->absx;
+    p->rendleny = p->leny;
+    p->rendlenx = p->lenx;
+  }
+  if(pile->orphanmin <= pile->orphanmax){
+    if(!all){
+      ncpile_dirty_rows(pile, pile->orphanmin - absy,
+                        pile->orphanmax - pile->orphanmin + 1);
+      dirty = true;
+    }
+    pile->orphanmin = INT_MAX;
+    pile->orphanmax = INT_MIN;
+  }
+  return dirty;
+}
+
+// repaint only those rows marked ROW_DIRTY, reusing the previous render's
+// crenders for all others. contiguous dirty rows are painted together. only
+// used for piles without sprixels.
+static void
+paint_dirty_rows(ncpile* pile, int absy, int absx){
+  unsigned char* rowflags = pile->rowflags;
+  int y = 0;
+  while(y < pile->dimy){
+    if(!(rowflags[y] & ROW_DIRTY)){
+      ++y;
+      continue;
+    }
+    int endy = y;
+    while(endy < pile->dimy && (rowflags[endy] & ROW_DIRTY)){
+      rowflags[endy] = ROW_UNPOSTED;
+      ++endy;
+    }
+    init_rvec(&pile->rvec, y * pile->dimx, (endy - y) * pile->dimx);
+    int count = ncpile_index_query(pile, absy + y, absx, endy - y, pile->dimx);
+    if(count > 0){
+      count = ncpile_layer_hits(pile, count, absy, absx, pile->dimy, pile->dimx);
+    }
+    if(count < 0){ // allocation failure; walk the z-axis
+      for(ncplane* p = pile->top ; p ; p = p->below){
+        paint(p, &pile->rvec, pile->dimy, pile->dimx, absy, absx, NULL, y, endy);
+      }
+    }else{
+      for(int i = 0 ; i < count ; ++i){
+        paint_entry(pile->index.hits[i], &pile->rvec, pile->dimy, pile->dimx,
+                    absy, absx, NULL, y, endy);
+      }
+    }
+    y = endy;
+  }
+}
+
 int ncpile_render(ncplane* n){
   struct timespec start, renderdone;
   clock_gettime(CLOCK_MONOTONIC, &start);
   notcurses* nc = ncplane_notcurses(n);
   ncpile* pile = ncplane_pile(n);
-  // update our notion of screen geometry, and render against that
-  notcurses_resize_internal(n, NULL, NULL);
+  // update our notion of screen geometry, and render against that. we touch
+  // nothing shared other than the stats (and then only under statlock), so
+  // distinct piles can be rendered concurrently. lastframe catches up with
+  // the new geometry once the pile is rasterized.
+  int rows, cols;
+  if(term_geometry(nc->ttyfd, &rows, &cols, &pile->cellpixy, &pile->cellpixx) == 0){
+    usable_geometry(nc, &rows, &cols);
+    ncpile_resize(pile, rows, cols);
+  }
   if(engorge_crender_vector(pile)){
     return -1;
   }
-  // FIXME notcurses_stdplane() doesn't belong here
-  ncpile_render_internal(n, pile->crender, pile->dimy, pile->dimx,
-                         notcurses_stdplane(nc)->absy,
-                         notcurses_stdplane(nc)->absx);
+  // the standard plane is fixed at the origin of our margins
+  const int absy = nc->margin_t;
+  const int absx = nc->margin_l;
+  // shed dead egcpool space before collecting dirt, since compaction marks
+  // its plane dirty.
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    ncplane_compact_sparse(p);
+  }
+  // sprixel state spans rows (and frames), so piles with sprixels are always
+  // repainted in their entirety. otherwise, repaint only what's changed (if
+  // nothing's changed, there's nothing to do).
+  if(pile->repaint || pile->sprixelcache){
+    ncpile_collect_dirt(pile, absy, true);
+    init_rvec(&pile->rvec, 0, pile->crenderlen);
+    ncpile_render_internal(n, &pile->rvec, pile->dimy, pile->dimx, absy, absx);
+    memset(pile->rowflags, ROW_UNPOSTED, pile->dimy);
+    pile->repaint = false;
+  }else if(ncpile_collect_dirt(pile, absy, false)){
+    paint_dirty_rows(pile, absy, absx);
+  }
   clock_gettime(CLOCK_MONOTONIC, &renderdone);
   pthread_mutex_lock(&nc->statlock);
   update_render_stats(&renderdone, &start, &nc->stats);
@@ -1376,26 +2758,62 @@ int notcurses_render(notcurses* nc){
   return i;
 }
 
-// for now, we just run the top half of notcurses_render(), and copy out the
-// memstream from within rstate. we want to allocate our own here, and return
-// it, to avoid the copy, but we need feed the params through to do so FIXME.
+int notcurses_render_request(notcurses* nc){
+  pthread_mutex_lock(&nc->statlock);
+  ++nc->stats.frames_requested;
+  pthread_mutex_unlock(&nc->statlock);
+  if(nc->scheduler){
+    return scheduler_request(nc->scheduler);
+  }
+  int ret = notcurses_render(nc);
+  pthread_mutex_lock(&nc->statlock);
+  ++nc->stats.frames_delivered;
+  pthread_mutex_unlock(&nc->statlock);
+  return ret;
+}
+
+int notcurses_render_drain(notcurses* nc){
+  return scheduler_drain(nc->scheduler, true);
+}
+
+int notcurses_set_target_fps(notcurses* nc, unsigned fps){
+  // any frame pending at the old rate is rendered now
+  int ret = scheduler_destroy(nc->scheduler);
+  nc->scheduler = NULL;
+  if(fps && (nc->scheduler = scheduler_create(nc, fps)) == NULL){
+    return -1;
+  }
+  return ret;
+}
+
+// run the top half of notcurses_render(), and hand the rasterized buffer over
+// to the caller. rstate gets a fresh buffer on the next rasterization.
 int notcurses_render_to_buffer(notcurses* nc, char** buf, size_t* buflen){
   ncplane* stdn = notcurses_stdplane(nc);
   if(ncpile_render(stdn)){
     return -1;
   }
-  int bytes = notcurses_rasterize_inner(nc, ncplane_pile(stdn), nc->rstate.mstreamfp);
+  ncpile* pile = ncplane_pile(stdn);
+  if(resize_lastframe(nc, pile->dimy, pile->dimx)){
+    return -1;
+  }
+  postpaint_pile(nc, pile);
+  int bytes = notcurses_rasterize_inner(nc, pile, &nc->rstate.f, pile->damage);
   pthread_mutex_lock(&nc->statlock);
   update_render_bytes(&nc->stats, bytes);
   pthread_mutex_unlock(&nc->statlock);
   if(bytes < 0){
     return -1;
   }
-  *buf = memdup(nc->rstate.mstreamfp, nc->rstate.mstrsize);
-  if(buf == NULL){
+  // NUL-terminate the buffer (as open_memstream() did), without counting the
+  // NUL in its length
+  if(fbuf_reserve(&nc->rstate.f, 1)){
     return -1;
   }
-  *buflen = nc->rstate.mstrsize;
+  nc->rstate.f.buf[nc->rstate.f.used] = '\0';
+  *buf = nc->rstate.f.buf;
+  *buflen = nc->rstate.f.used;
+  memset(&nc->rstate.f, 0, sizeof(nc->rstate.f));
   return 0;
 }
 
@@ -1437,9 +2855,13 @@ int ncdirect_set_bg_rgb(ncdirect* nc, unsigned rgb){
   if(!ncdirect_bg_default_p(nc) && ncchannels_bg_rgb(nc->channels) == rgb){
     return 0;
   }
-  if(term_bg_rgb8(nc->tcache.RGBflag, nc->tcache.setab, nc->tcache.colors, nc->ttyfp,
-                  (rgb & 0xff0000u) >> 16u, (rgb & 0xff00u) >> 8u, rgb & 0xffu,
-                  nc->tcache.bg_collides_default)){
+  fbuf f = {};
+  if(term_bg_rgb8(&nc->tcache, &f, (rgb & 0xff0000u) >> 16u,
+                  (rgb & 0xff00u) >> 8u, rgb & 0xffu)){
+    fbuf_free(&f);
+    return -1;
+  }
+  if(fbuf_finalize(&f, nc->ttyfp)){
     return -1;
   }
   ncchannels_set_bg_rgb(&nc->channels, rgb);
@@ -1454,8 +2876,13 @@ int ncdirect_set_fg_rgb(ncdirect* nc, unsigned rgb){
   if(!ncdirect_fg_default_p(nc) && ncchannels_fg_rgb(nc->channels) == rgb){
     return 0;
   }
-  if(term_fg_rgb8(nc->tcache.RGBflag, nc->tcache.setaf, nc->tcache.colors, nc->ttyfp,
+  fbuf f = {};
+  if(term_fg_rgb8(&nc->tcache, &f,
                   (rgb & 0xff0000u) >> 16u, (rgb & 0xff00u) >> 8u, rgb & 0xffu)){
+    fbuf_free(&f);
+    return -1;
+  }
+  if(fbuf_finalize(&f, nc->ttyfp)){
     return -1;
   }
   ncchannels_set_fg_rgb(&nc->channels, rgb);
@@ -1479,7 +2906,15 @@ int notcurses_cursor_enable(notcurses* nc, int y, int x){
   if(nc->ttyfd < 0 || !nc->tcache.cnorm){
     return -1;
   }
-  if(goto_location(nc, nc->ttyfp, y + nc->stdplane->absy, x + nc->stdplane->absx)){
+  if(writer_drain(nc->writer)){
+    return -1;
+  }
+  fbuf f = {};
+  if(goto_location(nc, &f, y + nc->stdplane->absy, x + nc->stdplane->absx, NULL)){
+    fbuf_free(&f);
+    return -1;
+  }
+  if(fbuf_finalize(&f, nc->ttyfp)){
     return -1;
   }
   // if we were already positive, we're already visible, no need to write cnorm
@@ -1502,7 +2937,7 @@ int notcurses_cursor_disable(notcurses* nc){
     return -1;
   }
   if(nc->ttyfd >= 0){
-    if(nc->tcache.civis){
+    if(nc->tcache.civis && !writer_drain(nc->writer)){
       if(!tty_emit(nc->tcache.civis, nc->ttyfd) && !fflush(nc->ttyfp)){
         nc->cursory = -1;
         nc->cursorx = -1;
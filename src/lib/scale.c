@@ -0,0 +1,558 @@
+#include "internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLE_X86
+#include <immintrin.h>
+#endif
+
+// our own RGBA resampler, for use whenever the multimedia backend can't scale
+// (or there is no backend). each output axis is mapped onto its source axis
+// once per resampling, and rows are then built from that mapping by kernels
+// working along a row. all channels, alpha included, are filtered alike.
+//
+// nearest: each output pixel takes the source pixel beneath its center.
+// bilinear: each output pixel is interpolated from the four source pixels
+//  surrounding its center, with weights of 1/256. each needed source row is
+//  interpolated horizontally into 16-bit channels (holding 7 fractional bits)
+//  once, and output rows are interpolated vertically between two such rows.
+// box: each output pixel is the average of the source area it covers,
+//  weighting partially-covered source pixels by their coverage. the taps of
+//  each output are normalized to sum to 1 << 15 along each axis, so no
+//  division is needed. source rows are accumulated into 32-bit channel sums,
+//  which are then summed horizontally (after dropping 8 of their fractional
+//  bits, so that these sums too fit in 32 bits).
+//
+// every kernel produces results identical to the scalar kernels.
+
+// box taps' weights sum to 1 << BOXSHIFT along each axis
+#define BOXSHIFT 15
+#define BOXSUMSHIFT (BOXSHIFT * 2 - 8)
+
+// the mapping of an output axis onto its source axis
+typedef struct resampleaxis {
+  int32_t* idx;      // source index of each output (box: of its first tap)
+  uint16_t* frac;    // bilinear: weight of idx + 1, out of 256
+  int32_t* taps;     // box: output i's taps are [taps[i], taps[i + 1])
+  uint16_t* weights; // box: normalized coverage of each tap
+} resampleaxis;
+
+static void
+resample_gather_scalar(const uint32_t* src, const int32_t* idx, uint32_t* dst, int n){
+  for(int i = 0 ; i < n ; ++i){
+    dst[i] = src[idx[i]];
+  }
+}
+
+static void
+resample_hlerp_scalar(const uint32_t* src, const int32_t* idx, const uint16_t* frac,
+                      uint16_t* dst, int n){
+  for(int i = 0 ; i < n ; ++i){
+    const unsigned char* p = (const unsigned char*)(src + idx[i]);
+    const unsigned w = frac[i];
+    for(int c = 0 ; c < 4 ; ++c){
+      dst[i * 4 + c] = (p[c] * (256 - w) + p[4 + c] * w) >> 1;
+    }
+  }
+}
+
+static void
+resample_vlerp_scalar(const uint16_t* top, const uint16_t* bot, unsigned w,
+                      uint32_t* dst, int n){
+  unsigned char* d = (unsigned char*)dst;
+  for(int i = 0 ; i < n * 4 ; ++i){
+    d[i] = (top[i] * (256 - w) + bot[i] * w + (1u << 14)) >> 15;
+  }
+}
+
+static void
+resample_boxacc_scalar(const uint32_t* src, unsigned w, uint32_t* acc, int n){
+  const unsigned char* s = (const unsigned char*)src;
+  for(int i = 0 ; i < n * 4 ; ++i){
+    acc[i] += s[i] * w;
+  }
+}
+
+static void
+resample_boxsum_scalar(const uint32_t* acc, const int32_t* idx, const int32_t* taps,
+                       const uint16_t* weights, uint32_t* dst, int n){
+  unsigned char* d = (unsigned char*)dst;
+  for(int i = 0 ; i < n ; ++i){
+    uint32_t sums[4] = { 0, 0, 0, 0, };
+    const uint32_t* a = acc + 4 * idx[i];
+    for(int t = taps[i] ; t < taps[i + 1] ; ++t, a += 4){
+      for(int c = 0 ; c < 4 ; ++c){
+        sums[c] += (a[c] >> 8) * weights[t];
+      }
+    }
+    for(int c = 0 ; c < 4 ; ++c){
+      d[i * 4 + c] = (sums[c] + (1u << (BOXSUMSHIFT - 1))) >> BOXSUMSHIFT;
+    }
+  }
+}
+
+#ifdef RESAMPLE_X86
+// SSE4.1 lacks a gather, and so uses resample_gather_scalar().
+
+// each bilinear tap is a pair of adjacent source pixels, loaded together and
+// widened to 16 bits. their weighted channels are summed by folding the upper
+// pixel onto the lower.
+__attribute__((target("sse4.1"))) static inline __m128i
+hlerp_pixel_sse41(const uint32_t* src, int32_t idx, unsigned w){
+  __m128i p = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(src + idx)));
+  const short iw = 256 - w;
+  const short fw = w;
+  p = _mm_mullo_epi16(p, _mm_setr_epi16(iw, iw, iw, iw, fw, fw, fw, fw));
+  return _mm_add_epi16(p, _mm_srli_si128(p, 8));
+}
+
+__attribute__((target("sse4.1"))) static void
+resample_hlerp_sse41(const uint32_t* src, const int32_t* idx, const uint16_t* frac,
+                     uint16_t* dst, int n){
+  int i;
+  for(i = 0 ; i + 2 <= n ; i += 2){
+    __m128i a = hlerp_pixel_sse41(src, idx[i], frac[i]);
+    __m128i b = hlerp_pixel_sse41(src, idx[i + 1], frac[i + 1]);
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_srli_epi16(_mm_unpacklo_epi64(a, b), 1));
+  }
+  resample_hlerp_scalar(src, idx + i, frac + i, dst + i * 4, n - i);
+}
+
+// the vertical interpolation interleaves the two rows' channels, so that
+// pmaddwd yields top * (256 - w) + bot * w in 32 bits.
+__attribute__((target("sse4.1"))) static void
+resample_vlerp_sse41(const uint16_t* top, const uint16_t* bot, unsigned w,
+                     uint32_t* dst, int n){
+  const __m128i wv = _mm_set1_epi32((w << 16) | (256 - w));
+  const __m128i round = _mm_set1_epi32(1u << 14);
+  int i;
+  for(i = 0 ; i + 2 <= n ; i += 2){
+    __m128i t = _mm_loadu_si128((const __m128i*)(top + i * 4));
+    __m128i b = _mm_loadu_si128((const __m128i*)(bot + i * 4));
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(t, b), wv);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(t, b), wv);
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 15);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 15);
+    __m128i px = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(px, px));
+  }
+  resample_vlerp_scalar(top + i * 4, bot + i * 4, w, dst + i, n - i);
+}
+
+__attribute__((target("sse4.1"))) static void
+resample_boxacc_sse41(const uint32_t* src, unsigned w, uint32_t* acc, int n){
+  const __m128i wv = _mm_set1_epi32(w);
+  int i;
+  for(i = 0 ; i + 4 <= n ; i += 4){
+    __m128i px = _mm_loadu_si128((const __m128i*)(src + i));
+    for(int j = 0 ; j < 4 ; ++j){
+      __m128i p = _mm_cvtepu8_epi32(px);
+      __m128i a = _mm_loadu_si128((const __m128i*)(acc + (i + j) * 4));
+      a = _mm_add_epi32(a, _mm_mullo_epi32(p, wv));
+      _mm_storeu_si128((__m128i*)(acc + (i + j) * 4), a);
+      px = _mm_srli_si128(px, 4);
+    }
+  }
+  resample_boxacc_scalar(src + i, w, acc + i * 4, n - i);
+}
+
+// one output pixel's channels per vector. AVX2 uses this, too, as outputs'
+// tap counts vary.
+__attribute__((target("sse4.1"))) static void
+resample_boxsum_sse41(const uint32_t* acc, const int32_t* idx, const int32_t* taps,
+                      const uint16_t* weights, uint32_t* dst, int n){
+  const __m128i round = _mm_set1_epi32(1u << (BOXSUMSHIFT - 1));
+  for(int i = 0 ; i < n ; ++i){
+    __m128i sums = _mm_setzero_si128();
+    const uint32_t* a = acc + 4 * idx[i];
+    for(int t = taps[i] ; t < taps[i + 1] ; ++t, a += 4){
+      __m128i px = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)a), 8);
+      sums = _mm_add_epi32(sums, _mm_mullo_epi32(px, _mm_set1_epi32(weights[t])));
+    }
+    sums = _mm_srli_epi32(_mm_add_epi32(sums, round), BOXSUMSHIFT);
+    sums = _mm_packus_epi32(sums, sums);
+    dst[i] = _mm_cvtsi128_si32(_mm_packus_epi16(sums, sums));
+  }
+}
+
+__attribute__((target("avx2"))) static void
+resample_gather_avx2(const uint32_t* src, const int32_t* idx, uint32_t* dst, int n){
+  int i;
+  for(i = 0 ; i + 8 <= n ; i += 8){
+    __m256i ix = _mm256_loadu_si256((const __m256i*)(idx + i));
+    __m256i px = _mm256_i32gather_epi32((const int*)src, ix, 4);
+    _mm256_storeu_si256((__m256i*)(dst + i), px);
+  }
+  resample_gather_scalar(src, idx + i, dst + i, n - i);
+}
+
+// as hlerp_pixel_sse41(), for two outputs, one in each lane
+__attribute__((target("avx2"))) static inline __m256i
+hlerp_pair_avx2(const uint32_t* src, const int32_t* idx, const uint16_t* frac){
+  __m128i pairs = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(src + idx[0])),
+                                     _mm_loadl_epi64((const __m128i*)(src + idx[1])));
+  __m256i p = _mm256_cvtepu8_epi16(pairs);
+  const short iw0 = 256 - frac[0], fw0 = frac[0];
+  const short iw1 = 256 - frac[1], fw1 = frac[1];
+  p = _mm256_mullo_epi16(p, _mm256_setr_epi16(iw0, iw0, iw0, iw0, fw0, fw0, fw0, fw0,
+                                              iw1, iw1, iw1, iw1, fw1, fw1, fw1, fw1));
+  return _mm256_add_epi16(p, _mm256_srli_si256(p, 8));
+}
+
+__attribute__((target("avx2"))) static void
+resample_hlerp_avx2(const uint32_t* src, const int32_t* idx, const uint16_t* frac,
+                    uint16_t* dst, int n){
+  int i;
+  for(i = 0 ; i + 4 <= n ; i += 4){
+    __m256i a = hlerp_pair_avx2(src, idx + i, frac + i);
+    __m256i b = hlerp_pair_avx2(src, idx + i + 2, frac + i + 2);
+    // each lane's result is in its low quadword; gather them in order
+    __m256i r = _mm256_unpacklo_epi64(a, b); // i, i + 2 | i + 1, i + 3
+    r = _mm256_permute4x64_epi64(r, 0xd8);   // i, i + 1, i + 2, i + 3
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_srli_epi16(r, 1));
+  }
+  resample_hlerp_scalar(src, idx + i, frac + i, dst + i * 4, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+resample_vlerp_avx2(const uint16_t* top, const uint16_t* bot, unsigned w,
+                    uint32_t* dst, int n){
+  const __m256i wv = _mm256_set1_epi32((w << 16) | (256 - w));
+  const __m256i round = _mm256_set1_epi32(1u << 14);
+  int i;
+  for(i = 0 ; i + 4 <= n ; i += 4){
+    __m256i t = _mm256_loadu_si256((const __m256i*)(top + i * 4));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(bot + i * 4));
+    __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(t, b), wv);
+    __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(t, b), wv);
+    lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), 15);
+    hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), 15);
+    // per lane, the packs restore channel order; then join the lanes
+    __m256i px = _mm256_packs_epi32(lo, hi);
+    px = _mm256_packus_epi16(px, px);
+    px = _mm256_permute4x64_epi64(px, 0x08);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(px));
+  }
+  resample_vlerp_scalar(top + i * 4, bot + i * 4, w, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+resample_boxacc_avx2(const uint32_t* src, unsigned w, uint32_t* acc, int n){
+  const __m256i wv = _mm256_set1_epi32(w);
+  int i;
+  for(i = 0 ; i + 2 <= n ; i += 2){
+    __m256i p = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+    __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i * 4));
+    a = _mm256_add_epi32(a, _mm256_mullo_epi32(p, wv));
+    _mm256_storeu_si256((__m256i*)(acc + i * 4), a);
+  }
+  resample_boxacc_scalar(src + i, w, acc + i * 4, n - i);
+}
+#endif
+
+static const resampler resampler_scalar = {
+  .gather = resample_gather_scalar,
+  .hlerp = resample_hlerp_scalar,
+  .vlerp = resample_vlerp_scalar,
+  .boxacc = resample_boxacc_scalar,
+  .boxsum = resample_boxsum_scalar,
+};
+
+#ifdef RESAMPLE_X86
+static const resampler resampler_sse41 = {
+  .gather = resample_gather_scalar,
+  .hlerp = resample_hlerp_sse41,
+  .vlerp = resample_vlerp_sse41,
+  .boxacc = resample_boxacc_sse41,
+  .boxsum = resample_boxsum_sse41,
+};
+
+static const resampler resampler_avx2 = {
+  .gather = resample_gather_avx2,
+  .hlerp = resample_hlerp_avx2,
+  .vlerp = resample_vlerp_avx2,
+  .boxacc = resample_boxacc_avx2,
+  .boxsum = resample_boxsum_sse41,
+};
+#endif
+
+const resampler* resampler_kernels(resampleisa_e isa){
+  switch(isa){
+    case RESAMPLEISA_SCALAR:
+      return &resampler_scalar;
+#ifdef RESAMPLE_X86
+    case RESAMPLEISA_SSE41:
+      if(__builtin_cpu_supports("sse4.1")){
+        return &resampler_sse41;
+      }
+      break;
+    case RESAMPLEISA_AVX2:
+      if(__builtin_cpu_supports("avx2")){
+        return &resampler_avx2;
+      }
+      break;
+#else
+    default:
+      break;
+#endif
+  }
+  return NULL;
+}
+
+static const resampler*
+resampler_best(void){
+  const resampler* ret;
+  if( (ret = resampler_kernels(RESAMPLEISA_AVX2)) ){
+    return ret;
+  }
+  if( (ret = resampler_kernels(RESAMPLEISA_SSE41)) ){
+    return ret;
+  }
+  return resampler_kernels(RESAMPLEISA_SCALAR);
+}
+
+resample_e resample_default(int srcy, int srcx, int dsty, int dstx){
+  if(dsty <= srcy && dstx <= srcx){
+    return RESAMPLE_BOX;
+  }
+  return RESAMPLE_BILINEAR;
+}
+
+// map each of 'dst' outputs to the source pixel beneath its center
+static void
+axis_nearest(int32_t* idx, int src, int dst){
+  for(int i = 0 ; i < dst ; ++i){
+    int32_t s = ((int64_t)(2 * i + 1) * src) / (2 * dst);
+    idx[i] = s < src ? s : src - 1;
+  }
+}
+
+// map each of 'dst' outputs to the pair of source pixels about its center.
+// 'src' must be at least 2, so that both pixels of each pair exist.
+static void
+axis_bilinear(int32_t* idx, uint16_t* frac, int src, int dst){
+  for(int i = 0 ; i < dst ; ++i){
+    int64_t pos = ((int64_t)(2 * i + 1) * src * 256) / (2 * dst) - 128;
+    if(pos < 0){
+      pos = 0;
+    }
+    idx[i] = pos >> 8;
+    frac[i] = pos & 0xff;
+    if(idx[i] >= src - 1){
+      idx[i] = src - 2;
+      frac[i] = 256;
+    }
+  }
+}
+
+// count the box taps of each of 'dst' outputs, recording them if 'weights'
+// is not NULL. returns the total number of taps. coverage is determined in
+// 256ths of a source pixel, and normalized to sum to 1 << BOXSHIFT (any
+// remainder going to the output's heaviest tap).
+static int
+axis_box(int32_t* idx, int32_t* taps, uint16_t* weights, int src, int dst){
+  int t = 0;
+  for(int i = 0 ; i < dst ; ++i){
+    const int64_t start = ((int64_t)i * src * 256) / dst;
+    int64_t end = ((int64_t)(i + 1) * src * 256) / dst;
+    if(end <= start){
+      end = start + 1;
+    }
+    const int k0 = start >> 8;
+    int k1 = (end + 255) >> 8;
+    if(k1 > src){
+      k1 = src;
+    }
+    if(weights){
+      idx[i] = k0;
+      taps[i] = t;
+      unsigned total = 0;
+      int heaviest = t;
+      for(int k = k0 ; k < k1 ; ++k){
+        const int64_t lo = start > k * 256 ? start : k * 256;
+        const int64_t hi = end < (k + 1) * 256 ? end : (k + 1) * 256;
+        weights[t + k - k0] = ((hi - lo) << BOXSHIFT) / (end - start);
+        total += weights[t + k - k0];
+        if(weights[t + k - k0] > weights[heaviest]){
+          heaviest = t + k - k0;
+        }
+      }
+      weights[heaviest] += (1u << BOXSHIFT) - total;
+    }
+    t += k1 - k0;
+  }
+  if(weights){
+    taps[dst] = t;
+  }
+  return t;
+}
+
+static inline const uint32_t*
+src_row(const uint32_t* src, int srcstride, int y){
+  return (const uint32_t*)((const char*)src + (size_t)srcstride * y);
+}
+
+static inline uint32_t*
+dst_row(uint32_t* dst, int dststride, int y){
+  return (uint32_t*)((char*)dst + (size_t)dststride * y);
+}
+
+static int
+resample_nearest(const resampler* rs, const uint32_t* src, int srcy, int srcx,
+                 int srcstride, uint32_t* dst, int dsty, int dstx, int dststride){
+  int32_t* xidx = malloc(sizeof(*xidx) * dstx);
+  if(xidx == NULL){
+    return -1;
+  }
+  axis_nearest(xidx, srcx, dstx);
+  int prevsy = -1;
+  for(int y = 0 ; y < dsty ; ++y){
+    const int sy = ((int64_t)(2 * y + 1) * srcy) / (2 * dsty);
+    uint32_t* drow = dst_row(dst, dststride, y);
+    if(sy == prevsy){ // magnifying; repeat the previous row
+      memcpy(drow, dst_row(dst, dststride, y - 1), sizeof(*drow) * dstx);
+    }else{
+      rs->gather(src_row(src, srcstride, sy < srcy ? sy : srcy - 1), xidx, drow, dstx);
+    }
+    prevsy = sy;
+  }
+  free(xidx);
+  return 0;
+}
+
+static int
+resample_bilinear(const resampler* rs, const uint32_t* src, int srcy, int srcx,
+                  int srcstride, uint32_t* dst, int dsty, int dstx, int dststride){
+  resampleaxis x, y;
+  x.idx = malloc(sizeof(*x.idx) * (dstx + dsty));
+  x.frac = malloc(sizeof(*x.frac) * (dstx + dsty));
+  // two horizontally-interpolated source rows, and their source indices
+  uint16_t* rows[2] = {
+    malloc(sizeof(**rows) * 4 * dstx * 2),
+    NULL,
+  };
+  if(x.idx == NULL || x.frac == NULL || rows[0] == NULL){
+    free(x.idx);
+    free(x.frac);
+    free(rows[0]);
+    return -1;
+  }
+  rows[1] = rows[0] + 4 * dstx;
+  y.idx = x.idx + dstx;
+  y.frac = x.frac + dstx;
+  axis_bilinear(x.idx, x.frac, srcx, dstx);
+  axis_bilinear(y.idx, y.frac, srcy, dsty);
+  int have[2] = { -1, -1, };
+  for(int oy = 0 ; oy < dsty ; ++oy){
+    const int sy = y.idx[oy];
+    if(have[0] != sy){
+      if(have[1] == sy){ // advanced by one row; reuse the lower as the upper
+        uint16_t* tmp = rows[0];
+        rows[0] = rows[1];
+        rows[1] = tmp;
+        have[1] = have[0];
+        have[0] = sy;
+      }else{
+        rs->hlerp(src_row(src, srcstride, sy), x.idx, x.frac, rows[0], dstx);
+        have[0] = sy;
+      }
+    }
+    if(have[1] != sy + 1){
+      rs->hlerp(src_row(src, srcstride, sy + 1), x.idx, x.frac, rows[1], dstx);
+      have[1] = sy + 1;
+    }
+    rs->vlerp(rows[0], rows[1], y.frac[oy], dst_row(dst, dststride, oy), dstx);
+  }
+  free(rows[0] < rows[1] ? rows[0] : rows[1]);
+  free(x.idx);
+  free(x.frac);
+  return 0;
+}
+
+static int
+resample_box(const resampler* rs, const uint32_t* src, int srcy, int srcx,
+             int srcstride, uint32_t* dst, int dsty, int dstx, int dststride){
+  const int xtaps = axis_box(NULL, NULL, NULL, srcx, dstx);
+  const int ytaps = axis_box(NULL, NULL, NULL, srcy, dsty);
+  resampleaxis x, y;
+  x.idx = malloc(sizeof(*x.idx) * (dstx + dsty));
+  x.taps = malloc(sizeof(*x.taps) * (dstx + dsty + 2));
+  x.weights = malloc(sizeof(*x.weights) * (xtaps + ytaps));
+  uint32_t* acc = malloc(sizeof(*acc) * 4 * srcx);
+  if(x.idx == NULL || x.taps == NULL || x.weights == NULL || acc == NULL){
+    free(x.idx);
+    free(x.taps);
+    free(x.weights);
+    free(acc);
+    return -1;
+  }
+  y.idx = x.idx + dstx;
+  y.taps = x.taps + dstx + 1;
+  y.weights = x.weights + xtaps;
+  axis_box(x.idx, x.taps, x.weights, srcx, dstx);
+  axis_box(y.idx, y.taps, y.weights, srcy, dsty);
+  for(int oy = 0 ; oy < dsty ; ++oy){
+    memset(acc, 0, sizeof(*acc) * 4 * srcx);
+    for(int t = y.taps[oy] ; t < y.taps[oy + 1] ; ++t){
+      rs->boxacc(src_row(src, srcstride, y.idx[oy] + t - y.taps[oy]),
+                 y.weights[t], acc, srcx);
+    }
+    rs->boxsum(acc, x.idx, x.taps, x.weights, dst_row(dst, dststride, oy), dstx);
+  }
+  free(acc);
+  free(x.weights);
+  free(x.taps);
+  free(x.idx);
+  return 0;
+}
+
+int rgba_resample_via(const resampler* rs, const uint32_t* src, int srcy,
+                      int srcx, int srcstride, uint32_t* dst, int dsty,
+                      int dstx, int dststride, resample_e mode){
+  if(srcy <= 0 || srcx <= 0 || dsty <= 0 || dstx <= 0){
+    return -1;
+  }
+  if(srcstride < srcx * 4 || dststride < dstx * 4){
+    return -1;
+  }
+  switch(mode){
+    case RESAMPLE_NEAREST:
+      return resample_nearest(rs, src, srcy, srcx, srcstride, dst, dsty, dstx, dststride);
+    case RESAMPLE_BILINEAR:
+      // a single source row or column can't be interpolated (and ought just
+      // be replicated, as the box does)
+      if(srcy > 1 && srcx > 1){
+        return resample_bilinear(rs, src, srcy, srcx, srcstride, dst, dsty, dstx, dststride);
+      }
+      // intentional fallthrough
+    case RESAMPLE_BOX:
+      return resample_box(rs, src, srcy, srcx, srcstride, dst, dsty, dstx, dststride);
+  }
+  return -1;
+}
+
+int rgba_resample(const uint32_t* src, int srcy, int srcx, int srcstride,
+                  uint32_t* dst, int dsty, int dstx, int dststride,
+                  resample_e mode){
+  return rgba_resample_via(resampler_best(), src, srcy, srcx, srcstride,
+                           dst, dsty, dstx, dststride, mode);
+}
+
+int resample_blit(ncplane* n, const struct blitset* bset, int linesize,
+                  const void* data, int srcy, int srcx, int rows, int cols,
+                  const blitterargs* bargs){
+  if(rows == srcy && cols == srcx){
+    return rgba_blit_dispatch(n, bset, linesize, data, rows, cols, bargs);
+  }
+  uint32_t* scaled = malloc(sizeof(*scaled) * rows * cols);
+  if(scaled == NULL){
+    return -1;
+  }
+  if(rgba_resample(data, srcy, srcx, linesize, scaled, rows, cols,
+                   cols * sizeof(*scaled), resample_default(srcy, srcx, rows, cols))){
+    free(scaled);
+    return -1;
+  }
+  int ret = rgba_blit_dispatch(n, bset, cols * sizeof(*scaled), scaled, rows, cols, bargs);
+  free(scaled);
+  return ret;
+}
@@ -0,0 +1,108 @@
+#include <errno.h>
+#include "internal.h"
+
+// render the frame 's' has just begun on the caller's thread, counting it.
+static int
+scheduler_render(ncscheduler* s){
+  int r = notcurses_render(s->nc);
+  pthread_mutex_lock(&s->nc->statlock);
+  ++s->nc->stats.frames_delivered;
+  pthread_mutex_unlock(&s->nc->statlock);
+  return r;
+}
+
+// begin a frame at 'nowns' if one is pending. call with the lock held.
+// returns true if the caller ought render it (having released the lock).
+static bool
+scheduler_begin(ncscheduler* s, uint64_t nowns){
+  if(!s->pending){
+    return false;
+  }
+  s->pending = false;
+  s->rendered = true;
+  s->lastns = nowns;
+  return true;
+}
+
+ncscheduler* scheduler_create(notcurses* nc, unsigned fps){
+  if(fps == 0){
+    return NULL;
+  }
+  ncscheduler* s = malloc(sizeof(*s));
+  if(s == NULL){
+    return NULL;
+  }
+  memset(s, 0, sizeof(*s));
+  s->nc = nc;
+  s->intervalns = NANOSECS_IN_SEC / fps;
+  if(pthread_mutex_init(&s->lock, NULL)){
+    free(s);
+    return NULL;
+  }
+  return s;
+}
+
+int scheduler_service(ncscheduler* s, uint64_t* deadline){
+  *deadline = 0;
+  if(s == NULL){
+    return 0;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const uint64_t nowns = timespec_to_ns(&now);
+  pthread_mutex_lock(&s->lock);
+  bool render = false;
+  if(!s->rendered || nowns - s->lastns >= s->intervalns){
+    render = scheduler_begin(s, nowns);
+  }else if(s->pending){
+    *deadline = s->lastns + s->intervalns;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return render ? scheduler_render(s) : 0;
+}
+
+int scheduler_request(ncscheduler* s){
+  pthread_mutex_lock(&s->lock);
+  s->pending = true;
+  pthread_mutex_unlock(&s->lock);
+  uint64_t deadline;
+  return scheduler_service(s, &deadline);
+}
+
+int scheduler_drain(ncscheduler* s, bool wait){
+  if(s == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&s->lock);
+  if(!s->pending){
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+  }
+  const uint64_t deadline = s->lastns + s->intervalns;
+  pthread_mutex_unlock(&s->lock);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if(wait && timespec_to_ns(&now) < deadline){
+    struct timespec ts;
+    ns_to_timespec(deadline, &ts);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR){
+      ;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  }
+  // another thread might have rendered it while we slept
+  pthread_mutex_lock(&s->lock);
+  bool render = scheduler_begin(s, timespec_to_ns(&now));
+  pthread_mutex_unlock(&s->lock);
+  return render ? scheduler_render(s) : 0;
+}
+
+int scheduler_destroy(ncscheduler* s){
+  int ret = 0;
+  if(s){
+    ret = scheduler_drain(s, false);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+  }
+  return ret;
+}
@@ -686,16 +686,16 @@ int sixel_blit(ncplane* n, int linesize, const void* data,
   return r;
 }
 
-int sixel_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s){
+int sixel_destroy(const notcurses* nc, const ncpile* p, fbuf* f, sprixel* s){
 //fprintf(stderr, "%d] %d %p\n", s->id, s->invalidated, s->n);
   (void)nc;
-  (void)out;
+  (void)f;
   int starty = s->movedfromy;
   int startx = s->movedfromx;
   for(int yy = starty ; yy < starty + s->dimy && yy < p->dimy ; ++yy){
     for(int xx = startx ; xx < startx + s->dimx && xx < p->dimx ; ++xx){
-      struct crender *r = &p->crender[yy * p->dimx + xx];
-      if(!r->sprixel){
+      struct crender *r = &p->rvec.crender[yy * p->dimx + xx];
+      if(!r->s.sprixeled){
         r->s.damaged = 1;
       }
     }
@@ -703,7 +703,7 @@ int sixel_destroy(const notcurses* nc, const ncpile* p, FILE* out, sprixel* s){
   return 0;
 }
 
-int sixel_draw(const ncpile* p, sprixel* s, FILE* out){
+int sixel_draw(const ncpile* p, sprixel* s, fbuf* f){
   // if we've wiped or rebuilt any cells, effect those changes now, or else
   // we'll get flicker when we move to the new location.
   if(s->wipes_outstanding){
@@ -715,15 +715,15 @@ int sixel_draw(const ncpile* p, sprixel* s, FILE* out){
   if(s->invalidated == SPRIXEL_MOVED){
     for(int yy = s->movedfromy ; yy < s->movedfromy + s->dimy && yy < p->dimy ; ++yy){
       for(int xx = s->movedfromx ; xx < s->movedfromx + s->dimx && xx < p->dimx ; ++xx){
-        struct crender *r = &p->crender[yy * p->dimx + xx];
-        if(!r->sprixel || sprixel_state(r->sprixel, yy, xx) != SPRIXCELL_OPAQUE_SIXEL){
+        struct crender *r = &p->rvec.crender[yy * p->dimx + xx];
+        if(!r->s.sprixeled || sprixel_state(p->rvec.aux[yy * p->dimx + xx].sprixel, yy, xx) != SPRIXCELL_OPAQUE_SIXEL){
           r->s.damaged = 1;
         }
       }
     }
     s->invalidated = SPRIXEL_INVALIDATED;
   }else{
-    if(fwrite(s->glyph, s->glyphlen, 1, out) != 1){
+    if(fbuf_putn(f, s->glyph, s->glyphlen)){
       return -1;
     }
     s->invalidated = SPRIXEL_QUIESCENT;
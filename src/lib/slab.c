@@ -0,0 +1,212 @@
+#include "internal.h"
+
+// widgets such as ncreel and nctree create and destroy planes constantly as
+// they scroll. rather than returning freed ncplane structs and framebuffers
+// to the allocator, we retain them (up to a cap on total bytes) for reuse.
+// each cached object is an ordinary heap allocation, and can always simply be
+// free()d. cached objects are linked through their first word.
+
+#define SLAB_DEFAULT_CAP (1u << 22u) // 4MiB
+
+// framebuffers of classes larger than the default cap are never cached, and
+// are thus allocated at exactly the size requested.
+#define SLAB_FB_MAXBYTES SLAB_DEFAULT_CAP
+
+typedef struct slabobj {
+  struct slabobj* next;
+} slabobj;
+
+// framebuffers come in classes of a quarter octave (16, 20, 24, 28, 32, 40,
+// ... cells), so that one can serve any plane of its class while wasting no
+// more than a quarter of its cells. returns the class for 'cells', and writes
+// its capacity in cells to '*ccells'.
+static unsigned
+fb_class(size_t cells, size_t* ccells){
+  if(cells <= 16){
+    *ccells = 16;
+    return 0;
+  }
+  unsigned k = 63 - __builtin_clzll(cells - 1); // 2^k < cells <= 2^(k + 1)
+  size_t quarter = (size_t)1 << (k - 2);
+  size_t q = (cells - ((size_t)1 << k) + quarter - 1) / quarter; // [1, 4]
+  *ccells = ((size_t)1 << k) + q * quarter;
+  return 1 + (k - 4) * 4 + (q - 1);
+}
+
+// the capacity in cells of framebuffer class 'class', inverting fb_class()
+static size_t
+fb_class_cells(unsigned class){
+  if(class == 0){
+    return 16;
+  }
+  const unsigned k = (class - 1) / 4 + 4;
+  const size_t q = (class - 1) % 4 + 1;
+  return ((size_t)1 << k) + q * ((size_t)1 << (k - 2));
+}
+
+// the bytes allocated for a framebuffer of 'cells' cells. if it's of a class
+// we cache, that class is written to '*class'; otherwise, '*class' is set to
+// SLAB_FB_CLASSES.
+static size_t
+fb_alloc_bytes(int cells, unsigned* class){
+  size_t ccells;
+  *class = fb_class(cells, &ccells);
+  if(sizeof(nccell) * ccells > SLAB_FB_MAXBYTES){
+    *class = SLAB_FB_CLASSES;
+    return sizeof(nccell) * cells;
+  }
+  return sizeof(nccell) * ccells;
+}
+
+// call with the slab locked
+static void
+slab_stats(notcurses* nc, bool hit){
+  pthread_mutex_lock(&nc->statlock);
+  nc->stats.slab_hits += hit;
+  nc->stats.slab_bytes = nc->slab.cached;
+  pthread_mutex_unlock(&nc->statlock);
+}
+
+// take an object from 'list', of 'bytes' bytes. returns NULL if empty.
+static void*
+slab_get(notcurses* nc, slabobj** list, size_t bytes){
+  ncslab* s = &nc->slab;
+  pthread_mutex_lock(&s->lock);
+  slabobj* o = *list;
+  if(o){
+    *list = o->next;
+    s->cached -= bytes;
+    slab_stats(nc, true);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return o;
+}
+
+// cache the object 'o' of 'bytes' bytes on 'list', or free it if that would
+// exceed our cap.
+static void
+slab_put(notcurses* nc, slabobj** list, void* o, size_t bytes){
+  ncslab* s = &nc->slab;
+  pthread_mutex_lock(&s->lock);
+  if(s->cached + bytes <= s->cap){
+    slabobj* so = o;
+    so->next = *list;
+    *list = so;
+    s->cached += bytes;
+    slab_stats(nc, false);
+    o = NULL;
+  }
+  pthread_mutex_unlock(&s->lock);
+  free(o);
+}
+
+static void
+slab_free_list(slabobj** list){
+  slabobj* o = *list;
+  while(o){
+    slabobj* next = o->next;
+    free(o);
+    o = next;
+  }
+  *list = NULL;
+}
+
+int slab_init(ncslab* s){
+  memset(s, 0, sizeof(*s));
+  s->cap = SLAB_DEFAULT_CAP;
+  if(pthread_mutex_init(&s->lock, NULL)){
+    return -1;
+  }
+  return 0;
+}
+
+void slab_destroy(ncslab* s){
+  slab_free_list(&s->planes);
+  for(unsigned i = 0 ; i < SLAB_FB_CLASSES ; ++i){
+    slab_free_list(&s->fbs[i]);
+  }
+  s->cached = 0;
+  pthread_mutex_destroy(&s->lock);
+}
+
+ncplane* slab_plane_alloc(notcurses* nc){
+  ncplane* p = NULL;
+  if(nc){
+    p = slab_get(nc, &nc->slab.planes, sizeof(*p));
+  }
+  if(p == NULL){
+    p = malloc(sizeof(*p));
+  }
+  return p;
+}
+
+void slab_plane_free(notcurses* nc, ncplane* p){
+  if(nc == NULL || p == NULL){
+    free(p);
+    return;
+  }
+  slab_put(nc, &nc->slab.planes, p, sizeof(*p));
+}
+
+size_t slab_fb_bytes(notcurses* nc, int cells){
+  if(nc == NULL){
+    return sizeof(nccell) * cells;
+  }
+  unsigned class;
+  return fb_alloc_bytes(cells, &class);
+}
+
+nccell* slab_fb_alloc(notcurses* nc, int cells){
+  if(nc == NULL){
+    return malloc(sizeof(nccell) * cells);
+  }
+  unsigned class;
+  const size_t bytes = fb_alloc_bytes(cells, &class);
+  nccell* fb = NULL;
+  if(class < SLAB_FB_CLASSES){
+    fb = slab_get(nc, &nc->slab.fbs[class], bytes);
+  }
+  if(fb == NULL){
+    fb = malloc(bytes);
+  }
+  return fb;
+}
+
+void slab_fb_free(notcurses* nc, nccell* fb, int cells){
+  if(nc == NULL || fb == NULL){
+    free(fb);
+    return;
+  }
+  unsigned class;
+  const size_t bytes = fb_alloc_bytes(cells, &class);
+  if(class >= SLAB_FB_CLASSES){
+    free(fb);
+    return;
+  }
+  slab_put(nc, &nc->slab.fbs[class], fb, bytes);
+}
+
+size_t notcurses_set_cache_limit(notcurses* nc, size_t bytes){
+  ncslab* s = &nc->slab;
+  pthread_mutex_lock(&s->lock);
+  size_t ret = s->cap;
+  s->cap = bytes;
+  // shed plane structs first, then framebuffers from the largest class down
+  slabobj* o;
+  while(s->cached > s->cap && (o = s->planes)){
+    s->planes = o->next;
+    s->cached -= sizeof(ncplane);
+    free(o);
+  }
+  for(int class = SLAB_FB_CLASSES - 1 ; class >= 0 && s->cached > s->cap ; --class){
+    const size_t cbytes = sizeof(nccell) * fb_class_cells(class);
+    while(s->cached > s->cap && (o = s->fbs[class])){
+      s->fbs[class] = o->next;
+      s->cached -= cbytes;
+      free(o);
+    }
+  }
+  slab_stats(nc, false);
+  pthread_mutex_unlock(&s->lock);
+  return ret;
+}
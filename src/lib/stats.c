@@ -70,9 +70,28 @@ void update_raster_stats(const struct timespec* time1, const struct timespec* ti
   }
 }
 
+// account for one parallel render split into 'bands' row bands, each of which
+// took bandns[i] ns to paint. call only while holding statlock.
+void update_band_stats(ncstats* stats, unsigned bands, const int64_t* bandns){
+  int64_t slowest = 0;
+  for(unsigned b = 0 ; b < bands ; ++b){
+    stats->band_ns += bandns[b];
+    if(bandns[b] > stats->band_max_ns){
+      stats->band_max_ns = bandns[b];
+    }
+    if(bandns[b] > slowest){
+      slowest = bandns[b];
+    }
+  }
+  ++stats->parallel_renders;
+  stats->render_bands += bands;
+  stats->band_span_ns += slowest;
+}
+
 void reset_stats(ncstats* stats){
   uint64_t fbbytes = stats->fbbytes;
   unsigned planes = stats->planes;
+  uint64_t slab_bytes = stats->slab_bytes;
   memset(stats, 0, sizeof(*stats));
   stats->render_min_ns = 1ull << 62u;
   stats->render_min_bytes = 1ull << 62u;
@@ -80,6 +99,7 @@ void reset_stats(ncstats* stats){
   stats->writeout_min_ns = 1ull << 62u;
   stats->fbbytes = fbbytes;
   stats->planes = planes;
+  stats->slab_bytes = slab_bytes;
 }
 
 void notcurses_stats(notcurses* nc, ncstats* stats){
@@ -124,6 +144,9 @@ void notcurses_stats_reset(notcurses* nc, ncstats* stats){
   if(nc->stats.writeout_max_ns > stash->writeout_max_ns){
     stash->writeout_max_ns = nc->stats.writeout_max_ns;
   }
+  if(nc->stats.band_max_ns > stash->band_max_ns){
+    stash->band_max_ns = nc->stats.band_max_ns;
+  }
   stash->writeout_ns += nc->stats.writeout_ns;
   stash->raster_ns += nc->stats.raster_ns;
   stash->render_ns += nc->stats.render_ns;
@@ -143,9 +166,34 @@ void notcurses_stats_reset(notcurses* nc, ncstats* stats){
   stash->refreshes += nc->stats.refreshes;
   stash->sprixelemissions += nc->stats.sprixelemissions;
   stash->sprixelelisions += nc->stats.sprixelelisions;
+  stash->parallel_renders += nc->stats.parallel_renders;
+  stash->render_bands += nc->stats.render_bands;
+  stash->band_ns += nc->stats.band_ns;
+  stash->band_span_ns += nc->stats.band_span_ns;
+  stash->rowelisions += nc->stats.rowelisions;
+  stash->rowemissions += nc->stats.rowemissions;
+  stash->writer_waits += nc->stats.writer_waits;
+  stash->writer_wait_ns += nc->stats.writer_wait_ns;
+  stash->coalesced_frames += nc->stats.coalesced_frames;
+  stash->dropped_frames += nc->stats.dropped_frames;
+  stash->dropped_bytes += nc->stats.dropped_bytes;
+  stash->motion_bytes_saved += nc->stats.motion_bytes_saved;
+  stash->scrolls_accelerated += nc->stats.scrolls_accelerated;
+  stash->run_bytes_saved += nc->stats.run_bytes_saved;
+  stash->frames_requested += nc->stats.frames_requested;
+  stash->frames_delivered += nc->stats.frames_delivered;
+  stash->pool_compactions += nc->stats.pool_compactions;
+  stash->pool_bytes_reclaimed += nc->stats.pool_bytes_reclaimed;
+  stash->slab_hits += nc->stats.slab_hits;
+  stash->layer_hits += nc->stats.layer_hits;
+  stash->layer_misses += nc->stats.layer_misses;
+  stash->parallel_blits += nc->stats.parallel_blits;
+  stash->blitelisions += nc->stats.blitelisions;
+  stash->blitemissions += nc->stats.blitemissions;
 
   stash->fbbytes = nc->stats.fbbytes;
   stash->planes = nc->stats.planes;
+  stash->slab_bytes = nc->stats.slab_bytes;
   reset_stats(&nc->stats);
   pthread_mutex_unlock(&nc->statlock);
 }
@@ -211,9 +259,83 @@ void summarize_stats(notcurses* nc){
             (stats->fgelisions * 100.0) / (stats->fgemissions + stats->fgelisions),
             (stats->bgemissions + stats->bgelisions) == 0 ? 0 :
             (stats->bgelisions * 100.0) / (stats->bgemissions + stats->bgelisions));
+    fprintf(stderr, "Row emits:elides: %ju/%ju (%.2f%%)\n",
+            stats->rowemissions, stats->rowelisions,
+            (stats->rowemissions + stats->rowelisions) == 0 ? 0 :
+            (stats->rowelisions * 100.0) / (stats->rowemissions + stats->rowelisions));
+    if(stats->writer_waits){
+      char waitbuf[BPREFIXSTRLEN + 1];
+      qprefix(stats->writer_wait_ns, NANOSECS_IN_SEC, waitbuf, 0);
+      fprintf(stderr, "%ju writer wait%s, %ss\n", stats->writer_waits,
+              stats->writer_waits == 1 ? "" : "s", waitbuf);
+    }
+    if(stats->coalesced_frames || stats->dropped_frames){
+      char dropbuf[BPREFIXSTRLEN + 1];
+      bprefix(stats->dropped_bytes, 1, dropbuf, 1);
+      fprintf(stderr, "%ju coalesced, %ju dropped frame%s (%sB discarded)\n",
+              stats->coalesced_frames, stats->dropped_frames,
+              stats->dropped_frames == 1 ? "" : "s", dropbuf);
+    }
+    if(stats->motion_bytes_saved){
+      char savebuf[BPREFIXSTRLEN + 1];
+      bprefix(stats->motion_bytes_saved, 1, savebuf, 1);
+      fprintf(stderr, "%sB saved by cursor motion costing\n", savebuf);
+    }
+    if(stats->scrolls_accelerated){
+      fprintf(stderr, "%ju scroll%s performed by the terminal\n",
+              stats->scrolls_accelerated,
+              stats->scrolls_accelerated == 1 ? "" : "s");
+    }
+    if(stats->run_bytes_saved){
+      char savebuf[BPREFIXSTRLEN + 1];
+      bprefix(stats->run_bytes_saved, 1, savebuf, 1);
+      fprintf(stderr, "%sB saved by run encoding\n", savebuf);
+    }
+    if(stats->frames_requested){
+      fprintf(stderr, "%ju frame%s requested, %ju delivered\n",
+              stats->frames_requested,
+              stats->frames_requested == 1 ? "" : "s",
+              stats->frames_delivered);
+    }
+    if(stats->pool_compactions){
+      char savebuf[BPREFIXSTRLEN + 1];
+      bprefix(stats->pool_bytes_reclaimed, 1, savebuf, 1);
+      fprintf(stderr, "%ju egcpool compaction%s reclaimed %sB\n",
+              stats->pool_compactions,
+              stats->pool_compactions == 1 ? "" : "s", savebuf);
+    }
+    if(stats->slab_hits){
+      fprintf(stderr, "%ju plane allocation%s recycled\n", stats->slab_hits,
+              stats->slab_hits == 1 ? "" : "s");
+    }
+    if(stats->layer_hits || stats->layer_misses){
+      fprintf(stderr, "%ju cached layer paint%s, %ju recomposited\n",
+              stats->layer_hits + stats->layer_misses,
+              stats->layer_hits + stats->layer_misses == 1 ? "" : "s",
+              stats->layer_misses);
+    }
+    if(stats->parallel_blits){
+      fprintf(stderr, "%ju parallel blit%s\n", stats->parallel_blits,
+              stats->parallel_blits == 1 ? "" : "s");
+    }
+    if(stats->blitelisions || stats->blitemissions){
+      fprintf(stderr, "Delta blit emits:elides: %ju/%ju (%.2f%%)\n",
+              stats->blitemissions, stats->blitelisions,
+              (stats->blitelisions * 100.0) / (stats->blitemissions + stats->blitelisions));
+    }
     fprintf(stderr, "Sprixel emits:elides: %ju/%ju (%.2f%%)\n",
             stats->sprixelemissions, stats->sprixelelisions,
             (stats->sprixelemissions + stats->sprixelelisions) == 0 ? 0 :
             (stats->sprixelelisions * 100.0) / (stats->sprixelemissions + stats->sprixelelisions));
   }
+  if(stats->parallel_renders){
+    char totalbuf[BPREFIXSTRLEN + 1];
+    char maxbuf[BPREFIXSTRLEN + 1];
+    qprefix(stats->band_ns, NANOSECS_IN_SEC, totalbuf, 0);
+    qprefix(stats->band_max_ns, NANOSECS_IN_SEC, maxbuf, 0);
+    fprintf(stderr, "%ju parallel render%s, %ju bands, %ss (%ss max) %.2fx\n",
+            stats->parallel_renders, stats->parallel_renders == 1 ? "" : "s",
+            stats->render_bands, totalbuf, maxbuf,
+            stats->band_span_ns ? (double)stats->band_ns / stats->band_span_ns : 0);
+  }
 }
@@ -75,6 +75,132 @@ int terminfostr(char** gseq, const char* name){
   return 0;
 }
 
+// the length of 'cap' instantiated with 'params' single-digit parameters,
+// less those digits, or 0 if 'cap' is unavailable. this is only an estimate
+// (it assumes decimal parameters), but it needn't be exact.
+static unsigned
+motion_cost(const char* cap, unsigned params){
+  if(cap == NULL){
+    return 0;
+  }
+  size_t len;
+  if(params == 2){
+    len = strlen(tiparm(cap, 1, 1));
+  }else if(params == 1){
+    len = strlen(tiparm(cap, 1));
+  }else{
+    len = strlen(cap);
+  }
+  return len > params ? len - params : 1;
+}
+
+static inline bool
+esctemplate_lit(esctemplate* t, char c){
+  if(t->litlen[t->slots] == sizeof(t->lit[t->slots])){
+    return false;
+  }
+  t->lit[t->slots][t->litlen[t->slots]++] = c;
+  return true;
+}
+
+// compile 'cap', taking 'params' parameters, into 't' if it takes the simple
+// form described alongside esctemplate: literals, "%%", a leading "%i", and
+// "%pN%d". the result is checked against tiparm(); should they disagree, or
+// should 'cap' be more exotic, 't' falls back to tiparm().
+static void
+compile_esctemplate(esctemplate* t, const char* cap, unsigned params){
+  memset(t, 0, sizeof(*t));
+  t->cap = cap;
+  if(cap == NULL){
+    return;
+  }
+  const char* c = cap;
+  while(*c){
+    if(*c != '%'){
+      if(!esctemplate_lit(t, *c++)){
+        return;
+      }
+    }else if(c[1] == '%'){
+      if(!esctemplate_lit(t, '%')){
+        return;
+      }
+      c += 2;
+    }else if(c[1] == 'i' && t->slots == 0){
+      t->incr = 1;
+      c += 2;
+    }else if(c[1] == 'p' && c[2] >= '1' && c[2] < (char)('1' + params) &&
+             c[3] == '%' && c[4] == 'd' && t->slots < 2){
+      t->param[t->slots++] = c[2] - '1';
+      c += 5;
+    }else{
+      return;
+    }
+  }
+  static const int checks[][2] = {
+    { 0, 0, }, { 1, 9, }, { 23, 79, }, { 999, 1234, },
+  };
+  t->compiled = true;
+  for(size_t i = 0 ; i < sizeof(checks) / sizeof(*checks) ; ++i){
+    char buf[ESCTEMPLATE_MAXLEN];
+    int len = esctemplate_expand(t, buf, sizeof(buf), checks[i][0], checks[i][1]);
+    const char* seq = tiparm(cap, checks[i][0], checks[i][1]);
+    if(len < 0 || seq == NULL || strlen(seq) != (size_t)len || memcmp(seq, buf, len)){
+      t->compiled = false;
+      return;
+    }
+  }
+}
+
+// expand 'cap' into 't' for each parameter in [0..256). if 'sgr' is set,
+// the parameter is instead the eight styles sgr controls, passed as does
+// term_setstyles(). should any expansion fail, 't' is left empty, and
+// term_emit_indexed() falls back to tiparm(). returns -1 only on allocation
+// failure.
+static int
+build_esctable(esctable* t, const char* cap, bool sgr){
+  memset(t, 0, sizeof(*t));
+  if(cap == NULL){
+    return 0;
+  }
+  size_t used = 0;
+  size_t alloc = 0;
+  char* arena = NULL;
+  for(unsigned i = 0 ; i < sizeof(t->len) / sizeof(*t->len) ; ++i){
+    const char* seq;
+    if(sgr){
+      seq = tiparm(cap, i & NCSTYLE_STANDOUT, i & NCSTYLE_UNDERLINE,
+                   i & NCSTYLE_REVERSE, i & NCSTYLE_BLINK, i & NCSTYLE_DIM,
+                   i & NCSTYLE_BOLD, i & NCSTYLE_INVIS, i & NCSTYLE_PROTECT, 0);
+    }else{
+      seq = tiparm(cap, i);
+    }
+    size_t len = seq ? strlen(seq) : 0;
+    if(seq == NULL || len > UINT8_MAX){
+      free(arena);
+      return 0;
+    }
+    if(used + len > alloc){
+      size_t newalloc = alloc ? alloc * 2 : 1024;
+      while(newalloc < used + len){
+        newalloc *= 2;
+      }
+      char* tmp = realloc(arena, newalloc);
+      if(tmp == NULL){
+        free(arena);
+        return -1;
+      }
+      arena = tmp;
+      alloc = newalloc;
+    }
+    memcpy(arena + used, seq, len);
+    t->off[i] = used;
+    t->len[i] = len;
+    used += len;
+  }
+  t->arena = arena;
+  return 0;
+}
+
 // Qui si convien lasciare ogne sospetto; ogne viltà convien che qui sia morta.
 static int
 apply_term_heuristics(tinfo* ti, const char* termname, int fd){
@@ -131,6 +257,9 @@ apply_term_heuristics(tinfo* ti, const char* termname, int fd){
 }
 
 void free_terminfo_cache(tinfo* ti){
+  free(ti->setaftab.arena);
+  free(ti->setabtab.arena);
+  free(ti->sgrtab.arena);
   pthread_mutex_destroy(&ti->pixel_query);
 }
 
@@ -195,6 +324,39 @@ int interrogate_terminfo(tinfo* ti, int fd, const char* termname, unsigned utf8)
   terminfostr(&ti->cuf, "cuf"); // n non-destructive spaces
   terminfostr(&ti->cub, "cub"); // n non-destructive backspaces
   terminfostr(&ti->cuf1, "cuf1"); // non-destructive space
+  ti->motioncost.cup = motion_cost(ti->cup, 2);
+  ti->motioncost.hpa = motion_cost(ti->hpa, 1);
+  ti->motioncost.vpa = motion_cost(ti->vpa, 1);
+  ti->motioncost.cuf = motion_cost(ti->cuf, 1);
+  ti->motioncost.cub = motion_cost(ti->cub, 1);
+  ti->motioncost.cud = motion_cost(ti->cud, 1);
+  ti->motioncost.cuu = motion_cost(ti->cuu, 1);
+  ti->motioncost.cuf1 = motion_cost(ti->cuf1, 0);
+  ti->motioncost.home = motion_cost(ti->home, 0);
+  compile_esctemplate(&ti->cuptmpl, ti->cup, 2);
+  compile_esctemplate(&ti->hpatmpl, ti->hpa, 1);
+  compile_esctemplate(&ti->vpatmpl, ti->vpa, 1);
+  compile_esctemplate(&ti->cuftmpl, ti->cuf, 1);
+  compile_esctemplate(&ti->cubtmpl, ti->cub, 1);
+  compile_esctemplate(&ti->cudtmpl, ti->cud, 1);
+  compile_esctemplate(&ti->cuutmpl, ti->cuu, 1);
+  terminfostr(&ti->csr, "csr"); // set scrolling region
+  terminfostr(&ti->indn, "indn"); // scroll N lines up
+  terminfostr(&ti->dl, "dl"); // delete N lines
+  terminfostr(&ti->ech, "ech"); // erase N characters
+  terminfostr(&ti->el, "el"); // clear to end of line
+  compile_esctemplate(&ti->csrtmpl, ti->csr, 2);
+  compile_esctemplate(&ti->indntmpl, ti->indn, 1);
+  compile_esctemplate(&ti->dltmpl, ti->dl, 1);
+  compile_esctemplate(&ti->echtmpl, ti->ech, 1);
+  // the rasterizer follows glyphs of any length with a bare REP, and thus
+  // needs rep to be exactly the glyph followed by ECMA-48's CSI Ps b.
+  if(terminfostr(&ti->rep, "rep") == 0){
+    const char* rep = tiparm(ti->rep, 'x', 5);
+    if(rep == NULL || strcmp(rep, "x\x1b[4b")){
+      ti->rep = NULL;
+    }
+  }
   terminfostr(&ti->sc, "sc"); // push ("save") cursor
   terminfostr(&ti->rc, "rc"); // pop ("restore") cursor
   // Some terminals cannot combine certain styles with colors. Don't advertise
@@ -253,6 +415,13 @@ int interrogate_terminfo(tinfo* ti, int fd, const char* termname, unsigned utf8)
   if(apply_term_heuristics(ti, termname, fd)){
     return -1;
   }
+  if(build_esctable(&ti->setaftab, ti->setaf, false) ||
+     build_esctable(&ti->setabtab, ti->setab, false) ||
+     build_esctable(&ti->sgrtab, ti->sgr, true)){
+    free(ti->setaftab.arena);
+    free(ti->setabtab.arena);
+    return -1;
+  }
   return 0;
 }
 
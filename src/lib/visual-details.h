@@ -25,6 +25,10 @@ typedef struct ncvisual {
   // lines are sometimes padded. this many true bytes per row in data.
   int rowstride;
   bool owndata; // we own data iff owndata == true
+  // a buffer (always owned) replaced by ncvisual_rotate(), and retained for
+  // its next use. it holds 'sparelen' pixels.
+  uint32_t* spare;
+  size_t sparelen;
 } ncvisual;
 
 static inline void
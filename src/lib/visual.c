@@ -21,7 +21,8 @@ int ncvisual_blit(ncvisual* ncv, int rows, int cols, ncplane* n,
       ret = 0;
     }
   }else{
-    if(rgba_blit_dispatch(n, bset, ncv->rowstride, ncv->data, rows, cols, barg) >= 0){
+    if(resample_blit(n, bset, ncv->rowstride, ncv->data, ncv->pixy, ncv->pixx,
+                     rows, cols, barg) >= 0){
       ret = 0;
     }
   }
@@ -90,7 +91,7 @@ ncvisual_blitset_geom(const notcurses* nc, const ncvisual* n,
   if(lenx == NULL){
     lenx = &fakelenx;
   }
-  if(vopts && vopts->flags >= (NCVISUAL_OPTION_ADDALPHA << 1u)){
+  if(vopts && vopts->flags >= (NCVISUAL_OPTION_DELTA << 1u)){
     logwarn(nc, "Warning: unknown ncvisual options %016jx\n", (uintmax_t)vopts->flags);
   }
   int begy, begx;
@@ -402,7 +403,189 @@ rotate_bounding_box(double stheta, double ctheta, int* leny, int* lenx,
   return *leny * *lenx;
 }
 
-int ncvisual_rotate(ncvisual* ncv, double rads){
+// if 'rads' is (to within rounding error) a multiple of pi/2, return the
+// number of quarter turns it represents (0..3), and otherwise -1.
+static int
+rotation_quarters(double rads){
+  const double q = fmod(rads, 2 * M_PI) / M_PI_2;
+  const double nq = nearbyint(q);
+  if(fabs(q - nq) > 1e-9){
+    return -1;
+  }
+  return (((int)nq % 4) + 4) % 4;
+}
+
+// restrict [*lo, *hi) to those x for which 0 <= 'start' + x * 'step' < 'len',
+// where 'step' is one of -1, 0, and 1.
+static void
+quarter_clip(int start, int step, int len, int* lo, int* hi){
+  int l = *lo, h = *hi;
+  if(step == 0){
+    if(start < 0 || start >= len){
+      h = l;
+    }
+  }else if(step > 0){
+    if(-start > l){
+      l = -start;
+    }
+    if(len - start < h){
+      h = len - start;
+    }
+  }else{
+    if(start - len + 1 > l){
+      l = start - len + 1;
+    }
+    if(start + 1 < h){
+      h = start + 1;
+    }
+  }
+  *lo = l;
+  *hi = h;
+}
+
+// rotate through a multiple of a quarter turn, for which 'stheta' and 'ctheta'
+// are each one of -1, 0, and 1. every source pixel maps to exactly one target
+// pixel, and moving along a source row moves through the target by a constant
+// step, so we map only the first pixel of each row (clipped to the target).
+static void
+rotate_quarters(const ncvisual* ncv, uint32_t* data, int stheta, int ctheta,
+                int centy, int centx, int bby, int bbx, int bboffy, int bboffx){
+  const int stride = ncv->rowstride / 4;
+  const ptrdiff_t step = (ptrdiff_t)stheta * bbx + ctheta;
+  memset(data, 0, sizeof(*data) * bby * bbx);
+  for(int y = 0 ; y < ncv->pixy ; ++y){
+    const int convy = y - centy;
+    // target of the source pixel at [y, 0]
+    const int ty = -centx * stheta + convy * ctheta - bboffy;
+    const int tx = -centx * ctheta - convy * stheta - bboffx;
+    int lo = 0;
+    int hi = ncv->pixx;
+    quarter_clip(ty, stheta, bby, &lo, &hi);
+    quarter_clip(tx, ctheta, bbx, &lo, &hi);
+    if(lo >= hi){
+      continue;
+    }
+    const uint32_t* src = ncv->data + y * stride;
+    uint32_t* t = data + (ptrdiff_t)(ty + lo * stheta) * bbx + tx + lo * ctheta;
+    for(int x = lo ; x < hi ; ++x){
+      *t = src[x];
+      t += step;
+    }
+  }
+}
+
+// source coordinates are stepped in fixed point, with this many fractional bits
+#define ROTSHIFT 16
+
+static inline uint32_t
+rotate_fetch(const ncvisual* ncv, int y, int x){
+  if(y < 0 || x < 0 || y >= ncv->pixy || x >= ncv->pixx){
+    return 0;
+  }
+  return ncv->data[y * (ncv->rowstride / 4) + x];
+}
+
+// sample the four source pixels about the fixed-point ['sy', 'sx']. color is
+// weighted by alpha as well as area, so that transparent neighbors (such as
+// those beyond the edges) fade the result without darkening it.
+static inline uint32_t
+rotate_bilinear(const ncvisual* ncv, int64_t sy, int64_t sx){
+  const int y0 = sy >> ROTSHIFT;
+  const int x0 = sx >> ROTSHIFT;
+  const unsigned fy = (sy >> (ROTSHIFT - 8)) & 0xff;
+  const unsigned fx = (sx >> (ROTSHIFT - 8)) & 0xff;
+  if(y0 < -1 || x0 < -1 || y0 >= ncv->pixy || x0 >= ncv->pixx){
+    return 0;
+  }
+  uint32_t px[4];
+  if(y0 >= 0 && x0 >= 0 && y0 + 1 < ncv->pixy && x0 + 1 < ncv->pixx){
+    const uint32_t* p = ncv->data + y0 * (ncv->rowstride / 4) + x0;
+    px[0] = p[0];
+    px[1] = p[1];
+    px[2] = p[ncv->rowstride / 4];
+    px[3] = p[ncv->rowstride / 4 + 1];
+  }else{
+    px[0] = rotate_fetch(ncv, y0, x0);
+    px[1] = rotate_fetch(ncv, y0, x0 + 1);
+    px[2] = rotate_fetch(ncv, y0 + 1, x0);
+    px[3] = rotate_fetch(ncv, y0 + 1, x0 + 1);
+  }
+  const unsigned w[4] = {
+    (256 - fy) * (256 - fx), (256 - fy) * fx, fy * (256 - fx), fy * fx,
+  };
+  // the common case of four opaque pixels needn't weight by alpha
+  if((px[0] & px[1] & px[2] & px[3] & htole(0xff000000u)) == htole(0xff000000u)){
+    uint32_t ret = htole(0xff000000u);
+    unsigned char* r = (unsigned char*)&ret;
+    for(int c = 0 ; c < 3 ; ++c){
+      uint32_t sum = 1u << 15;
+      for(int i = 0 ; i < 4 ; ++i){
+        sum += w[i] * ((const unsigned char*)&px[i])[c];
+      }
+      r[c] = sum >> 16;
+    }
+    return ret;
+  }
+  uint32_t asum = 0;
+  uint32_t csums[3] = { 0, 0, 0, };
+  for(int i = 0 ; i < 4 ; ++i){
+    const unsigned char* p = (const unsigned char*)&px[i];
+    const uint32_t wa = (w[i] * p[3]) >> 8;
+    asum += wa;
+    for(int c = 0 ; c < 3 ; ++c){
+      csums[c] += wa * p[c];
+    }
+  }
+  uint32_t ret = 0;
+  if(asum){
+    unsigned char* r = (unsigned char*)&ret;
+    for(int c = 0 ; c < 3 ; ++c){
+      r[c] = (csums[c] + asum / 2) / asum;
+    }
+    r[3] = (asum + 128) >> 8;
+  }
+  return ret;
+}
+
+// rotate through an arbitrary angle. each target pixel is mapped back into
+// the source, stepping the source coordinates along each target row in fixed
+// point (the start of each row is computed exactly, bounding the error).
+static void
+rotate_arbitrary(const ncvisual* ncv, uint32_t* data, double stheta, double ctheta,
+                 int centy, int centx, int bby, int bbx, int bboffy, int bboffx,
+                 bool bilinear){
+  const double one = 1 << ROTSHIFT;
+  const int64_t dsx = llround(ctheta * one);
+  const int64_t dsy = llround(-stheta * one);
+  const int stride = ncv->rowstride / 4;
+  for(int y = 0 ; y < bby ; ++y){
+    const int ty = y + bboffy;
+    int64_t sx = llround((bboffx * ctheta + ty * stheta + centx) * one);
+    int64_t sy = llround((-bboffx * stheta + ty * ctheta + centy) * one);
+    uint32_t* t = data + (ptrdiff_t)y * bbx;
+    if(bilinear){
+      for(int x = 0 ; x < bbx ; ++x, sx += dsx, sy += dsy){
+        t[x] = rotate_bilinear(ncv, sy, sx);
+      }
+    }else{
+      const int64_t half = 1 << (ROTSHIFT - 1);
+      for(int x = 0 ; x < bbx ; ++x, sx += dsx, sy += dsy){
+        const int64_t srcy = (sy + half) >> ROTSHIFT;
+        const int64_t srcx = (sx + half) >> ROTSHIFT;
+        if(srcy >= 0 && srcx >= 0 && srcy < ncv->pixy && srcx < ncv->pixx){
+          t[x] = ncv->data[srcy * stride + srcx];
+        }else{
+          t[x] = 0;
+        }
+      }
+    }
+  }
+}
+
+#undef ROTSHIFT
+
+static int
+ncvisual_rotate_sampled(ncvisual* ncv, double rads, bool bilinear){
   // done to force conversion into RGBA
   int err = ncvisual_resize(ncv, ncv->pixy, ncv->pixx);
   if(err){
@@ -416,8 +599,15 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
   int centy, centx;
   ncvisual_center(ncv, &centy, &centx); // pixel center (center of 'data')
   double stheta, ctheta; // sine, cosine
-  stheta = sin(rads);
-  ctheta = cos(rads);
+  const int quarters = rotation_quarters(rads);
+  if(quarters >= 0){
+    static const int qsin[] = { 0, 1, 0, -1, };
+    stheta = qsin[quarters];
+    ctheta = qsin[(quarters + 1) % 4];
+  }else{
+    stheta = sin(rads);
+    ctheta = cos(rads);
+  }
   // bounding box for real data within the ncvisual. we must only resize to
   // accommodate real data, lest we grow without band as we rotate.
   // see https://github.com/dankamongmen/notcurses/issues/599.
@@ -433,28 +623,32 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
   if(bbarea <= 0){
     return -1;
   }
-  int bbcentx = bbx, bbcenty = bby;
-  center_box(&bbcenty, &bbcentx);
-//fprintf(stderr, "stride: %d height: %d width: %d\n", ncv->rowstride, ncv->pixy, ncv->pixx);
-  assert(ncv->rowstride / 4 >= ncv->pixx);
-  uint32_t* data = malloc(bbarea * 4);
-  if(data == NULL){
-    return -1;
-  }
-  memset(data, 0, bbarea * 4);
-//fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d bbcenty: %d bbcentx: %d\n", bbarea, bby, bbx, centy, centx, bbcenty, bbcentx);
-  for(int y = 0 ; y < ncv->pixy ; ++y){
-      for(int x = 0 ; x < ncv->pixx ; ++x){
-      int targx = x, targy = y;
-      rotate_point(&targy, &targx, stheta, ctheta, centy, centx);
-      const int deconvx = targx - bboffx;
-      const int deconvy = targy - bboffy;
-      if(deconvy >= 0 && deconvx >= 0 && deconvy < bby && deconvx < bbx){
-        data[deconvy * bbx + deconvx] = ncv->data[y * (ncv->rowstride / 4) + x];
-      }
-//fprintf(stderr, "CW: %d/%d (%08x) -> %d/%d (stride: %d)\n", y, x, ncv->data[y * (ncv->rowstride / 4) + x], targy, targx, ncv->rowstride);
-//fprintf(stderr, "wrote %08x to %d (%d)\n", data[targy * ncv->pixy + targx], targy * ncv->pixy + targx, (targy * ncv->pixy + targx) * 4);
+  // rotating every frame ought not allocate every frame. the buffer we
+  // replace is retained as 'spare', and used for the next rotation if large
+  // enough.
+  uint32_t* data;
+  if(ncv->spare && ncv->sparelen >= (size_t)bbarea){
+    data = ncv->spare;
+  }else{
+    if((data = malloc(sizeof(*data) * bbarea)) == NULL){
+      return -1;
     }
+    free(ncv->spare);
+  }
+  ncv->spare = NULL;
+  ncv->sparelen = 0;
+//fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d\n", bbarea, bby, bbx, centy, centx);
+  if(quarters >= 0){
+    rotate_quarters(ncv, data, (int)stheta, (int)ctheta, centy, centx,
+                    bby, bbx, bboffy, bboffx);
+  }else{
+    rotate_arbitrary(ncv, data, stheta, ctheta, centy, centx, bby, bbx,
+                     bboffy, bboffx, bilinear);
+  }
+  if(ncv->owndata){
+    ncv->spare = ncv->data;
+    ncv->sparelen = (size_t)ncv->pixy * (ncv->rowstride / 4);
+    ncv->owndata = false; // don't free it in ncvisual_set_data()
   }
   ncvisual_set_data(ncv, data, true);
   ncv->pixx = bbx;
@@ -464,6 +658,14 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
   return 0;
 }
 
+int ncvisual_rotate(ncvisual* ncv, double rads){
+  return ncvisual_rotate_sampled(ncv, rads, false);
+}
+
+int ncvisual_rotate_bilinear(ncvisual* ncv, double rads){
+  return ncvisual_rotate_sampled(ncv, rads, true);
+}
+
 ncvisual* ncvisual_from_rgba(const void* rgba, int rows, int rowstride, int cols){
   if(rowstride % 4){
     return NULL;
@@ -598,6 +800,9 @@ ncplane* ncvisual_render_cells(notcurses* nc, ncvisual* ncv, const struct blitse
   bargs.u.cell.placey = placey;
   bargs.u.cell.placex = placex;
   bargs.u.cell.blendcolors = flags & NCVISUAL_OPTION_BLEND;
+  bargs.u.cell.stage = NULL;
+  bargs.u.cell.delta = flags & NCVISUAL_OPTION_DELTA;
+  bargs.u.cell.bdelta = NULL;
   if(ncvisual_blit(ncv, disprows, dispcols, n, bset, &bargs)){
     ncplane_destroy(createdn);
     return NULL;
@@ -854,6 +1059,12 @@ ncvisual* ncvisual_from_plane(const ncplane* n, ncblitter_e blit, int begy, int
 void ncvisual_destroy(ncvisual* ncv){
   if(visual_implementation){
     visual_implementation->visual_destroy(ncv);
+  }else if(ncv){
+    if(ncv->owndata){
+      free(ncv->data);
+    }
+    free(ncv->spare);
+    free(ncv);
   }
 }
 
@@ -970,7 +1181,7 @@ char* ncvisual_subtitle(const ncvisual* ncv){
 
 int ncvisual_resize(ncvisual* nc, int rows, int cols){
   if(!visual_implementation){
-    return -1;
+    return resample_visual(nc, rows, cols);
   }
   if(visual_implementation->visual_resize(nc, rows, cols)){
     return -1;
@@ -978,40 +1189,42 @@ int ncvisual_resize(ncvisual* nc, int rows, int cols){
   return 0;
 }
 
-// Inflate each pixel of 'bmap' to 'scale'x'scale' pixels square, using the
-// same color as the original pixel.
-static inline void*
-inflate_bitmap(const uint32_t* bmap, int scale, int rows, int stride, int cols){
-  size_t size = rows * cols * scale * scale * sizeof(*bmap);
-  uint32_t* ret = malloc(size);
-  if(ret){
-    for(int y = 0 ; y < rows ; ++y){
-      const uint32_t* src = bmap + y * (stride / sizeof(*bmap));
-      for(int yi = 0 ; yi < scale ; ++yi){
-        uint32_t* dst = ret + (y * scale + yi) * cols * scale;
-        for(int x = 0 ; x < cols ; ++x){
-          for(int xi = 0 ; xi < scale ; ++xi){
-            dst[x * scale + xi] = src[x];
-          }
-        }
-      }
-    }
+// scale 'ncv' with the built-in resampler, replacing its data
+static int
+resample_visual_mode(ncvisual* ncv, int rows, int cols, resample_e mode){
+  if(rows <= 0 || cols <= 0){
+    return -1;
   }
-  return ret;
+  if(ncv->pixy == rows && ncv->pixx == cols){
+    return 0;
+  }
+  uint32_t* data = malloc(sizeof(*data) * rows * cols);
+  if(data == NULL){
+    return -1;
+  }
+  if(rgba_resample(ncv->data, ncv->pixy, ncv->pixx, ncv->rowstride,
+                   data, rows, cols, cols * sizeof(*data), mode)){
+    free(data);
+    return -1;
+  }
+  ncvisual_set_data(ncv, data, true);
+  ncv->pixy = rows;
+  ncv->pixx = cols;
+  ncv->rowstride = cols * sizeof(*data);
+  ncvisual_details_seed(ncv);
+  return 0;
+}
+
+int resample_visual(ncvisual* ncv, int rows, int cols){
+  return resample_visual_mode(ncv, rows, cols,
+                              resample_default(ncv->pixy, ncv->pixx, rows, cols));
 }
 
+// Inflate each pixel to 'scale'x'scale' pixels square, using the same color
+// as the original pixel (nearest-neighbor sampling is exact at integer scales).
 int ncvisual_inflate(ncvisual* n, int scale){
   if(scale <= 0){
     return -1;
   }
-  void* inflaton = inflate_bitmap(n->data, scale, n->pixy, n->rowstride, n->pixx);
-  if(inflaton == NULL){
-    return -1;
-  }
-  ncvisual_set_data(n, inflaton, true);
-  n->pixy *= scale;
-  n->pixx *= scale;
-  n->rowstride = 4 * n->pixx;
-  ncvisual_details_seed(n);
-  return 0;
+  return resample_visual_mode(n, n->pixy * scale, n->pixx * scale, RESAMPLE_NEAREST);
 }
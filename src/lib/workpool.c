@@ -0,0 +1,146 @@
+#include <signal.h>
+#include "internal.h"
+
+// helper threads sleep on the pool's condvar until a batch is posted, then
+// claim jobs one at a time until none remain. the last thread to finish a
+// job wakes up the poster.
+static void*
+workpool_thread(void* vpool){
+  ncworkpool* pool = vpool;
+  pthread_mutex_lock(&pool->lock);
+  while(!pool->shutdown){
+    if(pool->nextjob >= pool->jobs){
+      pthread_cond_wait(&pool->cond, &pool->lock);
+      continue;
+    }
+    unsigned job = pool->nextjob++;
+    pthread_mutex_unlock(&pool->lock);
+    pool->fxn(pool->curry, job);
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->outstanding == 0){
+      pthread_cond_signal(&pool->donecond);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+ncworkpool* workpool_create(unsigned threads){
+  if(threads == 0){
+    return NULL;
+  }
+  ncworkpool* pool = malloc(sizeof(*pool));
+  if(pool == NULL){
+    return NULL;
+  }
+  if((pool->tids = malloc(sizeof(*pool->tids) * threads)) == NULL){
+    free(pool);
+    return NULL;
+  }
+  pool->threads = 0;
+  pool->jobs = 0;
+  pool->nextjob = 0;
+  pool->outstanding = 0;
+  pool->fxn = NULL;
+  pool->curry = NULL;
+  pool->shutdown = false;
+  if(pthread_mutex_init(&pool->lock, NULL)){
+    free(pool->tids);
+    free(pool);
+    return NULL;
+  }
+  if(pthread_mutex_init(&pool->runlock, NULL)){
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->tids);
+    free(pool);
+    return NULL;
+  }
+  if(pthread_cond_init(&pool->cond, NULL)){
+    pthread_mutex_destroy(&pool->runlock);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->tids);
+    free(pool);
+    return NULL;
+  }
+  if(pthread_cond_init(&pool->donecond, NULL)){
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->runlock);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->tids);
+    free(pool);
+    return NULL;
+  }
+  // helpers must never field signals intended for the application (or for
+  // our own SIGWINCH handler), so block everything while they're spawned;
+  // they inherit our mask.
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  for(unsigned t = 0 ; t < threads ; ++t){
+    if(pthread_create(&pool->tids[t], NULL, workpool_thread, pool)){
+      break;
+    }
+    ++pool->threads;
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if(pool->threads == 0){
+    workpool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void workpool_run(ncworkpool* pool, unsigned jobs,
+                  void (*fxn)(void*, unsigned), void* curry){
+  if(jobs == 0){
+    return;
+  }
+  // should another thread's batch (i.e. a render of some other pile) be
+  // underway, we're better off working alone than waiting for it.
+  if(pool == NULL || jobs == 1 || pthread_mutex_trylock(&pool->runlock)){
+    for(unsigned j = 0 ; j < jobs ; ++j){
+      fxn(curry, j);
+    }
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  pool->fxn = fxn;
+  pool->curry = curry;
+  pool->jobs = jobs;
+  pool->nextjob = 0;
+  pool->outstanding = jobs;
+  pthread_cond_broadcast(&pool->cond);
+  // the caller takes part in the work, rather than idly waiting
+  while(pool->nextjob < pool->jobs){
+    unsigned job = pool->nextjob++;
+    pthread_mutex_unlock(&pool->lock);
+    fxn(curry, job);
+    pthread_mutex_lock(&pool->lock);
+    --pool->outstanding;
+  }
+  while(pool->outstanding){
+    pthread_cond_wait(&pool->donecond, &pool->lock);
+  }
+  pool->jobs = 0;
+  pool->nextjob = 0;
+  pthread_mutex_unlock(&pool->lock);
+  pthread_mutex_unlock(&pool->runlock);
+}
+
+void workpool_destroy(ncworkpool* pool){
+  if(pool){
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for(unsigned t = 0 ; t < pool->threads ; ++t){
+      pthread_join(pool->tids[t], NULL);
+    }
+    pthread_cond_destroy(&pool->donecond);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->runlock);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->tids);
+    free(pool);
+  }
+}
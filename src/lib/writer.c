@@ -0,0 +1,252 @@
+#include <poll.h>
+#include <signal.h>
+#include "internal.h"
+
+// index of the first of 'f's row marks at or beyond 'offset' (the number of
+// marks, if there is no such mark).
+static unsigned
+writer_markidx(const struct ncwriterframe* f, size_t offset){
+  unsigned lo = 0;
+  unsigned hi = f->markcount;
+  while(lo < hi){
+    unsigned mid = lo + (hi - lo) / 2;
+    if(f->marks[mid].offset < offset){
+      lo = mid + 1;
+    }else{
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// write out 'f', polling on EAGAIN. if the frame has row marks, and we're
+// asked to cut it short, stop at the first mark at or beyond what's already
+// been written. returns the number of bytes written, or -1 on error.
+static ssize_t
+writer_write(ncwriter* w, const struct ncwriterframe* f){
+  size_t end = f->f.used;
+  size_t written = 0;
+  bool cut = false;
+  while(written < end){
+    if(!cut && f->markcount){
+      pthread_mutex_lock(&w->lock);
+      cut = w->cut;
+      pthread_mutex_unlock(&w->lock);
+      if(cut){
+        unsigned idx = writer_markidx(f, written);
+        if(idx < f->markcount){
+          end = f->marks[idx].offset;
+        }
+        continue;
+      }
+    }
+    ssize_t r = write(w->fd, f->f.buf + written, end - written);
+    if(r < 0){
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+        return -1;
+      }
+      if(errno != EINTR){
+        struct pollfd pfd = {
+          .fd = w->fd,
+          .events = POLLOUT,
+          .revents = 0,
+        };
+        poll(&pfd, 1, -1);
+      }
+    }else{
+      written += r;
+    }
+  }
+  return written;
+}
+
+// the writer sleeps on its condvar until a frame is queued, then writes out
+// the oldest queued frame without holding the lock. once it's been written,
+// its buffer is released, and anyone waiting for a free buffer is woken.
+static void*
+writer_thread(void* vw){
+  ncwriter* w = vw;
+  pthread_mutex_lock(&w->lock);
+  while(true){
+    if(w->queued == 0){
+      if(w->shutdown){
+        break;
+      }
+      pthread_cond_wait(&w->cond, &w->lock);
+      continue;
+    }
+    struct ncwriterframe* f = &w->frames[w->next];
+    pthread_mutex_unlock(&w->lock);
+    ssize_t r = writer_write(w, f);
+    pthread_mutex_lock(&w->lock);
+    if(r < 0){
+      w->failed = true;
+    }else if((size_t)r < f->f.used){
+      w->cutframe = f;
+      w->cutat = r;
+    }
+    w->next = (w->next + 1) % 2;
+    --w->queued;
+    pthread_cond_broadcast(&w->donecond);
+  }
+  pthread_mutex_unlock(&w->lock);
+  return NULL;
+}
+
+ncwriter* writer_create(int fd, bool coalesce){
+  if(fd < 0){
+    return NULL;
+  }
+  ncwriter* w = malloc(sizeof(*w));
+  if(w == NULL){
+    return NULL;
+  }
+  memset(w, 0, sizeof(*w));
+  w->fd = fd;
+  w->coalesce = coalesce;
+  if(pthread_mutex_init(&w->lock, NULL)){
+    free(w);
+    return NULL;
+  }
+  if(pthread_cond_init(&w->cond, NULL)){
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+    return NULL;
+  }
+  if(pthread_cond_init(&w->donecond, NULL)){
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+    return NULL;
+  }
+  // as with the workpool, the writer must never field signals intended for
+  // the application (or our own SIGWINCH handler).
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  int r = pthread_create(&w->tid, NULL, writer_thread, w);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if(r){
+    pthread_cond_destroy(&w->donecond);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+    return NULL;
+  }
+  return w;
+}
+
+// wait (holding the lock) until no more than 'maxqueued' frames are in
+// flight. returns the number of nanoseconds spent waiting.
+static int64_t
+writer_wait(ncwriter* w, unsigned maxqueued){
+  if(w->queued <= maxqueued){
+    return 0;
+  }
+  struct timespec start, done;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while(w->queued > maxqueued){
+    pthread_cond_wait(&w->donecond, &w->lock);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &done);
+  return timespec_to_ns(&done) - timespec_to_ns(&start);
+}
+
+// check for (and reset) a write failure. call with the lock held.
+static int
+writer_check(ncwriter* w){
+  if(w->failed){
+    w->failed = false;
+    return -1;
+  }
+  return 0;
+}
+
+int writer_submit(ncwriter* w, fbuf* f, const ncrowmark* marks,
+                  unsigned markcount, int64_t* waitns){
+  pthread_mutex_lock(&w->lock);
+  *waitns = writer_wait(w, 1);
+  int ret = writer_check(w);
+  struct ncwriterframe* frame = &w->frames[(w->next + w->queued) % 2];
+  if(frame->markalloc < markcount){
+    ncrowmark* tmp = realloc(frame->marks, sizeof(*marks) * markcount);
+    if(tmp == NULL){
+      pthread_mutex_unlock(&w->lock);
+      return -1;
+    }
+    frame->marks = tmp;
+    frame->markalloc = markcount;
+  }
+  // trade buffers rather than copying; the caller gets back the storage of a
+  // frame we've finished writing.
+  fbuf done = frame->f;
+  frame->f = *f;
+  *f = done;
+  fbuf_reset(f);
+  if(markcount){
+    memcpy(frame->marks, marks, sizeof(*marks) * markcount);
+  }
+  frame->markcount = markcount;
+  ++w->queued;
+  pthread_cond_signal(&w->cond);
+  pthread_mutex_unlock(&w->lock);
+  return ret;
+}
+
+int writer_coalesce(ncwriter* w, ncwritercut* cut){
+  memset(cut, 0, sizeof(*cut));
+  if(w == NULL || !w->coalesce){
+    return 0;
+  }
+  pthread_mutex_lock(&w->lock);
+  // only the most recent frame is cut short; should an older one be queued
+  // ahead of it, let it finish, so that all lost rows come from one frame.
+  cut->waitns = writer_wait(w, 1);
+  w->cutframe = NULL;
+  w->cut = true;
+  cut->waitns += writer_wait(w, 0);
+  w->cut = false;
+  if(w->cutframe){
+    const struct ncwriterframe* f = w->cutframe;
+    unsigned idx = writer_markidx(f, w->cutat);
+    cut->lost = f->marks + idx;
+    cut->lostcount = f->markcount - idx;
+    cut->dropped = (idx == 0);
+    cut->lostbytes = f->f.used - w->cutat;
+  }
+  int ret = writer_check(w);
+  pthread_mutex_unlock(&w->lock);
+  return ret;
+}
+
+int writer_drain(ncwriter* w){
+  if(w == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&w->lock);
+  writer_wait(w, 0);
+  int ret = writer_check(w);
+  pthread_mutex_unlock(&w->lock);
+  return ret;
+}
+
+int writer_destroy(ncwriter* w){
+  int ret = 0;
+  if(w){
+    pthread_mutex_lock(&w->lock);
+    w->shutdown = true;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->tid, NULL);
+    ret = writer_check(w);
+    pthread_cond_destroy(&w->donecond);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    for(unsigned i = 0 ; i < sizeof(w->frames) / sizeof(*w->frames) ; ++i){
+      fbuf_free(&w->frames[i].f);
+      free(w->frames[i].marks);
+    }
+    free(w);
+  }
+  return ret;
+}
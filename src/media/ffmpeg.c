@@ -388,13 +388,15 @@ int ffmpeg_stream(notcurses* nc, ncvisual* ncv, float timescale,
     // all media when we loop =[. we seem to be accurate enough now with the
     // tbase/ppd. see https://github.com/dankamongmen/notcurses/issues/1352.
     double tbase = av_q2d(ncv->details->fmtctx->streams[ncv->details->stream_index]->time_base);
-    if(activevopts.n){
-      ncplane_erase(activevopts.n); // new frame could be partially transparent
-    }
     // decay the blitter explicitly, so that the callback knows the blitter it
     // was actually rendered with
     ncvisual_blitter_geom(nc, ncv, &activevopts, NULL, NULL, NULL, NULL,
                           &activevopts.blitter);
+    // new frame could be partially transparent. a delta blit clears any cell
+    // it writes, and leaves only those which would be written identically.
+    if(activevopts.n && !delta_blit_p(activevopts.blitter, activevopts.flags)){
+      ncplane_erase(activevopts.n);
+    }
     if((newn = ncvisual_render(nc, ncv, &activevopts)) == NULL){
       if(activevopts.n != vopts->n){
         ncplane_destroy(activevopts.n);
@@ -576,6 +578,7 @@ void ffmpeg_destroy(ncvisual* ncv){
     if(ncv->owndata){
       free(ncv->data);
     }
+    free(ncv->spare);
     free(ncv);
   }
 }
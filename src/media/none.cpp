@@ -9,7 +9,13 @@ ncvisual* none_create(){
 }
 
 void none_destroy(ncvisual* ncv){
-  delete ncv;
+  if(ncv){
+    if(ncv->owndata){
+      free(ncv->data);
+    }
+    free(ncv->spare);
+    delete ncv;
+  }
 }
 
 int none_decode(ncvisual* nc){
@@ -32,17 +38,14 @@ int none_resize(ncvisual* nc, int rows, int cols){
   // we'd need to verify that it's RGBA as well, except that if we've got no
   // multimedia engine, we've only got memory-assembled ncvisuals, which are
   // RGBA-native. so we ought be good, but this is undeniably sloppy...
-  if(nc->pixy == rows && nc->pixx == cols){
-    return 0;
-  }
-  return -1;
+  return resample_visual(nc, rows, cols);
 }
 
 int none_blit(struct ncvisual* ncv, int rows, int cols,
               ncplane* n, const struct blitset* bset,
               const blitterargs* bargs){
-  if(rgba_blit_dispatch(n, bset, ncv->rowstride, ncv->data,
-                        rows, cols, bargs) >= 0){
+  if(resample_blit(n, bset, ncv->rowstride, ncv->data, ncv->pixy, ncv->pixx,
+                   rows, cols, bargs) >= 0){
     return 0;
   }
   return -1;
@@ -77,7 +80,7 @@ int none_init(int loglevel __attribute__ ((unused))) {
 }
 
 void none_printbanner(const notcurses* nc){
-  term_fg_palindex(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
+  term_fg_palindex_file(nc, stderr, nc->tcache.colors <= 88 ? 1 % nc->tcache.colors : 0xcb);
   fprintf(stderr, "\n Warning! Notcurses was built without multimedia support.\n");
 }
 
@@ -143,6 +143,8 @@ int oiio_resize(ncvisual* nc, int rows, int cols) {
     ncvisual_set_data(nc, static_cast<uint32_t*>(ibuf->localpixels()), false);
 //fprintf(stderr, "HAVE SOME NEW DATA: %p\n", ibuf->localpixels());
     nc->details->ibuf = std::move(ibuf);
+  }else if(!nc->details->ibuf){ // OIIO can't scale it; use our own resampler
+    return resample_visual(nc, rows, cols);
   }
   return 0;
 }
@@ -166,6 +168,12 @@ int oiio_blit(struct ncvisual* ncv, int rows, int cols,
     stride = cols * 4;
     data = ibuf->localpixels();
 //fprintf(stderr, "HAVE SOME NEW DATA: %p\n", ibuf->localpixels());
+  }else if(ncv->pixx != cols || ncv->pixy != rows){ // use our own resampler
+    if(resample_blit(n, bset, ncv->rowstride, ncv->data, ncv->pixy, ncv->pixx,
+                     rows, cols, bargs) < 0){
+      return -1;
+    }
+    return 0;
   }else{
     data = ncv->data;
     stride = ncv->rowstride;
@@ -199,6 +207,7 @@ auto oiio_destroy(ncvisual* ncv) -> void {
     if(ncv->owndata){
       free(ncv->data);
     }
+    free(ncv->spare);
     delete ncv;
   }
 }
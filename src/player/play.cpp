@@ -386,7 +386,8 @@ int rendered_mode_player_inner(NotCurses& nc, int argc, char** argv,
     ncplane_move_bottom(n);
     struct ncvisual_options vopts{};
     int r;
-    vopts.flags |= NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_VERALIGNED;
+    vopts.flags |= NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_VERALIGNED |
+                   NCVISUAL_OPTION_DELTA;
     if(transcolor){
       vopts.flags |= NCVISUAL_OPTION_ADDALPHA;
     }
@@ -1,4 +1,8 @@
 #include "main.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 TEST_CASE("Blitting") {
   auto nc_ = testing_notcurses();
@@ -162,3 +166,493 @@ TEST_CASE("Blitting") {
 
   CHECK(!notcurses_stop(nc_));
 }
+
+static const blitsolve_e solveisas[] = {
+  BLITSOLVE_SCALAR, BLITSOLVE_SSE41, BLITSOLVE_AVX2,
+};
+
+static const char* solveisanames[] = { "scalar", "sse4.1", "avx2", };
+
+// fill 'px' with opaque pixels. 'palette' limits the number of distinct
+// values each channel takes, yielding ties among the solvers' candidates.
+static void
+solver_pixels(std::vector<uint32_t>& px, unsigned seed, unsigned palette){
+  for(size_t i = 0 ; i < px.size() ; ++i){
+    unsigned rnd = (i + seed) * 2654435761u;
+    rnd ^= rnd >> 13;
+    rnd *= 2246822519u;
+    uint32_t p = 0;
+    ncpixel_set_a(&p, 0xff);
+    ncpixel_set_r(&p, (rnd % palette) * (255 / (palette - 1)));
+    ncpixel_set_g(&p, ((rnd >> 8) % palette) * (255 / (palette - 1)));
+    ncpixel_set_b(&p, ((rnd >> 16) % palette) * (255 / (palette - 1)));
+    px[i] = p;
+  }
+}
+
+// every quadrant and sextant solver kernel must exactly match the scalar
+// kernel, for any number of cells.
+TEST_CASE("BlitSolvers") {
+  const int maxcells = 45;
+  std::vector<uint32_t> px(maxcells * 2 * 3);
+  const unsigned palettes[] = { 256, 5, 2, };
+  auto quadscalar = quadsolve_kernel(BLITSOLVE_SCALAR);
+  auto sexscalar = sexsolve_kernel(BLITSOLVE_SCALAR);
+  REQUIRE(nullptr != quadscalar);
+  REQUIRE(nullptr != sexscalar);
+  std::vector<unsigned char> egcs(maxcells), wegcs(maxcells);
+  std::vector<uint32_t> fg(maxcells), wfg(maxcells), bg(maxcells), wbg(maxcells);
+
+  SUBCASE("QuadrantKernelsAgree") {
+    for(size_t k = 1 ; k < sizeof(solveisas) / sizeof(*solveisas) ; ++k){
+      auto solve = quadsolve_kernel(solveisas[k]);
+      if(!solve){
+        continue;
+      }
+      for(unsigned palette : palettes){
+        for(unsigned seed = 0 ; seed < 64 ; ++seed){
+          solver_pixels(px, seed, palette);
+          const auto top = reinterpret_cast<const unsigned char*>(px.data());
+          const auto bot = reinterpret_cast<const unsigned char*>(px.data() + maxcells * 2);
+          const int n = maxcells - seed % 9;
+          quadscalar(top, bot, n, wegcs.data(), wfg.data(), wbg.data());
+          solve(top, bot, n, egcs.data(), fg.data(), bg.data());
+          for(int i = 0 ; i < n ; ++i){
+            CHECK(wegcs[i] == egcs[i]);
+            CHECK(wfg[i] == fg[i]);
+            CHECK(wbg[i] == bg[i]);
+          }
+        }
+      }
+    }
+  }
+
+  SUBCASE("SextantKernelsAgree") {
+    for(size_t k = 1 ; k < sizeof(solveisas) / sizeof(*solveisas) ; ++k){
+      auto solve = sexsolve_kernel(solveisas[k]);
+      if(!solve){
+        continue;
+      }
+      for(unsigned palette : palettes){
+        for(unsigned seed = 0 ; seed < 64 ; ++seed){
+          solver_pixels(px, seed, palette);
+          const auto base = reinterpret_cast<const unsigned char*>(px.data());
+          const unsigned char* const rows[3] = {
+            base, base + maxcells * 8, base + maxcells * 16,
+          };
+          const int n = maxcells - seed % 9;
+          sexscalar(rows, n, wegcs.data(), wfg.data(), wbg.data());
+          solve(rows, n, egcs.data(), fg.data(), bg.data());
+          for(int i = 0 ; i < n ; ++i){
+            CHECK(wegcs[i] == egcs[i]);
+            CHECK(wfg[i] == fg[i]);
+            CHECK(wbg[i] == bg[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// the cells of a blit must be those the scalar solvers produce, including
+// those solved by the kernels from within an offset and clipped image.
+TEST_CASE("BlitSolvedCells") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  if(!notcurses_canutf8(nc_)){
+    CHECK(!notcurses_stop(nc_));
+    return;
+  }
+  const int rows = 13;
+  const int cols = 71;
+  std::vector<uint32_t> px(rows * cols);
+  solver_pixels(px, 7, 6);
+  // we're examining the blitters, not the terminal; don't let them degrade
+  nc_->tcache.quadrants = true;
+  nc_->tcache.sextants = true;
+  const struct {
+    ncblitter_e blitter;
+    int rowsper;
+  } blitters[] = {
+    { NCBLIT_2x2, 2, },
+    { NCBLIT_3x2, 3, },
+  };
+  // blit from the second column of a plane too narrow for the image, so that
+  // its cells are clipped on the right
+  struct ncplane_options nopts{};
+  nopts.rows = rows;
+  nopts.cols = 30;
+  auto n = ncplane_create(notcurses_stdplane(nc_), &nopts);
+  REQUIRE(nullptr != n);
+  const int placex = 1;
+  const int cells = nopts.cols - placex;
+  std::vector<unsigned char> egcs(cells);
+  std::vector<uint32_t> fg(cells), bg(cells);
+  for(const auto& b : blitters){
+    auto ncv = ncvisual_from_rgba(px.data(), rows, cols * 4, cols);
+    REQUIRE(nullptr != ncv);
+    struct ncvisual_options vopts{};
+    vopts.n = n;
+    vopts.blitter = b.blitter;
+    vopts.x = placex;
+    CHECK(n == ncvisual_render(nc_, ncv, &vopts));
+    ncvisual_destroy(ncv);
+    for(int y = 0 ; (y + 1) * b.rowsper <= rows ; ++y){
+      const auto top = reinterpret_cast<const unsigned char*>(px.data() + y * b.rowsper * cols);
+      if(b.blitter == NCBLIT_2x2){
+        quadsolve_kernel(BLITSOLVE_SCALAR)(top, top + cols * 4, cells,
+                                           egcs.data(), fg.data(), bg.data());
+      }else{
+        const unsigned char* const band[3] = { top, top + cols * 4, top + cols * 8, };
+        sexsolve_kernel(BLITSOLVE_SCALAR)(band, cells, egcs.data(), fg.data(), bg.data());
+      }
+      for(int x = 0 ; x < cells ; ++x){
+        uint64_t channels;
+        uint16_t stylemask;
+        char* egc = ncplane_at_yx(n, y, placex + x, &stylemask, &channels);
+        REQUIRE(nullptr != egc);
+        // the foreground channel additionally carries the blitted quadrants
+        CHECK((fg[x] & CELL_BG_RGB_MASK) == ncchannels_fg_rgb(channels));
+        CHECK(bg[x] == ncchannels_bchannel(channels));
+        // both blitters' first EGC is the space
+        CHECK((0 == egcs[x]) == (0 == strcmp(egc, " ")));
+        free(egc);
+      }
+    }
+  }
+  ncplane_destroy(n);
+  CHECK(!notcurses_stop(nc_));
+}
+
+// fill every cell of 'n' with an EGC too long to be inlined, so that blitting
+// over them exercises the staging of spilled EGCs.
+static void
+spill_plane(ncplane* n){
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      CHECK(0 < ncplane_putegc_yx(n, y, x, "e\u0301\u0302", nullptr));
+    }
+  }
+}
+
+struct blitcell {
+  std::string egc;
+  uint16_t stylemask;
+  uint64_t channels;
+};
+
+static std::vector<blitcell>
+blitted_plane(ncplane* n){
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  std::vector<blitcell> cells;
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      blitcell bc;
+      char* egc = ncplane_at_yx(n, y, x, &bc.stylemask, &bc.channels);
+      REQUIRE(nullptr != egc);
+      bc.egc = egc;
+      free(egc);
+      cells.push_back(bc);
+    }
+  }
+  return cells;
+}
+
+// a blit split into bands of rows across the workpool must write exactly the
+// cells, and leave the cursor exactly where, the serial blit does.
+TEST_CASE("ParallelBlit") {
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN |
+                NCOPTION_PARALLEL_RENDER;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    return;
+  }
+  if(!notcurses_canutf8(nc_)){
+    CHECK(!notcurses_stop(nc_));
+    return;
+  }
+  nc_->tcache.quadrants = true;
+  nc_->tcache.sextants = true;
+  nc_->tcache.braille = true;
+  // a single-core machine gets no workpool; lend it one, so that we're
+  // banding regardless
+  ncworkpool* lent = nullptr;
+  if(!nc_->workpool){
+    lent = nc_->workpool = workpool_create(3);
+    REQUIRE(nullptr != lent);
+  }
+  const ncblitter_e blitters[] = {
+    NCBLIT_1x1, NCBLIT_2x1, NCBLIT_2x2, NCBLIT_3x2, NCBLIT_BRAILLE,
+  };
+  // an image rather taller than the plane, not a multiple of any blitter's
+  // geometry, placed such that it's clipped on the bottom and right
+  const int rows = 83;
+  const int cols = 97;
+  std::vector<uint32_t> px(rows * cols);
+  solver_pixels(px, 3, 7);
+  for(size_t i = 0 ; i < px.size() ; i += 5){
+    ncpixel_set_a(&px[i], 0); // some transparency, to exercise the blends
+  }
+  struct ncplane_options popts{};
+  popts.rows = 21;
+  popts.cols = 43;
+  auto n = ncplane_create(notcurses_stdplane(nc_), &popts);
+  REQUIRE(nullptr != n);
+  for(auto blitter : blitters){
+    auto ncv = ncvisual_from_rgba(px.data(), rows, cols * 4, cols);
+    REQUIRE(nullptr != ncv);
+    struct ncvisual_options vopts{};
+    vopts.n = n;
+    vopts.blitter = blitter;
+    vopts.y = 2;
+    vopts.x = 1;
+    spill_plane(n);
+    notcurses_set_blit_threshold(nc_, 0);
+    CHECK(n == ncvisual_render(nc_, ncv, &vopts));
+    auto serial = blitted_plane(n);
+    int sy, sx;
+    ncplane_cursor_yx(n, &sy, &sx);
+    spill_plane(n);
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    const uint64_t parallel = stats.parallel_blits;
+    CHECK(0 == notcurses_set_blit_threshold(nc_, 1));
+    CHECK(n == ncvisual_render(nc_, ncv, &vopts));
+    auto banded = blitted_plane(n);
+    int by, bx;
+    ncplane_cursor_yx(n, &by, &bx);
+    CHECK(sy == by);
+    CHECK(sx == bx);
+    REQUIRE(serial.size() == banded.size());
+    for(size_t i = 0 ; i < serial.size() ; ++i){
+      CHECK(serial[i].egc == banded[i].egc);
+      CHECK(serial[i].stylemask == banded[i].stylemask);
+      CHECK(serial[i].channels == banded[i].channels);
+    }
+    notcurses_stats(nc_, &stats);
+    CHECK(parallel < stats.parallel_blits);
+    ncvisual_destroy(ncv);
+  }
+  ncplane_destroy(n);
+  if(lent){
+    nc_->workpool = nullptr;
+    workpool_destroy(lent);
+  }
+  CHECK(!notcurses_stop(nc_));
+}
+
+// a delta blit must leave the plane exactly as erasing it and blitting afresh
+// would, while writing only those cells whose source pixels changed.
+TEST_CASE("DeltaBlit") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  if(!notcurses_canutf8(nc_)){
+    CHECK(!notcurses_stop(nc_));
+    return;
+  }
+  nc_->tcache.quadrants = true;
+  nc_->tcache.sextants = true;
+  nc_->tcache.braille = true;
+  const ncblitter_e blitters[] = {
+    NCBLIT_1x1, NCBLIT_2x1, NCBLIT_2x2, NCBLIT_3x2, NCBLIT_BRAILLE,
+  };
+  const int rows = 83;
+  const int cols = 97;
+  std::vector<uint32_t> px(rows * cols);
+  struct ncplane_options popts{};
+  popts.rows = 21;
+  popts.cols = 43;
+  auto n = ncplane_create(notcurses_stdplane(nc_), &popts);
+  REQUIRE(nullptr != n);
+  auto ref = ncplane_create(notcurses_stdplane(nc_), &popts);
+  REQUIRE(nullptr != ref);
+  // blit the current pixels into 'n' as a delta, and into 'ref' afresh,
+  // returning the cells written by the delta blit
+  auto frame = [&](struct ncvisual_options& vopts) -> uint64_t {
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    auto ncv = ncvisual_from_rgba(px.data(), rows, cols * 4, cols);
+    REQUIRE(nullptr != ncv);
+    vopts.n = n;
+    vopts.flags |= NCVISUAL_OPTION_DELTA;
+    CHECK(n == ncvisual_render(nc_, ncv, &vopts));
+    vopts.n = ref;
+    vopts.flags &= ~NCVISUAL_OPTION_DELTA;
+    ncplane_erase(ref);
+    CHECK(ref == ncvisual_render(nc_, ncv, &vopts));
+    ncvisual_destroy(ncv);
+    auto delta = blitted_plane(n);
+    auto fresh = blitted_plane(ref);
+    REQUIRE(delta.size() == fresh.size());
+    for(size_t i = 0 ; i < delta.size() ; ++i){
+      CHECK(delta[i].egc == fresh[i].egc);
+      CHECK(delta[i].stylemask == fresh[i].stylemask);
+      CHECK(delta[i].channels == fresh[i].channels);
+    }
+    notcurses_stats(nc_, &after);
+    return after.blitemissions - before.blitemissions;
+  };
+  // run through the blitters first serially, and then in bands
+  ncworkpool* lent = nullptr;
+  for(int banded = 0 ; banded < 2 ; ++banded){
+    if(banded){
+      if(!nc_->workpool){
+        lent = nc_->workpool = workpool_create(3);
+        REQUIRE(nullptr != lent);
+      }
+      notcurses_set_blit_threshold(nc_, 1);
+    }
+    for(auto blitter : blitters){
+      solver_pixels(px, 11, 7);
+      for(size_t i = 0 ; i < px.size() ; i += 7){
+        ncpixel_set_a(&px[i], 0);
+      }
+      ncplane_erase(n);
+      struct ncvisual_options vopts{};
+      vopts.blitter = blitter;
+      vopts.y = 1;
+      vopts.x = 2;
+      const uint64_t region = frame(vopts);
+      CHECK(0 < region);
+      // an unchanged frame writes nothing, and leaves the plane undamaged
+      CHECK(0 == ncpile_render(n));
+      CHECK(0 == frame(vopts));
+      CHECK(n->dirtymin > n->dirtymax);
+      // a change to a few pixels rewrites only their cells
+      for(int y = 10 ; y < 14 ; ++y){
+        for(int x = 9 ; x < 14 ; ++x){
+          px[y * cols + x] ^= 0x00ffffffu;
+        }
+      }
+      const uint64_t changed = frame(vopts);
+      CHECK(0 < changed);
+      CHECK(changed < region / 4);
+      // cells written other than by the blit are repaired
+      CHECK(0 < ncplane_putstr_yx(n, 5, 5, "notcurses"));
+      CHECK(9 <= frame(vopts));
+      // a blit with different placement clears what it no longer covers
+      vopts.y = 0;
+      vopts.x = 0;
+      CHECK(region <= frame(vopts));
+      CHECK(0 == frame(vopts));
+    }
+  }
+  if(lent){
+    nc_->workpool = nullptr;
+    workpool_destroy(lent);
+  }
+  ncplane_destroy(ref);
+  ncplane_destroy(n);
+  CHECK(!notcurses_stop(nc_));
+}
+
+// report the throughput of each cell blitter over the images in data/, and of
+// each quadrant and sextant solver kernel.
+TEST_CASE("BlitterBench" * doctest::skip(true)) {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  const char* images[] = {
+    "changes.jpg", "PurpleDrank.jpg", "aidsrobots.jpeg", "atma.png",
+    "chunli01.png", "worldmap.png",
+  };
+  const struct {
+    ncblitter_e blitter;
+    const char* name;
+  } blitters[] = {
+    { NCBLIT_1x1, "1x1", }, { NCBLIT_2x1, "2x1", }, { NCBLIT_2x2, "2x2", },
+    { NCBLIT_3x2, "3x2", }, { NCBLIT_BRAILLE, "braille", },
+  };
+  nc_->tcache.quadrants = true;
+  nc_->tcache.sextants = true;
+  const int reps = 20;
+  // a synthetic image is always available, even without multimedia support
+  const int synrows = 720;
+  const int syncols = 1280;
+  std::vector<uint32_t> synthetic(synrows * syncols);
+  for(int y = 0 ; y < synrows ; ++y){
+    for(int x = 0 ; x < syncols ; ++x){
+      uint32_t* p = &synthetic[y * syncols + x];
+      ncpixel_set_a(p, 0xff);
+      ncpixel_set_r(p, x * 255 / syncols);
+      ncpixel_set_g(p, y * 255 / synrows);
+      ncpixel_set_b(p, (x ^ y) & 0xff);
+    }
+  }
+  for(size_t i = 0 ; i <= sizeof(images) / sizeof(*images) ; ++i){
+    const char* image = "synthetic";
+    ncvisual* ncv;
+    if(i < sizeof(images) / sizeof(*images)){
+      image = images[i];
+      char* path = find_data(image);
+      ncv = ncvisual_from_file(path);
+      free(path);
+    }else{
+      ncv = ncvisual_from_rgba(synthetic.data(), synrows, syncols * 4, syncols);
+    }
+    if(!ncv){ // no multimedia support, or no such image
+      printf("%16s: couldn't load, skipping\n", image);
+      continue;
+    }
+    for(const auto& b : blitters){
+      struct ncvisual_options vopts{};
+      vopts.blitter = b.blitter;
+      vopts.flags = NCVISUAL_OPTION_NODEGRADE;
+      long cells = 0;
+      auto start = std::chrono::steady_clock::now();
+      for(int r = 0 ; r < reps ; ++r){
+        auto ncp = ncvisual_render(nc_, ncv, &vopts);
+        if(!ncp){
+          break;
+        }
+        cells += (long)ncplane_dim_y(ncp) * ncplane_dim_x(ncp);
+        ncplane_destroy(ncp);
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+      if(cells){
+        printf("%16s %8s: %12.0f cells/s\n", image, b.name, cells * 1e9 / ns);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+  // the solvers alone, over a synthetic band of 1024 cells
+  const int cells = 1024;
+  const int iters = 2000;
+  std::vector<uint32_t> px(cells * 2 * 3);
+  solver_pixels(px, 0, 256);
+  std::vector<unsigned char> egcs(cells);
+  std::vector<uint32_t> fg(cells), bg(cells);
+  const auto base = reinterpret_cast<const unsigned char*>(px.data());
+  const unsigned char* const band[3] = { base, base + cells * 8, base + cells * 16, };
+  for(size_t k = 0 ; k < sizeof(solveisas) / sizeof(*solveisas) ; ++k){
+    auto qsolve = quadsolve_kernel(solveisas[k]);
+    auto ssolve = sexsolve_kernel(solveisas[k]);
+    if(!qsolve || !ssolve){
+      continue;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < iters ; ++i){
+      qsolve(band[0], band[1], cells, egcs.data(), fg.data(), bg.data());
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < iters ; ++i){
+      ssolve(band, cells, egcs.data(), fg.data(), bg.data());
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto qns = std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+    auto sns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+    printf("%8s quadrant: %12.0f cells/s sextant: %12.0f cells/s\n", solveisanames[k],
+           (double)cells * iters * 1e9 / qns, (double)cells * iters * 1e9 / sns);
+  }
+  CHECK(!notcurses_stop(nc_));
+}
@@ -0,0 +1,158 @@
+#include "main.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const damagescan_e isas[] = {
+  DAMAGESCAN_SCALAR, DAMAGESCAN_SSE2, DAMAGESCAN_AVX2,
+};
+
+static const char* isanames[] = { "scalar", "sse2", "avx2", };
+
+// fill 'cells' and 'lastframe' with identical, varied, inline cells, and
+// reset the 'rvec' state alongside them
+static void
+identical_frames(std::vector<crender>& rvec, std::vector<nccell>& cells,
+                 std::vector<nccell>& lastframe, const ncplane* n){
+  for(size_t i = 0 ; i < rvec.size() ; ++i){
+    crender* r = &rvec[i];
+    memset(r, 0, sizeof(*r));
+    r->p = n;
+    nccell* c = &cells[i];
+    memset(c, 0, sizeof(*c));
+    unsigned rnd = i * 2654435761u;
+    c->gcluster = htole('A' + rnd % 26);
+    c->width = 1;
+    c->stylemask = (rnd >> 8) % 2 ? NCSTYLE_BOLD : NCSTYLE_NONE;
+    nccell_set_fg_rgb(c, rnd >> 8);
+    nccell_set_bg_rgb(c, rnd >> 4);
+    lastframe[i] = *c;
+  }
+}
+
+TEST_CASE("DamageScan") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+  const int count = 67;
+  std::vector<crender> rvec(count);
+  std::vector<nccell> cells(count);
+  std::vector<nccell> lastframe(count);
+
+  // the scalar kernel is always available
+  REQUIRE(nullptr != damagescan_kernel(DAMAGESCAN_SCALAR));
+
+  // every kernel must stop at the first cell which differs in any byte, or
+  // which postpaint() must otherwise handle itself
+  SUBCASE("KernelsAgree") {
+    for(size_t k = 0 ; k < sizeof(isas) / sizeof(*isas) ; ++k){
+      auto scan = damagescan_kernel(isas[k]);
+      if(!scan){
+        continue;
+      }
+      identical_frames(rvec, cells, lastframe, n_);
+      CHECK(count == scan(rvec.data(), cells.data(), lastframe.data(), count));
+      CHECK(0 == scan(rvec.data(), cells.data(), lastframe.data(), 0));
+      for(int stop = 0 ; stop < count ; ++stop){
+        for(int variant = 0 ; variant < 7 ; ++variant){
+          identical_frames(rvec, cells, lastframe, n_);
+          nccell* c = &cells[stop];
+          switch(variant){
+            case 0: c->gcluster = htole('z' + 1); break;
+            case 1: c->width = 2; break;
+            case 2: c->stylemask ^= NCSTYLE_ITALIC; break;
+            case 3: c->channels ^= 0x1ull; break;
+            case 4: rvec[stop].s.highcontrast = 1; break;
+            case 5: rvec[stop].s.damaged = 1; break;
+            case 6: // spilled, though its index matches lastframe
+              c->gcluster = htole(0x01000000ul);
+              lastframe[stop].gcluster = c->gcluster;
+              break;
+          }
+          CHECK(stop == scan(rvec.data(), cells.data(), lastframe.data(), count));
+          // a scan starting beyond the stopper runs to the end
+          CHECK(count - stop - 1 == scan(rvec.data() + stop + 1,
+                                         cells.data() + stop + 1,
+                                         lastframe.data() + stop + 1,
+                                         count - stop - 1));
+        }
+      }
+    }
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// time per-cell comparison (the original postpaint() strategy) against each
+// kernel followed by per-cell comparison of the cells which stopped it, as
+// postpaint() drives them, over frames with no changes, sparse changes, and
+// changes everywhere.
+TEST_CASE("DamageScanBench" * doctest::skip(true)) {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+  const int rows = 60;
+  const int cols = 200;
+  const int frames = 2000;
+  std::vector<crender> rvec(rows * cols);
+  std::vector<nccell> cells(rows * cols);
+  std::vector<nccell> pristine(rows * cols);
+  std::vector<nccell> lastframe(rows * cols);
+  egcpool pool{};
+  const struct {
+    const char* name;
+    int changeevery; // 0 for no changes
+  } scenarios[] = {
+    { "nochange", 0, },
+    { "sparse", 97, },
+    { "full", 1, },
+  };
+  for(const auto& scenario : scenarios){
+    identical_frames(rvec, cells, pristine, n_);
+    if(scenario.changeevery){
+      for(size_t i = 0 ; i < rvec.size() ; i += scenario.changeevery){
+        cells[i].channels ^= 0x10101ull;
+      }
+    }
+    // kernel -1 is the original cell-at-a-time comparison
+    for(int k = -1 ; k < (int)(sizeof(isas) / sizeof(*isas)) ; ++k){
+      damagescan_fxn scan = nullptr;
+      if(k >= 0 && (scan = damagescan_kernel(isas[k])) == nullptr){
+        continue;
+      }
+      unsigned damaged = 0;
+      auto start = std::chrono::steady_clock::now();
+      for(int f = 0 ; f < frames ; ++f){
+        lastframe = pristine;
+        for(int y = 0 ; y < rows ; ++y){
+          crender* rrow = &rvec[y * cols];
+          nccell* crow = &cells[y * cols];
+          nccell* lrow = &lastframe[y * cols];
+          bool scanning = scan;
+          for(int x = 0 ; x < cols ; ++x){
+            if(scanning && (x += scan(rrow + x, crow + x, lrow + x, cols - x)) == cols){
+              break;
+            }
+            int d = cellcmp_and_dupfar(&pool, &lrow[x], n_, &crow[x]);
+            scanning = scan && !d;
+            damaged += d;
+          }
+        }
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+      CHECK(damaged == frames * (scenario.changeevery ?
+                                 (rvec.size() + scenario.changeevery - 1) / scenario.changeevery : 0));
+      printf("%8s %8s: %10.1f ns/frame\n", scenario.name,
+             k < 0 ? "percell" : isanames[k], ns / (double)frames);
+    }
+  }
+  egcpool_dump(&pool);
+  CHECK(0 == notcurses_stop(nc_));
+}
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <random>
+#include <string>
 #include <vector>
 #include "main.h"
 #include "egcpool.h"
@@ -204,6 +207,84 @@ TEST_CASE("EGCpool") {
     CHECK(candidates.size() / 13 > no);
   }
 
+  // a released block serves the next cluster of its size class
+  SUBCASE("ReuseReleased") {
+    const char* wstr = "\u8840"; // three bytes, four with NUL
+    const char* ostr = "\u00e0\u00e0"; // four bytes, five with NUL
+    int o1 = egcpool_stash(&pool_, wstr, strlen(wstr));
+    int o2 = egcpool_stash(&pool_, ostr, strlen(ostr));
+    REQUIRE(0 <= o1);
+    REQUIRE(o1 < o2);
+    auto hiwater = pool_.poolwrite;
+    egcpool_release(&pool_, o1);
+    egcpool_release(&pool_, o1); // releasing a free block is a no-op
+    CHECK(strlen(ostr) + 1 == static_cast<size_t>(pool_.poolused));
+    int o3 = egcpool_stash(&pool_, ostr, strlen(ostr)); // larger class
+    CHECK(o3 != o1);
+    int o4 = egcpool_stash(&pool_, "\u00e1", strlen("\u00e1"));
+    CHECK(o4 == o1);
+    CHECK(!strcmp(pool_.pool + o4, "\u00e1"));
+    CHECK(!strcmp(pool_.pool + o2, ostr));
+    CHECK(!strcmp(pool_.pool + o3, ostr));
+    CHECK(hiwater < pool_.poolwrite);
+  }
+
+  SUBCASE("Interning") {
+    pool_.intern = true;
+    const char* wstr = "\U0001F3F3\uFE0F\u200D\U0001F308"; // rainbow flag
+    size_t ulen = strlen(wstr);
+    int o1 = egcpool_stash(&pool_, wstr, ulen);
+    int o2 = egcpool_stash(&pool_, wstr, ulen);
+    REQUIRE(0 <= o1);
+    CHECK(o1 == o2);
+    CHECK(ulen + 1 == static_cast<size_t>(pool_.poolused));
+    int o3 = egcpool_stash(&pool_, "\u8840", strlen("\u8840"));
+    CHECK(o3 != o1);
+    egcpool_release(&pool_, o1);
+    CHECK(!strcmp(pool_.pool + o2, wstr)); // one reference remains
+    CHECK(ulen + strlen("\u8840") + 2 == static_cast<size_t>(pool_.poolused));
+    egcpool_release(&pool_, o2);
+    CHECK('\0' == pool_.pool[o2]);
+    CHECK(strlen("\u8840") + 1 == pool_.poolused);
+    CHECK(1 == pool_.interncount);
+    // a fresh stash gets a fresh reference count
+    int o4 = egcpool_stash(&pool_, wstr, ulen);
+    CHECK(o4 == o1);
+    egcpool_release(&pool_, o4);
+    CHECK('\0' == pool_.pool[o4]);
+    // many distinct clusters, interned several times apiece, force the table
+    // to grow; all must remain distinct and correct.
+    std::vector<int> offsets;
+    for(int rep = 0 ; rep < 3 ; ++rep){
+      for(wchar_t w = 0x4e00 ; w < 0x5e00 ; ++w){
+        char mb[MB_CUR_MAX + 1];
+        auto r = wctomb(mb, w);
+        REQUIRE(0 < r);
+        int o = egcpool_stash(&pool_, mb, r);
+        REQUIRE(0 <= o);
+        if(rep == 0){
+          offsets.push_back(o);
+        }else{
+          CHECK(offsets[w - 0x4e00] == o);
+        }
+      }
+    }
+    CHECK(0x1001 == pool_.interncount);
+    for(int rep = 0 ; rep < 3 ; ++rep){
+      for(wchar_t w = 0x4e00 ; w < 0x5e00 ; w += 2){
+        egcpool_release(&pool_, offsets[w - 0x4e00]);
+      }
+    }
+    CHECK(0x801 == pool_.interncount);
+    for(wchar_t w = 0x4e01 ; w < 0x5e00 ; w += 2){
+      char mb[MB_CUR_MAX + 1];
+      auto r = wctomb(mb, w);
+      mb[r] = '\0';
+      CHECK(!strcmp(mb, pool_.pool + offsets[w - 0x4e00]));
+      CHECK(offsets[w - 0x4e00] == egcpool_stash(&pool_, mb, r));
+    }
+  }
+
   // common cleanup
   egcpool_dump(&pool_);
 
@@ -211,6 +292,148 @@ TEST_CASE("EGCpool") {
 
 }
 
+// fill 'n' with distinct wide EGCs of five bytes (a CJK ideograph with a
+// combining acute accent).
+static void
+fill_distinct_egcs(struct ncplane* n){
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  wchar_t w = 0x4e00;
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x + 1 < dimx ; x += 2){
+      wchar_t wcs[] = { w++, 0x0301, 0 };
+      REQUIRE(2 == ncplane_putwstr_yx(n, y, x, wcs));
+    }
+  }
+}
+
+static auto
+egc_at(struct ncplane* n, int y, int x) -> std::string {
+  char* egc = ncplane_at_yx(n, y, x, nullptr, nullptr);
+  REQUIRE(egc);
+  std::string ret = egc;
+  free(egc);
+  return ret;
+}
+
+TEST_CASE("EGCpoolCompaction") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  if(!notcurses_canutf8(nc_)){
+    CHECK(0 == notcurses_stop(nc_));
+    return;
+  }
+
+  SUBCASE("PoolLevel") {
+    egcpool pool{};
+    pool.intern = true;
+    std::vector<nccell> cells(4096);
+    std::vector<std::string> egcs;
+    for(size_t i = 0 ; i < cells.size() ; ++i){
+      egcs.push_back("x" + std::to_string(i));
+      nccell_init(&cells[i]);
+      int o = egcpool_stash(&pool, egcs[i].c_str(), egcs[i].size());
+      REQUIRE(0 <= o);
+      set_gcluster_egc(&cells[i], o);
+    }
+    CHECK(cells.size() == pool.stashes);
+    for(size_t i = 0 ; i < cells.size() ; ++i){
+      if(i % 16){
+        pool_release(&pool, &cells[i]);
+      }
+    }
+    CHECK(egcpool_sparse_p(&pool));
+    const int oldsize = pool.poolsize;
+    nccell extra = CELL_TRIVIAL_INITIALIZER;
+    int o = egcpool_stash(&pool, "outside", strlen("outside"));
+    REQUIRE(0 <= o);
+    set_gcluster_egc(&extra, o);
+    // provide the cells as two spans, with an absent span between them
+    const size_t half = cells.size() / 2;
+    nccell* spans[] = { cells.data(), nullptr, cells.data() + half, };
+    const size_t lens[] = { half, 1, cells.size() - half, };
+    // 'extra' isn't among the cells we provide, so we can't compact
+    CHECK(0 > egcpool_compact(&pool, spans, lens, 3, nullptr));
+    CHECK(oldsize == pool.poolsize);
+    int reclaimed = egcpool_compact(&pool, spans, lens, 3, &extra);
+    CHECK(0 < reclaimed);
+    CHECK(oldsize - reclaimed == pool.poolsize);
+    CHECK(!egcpool_sparse_p(&pool));
+    CHECK(cells.size() / 16 + 1 == pool.stashes);
+    CHECK(!strcmp("outside", egcpool_extended_gcluster(&pool, &extra)));
+    for(size_t i = 0 ; i < cells.size() ; i += 16){
+      CHECK(egcs[i] == egcpool_extended_gcluster(&pool, &cells[i]));
+    }
+    // the rebuilt pool must still intern
+    o = egcpool_stash(&pool, egcs[0].c_str(), egcs[0].size());
+    CHECK(cell_egc_idx(&cells[0]) == (unsigned)o);
+    egcpool_release(&pool, o);
+    egcpool_dump(&pool);
+  }
+
+  SUBCASE("Plane") {
+    struct ncplane_options nopts{};
+    nopts.rows = 50;
+    nopts.cols = 200;
+    auto n = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    REQUIRE(n);
+    fill_distinct_egcs(n);
+    const int oldsize = n->pool.poolsize;
+    CHECK(!egcpool_sparse_p(&n->pool));
+    std::string kept = egc_at(n, 7, 20);
+    // an outstanding nccell loaded against the plane blocks compaction
+    nccell c = CELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < nccell_load(n, &c, "\U0001F3F3\uFE0F\u200D\U0001F308"));
+    CHECK(0 > ncplane_compact(n));
+    nccell_release(n, &c);
+    CHECK(0 == ncplane_compact(n));
+    CHECK(kept == egc_at(n, 7, 20));
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(1 == stats.pool_compactions);
+    // now leave only one row of glyphs, and see it compacted at render
+    for(int y = 0 ; y < 50 ; ++y){
+      if(y != 7){
+        REQUIRE(0 == ncplane_cursor_move_yx(n, y, 0));
+        for(int x = 0 ; x < 200 ; ++x){
+          REQUIRE(1 == ncplane_putchar(n, ' '));
+        }
+      }
+    }
+    CHECK(egcpool_sparse_p(&n->pool));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(n->pool.poolsize < oldsize);
+    CHECK(kept == egc_at(n, 7, 20));
+    notcurses_stats(nc_, &stats);
+    CHECK(2 == stats.pool_compactions);
+    CHECK(static_cast<uint64_t>(oldsize - n->pool.poolsize) == stats.pool_bytes_reclaimed);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("Resize") {
+    struct ncplane_options nopts{};
+    nopts.rows = 50;
+    nopts.cols = 200;
+    auto n = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    REQUIRE(n);
+    fill_distinct_egcs(n);
+    const int oldsize = n->pool.poolsize;
+    std::string kept = egc_at(n, 10, 10);
+    REQUIRE(0 == ncplane_resize(n, 10, 10, 2, 20, 0, 0, 2, 20));
+    CHECK(n->pool.poolsize < oldsize);
+    CHECK(20 == n->pool.stashes);
+    CHECK(kept == egc_at(n, 0, 0));
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(1 == stats.pool_compactions);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
 TEST_CASE("EGCpoolLong" * doctest::skip(true)) {
   egcpool pool_{};
 
@@ -243,3 +466,45 @@ TEST_CASE("EGCpoolLong" * doctest::skip(true)) {
   egcpool_dump(&pool_);
 
 }
+
+// random stash/release churn over emoji-dense text, as seen in a busy chat
+// pane, with and without interning. the working set is held roughly constant.
+TEST_CASE("EGCpoolBench" * doctest::skip(true)) {
+  const char* egcs[] = {
+    "\U0001F600", "\U0001F602", "\U0001F44D\U0001F3FD", "\u2764\uFE0F",
+    "\U0001F525", "\U0001F468\u200D\U0001F469\u200D\U0001F467\u200D\U0001F466",
+    "\U0001F3F3\uFE0F\u200D\U0001F308", "\U0001F1FA\U0001F1F8",
+    "\U0001F9D1\U0001F3FF\u200D\U0001F4BB", "\u00e0\u0301", "\u8840",
+    "\U0001F469\u200D\u2764\uFE0F\u200D\U0001F48B\u200D\U0001F468",
+  };
+  const size_t egccount = sizeof(egcs) / sizeof(*egcs);
+  const int ops = 1 << 22;
+  const size_t live = 1 << 16;
+  for(int intern = 0 ; intern < 2 ; ++intern){
+    egcpool pool{};
+    pool.intern = intern;
+    std::mt19937 rng(0x5eed); // same sequence for both runs
+    std::vector<int> offsets;
+    offsets.reserve(live * 2);
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < ops ; ++i){
+      if(offsets.size() < live || rng() % 2){
+        const char* egc = egcs[rng() % egccount];
+        int o = egcpool_stash(&pool, egc, strlen(egc));
+        REQUIRE(0 <= o);
+        offsets.push_back(o);
+      }else{
+        size_t victim = rng() % offsets.size();
+        egcpool_release(&pool, offsets[victim]);
+        offsets[victim] = offsets.back();
+        offsets.pop_back();
+      }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    printf("%9s: %6.1f ns/op, %zu live, %d used, %d bytes\n",
+           intern ? "interned" : "distinct", ns / (double)ops,
+           offsets.size(), pool.poolused, pool.poolsize);
+    egcpool_dump(&pool);
+  }
+}
@@ -1,4 +1,7 @@
 #include "main.h"
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST_CASE("Piles") {
   auto nc_ = testing_notcurses();
@@ -278,6 +281,196 @@ notcurses_debug(nc_, stderr);
     ncplane_destroy(gen3);
   }
 
+  // hit testing must track creation, movement, resizing, z-axis changes, and
+  // reparenting, among many planes mostly off-screen.
+  SUBCASE("PlaneAtYX") {
+    CHECK(n_ == ncpile_plane_at_yx(n_, 0, 0));
+    CHECK(nullptr == ncpile_plane_at_yx(n_, -1, 0));
+    CHECK(nullptr == ncpile_plane_at_yx(n_, dimy, 0));
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 4;
+    std::vector<struct ncplane*> offscreen;
+    for(int i = 0 ; i < 1000 ; ++i){
+      nopts.y = dimy + i;
+      nopts.x = -2;
+      auto n = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != n);
+      offscreen.push_back(n);
+    }
+    nopts.y = 2;
+    nopts.x = 2;
+    nopts.rows = 3;
+    nopts.cols = 3;
+    auto a = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != a);
+    nopts.y = 3;
+    nopts.x = 3;
+    auto b = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != b);
+    auto child = ncplane_create(b, &nopts);
+    REQUIRE(nullptr != child);
+    CHECK(offscreen[500] == ncpile_plane_at_yx(n_, dimy + 500, 0));
+    CHECK(offscreen[500] == ncpile_plane_at_yx(n_, dimy + 500, -2));
+    CHECK(n_ == ncpile_plane_at_yx(n_, dimy - 1, 2));
+    CHECK(a == ncpile_plane_at_yx(n_, 2, 2));
+    CHECK(b == ncpile_plane_at_yx(n_, 4, 4));
+    CHECK(child == ncpile_plane_at_yx(n_, 6, 6));
+    ncplane_move_top(a);
+    CHECK(a == ncpile_plane_at_yx(n_, 4, 4));
+    CHECK(0 == ncplane_move_below(a, b));
+    CHECK(b == ncpile_plane_at_yx(n_, 4, 4));
+    ncplane_move_bottom(b);
+    CHECK(a == ncpile_plane_at_yx(n_, 4, 4));
+    CHECK(n_ == ncpile_plane_at_yx(n_, 5, 5));
+    // moving b carries its child along
+    CHECK(0 == ncplane_move_yx(b, 100, 100));
+    CHECK(b == ncpile_plane_at_yx(n_, 100, 100));
+    CHECK(child == ncpile_plane_at_yx(n_, 103, 103));
+    CHECK(a == ncpile_plane_at_yx(n_, 4, 4));
+    CHECK(0 == ncplane_resize_simple(a, 400, 1000));
+    CHECK(a == ncpile_plane_at_yx(n_, 300, 900));
+    // a render paints the visible planes in z-order
+    CHECK(0 < ncplane_putstr_yx(a, 0, 0, "a"));
+    CHECK(0 < ncplane_putstr_yx(offscreen[0], 0, 0, "off"));
+    CHECK(0 == notcurses_render(nc_));
+    char* egc = notcurses_at_yx(nc_, 2, 2, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "a"));
+    free(egc);
+    // b and its child leave for a new pile
+    CHECK(b == ncplane_reparent_family(b, b));
+    CHECK(a == ncpile_plane_at_yx(n_, 103, 103));
+    CHECK(child == ncpile_plane_at_yx(b, 103, 103));
+    CHECK(b == ncpile_plane_at_yx(b, 100, 100));
+    CHECK(nullptr == ncpile_plane_at_yx(b, 0, 0));
+    CHECK(0 == ncplane_move_yx(child, 10, 10));
+    CHECK(child == ncpile_plane_at_yx(b, 110, 110));
+    CHECK(0 == ncplane_destroy(child));
+    CHECK(nullptr == ncpile_plane_at_yx(b, 110, 110));
+    CHECK(0 == ncplane_destroy(b));
+    CHECK(0 == ncplane_destroy(a));
+    for(auto n : offscreen){
+      CHECK(0 == ncplane_destroy(n));
+    }
+    CHECK(n_ == ncpile_plane_at_yx(n_, 4, 4));
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
+
+// render a pile from each of several threads, each modifying its own pile
+// between renders. every pile must then rasterize to exactly its planes, and
+// each render must have been counted.
+static void
+render_piles_concurrently(struct notcurses* nc, int dimy, int dimx){
+  const int pilecount = 8;
+  const int rounds = 50;
+  std::vector<struct ncplane*> piles;
+  std::vector<struct ncplane*> children;
+  for(int i = 0 ; i < pilecount ; ++i){
+    struct ncplane_options nopts{};
+    nopts.rows = dimy;
+    nopts.cols = dimx;
+    auto p = ncpile_create(nc, &nopts);
+    REQUIRE(nullptr != p);
+    // a child plane, so that each render composes more than one plane
+    nopts.y = i;
+    nopts.x = i;
+    nopts.rows = dimy / 2;
+    nopts.cols = dimx / 2;
+    auto child = ncplane_create(p, &nopts);
+    REQUIRE(nullptr != child);
+    piles.push_back(p);
+    children.push_back(child);
+  }
+  ncstats before, after;
+  notcurses_stats(nc, &before);
+  std::vector<std::thread> threads;
+  std::vector<int> failures(pilecount);
+  for(int i = 0 ; i < pilecount ; ++i){
+    threads.emplace_back([&, i](){
+      struct ncplane* p = piles[i];
+      struct ncplane* child = children[i];
+      for(int r = 0 ; r < rounds ; ++r){
+        ncplane_set_fg_rgb8(p, i * 31, r * 5, 255 - i * 31);
+        std::string row(dimx, 'a' + (i + r) % 26);
+        if(ncplane_putstr_yx(p, r % dimy, 0, row.c_str()) <= 0){
+          ++failures[i];
+        }
+        if(ncplane_putchar_yx(child, r % (dimy / 2), r % (dimx / 2), 'A' + i) <= 0){
+          ++failures[i];
+        }
+        if(ncplane_move_yx(child, (i + r) % (dimy / 2), (i + r) % (dimx / 2))){
+          ++failures[i];
+        }
+        if(ncpile_render(p)){
+          ++failures[i];
+        }
+      }
+    });
+  }
+  for(auto& t : threads){
+    t.join();
+  }
+  for(int i = 0 ; i < pilecount ; ++i){
+    CHECK(0 == failures[i]);
+  }
+  notcurses_stats(nc, &after);
+  CHECK(pilecount * rounds == after.renders - before.renders);
+  // rasterize each pile in turn, and compare what was rendered to a fresh
+  // serial render of the same pile
+  for(auto p : piles){
+    CHECK(0 == ncpile_rasterize(p));
+    std::vector<std::string> concurrent;
+    for(int y = 0 ; y < dimy ; ++y){
+      for(int x = 0 ; x < dimx ; ++x){
+        uint16_t style;
+        uint64_t channels;
+        char* egc = notcurses_at_yx(nc, y, x, &style, &channels);
+        REQUIRE(nullptr != egc);
+        concurrent.emplace_back(std::string(egc) + std::to_string(channels));
+        free(egc);
+      }
+    }
+    ncplane_pile(p)->repaint = true;
+    CHECK(0 == ncpile_render(p));
+    CHECK(0 == ncpile_rasterize(p));
+    int mismatched = 0;
+    for(int y = 0 ; y < dimy ; ++y){
+      for(int x = 0 ; x < dimx ; ++x){
+        uint16_t style;
+        uint64_t channels;
+        char* egc = notcurses_at_yx(nc, y, x, &style, &channels);
+        REQUIRE(nullptr != egc);
+        if(concurrent[y * dimx + x] != std::string(egc) + std::to_string(channels)){
+          ++mismatched;
+        }
+        free(egc);
+      }
+    }
+    CHECK(0 == mismatched);
+  }
+  for(int i = 0 ; i < pilecount ; ++i){
+    CHECK(0 == ncplane_destroy(children[i]));
+    CHECK(0 == ncplane_destroy(piles[i]));
+  }
+}
+
+// piles are independent, and can be rendered concurrently from different
+// threads, whether or not each render is itself banded across the workpool.
+TEST_CASE("ConcurrentPiles") {
+  for(uint64_t flags : { 0ull, (unsigned long long)NCOPTION_PARALLEL_RENDER, }){
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN | flags;
+    auto nc_ = notcurses_init(&nopts, nullptr);
+    if(!nc_){
+      return;
+    }
+    int dimy, dimx;
+    notcurses_stddim_yx(nc_, &dimy, &dimx);
+    render_piles_concurrently(nc_, dimy, dimx);
+    CHECK(0 == notcurses_stop(nc_));
+  }
+}
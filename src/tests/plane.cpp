@@ -987,6 +987,161 @@ TEST_CASE("Plane") {
     ncplane_destroy(n1);
   }
 
+  // destroyed planes and their framebuffers are recycled, up to a limit
+  SUBCASE("RecycledPlanes") {
+    struct ncplane_options nopts{};
+    nopts.rows = 10;
+    nopts.cols = 10;
+    // 100 cells lie in the class of 112
+    const uint64_t cached = sizeof(ncplane) + sizeof(nccell) * 112;
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    CHECK(0 < ncplane_putstr(n, "dirty"));
+    CHECK(0 == ncplane_destroy(n));
+    notcurses_stats(nc_, &after);
+    CHECK(before.slab_bytes + cached == after.slab_bytes);
+    // 99 cells lie in the same class, and get a clean plane
+    nopts.rows = 9;
+    nopts.cols = 11;
+    n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    notcurses_stats(nc_, &after);
+    CHECK(before.slab_bytes == after.slab_bytes);
+    CHECK(before.slab_hits + 2 == after.slab_hits);
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, ""));
+    CHECK(0 == channels);
+    free(egc);
+    // a resize returns the old framebuffer to the cache, and draws on it
+    CHECK(0 == ncplane_resize_simple(n, 10, 10));
+    notcurses_stats(nc_, &after);
+    CHECK(before.slab_bytes + sizeof(nccell) * 112 == after.slab_bytes);
+    CHECK(before.slab_hits + 2 == after.slab_hits);
+    CHECK(0 == ncplane_resize_simple(n, 11, 9));
+    notcurses_stats(nc_, &after);
+    CHECK(before.slab_bytes + sizeof(nccell) * 112 == after.slab_bytes);
+    CHECK(before.slab_hits + 3 == after.slab_hits);
+    // a limit of 0 sheds everything, and caches nothing further
+    size_t oldlimit = notcurses_set_cache_limit(nc_, 0);
+    CHECK(0 < oldlimit);
+    CHECK(0 == ncplane_destroy(n));
+    notcurses_stats(nc_, &after);
+    CHECK(0 == after.slab_bytes);
+    CHECK(0 == notcurses_set_cache_limit(nc_, oldlimit));
+    // framebuffers of classes beyond 4MiB are allocated (and accounted) at
+    // their exact size, and never cached, whatever the limit
+    nopts.rows = 1000;
+    nopts.cols = 300;
+    oldlimit = notcurses_set_cache_limit(nc_, 1u << 30u);
+    notcurses_stats(nc_, &before);
+    n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes + sizeof(nccell) * 300000 == after.fbbytes);
+    CHECK(0 == ncplane_destroy(n));
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes == after.fbbytes);
+    CHECK(before.slab_bytes + sizeof(ncplane) == after.slab_bytes);
+    CHECK(1u << 30u == notcurses_set_cache_limit(nc_, oldlimit));
+  }
+
+  SUBCASE("SparsePlanes") {
+    struct ncplane_options nopts{};
+    nopts.rows = 200000;
+    nopts.cols = 80;
+    nopts.flags = NCPLANE_OPTION_SPARSE;
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes == after.fbbytes);
+    // writing allocates only the band of rows holding the cursor
+    CHECK(0 < ncplane_putstr_yx(n, 150000, 10, "sparse"));
+    CHECK(0 < ncplane_putstr_yx(n, 150001, 10, "again"));
+    notcurses_stats(nc_, &after);
+    const uint64_t tilebytes = sizeof(nccell) * 64 * 80;
+    CHECK(before.fbbytes + tilebytes == after.fbbytes);
+    CHECK(0 < ncplane_putstr_yx(n, 5, 0, "top"));
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes + 2 * tilebytes == after.fbbytes);
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 150000, 10, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "s"));
+    free(egc);
+    egc = ncplane_at_yx(n, 100000, 10, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, ""));
+    CHECK(0 == channels);
+    free(egc);
+    // unwritten cells render as the base cell
+    CHECK(0 < ncplane_set_base(n, ".", 0, 0));
+    CHECK(0 == notcurses_render(nc_));
+    egc = notcurses_at_yx(nc_, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "."));
+    free(egc);
+    egc = notcurses_at_yx(nc_, 5, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "t"));
+    free(egc);
+    // narrowing retains the written bands, and nothing else
+    CHECK(0 == ncplane_resize(n, 0, 0, 200000, 40, 0, 0, 200000, 40));
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes + tilebytes == after.fbbytes);
+    egc = ncplane_at_yx(n, 150001, 10, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "a"));
+    free(egc);
+    auto dup = ncplane_dup(n, nullptr);
+    REQUIRE(dup);
+    egc = ncplane_at_yx(dup, 150000, 11, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "p"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(0 == ncplane_compact(n));
+    egc = ncplane_at_yx(n, 5, 1, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "o"));
+    free(egc);
+    // erasing returns the plane to its unwritten state
+    ncplane_erase(n);
+    notcurses_stats(nc_, &after);
+    CHECK(before.fbbytes == after.fbbytes);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("SparseScrolling") {
+    struct ncplane_options nopts{};
+    nopts.rows = 3;
+    nopts.cols = 10;
+    nopts.flags = NCPLANE_OPTION_SPARSE;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    ncplane_set_scrolling(n, true);
+    CHECK(0 < ncplane_putstr(n, "a\nb\nc\nd"));
+    for(int y = 0 ; y < 3 ; ++y){
+      char* egc = ncplane_at_yx(n, y, 0, nullptr, nullptr);
+      REQUIRE(egc);
+      CHECK(egc[0] == 'b' + y);
+      CHECK(egc[1] == '\0');
+      free(egc);
+    }
+    // a resize lays the rows back out from the top
+    CHECK(0 == ncplane_resize_simple(n, 2, 10));
+    char* egc = ncplane_at_yx(n, 1, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "c"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -0,0 +1,1398 @@
+#include "main.h"
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wchar.h>
+
+struct rendered_cell {
+  nccell c;
+  crender r;
+  crenderaux aux;
+};
+
+// snapshot the pile's most recent render
+static auto
+rendered_pile(struct ncplane* n) -> std::vector<rendered_cell> {
+  const ncpile* pile = ncplane_pile_const(n);
+  std::vector<rendered_cell> cells;
+  for(int i = 0 ; i < pile->dimy * pile->dimx ; ++i){
+    cells.push_back({pile->rvec.cells[i], pile->rvec.crender[i], pile->rvec.aux[i]});
+  }
+  return cells;
+}
+
+static bool
+crender_eq(const rendered_cell& c1, const rendered_cell& c2){
+  return c1.r.p == c2.r.p && c1.c.gcluster == c2.c.gcluster &&
+         c1.c.width == c2.c.width && c1.c.stylemask == c2.c.stylemask &&
+         c1.c.channels == c2.c.channels &&
+         (!c1.r.s.highcontrast || c1.aux.hcfg == c2.aux.hcfg) &&
+         (!c1.r.s.sprixeled || c1.aux.sprixel == c2.aux.sprixel) &&
+         c1.r.s.blittedquads == c2.r.s.blittedquads &&
+         c1.r.s.highcontrast == c2.r.s.highcontrast &&
+         c1.r.s.fgblends == c2.r.s.fgblends && c1.r.s.bgblends == c2.r.s.bgblends &&
+         c1.r.s.hcfgblends == c2.r.s.hcfgblends && c1.r.s.sprixeled == c2.r.s.sprixeled &&
+         c1.r.s.p_beats_sprixel == c2.r.s.p_beats_sprixel;
+}
+
+// fill a plane with a pattern of narrow and wide glyphs, styles, and
+// (sometimes blended) colors, all derived from 'seed'
+static void
+pattern_plane(struct ncplane* n, unsigned seed){
+  static const char* egcs[] = { "a", "█", "Ж", "▚", "🐸", "字", " ", "⎧", };
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    ncplane_cursor_move_yx(n, y, 0);
+    for(int x = 0 ; x < dimx ; ++x){
+      unsigned r = seed * 2654435761u + y * 40503u + x * 69069u;
+      ncplane_set_fg_rgb8(n, r % 256, (r >> 8) % 256, (r >> 16) % 256);
+      ncplane_set_bg_rgb8(n, (r >> 4) % 256, (r >> 12) % 256, (r >> 20) % 256);
+      ncplane_set_bg_alpha(n, (r >> 24) % 3 ? CELL_ALPHA_OPAQUE : CELL_ALPHA_BLEND);
+      ncplane_set_styles(n, (r >> 27) % 2 ? NCSTYLE_BOLD : NCSTYLE_NONE);
+      if(ncplane_putstr(n, egcs[(r >> 28) % (sizeof(egcs) / sizeof(*egcs))]) <= 0){
+        break; // wide glyph didn't fit on this row
+      }
+      ncplane_cursor_yx(n, nullptr, &x);
+      --x;
+    }
+  }
+}
+
+// snapshot the last rasterized frame. the right halves of wide glyphs take
+// their styling from whichever frame last damaged them, so ignore it.
+static auto
+rasterized_frame(struct notcurses* nc) -> std::vector<std::string> {
+  std::vector<std::string> frame;
+  for(int y = 0 ; y < nc->lfdimy ; ++y){
+    for(int x = 0 ; x < nc->lfdimx ; ++x){
+      uint16_t stylemask;
+      uint64_t channels;
+      auto egc = notcurses_at_yx(nc, y, x, &stylemask, &channels);
+      REQUIRE(nullptr != egc);
+      std::string rc = egc;
+      free(egc);
+      if(rc.size()){
+        rc += "/" + std::to_string(stylemask);
+      }
+      frame.push_back(rc + "/" + std::to_string(channels));
+    }
+  }
+  return frame;
+}
+
+// render (incrementally, if nothing forces otherwise), and then render anew
+// from scratch. the results ought be identical.
+static void
+check_incremental_render(struct notcurses* nc){
+  CHECK(0 == notcurses_render(nc));
+  auto incremental = rasterized_frame(nc);
+  ncplane_pile(notcurses_stdplane(nc))->repaint = true;
+  nc->lastpile = nullptr;
+  CHECK(0 == notcurses_render(nc));
+  auto full = rasterized_frame(nc);
+  CHECK(incremental == full);
+}
+
+TEST_CASE("ParallelRender") {
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN |
+                NCOPTION_PARALLEL_RENDER;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    return;
+  }
+  int dimy, dimx;
+  struct ncplane* n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(nullptr != n_);
+
+  // a stack of overlapping planes, some partially offscreen, must render
+  // identically whether or not it's painted in bands
+  SUBCASE("BandedMatchesSerial") {
+    pattern_plane(n_, 0);
+    struct ncplane_options opts{};
+    struct ncplane* planes[4];
+    for(int i = 0 ; i < 4 ; ++i){
+      opts.y = i * dimy / 4 - 3;
+      opts.x = i * 7 - 2;
+      opts.rows = dimy / 2 + i;
+      opts.cols = dimx / 2 + i * 3;
+      planes[i] = ncplane_create(n_, &opts);
+      REQUIRE(nullptr != planes[i]);
+      pattern_plane(planes[i], i + 1);
+      if(i % 2){
+        uint64_t channels = 0;
+        ncchannels_set_fg_alpha(&channels, CELL_ALPHA_TRANSPARENT);
+        ncchannels_set_bg_alpha(&channels, CELL_ALPHA_BLEND);
+        ncplane_set_base(planes[i], "", 0, channels);
+      }
+    }
+    ncworkpool* pool = nc_->workpool;
+    nc_->workpool = nullptr;
+    CHECK(0 == ncpile_render(n_));
+    auto serial = rendered_pile(n_);
+    nc_->workpool = pool;
+    ncplane_pile(n_)->repaint = true;
+    CHECK(0 == ncpile_render(n_));
+    auto banded = rendered_pile(n_);
+    REQUIRE(serial.size() == banded.size());
+    for(size_t i = 0 ; i < serial.size() ; ++i){
+      CHECK(crender_eq(serial[i], banded[i]));
+    }
+    CHECK(0 == ncpile_rasterize(n_));
+    if(pool){
+      ncstats stats;
+      notcurses_stats(nc_, &stats);
+      CHECK(0 < stats.parallel_renders);
+      CHECK(stats.parallel_renders < stats.render_bands);
+      CHECK(stats.band_span_ns <= stats.band_ns);
+    }
+    for(auto p : planes){
+      ncplane_destroy(p);
+    }
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+TEST_CASE("AsyncOutput") {
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN |
+                NCOPTION_ASYNC_OUTPUT;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  if(nc_->ttyfd >= 0){
+    CHECK(nullptr != nc_->writer);
+  }
+
+  // frames queued to the writer must rasterize exactly as they would have
+  // synchronously, and the writer must have caught up once drained
+  SUBCASE("QueuedMatchesSync") {
+    for(unsigned seed = 0 ; seed < 8 ; ++seed){
+      pattern_plane(n_, seed);
+      CHECK(0 == notcurses_render(nc_));
+      auto async = rasterized_frame(nc_);
+      ncwriter* w = nc_->writer;
+      nc_->writer = nullptr;
+      ncplane_pile(n_)->repaint = true;
+      nc_->lastpile = nullptr;
+      CHECK(0 == writer_drain(w));
+      CHECK(0 == notcurses_render(nc_));
+      nc_->writer = w;
+      CHECK(async == rasterized_frame(nc_));
+    }
+    CHECK(0 == writer_drain(nc_->writer));
+    if(nc_->writer){
+      CHECK(0 == nc_->writer->queued);
+    }
+  }
+
+  // refreshing and enabling the cursor write synchronously, after the queue
+  SUBCASE("SyncAfterQueue") {
+    pattern_plane(n_, 1);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+    if(nc_->writer){
+      CHECK(0 == nc_->writer->queued);
+    }
+    CHECK(0 == notcurses_cursor_enable(nc_, 0, 0));
+    pattern_plane(n_, 2);
+    CHECK(0 == notcurses_render(nc_));
+    if(nc_->writer){
+      CHECK(0 == nc_->writer->queued);
+    }
+    CHECK(0 == notcurses_cursor_disable(nc_));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// a pipe which the writer can fill quickly, and from which we can read
+// whatever it has written.
+static void
+writer_pipe(int fds[2]){
+  REQUIRE(0 == pipe(fds));
+#ifdef F_SETPIPE_SZ
+  fcntl(fds[1], F_SETPIPE_SZ, 4096);
+#endif
+  REQUIRE(0 == fcntl(fds[0], F_SETFL, O_NONBLOCK));
+  REQUIRE(0 == fcntl(fds[1], F_SETFL, O_NONBLOCK));
+}
+
+// while 'fxn' is run on another thread, read everything which the writer
+// writes to 'fd'. we don't start reading until the writer has been asked to
+// cut its frame short.
+template<typename F> static auto
+coalesce_reading(ncwriter* w, int fd, F fxn) -> std::string {
+  std::atomic<bool> done = false;
+  std::thread t([&]{
+    fxn();
+    done = true;
+  });
+  bool cutting = false;
+  while(!cutting && !done){
+    pthread_mutex_lock(&w->lock);
+    cutting = w->cut;
+    pthread_mutex_unlock(&w->lock);
+  }
+  std::string received;
+  char buf[BUFSIZ];
+  while(true){
+    bool finished = done;
+    ssize_t r = read(fd, buf, sizeof(buf));
+    if(r > 0){
+      received.append(buf, r);
+    }else if(finished){
+      break;
+    }
+  }
+  t.join();
+  return received;
+}
+
+TEST_CASE("CoalescedOutput") {
+  notcurses_options nopts{};
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN |
+                NCOPTION_COALESCE_OUTPUT;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  int fds[2];
+  writer_pipe(fds);
+  ncwriter* w = writer_create(fds[1], true);
+  REQUIRE(nullptr != w);
+
+  // a frame cut short must stop at a row mark, having written exactly what
+  // precedes it, and report every row beyond it as lost
+  SUBCASE("CutAtRowMark") {
+    std::string frame;
+    std::vector<ncrowmark> marks;
+    for(int y = 0 ; y < 256 ; ++y){
+      marks.push_back({frame.size(), y});
+      frame += std::string(1000 + y, 'a' + y % 26);
+    }
+    int64_t waitns;
+    fbuf f{};
+    REQUIRE(0 == fbuf_putn(&f, frame.data(), frame.size()));
+    CHECK(0 == writer_submit(w, &f, marks.data(), marks.size(), &waitns));
+    // the frame's buffer was traded, not copied
+    CHECK(0 == f.used);
+    ncwritercut cut;
+    auto received = coalesce_reading(w, fds[0], [&]{
+      CHECK(0 == writer_coalesce(w, &cut));
+    });
+    CHECK(received.size() < frame.size());
+    CHECK(received == frame.substr(0, received.size()));
+    CHECK(frame.size() - received.size() == cut.lostbytes);
+    REQUIRE(0 < cut.lostcount);
+    CHECK(received.size() == cut.lost[0].offset);
+    CHECK(255 == cut.lost[cut.lostcount - 1].y);
+    CHECK(256u - cut.lost[0].y == cut.lostcount);
+    CHECK(!cut.dropped);
+    // without marks, a frame is written in full
+    REQUIRE(0 == fbuf_putn(&f, frame.data(), frame.size()));
+    CHECK(0 == writer_submit(w, &f, nullptr, 0, &waitns));
+    received = coalesce_reading(w, fds[0], [&]{
+      CHECK(0 == writer_coalesce(w, &cut));
+    });
+    CHECK(received == frame);
+    CHECK(0 == cut.lostcount);
+    fbuf_free(&f);
+  }
+
+  // rows lost from a frame cut short are redrawn by its successor, even
+  // though it didn't change them
+  SUBCASE("RedrawsLostRows") {
+    if(nc_->writer){
+      ncwriter* ttywriter = nc_->writer;
+      nc_->writer = w;
+      pattern_plane(n_, 0);
+      CHECK(0 == notcurses_render(nc_));
+      ncstats before, after;
+      notcurses_stats(nc_, &before);
+      CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "x"));
+      coalesce_reading(w, fds[0], [&]{
+        CHECK(0 == notcurses_render(nc_));
+        CHECK(0 == writer_drain(w));
+      });
+      notcurses_stats(nc_, &after);
+      CHECK(1 == (after.coalesced_frames + after.dropped_frames) -
+                 (before.coalesced_frames + before.dropped_frames));
+      CHECK(after.dropped_bytes > before.dropped_bytes);
+      CHECK(1 < after.rowemissions - before.rowemissions);
+      nc_->writer = ttywriter;
+      check_incremental_render(nc_);
+    }
+  }
+
+  CHECK(0 == writer_destroy(w));
+  close(fds[0]);
+  close(fds[1]);
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// reads everything written to a pipe on a thread of its own, so that the
+// writer never blocks on us
+class pipe_reader {
+ public:
+  explicit pipe_reader(int fd) : fd_(fd), done_(false), thread_([this]{ run(); }) {}
+
+  ~pipe_reader(){
+    done_ = true;
+    thread_.join();
+  }
+
+  // everything 'w' has written since the last call
+  auto take(ncwriter* w) -> std::string {
+    CHECK(0 == writer_drain(w));
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain();
+    std::string ret;
+    ret.swap(buf_);
+    return ret;
+  }
+
+ private:
+  void drain(){
+    char b[BUFSIZ];
+    ssize_t r;
+    while((r = read(fd_, b, sizeof(b))) > 0){
+      buf_.append(b, r);
+    }
+  }
+
+  void run(){
+    while(!done_){
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain();
+      }
+      struct pollfd pfd = { fd_, POLLIN, 0, };
+      poll(&pfd, 1, 10);
+    }
+  }
+
+  int fd_;
+  std::mutex mutex_;
+  std::string buf_;
+  std::atomic<bool> done_;
+  std::thread thread_;
+};
+
+// a minimal model of an xterm-like terminal, against which we can replay our
+// output. it understands only what rasterization ought emit, and counts
+// anything else as an error.
+struct termmodel {
+  struct pen {
+    unsigned attrs = 0; // bit per SGR attribute parameter
+    std::string fg, bg; // as specified, empty for the default
+    bool operator==(const pen& p) const {
+      return attrs == p.attrs && fg == p.fg && bg == p.bg;
+    }
+  };
+
+  struct cell {
+    std::string egc;
+    int width = 1; // 0 for the right half of a wide glyph
+    pen p;
+    bool operator==(const cell& c) const {
+      return egc == c.egc && width == c.width && p == c.p;
+    }
+  };
+
+  int rows, cols;
+  int y = 0, x = 0; // x == cols when a wrap is pending
+  int top, bot;     // scrolling region
+  pen cur;
+  std::string last; // most recent graphic character, for REP
+  std::vector<cell> grid;
+  unsigned errors = 0;
+
+  termmodel(int r, int c) : rows(r), cols(c), top(0), bot(r - 1), grid(r * c) {}
+
+  // blank the screen and home the cursor, retaining the pen
+  void clear(){
+    grid.assign(rows * cols, cell{});
+    y = x = 0;
+  }
+
+  void replay(const std::string& s){
+    size_t i = 0;
+    while(i < s.size()){
+      unsigned char c = s[i];
+      if(c == '\x1b'){
+        i = escape(s, i + 1);
+      }else if(c == '\r'){
+        x = 0;
+        ++i;
+      }else if(c == '\n'){
+        linefeed();
+        ++i;
+      }else if(c == '\b'){
+        x = col() ? col() - 1 : 0;
+        ++i;
+      }else if(c < 0x20 || c == 0x7f){
+        ++errors;
+        ++i;
+      }else{
+        i = glyph(s, i);
+      }
+    }
+  }
+
+ private:
+  // the column, resolving any pending wrap
+  int col() const {
+    return x >= cols ? cols - 1 : x;
+  }
+
+  static int clamp(int v, int lo, int hi){
+    return v < lo ? lo : v > hi ? hi : v;
+  }
+
+  // scroll rows [first, bot] up by 'n', blanking those exposed
+  void scroll_up(int first, int n){
+    n = clamp(n, 0, bot - first + 1);
+    auto b = grid.begin() + first * cols;
+    auto e = grid.begin() + (bot + 1) * cols;
+    std::move(b + n * cols, e, b);
+    std::fill(e - n * cols, e, cell{});
+  }
+
+  void linefeed(){
+    if(y == bot){
+      scroll_up(top, 1);
+    }else if(y < rows - 1){
+      ++y;
+    }
+  }
+
+  auto escape(const std::string& s, size_t i) -> size_t {
+    if(i >= s.size()){
+      ++errors;
+      return i;
+    }
+    if(s[i] == '(' || s[i] == ')'){ // character set designation
+      return i + 2;
+    }
+    if(s[i] != '['){
+      ++errors;
+      return i + 1;
+    }
+    ++i;
+    bool priv = false;
+    if(i < s.size() && s[i] == '?'){
+      priv = true;
+      ++i;
+    }
+    std::vector<int> params;
+    int param = -1;
+    while(i < s.size() && (isdigit(s[i]) || s[i] == ';')){
+      if(s[i] == ';'){
+        params.push_back(param);
+        param = -1;
+      }else{
+        param = (param < 0 ? 0 : param * 10) + (s[i] - '0');
+      }
+      ++i;
+    }
+    params.push_back(param);
+    if(i >= s.size()){
+      ++errors;
+      return i;
+    }
+    if(!priv){
+      csi(params, s[i]);
+    }
+    return i + 1;
+  }
+
+  void csi(const std::vector<int>& params, char final){
+    int n = params[0] < 1 ? 1 : params[0];
+    switch(final){
+      case 'A': y = clamp(y - n, 0, rows - 1); x = col(); break;
+      case 'B': y = clamp(y + n, 0, rows - 1); x = col(); break;
+      case 'C': x = clamp(col() + n, 0, cols - 1); break;
+      case 'D': x = clamp(col() - n, 0, cols - 1); break;
+      case 'G': x = clamp(n - 1, 0, cols - 1); break;
+      case 'd': y = clamp(n - 1, 0, rows - 1); x = col(); break;
+      case 'H':
+        y = clamp(n - 1, 0, rows - 1);
+        x = clamp((params.size() > 1 && params[1] > 0 ? params[1] : 1) - 1, 0, cols - 1);
+        break;
+      case 'm': sgr(params); break;
+      case 'r':
+        top = clamp((params[0] > 0 ? params[0] : 1) - 1, 0, rows - 1);
+        bot = clamp((params.size() > 1 && params[1] > 0 ? params[1] : rows) - 1, top, rows - 1);
+        y = x = 0;
+        break;
+      case 'S': scroll_up(top, n); break;
+      case 'b':
+        if(last.empty()){
+          ++errors;
+        }
+        for(int j = 0 ; j < n && !last.empty() ; ++j){
+          glyph(last, 0);
+        }
+        break;
+      case 'X': erase(col(), std::min(col() + n, cols)); break;
+      case 'K':
+        if(params[0] > 0){
+          ++errors;
+        }
+        erase(col(), cols);
+        break;
+      case 'M':
+        if(y >= top && y <= bot){
+          scroll_up(y, n);
+        }
+        x = 0;
+        break;
+      default: ++errors; break;
+    }
+  }
+
+  void sgr(const std::vector<int>& params){
+    for(size_t i = 0 ; i < params.size() ; ++i){
+      int p = params[i] < 0 ? 0 : params[i];
+      if(p == 0){
+        cur = pen{};
+      }else if(p < 10){
+        cur.attrs |= 1u << p;
+      }else if(p == 22){
+        cur.attrs &= ~((1u << 1) | (1u << 2));
+      }else if(p > 22 && p < 30){
+        cur.attrs &= ~(1u << (p - 20));
+      }else if((p >= 30 && p < 38) || (p >= 40 && p < 48)){
+        (p < 40 ? cur.fg : cur.bg) = "i" + std::to_string(p % 10);
+      }else if((p >= 90 && p < 98) || (p >= 100 && p < 108)){
+        (p < 100 ? cur.fg : cur.bg) = "i" + std::to_string(p % 10 + 8);
+      }else if(p == 39 || p == 49){
+        (p == 39 ? cur.fg : cur.bg).clear();
+      }else if((p == 38 || p == 48) && i + 2 < params.size() && params[i + 1] == 5){
+        (p == 38 ? cur.fg : cur.bg) = "i" + std::to_string(params[i + 2]);
+        i += 2;
+      }else if((p == 38 || p == 48) && i + 4 < params.size() && params[i + 1] == 2){
+        (p == 38 ? cur.fg : cur.bg) = "rgb" + std::to_string(params[i + 2]) + "," +
+                                      std::to_string(params[i + 3]) + "," +
+                                      std::to_string(params[i + 4]);
+        i += 4;
+      }else{
+        ++errors;
+      }
+    }
+  }
+
+  // erase columns [from, to) of the current row, as a terminal with bce does,
+  // leaving the cursor where it is
+  void erase(int from, int to){
+    for(int c = from ; c < to ; ++c){
+      break_wide(y * cols + c);
+      grid[y * cols + c] = cell{" ", 1, pen{0, cur.fg, cur.bg}};
+    }
+  }
+
+  // blank whichever wide glyph covers the cell at 'idx'
+  void break_wide(int idx){
+    if(grid[idx].width == 0 && idx % cols){
+      grid[idx - 1] = cell{" ", 1, grid[idx - 1].p};
+    }else if(grid[idx].width == 2 && (idx + 1) % cols){
+      grid[idx + 1] = cell{" ", 1, grid[idx + 1].p};
+    }
+  }
+
+  auto glyph(const std::string& s, size_t i) -> size_t {
+    mbstate_t ps{};
+    wchar_t w;
+    size_t len = mbrtowc(&w, s.data() + i, s.size() - i, &ps);
+    if(len == 0 || len > s.size() - i){
+      ++errors;
+      return i + 1;
+    }
+    std::string egc = s.substr(i, len);
+    int width = wcwidth(w);
+    if(width == 0 && x > 0){ // combine with the preceding glyph
+      int idx = y * cols + col() - 1;
+      if(grid[idx].width == 0 && idx % cols){
+        --idx;
+      }
+      grid[idx].egc += egc;
+      return i + len;
+    }
+    width = width == 2 ? 2 : 1;
+    last = egc;
+    if(x >= cols || x + width > cols){
+      x = 0;
+      linefeed();
+    }
+    int idx = y * cols + x;
+    for(int j = 0 ; j < width ; ++j){
+      break_wide(idx + j);
+    }
+    grid[idx] = cell{egc, width, cur};
+    if(width == 2){
+      grid[idx + 1] = cell{"", 0, cur};
+    }
+    x += width;
+    return i + len;
+  }
+};
+
+// forget everything we know about the terminal, as if our output had been
+// lost, so that the next frame is drawn in full from an unknown state.
+static void
+forget_terminal(struct notcurses* nc){
+  for(int i = 0 ; i < nc->lfdimy * nc->lfdimx ; ++i){
+    nc->lastframe[i].stylemask = 0xffffu; // matches no real style
+  }
+  nc->lastpile = nullptr;
+  nc->rstate.hardcursorpos = true;
+  nc->rstate.curattr = 0xffffu;
+  nc->rstate.fgelidable = nc->rstate.bgelidable = false;
+  nc->rstate.fgpalelidable = nc->rstate.bgpalelidable = false;
+  nc->rstate.fgdefelidable = nc->rstate.bgdefelidable = false;
+}
+
+// the number of cells in which two model terminals differ
+static int
+mismatches(const termmodel& t1, const termmodel& t2){
+  int count = 0;
+  for(size_t i = 0 ; i < t1.grid.size() ; ++i){
+    if(!(t1.grid[i] == t2.grid[i])){
+      ++count;
+    }
+  }
+  return count;
+}
+
+// whatever cursor motions are chosen, replaying a sequence of incremental
+// renders through a model terminal must leave it looking just like a full
+// redraw does.
+TEST_CASE("CursorMotion") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  int dimy, dimx;
+  ncplane_dim_yx(n_, &dimy, &dimx);
+  int fds[2];
+  writer_pipe(fds);
+  ncwriter* w = writer_create(fds[1], false);
+  REQUIRE(nullptr != w);
+  ncwriter* ttywriter = nc_->writer;
+  {
+    pipe_reader reader(fds[0]);
+    nc_->writer = w;
+    termmodel term(dimy + nc_->margin_t + nc_->margin_b,
+                   dimx + nc_->margin_l + nc_->margin_r);
+    forget_terminal(nc_);
+    pattern_plane(n_, 0);
+    CHECK(0 == notcurses_render(nc_));
+    term.replay(reader.take(w));
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+
+    // scattered changes, including wide glyphs and the edges of the plane
+    static const char* egcs[] = { "b", "字", "🐸", "Ж", " ", };
+    for(unsigned round = 0 ; round < 16 ; ++round){
+      for(unsigned i = 0 ; i < 12 ; ++i){
+        unsigned r = (round * 12 + i + 1) * 2654435761u;
+        int y = (r >> 4) % dimy;
+        int x = i % 4 == 0 ? dimx - 1 : i % 4 == 1 ? 0 : (r >> 12) % dimx;
+        ncplane_set_fg_rgb8(n_, r % 256, (r >> 8) % 256, (r >> 16) % 256);
+        ncplane_set_bg_rgb8(n_, (r >> 16) % 256, r % 256, (r >> 8) % 256);
+        ncplane_putstr_yx(n_, y, x, egcs[(r >> 24) % (sizeof(egcs) / sizeof(*egcs))]);
+      }
+      CHECK(0 == notcurses_render(nc_));
+      term.replay(reader.take(w));
+    }
+
+    // a uniform row changed at every third cell, best updated by rewriting
+    // the glyphs in between
+    ncplane_set_fg_rgb(n_, 0x80c0ff);
+    ncplane_set_bg_rgb(n_, 0x202020);
+    ncplane_set_styles(n_, NCSTYLE_NONE);
+    CHECK(0 < ncplane_putstr_yx(n_, 1, 0, std::string(dimx, 'a').c_str()));
+    CHECK(0 == notcurses_render(nc_));
+    term.replay(reader.take(w));
+    for(int x = 0 ; x < dimx ; x += 3){
+      CHECK(0 < ncplane_putchar_yx(n_, 1, x, 'b'));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    term.replay(reader.take(w));
+    notcurses_stats(nc_, &after);
+    CHECK(after.motion_bytes_saved > before.motion_bytes_saved);
+
+    termmodel redrawn = term;
+    redrawn.clear();
+    CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+    redrawn.replay(reader.take(w));
+    CHECK(0 == term.errors);
+    CHECK(0 == redrawn.errors);
+    CHECK(0 == mismatches(term, redrawn));
+    nc_->writer = ttywriter;
+  }
+  CHECK(0 == writer_destroy(w));
+  close(fds[0]);
+  close(fds[1]);
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// a scrolling plane spanning the width of the terminal ought be scrolled by
+// the terminal itself, leaving only the exposed row to be written, with the
+// same result as a full redraw.
+TEST_CASE("ScrollAcceleration") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  int dimy, dimx;
+  ncplane_dim_yx(n_, &dimy, &dimx);
+  const tinfo* ti = &nc_->tcache;
+  if(!(ti->indn || ti->dl) || dimy < 8 || nc_->margin_l || nc_->margin_r){
+    CHECK(0 == notcurses_stop(nc_));
+    return;
+  }
+  int fds[2];
+  writer_pipe(fds);
+  ncwriter* w = writer_create(fds[1], false);
+  REQUIRE(nullptr != w);
+  ncwriter* ttywriter = nc_->writer;
+  {
+    pipe_reader reader(fds[0]);
+    nc_->writer = w;
+    termmodel term(dimy + nc_->margin_t + nc_->margin_b,
+                   dimx + nc_->margin_l + nc_->margin_r);
+    // lastframe must exist for us to forget it, so that all of the next
+    // frame is written to the model
+    CHECK(0 == notcurses_render(nc_));
+    reader.take(w);
+    forget_terminal(nc_);
+
+    // scroll 'n' through 'total' lines, each of which is written and
+    // rendered, the last 'scrolls' of them requiring a scroll
+    auto scroll_through = [&](struct ncplane* n, int total, int scrolls) {
+      ncstats before, after;
+      notcurses_stats(nc_, &before);
+      size_t maxbytes = 0;
+      for(int i = 0 ; i < total ; ++i){
+        ncplane_set_fg_rgb(n, 0x40 * (i % 4) + 0x3f);
+        CHECK(0 < ncplane_printf(n, "\nline %d of the log", i));
+        CHECK(0 == notcurses_render(nc_));
+        auto frame = reader.take(w);
+        term.replay(frame);
+        if(i >= total - scrolls){
+          maxbytes = std::max(maxbytes, frame.size());
+        }
+      }
+      notcurses_stats(nc_, &after);
+      CHECK(scrolls <= (int)(after.scrolls_accelerated - before.scrolls_accelerated));
+      // the whole plane would otherwise be rewritten on each scroll
+      CHECK(maxbytes < (size_t)dimx * 4);
+    };
+
+    SUBCASE("WholeScreen") {
+      ncplane_set_scrolling(n_, true);
+      CHECK(0 == notcurses_render(nc_));
+      term.replay(reader.take(w));
+      scroll_through(n_, dimy + 8, 8);
+    }
+
+    // a full-width plane short of the screen's top and bottom requires a
+    // scrolling region
+    SUBCASE("Region") {
+      struct ncplane_options nopts{};
+      nopts.y = 2;
+      nopts.rows = dimy - 4;
+      nopts.cols = dimx;
+      auto log = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != log);
+      ncplane_set_scrolling(log, true);
+      CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "above the log"));
+      CHECK(0 < ncplane_putstr_yx(n_, dimy - 1, 0, "below the log"));
+      CHECK(0 == notcurses_render(nc_));
+      term.replay(reader.take(w));
+      scroll_through(log, dimy + 8, ti->csr ? 8 : 0);
+      CHECK(0 == ncplane_destroy(log));
+      CHECK(0 == notcurses_render(nc_));
+      term.replay(reader.take(w));
+    }
+
+    termmodel redrawn = term;
+    redrawn.clear();
+    CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+    redrawn.replay(reader.take(w));
+    CHECK(0 == term.errors);
+    CHECK(0 == redrawn.errors);
+    CHECK(0 == mismatches(term, redrawn));
+    nc_->writer = ttywriter;
+  }
+  CHECK(0 == writer_destroy(w));
+  close(fds[0]);
+  close(fds[1]);
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// runs of identical cells written as a repeated glyph or an erasure must draw
+// the same screen as writing each of their glyphs out.
+TEST_CASE("RunEncoding") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  int dimy, dimx;
+  ncplane_dim_yx(n_, &dimy, &dimx);
+  tinfo* ti = &nc_->tcache;
+  if(dimy < 8 || dimx < 40){
+    CHECK(0 == notcurses_stop(nc_));
+    return;
+  }
+  int fds[2];
+  writer_pipe(fds);
+  ncwriter* w = writer_create(fds[1], false);
+  REQUIRE(nullptr != w);
+  ncwriter* ttywriter = nc_->writer;
+  {
+    pipe_reader reader(fds[0]);
+    nc_->writer = w;
+    termmodel term(dimy + nc_->margin_t + nc_->margin_b,
+                   dimx + nc_->margin_l + nc_->margin_r);
+    CHECK(0 == notcurses_render(nc_));
+    reader.take(w);
+    forget_terminal(nc_);
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+
+    // repeated glyphs, both ASCII and multibyte
+    ncplane_set_fg_rgb(n_, 0x80c0ff);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, std::string(dimx, 'x').c_str()));
+    for(int x = 0 ; x < dimx ; ++x){
+      CHECK(0 < ncplane_putstr_yx(n_, 1, x, "─"));
+    }
+    // blanks on a colored background, through the end of the row and not
+    ncplane_set_bg_rgb(n_, 0x204060);
+    CHECK(0 < ncplane_putstr_yx(n_, 2, 0, std::string(dimx, ' ').c_str()));
+    CHECK(0 < ncplane_putstr_yx(n_, 3, 4, std::string(20, ' ').c_str()));
+    // blanks which can't be erased, being underlined
+    ncplane_set_styles(n_, NCSTYLE_UNDERLINE);
+    CHECK(0 < ncplane_putstr_yx(n_, 4, 4, std::string(20, ' ').c_str()));
+    ncplane_set_styles(n_, NCSTYLE_NONE);
+    // blanks on the default background, within a row of glyphs
+    ncplane_set_bg_default(n_);
+    CHECK(0 < ncplane_putstr_yx(n_, 5, 0, (std::string(10, 'a') + std::string(20, ' ') +
+                                           std::string(10, 'a')).c_str()));
+    CHECK(0 == notcurses_render(nc_));
+    term.replay(reader.take(w));
+
+    // runs overwriting parts of the runs already onscreen
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 8, std::string(16, 'y').c_str()));
+    CHECK(0 < ncplane_putstr_yx(n_, 2, 8, std::string(16, ' ').c_str()));
+    ncplane_set_bg_rgb(n_, 0x204060);
+    CHECK(0 < ncplane_putstr_yx(n_, 5, 5, std::string(30, ' ').c_str()));
+    CHECK(0 == notcurses_render(nc_));
+    term.replay(reader.take(w));
+    notcurses_stats(nc_, &after);
+    if(ti->rep || ti->ech || ti->el){
+      CHECK(after.run_bytes_saved > before.run_bytes_saved);
+    }
+
+    // redraw without the means to encode runs
+    char* rep = ti->rep;
+    char* el = ti->el;
+    const char* ech = ti->echtmpl.cap;
+    ti->rep = nullptr;
+    ti->el = nullptr;
+    ti->echtmpl.cap = nullptr;
+    termmodel redrawn = term;
+    redrawn.clear();
+    CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+    redrawn.replay(reader.take(w));
+    ti->rep = rep;
+    ti->el = el;
+    ti->echtmpl.cap = ech;
+    CHECK(0 == term.errors);
+    CHECK(0 == redrawn.errors);
+    CHECK(0 == mismatches(term, redrawn));
+    nc_->writer = ttywriter;
+  }
+  CHECK(0 == writer_destroy(w));
+  close(fds[0]);
+  close(fds[1]);
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// a frame handed over by notcurses_render_to_buffer() must draw the same
+// screen as notcurses_render_to_file() does, and neither touches the terminal.
+TEST_CASE("RenderToBuffer") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+  int dimy, dimx;
+  ncplane_dim_yx(n_, &dimy, &dimx);
+  termmodel buffered(dimy + nc_->margin_t + nc_->margin_b,
+                     dimx + nc_->margin_l + nc_->margin_r);
+  termmodel filed = buffered;
+  forget_terminal(nc_);
+  pattern_plane(n_, 0);
+  char* buf = nullptr;
+  size_t buflen = 0;
+  REQUIRE(0 == notcurses_render_to_buffer(nc_, &buf, &buflen));
+  REQUIRE(nullptr != buf);
+  CHECK(0 < buflen);
+  CHECK('\0' == buf[buflen]); // terminated, though the NUL isn't counted
+  CHECK(buflen == strlen(buf));
+  buffered.replay(std::string(buf, buflen));
+  free(buf);
+  const rasterstate before = nc_->rstate;
+  char* fbufp = nullptr;
+  size_t fbuflen = 0;
+  FILE* fp = open_memstream(&fbufp, &fbuflen);
+  REQUIRE(nullptr != fp);
+  CHECK(0 == notcurses_render_to_file(nc_, fp));
+  CHECK(0 == fclose(fp));
+  filed.replay(std::string(fbufp, fbuflen));
+  free(fbufp);
+  CHECK(before.y == nc_->rstate.y);
+  CHECK(before.x == nc_->rstate.x);
+  CHECK(before.curattr == nc_->rstate.curattr);
+  CHECK(0 == buffered.errors);
+  CHECK(0 == filed.errors);
+  CHECK(0 == mismatches(buffered, filed));
+  // the terminal never saw that frame
+  CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// with a target frame rate, any number of render requests made within a
+// frame interval are satisfied by a single frame, showing the latest state.
+TEST_CASE("RenderRequest") {
+  SUBCASE("Immediate") {
+    auto nc_ = testing_notcurses();
+    if(!nc_){
+      return;
+    }
+    CHECK(nullptr == nc_->scheduler);
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    for(int i = 0 ; i < 4 ; ++i){
+      CHECK(0 == notcurses_render_request(nc_));
+    }
+    notcurses_stats(nc_, &after);
+    CHECK(4 == after.frames_requested - before.frames_requested);
+    CHECK(4 == after.frames_delivered - before.frames_delivered);
+    CHECK(0 == notcurses_stop(nc_));
+  }
+
+  SUBCASE("Governed") {
+    const unsigned fps = 20;
+    const uint64_t intervalns = NANOSECS_IN_SEC / fps;
+    notcurses_options nopts{};
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN;
+    auto nc_ = notcurses_init(&nopts, nullptr);
+    if(!nc_){
+      return;
+    }
+    CHECK(0 == notcurses_set_target_fps(nc_, fps));
+    REQUIRE(nullptr != nc_->scheduler);
+    struct ncplane* n_ = notcurses_stdplane(nc_);
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const int requests = 500;
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "old"));
+    CHECK(0 == notcurses_render_request(nc_));
+    CHECK(0 == notcurses_render_drain(nc_));
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "new"));
+    for(int i = 1 ; i < requests ; ++i){
+      CHECK(0 == notcurses_render_request(nc_));
+    }
+    CHECK(0 == notcurses_render_drain(nc_));
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    notcurses_stats(nc_, &after);
+    const uint64_t delivered = after.frames_delivered - before.frames_delivered;
+    const uint64_t elapsed = timespec_to_ns(&done) - timespec_to_ns(&start);
+    CHECK(requests == after.frames_requested - before.frames_requested);
+    CHECK(1 <= delivered);
+    CHECK(delivered <= elapsed / intervalns + 1);
+    CHECK(delivered == after.renders - before.renders);
+    // the last frame reflects the last request
+    uint16_t stylemask;
+    uint64_t channels;
+    char* egc = notcurses_at_yx(nc_, 0, 0, &stylemask, &channels);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "n"));
+    free(egc);
+    // two frames requested in succession are separated by an interval
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(0 == notcurses_render_request(nc_));
+    CHECK(0 == notcurses_render_drain(nc_));
+    CHECK(0 == notcurses_render_request(nc_));
+    CHECK(0 == notcurses_render_drain(nc_));
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    CHECK(intervalns <= (uint64_t)(timespec_to_ns(&done) - timespec_to_ns(&start)));
+    // a pending frame is delivered by an input poll blocking past its deadline.
+    // stray input on the terminal ends a poll early, so poll until it's gone.
+    CHECK(0 == notcurses_render_request(nc_));
+    CHECK(0 == notcurses_render_request(nc_));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const uint64_t untilns = timespec_to_ns(&start) + 3 * intervalns;
+    done = start;
+    do{
+      struct timespec ts;
+      ns_to_timespec(untilns - timespec_to_ns(&done), &ts);
+      notcurses_getc(nc_, &ts, nullptr, nullptr);
+      clock_gettime(CLOCK_MONOTONIC, &done);
+    }while(nc_->scheduler->pending && (uint64_t)timespec_to_ns(&done) < untilns);
+    CHECK(!nc_->scheduler->pending);
+    // a pending frame is rendered by notcurses_stop()
+    CHECK(0 == notcurses_render_request(nc_));
+    CHECK(0 == notcurses_stop(nc_));
+  }
+}
+
+TEST_CASE("IncrementalRender") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  int dimy, dimx;
+  struct ncplane* n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(nullptr != n_);
+  pattern_plane(n_, 0);
+  struct ncplane_options opts{};
+  opts.y = 2;
+  opts.x = 3;
+  opts.rows = dimy / 2;
+  opts.cols = dimx / 2;
+  auto p = ncplane_create(n_, &opts);
+  REQUIRE(nullptr != p);
+  pattern_plane(p, 1);
+  opts.y = 5;
+  opts.x = 9;
+  auto q = ncplane_create(n_, &opts);
+  REQUIRE(nullptr != q);
+  pattern_plane(q, 2);
+  CHECK(0 == notcurses_render(nc_));
+
+  // with no changes, nothing ought be repainted
+  SUBCASE("NoChangeNoRepaint") {
+    auto pile = ncplane_pile(n_);
+    pile->rvec.crender[0].s.fgblends = 0xad;
+    CHECK(0 == ncpile_render(n_));
+    CHECK(0xad == pile->rvec.crender[0].s.fgblends);
+    CHECK(0 == ncpile_rasterize(n_));
+    // but a change anywhere in the row repaints it
+    CHECK(0 < ncplane_putchar_yx(n_, 0, dimx - 1, 'x'));
+    CHECK(0 == ncpile_render(n_));
+    CHECK(0xad != pile->rvec.crender[0].s.fgblends);
+    CHECK(0 == ncpile_rasterize(n_));
+  }
+
+  // only the damaged rows ought be scanned by the rasterizer
+  SUBCASE("DamagedRowsOnly") {
+    ncstats before, after;
+    notcurses_stats(nc_, &before);
+    CHECK(0 < ncplane_putstr_yx(p, 1, 1, "damage"));
+    CHECK(0 < ncplane_putstr_yx(n_, dimy - 1, dimx - 2, "字"));
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats(nc_, &after);
+    CHECK(2 == after.rowemissions - before.rowemissions);
+    CHECK(dimy - 2u == after.rowelisions - before.rowelisions);
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Write") {
+    CHECK(0 < ncplane_putstr_yx(p, 1, 1, "incremental"));
+    CHECK(0 < ncplane_putstr_yx(n_, dimy - 1, 0, "字字字"));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Move") {
+    CHECK(0 == ncplane_move_yx(p, 7, 1));
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_move_yx(q, 5, 20));
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_move_yx(q, -3, -4));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Resize") {
+    CHECK(0 == ncplane_resize_simple(p, 3, 10));
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_resize(q, 1, 1, 2, 2, 0, 0, dimy, 4));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Destroy") {
+    CHECK(0 == ncplane_destroy(q));
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_destroy(p));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Restack") {
+    ncplane_move_bottom(q);
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_move_above(q, p));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("Base") {
+    uint64_t channels = 0;
+    ncchannels_set_bg_rgb(&channels, 0x40c040);
+    CHECK(0 < ncplane_set_base(q, "+", 0, channels));
+    ncplane_erase(q);
+    check_incremental_render(nc_);
+    ncchannels_set_bg_rgb(&channels, 0x4040c0);
+    CHECK(0 < ncplane_set_base(q, "-", 0, channels));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("LeavePile") {
+    CHECK(nullptr != ncplane_reparent(p, p));
+    check_incremental_render(nc_);
+    CHECK(nullptr != ncplane_reparent(p, n_));
+    check_incremental_render(nc_);
+    ncplane_destroy(p);
+  }
+
+  SUBCASE("Scroll") {
+    ncplane_set_scrolling(q, true);
+    CHECK(0 < ncplane_putstr_yx(q, ncplane_dim_y(q) - 1, 0, "scroll\nscroll"));
+    check_incremental_render(nc_);
+  }
+
+  SUBCASE("NewPlane") {
+    opts.y = dimy - 4;
+    opts.x = dimx - 10;
+    opts.rows = 6;
+    opts.cols = 12;
+    auto r = ncplane_create(q, &opts);
+    REQUIRE(nullptr != r);
+    pattern_plane(r, 3);
+    check_incremental_render(nc_);
+    CHECK(0 == ncplane_move_yx(q, 0, 0)); // moves bound plane r as well
+    check_incremental_render(nc_);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// render the pile from scratch with and without the cached layer rooted at
+// 'root'. the results ought be identical.
+static void
+check_layer_render(struct notcurses* nc, struct ncplane* root){
+  auto pile = ncplane_pile(root);
+  pile->repaint = true;
+  CHECK(0 == notcurses_render(nc));
+  auto cached = rendered_pile(root);
+  CHECK(0 == ncplane_set_cached_layer(root, false));
+  pile->repaint = true;
+  CHECK(0 == notcurses_render(nc));
+  auto uncached = rendered_pile(root);
+  CHECK(0 == ncplane_set_cached_layer(root, true));
+  REQUIRE(cached.size() == uncached.size());
+  for(size_t i = 0 ; i < cached.size() ; ++i){
+    CHECK(crender_eq(cached[i], uncached[i]));
+  }
+}
+
+TEST_CASE("CachedLayer") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  int dimy, dimx;
+  struct ncplane* n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(nullptr != n_);
+  pattern_plane(n_, 0);
+  // a layer of three overlapping planes, the lower two partially blended
+  struct ncplane_options opts{};
+  opts.y = 1;
+  opts.x = 2;
+  opts.rows = dimy - 4;
+  opts.cols = dimx - 6;
+  auto l = ncplane_create(n_, &opts);
+  REQUIRE(nullptr != l);
+  pattern_plane(l, 1);
+  opts.y = 3;
+  opts.x = 5;
+  opts.rows = dimy / 2;
+  opts.cols = dimx / 2;
+  auto l1 = ncplane_create(l, &opts);
+  REQUIRE(nullptr != l1);
+  pattern_plane(l1, 2);
+  opts.y = 6;
+  opts.x = 11;
+  auto l2 = ncplane_create(l1, &opts);
+  REQUIRE(nullptr != l2);
+  pattern_plane(l2, 3);
+  // and above it, a plane partially transparent over the layer
+  opts.y = 2;
+  opts.x = 4;
+  opts.rows = 5;
+  opts.cols = 20;
+  auto d = ncplane_create(n_, &opts);
+  REQUIRE(nullptr != d);
+  pattern_plane(d, 4);
+  ncplane_set_fg_alpha(d, CELL_ALPHA_TRANSPARENT);
+  ncplane_set_bg_alpha(d, CELL_ALPHA_TRANSPARENT);
+  CHECK(0 < ncplane_putstr_yx(d, 1, 0, "see-through"));
+  ncplane_set_bg_alpha(d, CELL_ALPHA_BLEND);
+  CHECK(0 < ncplane_putstr_yx(d, 3, 2, "tinted"));
+  CHECK(0 == ncplane_set_cached_layer(l, true));
+  CHECK(0 == notcurses_render(nc_));
+  uint64_t hits, misses;
+  CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+  CHECK(0 == hits);
+  CHECK(1 == misses);
+  CHECK(-1 == ncplane_cached_layer_stats(l1, &hits, &misses));
+
+  // changes above the layer reuse its composition
+  SUBCASE("HitsAbove") {
+    for(int i = 0 ; i < 4 ; ++i){
+      CHECK(0 == ncplane_move_yx(d, 3 + i, 4 + i * 3));
+      CHECK(0 == notcurses_render(nc_));
+    }
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(4 <= hits);
+    CHECK(1 == misses);
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(4 <= stats.layer_hits);
+    check_layer_render(nc_, l);
+    check_incremental_render(nc_);
+  }
+
+  // any change within the layer requires recomposition
+  SUBCASE("InvalidatedWithin") {
+    CHECK(0 < ncplane_putstr_yx(l2, 0, 0, "changed"));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(2 == misses);
+    CHECK(0 == ncplane_move_yx(l1, 2, 2));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(3 == misses);
+    uint64_t channels = 0;
+    ncchannels_set_bg_rgb(&channels, 0x40c040);
+    CHECK(0 < ncplane_set_base(l, "+", 0, channels));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(4 == misses);
+    check_layer_render(nc_, l);
+    check_incremental_render(nc_);
+  }
+
+  // planes joining or leaving the layer require recomposition
+  SUBCASE("Membership") {
+    CHECK(nullptr != ncplane_reparent_family(d, l2));
+    CHECK(0 == ncplane_move_yx(d, 1, 1));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(2 == misses);
+    check_layer_render(nc_, l);
+    CHECK(0 == ncplane_destroy(l1));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(1 == misses); // the layer was recreated by check_layer_render()
+    check_layer_render(nc_, l);
+    CHECK(nullptr != ncplane_reparent_family(d, n_));
+    check_layer_render(nc_, l);
+    check_incremental_render(nc_);
+  }
+
+  // a plane interposed within the layer defeats it, but renders correctly
+  SUBCASE("Interposed") {
+    CHECK(0 == ncplane_move_below(d, l2));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_cached_layer_stats(l, &hits, &misses));
+    CHECK(0 == hits);
+    CHECK(1 == misses);
+    check_layer_render(nc_, l);
+    ncplane_move_top(d);
+    check_layer_render(nc_, l);
+    check_incremental_render(nc_);
+  }
+
+  // a nested layer is composited separately
+  SUBCASE("Nested") {
+    CHECK(0 == ncplane_set_cached_layer(l1, true));
+    check_layer_render(nc_, l1);
+    check_layer_render(nc_, l);
+    check_incremental_render(nc_);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
+
+// time full repaints of a stack of overlapping, partially blended planes at
+// the current terminal geometry, followed by their postpaint and
+// rasterization (the latter mostly elided, since only the first frame
+// differs from its predecessor).
+TEST_CASE("RenderBench" * doctest::skip(true)) {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  int dimy, dimx;
+  struct ncplane* n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(nullptr != n_);
+  pattern_plane(n_, 0);
+  struct ncplane_options opts{};
+  std::vector<struct ncplane*> planes;
+  for(int i = 0 ; i < 4 ; ++i){
+    opts.y = i * dimy / 4 - 3;
+    opts.x = i * dimx / 5 - 2;
+    opts.rows = dimy / 2 + i;
+    opts.cols = dimx / 2 + i * 3;
+    auto p = ncplane_create(n_, &opts);
+    REQUIRE(nullptr != p);
+    pattern_plane(p, i + 1);
+    if(i % 2){
+      uint64_t channels = 0;
+      ncchannels_set_fg_alpha(&channels, CELL_ALPHA_TRANSPARENT);
+      ncchannels_set_bg_alpha(&channels, CELL_ALPHA_BLEND);
+      ncplane_set_base(p, "", 0, channels);
+    }
+    planes.push_back(p);
+  }
+  CHECK(0 == notcurses_render(nc_));
+  const int frames = 200;
+  ncstats before, after;
+  notcurses_stats(nc_, &before);
+  for(int f = 0 ; f < frames ; ++f){
+    ncplane_pile(n_)->repaint = true;
+    CHECK(0 == notcurses_render(nc_));
+  }
+  notcurses_stats(nc_, &after);
+  printf("%dx%d: %.1f render ns/frame %.1f raster ns/frame\n", dimx, dimy,
+         (after.render_ns - before.render_ns) / (double)frames,
+         (after.raster_ns - before.raster_ns) / (double)frames);
+  for(auto p : planes){
+    ncplane_destroy(p);
+  }
+  CHECK(0 == notcurses_stop(nc_));
+}
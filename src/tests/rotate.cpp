@@ -1,4 +1,5 @@
 #include "main.h"
+#include "visual-details.h"
 #include <cmath>
 #include <vector>
 
@@ -287,3 +288,118 @@ TEST_CASE("Rotate") {
   CHECK(0 == notcurses_stop(nc_));
 
 }
+
+// the nonzero pixels of each row of 'ncv' must be contiguous (as they are for
+// any rotation of a solid rectangle). returns the number of nonzero pixels.
+static int
+rotated_solid(const ncvisual* ncv){
+  int nonzero = 0;
+  for(int y = 0 ; y < ncv->pixy ; ++y){
+    int runs = 0;
+    bool in = false;
+    for(int x = 0 ; x < ncv->pixx ; ++x){
+      const bool set = ncv->data[y * ncv->rowstride / 4 + x];
+      if(set && !in){
+        ++runs;
+      }
+      in = set;
+      nonzero += set;
+    }
+    CHECK(1 >= runs);
+  }
+  return nonzero;
+}
+
+TEST_CASE("RotateVisual") {
+  const int rows = 23;
+  const int cols = 40;
+  std::vector<uint32_t> rgba(rows * cols);
+  for(size_t i = 0 ; i < rgba.size() ; ++i){
+    rgba[i] = htole(0xff000000u | (i * 2654435761u >> 8));
+  }
+
+  // quarter turns are exact permutations of the pixels
+  SUBCASE("RotateQuarters") {
+    auto ncv = ncvisual_from_rgba(rgba.data(), rows, cols * 4, cols);
+    REQUIRE(ncv);
+    CHECK(0 == ncvisual_rotate(ncv, M_PI / 2));
+    REQUIRE(cols == ncv->pixy);
+    REQUIRE(rows == ncv->pixx);
+    for(int y = 0 ; y < rows ; ++y){
+      for(int x = 0 ; x < cols ; ++x){
+        CHECK(rgba[y * cols + x] == ncv->data[(cols - 1 - x) * rows + y]);
+      }
+    }
+    CHECK(0 == ncvisual_rotate(ncv, M_PI));
+    CHECK(0 == ncvisual_rotate(ncv, -3 * M_PI / 2));
+    CHECK(0 == ncvisual_rotate(ncv, 4 * M_PI));
+    REQUIRE(rows == ncv->pixy);
+    REQUIRE(cols == ncv->pixx);
+    for(int y = 0 ; y < rows ; ++y){
+      for(int x = 0 ; x < cols ; ++x){
+        CHECK(rgba[y * cols + x] == ncv->data[y * cols + x]);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+
+  // repeated rotations alternate between two buffers
+  SUBCASE("RotateReusesBuffers") {
+    auto ncv = ncvisual_from_rgba(rgba.data(), rows, cols * 4, cols);
+    REQUIRE(ncv);
+    const uint32_t* orig = ncv->data;
+    CHECK(0 == ncvisual_rotate(ncv, M_PI));
+    const uint32_t* rotated = ncv->data;
+    CHECK(orig != rotated);
+    CHECK(orig == ncv->spare);
+    CHECK(0 == ncvisual_rotate(ncv, M_PI));
+    CHECK(orig == ncv->data);
+    CHECK(rotated == ncv->spare);
+    CHECK(0 == ncvisual_rotate(ncv, M_PI / 5));
+    CHECK(0 == ncvisual_rotate(ncv, -M_PI / 5));
+    ncvisual_destroy(ncv);
+  }
+
+  // arbitrary angles leave no holes within a rotated solid image
+  SUBCASE("RotateArbitrary") {
+    std::vector<uint32_t> solid(rows * cols, htole(0xff2080c0));
+    const double angles[] = { M_PI / 4, M_PI / 6, -M_PI / 7, 2.5, };
+    for(auto a : angles){
+      auto ncv = ncvisual_from_rgba(solid.data(), rows, cols * 4, cols);
+      REQUIRE(ncv);
+      CHECK(0 == ncvisual_rotate(ncv, a));
+      const int nonzero = rotated_solid(ncv);
+      CHECK(rows * cols * 95 / 100 < nonzero);
+      CHECK(rows * cols * 105 / 100 > nonzero);
+      for(int i = 0 ; i < ncv->pixy * ncv->pixx ; ++i){
+        CHECK((0 == ncv->data[i] || htole(0xff2080c0) == ncv->data[i]));
+      }
+      ncvisual_destroy(ncv);
+    }
+  }
+
+  // bilinear edges fade by alpha alone, without darkening
+  SUBCASE("RotateBilinear") {
+    std::vector<uint32_t> solid(rows * cols, htole(0xff2080c0));
+    auto ncv = ncvisual_from_rgba(solid.data(), rows, cols * 4, cols);
+    REQUIRE(ncv);
+    CHECK(0 == ncvisual_rotate_bilinear(ncv, M_PI / 6));
+    rotated_solid(ncv);
+    int opaque = 0;
+    int partial = 0;
+    for(int i = 0 ; i < ncv->pixy * ncv->pixx ; ++i){
+      const uint32_t px = ncv->data[i];
+      if(px){
+        CHECK(0x2080c0 == (htole(px) & 0xffffff));
+        if(ncpixel_a(px) == 0xff){
+          ++opaque;
+        }else{
+          ++partial;
+        }
+      }
+    }
+    CHECK(rows * cols * 80 / 100 < opaque);
+    CHECK(0 < partial);
+    ncvisual_destroy(ncv);
+  }
+}
@@ -0,0 +1,212 @@
+#include "main.h"
+#include "visual-details.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const resampleisa_e resampleisas[] = {
+  RESAMPLEISA_SCALAR, RESAMPLEISA_SSE41, RESAMPLEISA_AVX2,
+};
+
+static const char* resampleisanames[] = { "scalar", "sse4.1", "avx2", };
+
+static const resample_e resamplemodes[] = {
+  RESAMPLE_NEAREST, RESAMPLE_BOX, RESAMPLE_BILINEAR,
+};
+
+static const char* resamplemodenames[] = { "nearest", "box", "bilinear", };
+
+// fill 'px' with pseudorandom pixels, alpha included
+static void
+resample_pixels(std::vector<uint32_t>& px, unsigned seed){
+  for(size_t i = 0 ; i < px.size() ; ++i){
+    unsigned rnd = (i + seed) * 2654435761u;
+    rnd ^= rnd >> 15;
+    rnd *= 2246822519u;
+    rnd ^= rnd >> 13;
+    px[i] = rnd;
+  }
+}
+
+// every resampler kernel must exactly match the scalar kernels, for each mode,
+// whether magnifying or minifying, and for any row length.
+TEST_CASE("ResampleKernels") {
+  auto scalar = resampler_kernels(RESAMPLEISA_SCALAR);
+  REQUIRE(nullptr != scalar);
+  const struct {
+    int srcy, srcx, dsty, dstx;
+  } geoms[] = {
+    { 7, 9, 7, 9, },
+    { 5, 3, 17, 29, },
+    { 31, 37, 8, 11, },
+    { 16, 16, 9, 33, },
+    { 2, 61, 13, 1, },
+    { 1, 19, 6, 23, },
+    { 23, 1, 3, 5, },
+  };
+  for(size_t k = 1 ; k < sizeof(resampleisas) / sizeof(*resampleisas) ; ++k){
+    auto rs = resampler_kernels(resampleisas[k]);
+    if(!rs){
+      continue;
+    }
+    for(const auto& g : geoms){
+      // pad the source rows, ensuring the stride is respected
+      const int srcstride = (g.srcx + 3) * 4;
+      std::vector<uint32_t> src(g.srcy * (g.srcx + 3));
+      std::vector<uint32_t> want(g.dsty * g.dstx), got(g.dsty * g.dstx);
+      for(unsigned seed = 0 ; seed < 8 ; ++seed){
+        resample_pixels(src, seed);
+        for(auto mode : resamplemodes){
+          CHECK(0 == rgba_resample_via(scalar, src.data(), g.srcy, g.srcx, srcstride,
+                                       want.data(), g.dsty, g.dstx, g.dstx * 4, mode));
+          CHECK(0 == rgba_resample_via(rs, src.data(), g.srcy, g.srcx, srcstride,
+                                       got.data(), g.dsty, g.dstx, g.dstx * 4, mode));
+          CHECK(want == got);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Resample") {
+  const int rows = 12;
+  const int cols = 10;
+  std::vector<uint32_t> src(rows * cols);
+  resample_pixels(src, 0);
+
+  // resampling to the same geometry leaves the image untouched
+  SUBCASE("ResampleIdentity") {
+    std::vector<uint32_t> dst(rows * cols);
+    for(auto mode : resamplemodes){
+      CHECK(0 == rgba_resample(src.data(), rows, cols, cols * 4,
+                               dst.data(), rows, cols, cols * 4, mode));
+      CHECK(src == dst);
+    }
+  }
+
+  // a constant image remains constant at any scale
+  SUBCASE("ResampleConstant") {
+    std::vector<uint32_t> flat(rows * cols, 0x80ff4001);
+    const int geoms[][2] = { { 5, 3, }, { 29, 31, }, { 1, 40, }, { 12, 1, }, };
+    for(auto g : geoms){
+      std::vector<uint32_t> dst(g[0] * g[1]);
+      for(auto mode : resamplemodes){
+        CHECK(0 == rgba_resample(flat.data(), rows, cols, cols * 4,
+                                 dst.data(), g[0], g[1], g[1] * 4, mode));
+        for(auto p : dst){
+          CHECK(0x80ff4001 == p);
+        }
+      }
+    }
+  }
+
+  // nearest-neighbor magnification by an integer replicates each pixel
+  SUBCASE("ResampleNearestInteger") {
+    const int scale = 3;
+    std::vector<uint32_t> dst(rows * cols * scale * scale);
+    CHECK(0 == rgba_resample(src.data(), rows, cols, cols * 4, dst.data(),
+                             rows * scale, cols * scale, cols * scale * 4,
+                             RESAMPLE_NEAREST));
+    for(int y = 0 ; y < rows * scale ; ++y){
+      for(int x = 0 ; x < cols * scale ; ++x){
+        CHECK(src[(y / scale) * cols + x / scale] == dst[y * cols * scale + x]);
+      }
+    }
+  }
+
+  // halving with the box filter averages each 2x2 block, rounding
+  SUBCASE("ResampleBoxHalf") {
+    std::vector<uint32_t> dst(rows * cols / 4);
+    CHECK(0 == rgba_resample(src.data(), rows, cols, cols * 4, dst.data(),
+                             rows / 2, cols / 2, cols / 2 * 4, RESAMPLE_BOX));
+    for(int y = 0 ; y < rows / 2 ; ++y){
+      for(int x = 0 ; x < cols / 2 ; ++x){
+        const auto d = reinterpret_cast<const unsigned char*>(&dst[y * cols / 2 + x]);
+        for(int c = 0 ; c < 4 ; ++c){
+          unsigned sum = 0;
+          for(int yy = 0 ; yy < 2 ; ++yy){
+            for(int xx = 0 ; xx < 2 ; ++xx){
+              sum += reinterpret_cast<const unsigned char*>(
+                       &src[(y * 2 + yy) * cols + x * 2 + xx])[c];
+            }
+          }
+          CHECK((sum + 2) / 4 == d[c]);
+        }
+      }
+    }
+  }
+
+  SUBCASE("ResampleBadGeometry") {
+    std::vector<uint32_t> dst(rows * cols);
+    CHECK(0 > rgba_resample(src.data(), rows, cols, cols * 4,
+                            dst.data(), 0, cols, cols * 4, RESAMPLE_BOX));
+    CHECK(0 > rgba_resample(src.data(), rows, cols, cols * 2,
+                            dst.data(), rows, cols, cols * 4, RESAMPLE_BOX));
+  }
+
+  // a backend which can't scale falls back to the built-in resampler
+  SUBCASE("ResampleVisual") {
+    auto ncv = ncvisual_from_rgba(src.data(), rows, cols * 4, cols);
+    REQUIRE(nullptr != ncv);
+    CHECK(0 == ncvisual_resize(ncv, rows / 2, cols * 2));
+    CHECK(rows / 2 == ncv->pixy);
+    CHECK(cols * 2 == ncv->pixx);
+    CHECK(cols * 2 * 4 == ncv->rowstride);
+    CHECK(0 == ncvisual_inflate(ncv, 2));
+    CHECK(rows == ncv->pixy);
+    CHECK(cols * 4 == ncv->pixx);
+    ncvisual_destroy(ncv);
+  }
+}
+
+// compare the built-in resampler's modes and kernels on a 1080p frame, both
+// downscaling and upscaling, against the multimedia backend's own scaling
+// (swscale, when built with FFmpeg).
+TEST_CASE("ResampleBench" * doctest::skip(true)) {
+  const int srcy = 1080;
+  const int srcx = 1920;
+  const int iters = 20;
+  std::vector<uint32_t> src(srcy * srcx);
+  resample_pixels(src, 0);
+  const struct {
+    const char* name;
+    int dsty, dstx;
+  } scenarios[] = {
+    { "down", 270, 480, },
+    { "up", 1620, 2880, },
+  };
+  for(const auto& scenario : scenarios){
+    std::vector<uint32_t> dst(scenario.dsty * scenario.dstx);
+    for(size_t m = 0 ; m < sizeof(resamplemodes) / sizeof(*resamplemodes) ; ++m){
+      for(size_t k = 0 ; k < sizeof(resampleisas) / sizeof(*resampleisas) ; ++k){
+        auto rs = resampler_kernels(resampleisas[k]);
+        if(!rs){
+          continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0 ; i < iters ; ++i){
+          CHECK(0 == rgba_resample_via(rs, src.data(), srcy, srcx, srcx * 4, dst.data(),
+                                       scenario.dsty, scenario.dstx, scenario.dstx * 4,
+                                       resamplemodes[m]));
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+        printf("%5s %8s %8s: %10.1f us/frame\n", scenario.name, resamplemodenames[m],
+               resampleisanames[k], ns / 1000.0 / iters);
+      }
+    }
+#ifdef USE_FFMPEG
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < iters ; ++i){
+      auto ncv = ncvisual_from_rgba(src.data(), srcy, srcx * 4, srcx);
+      REQUIRE(nullptr != ncv);
+      CHECK(0 == ncvisual_resize(ncv, scenario.dsty, scenario.dstx));
+      ncvisual_destroy(ncv);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    printf("%5s %8s %8s: %10.1f us/frame (including setup)\n", scenario.name,
+           "lanczos", "swscale", ns / 1000.0 / iters);
+#endif
+  }
+}
@@ -0,0 +1,87 @@
+#include "main.h"
+#include <string>
+
+// expand 't' with 'p1' and 'p2', or return "(failed)"
+static auto
+expand(const esctemplate* t, int p1, int p2) -> std::string {
+  char buf[ESCTEMPLATE_MAXLEN];
+  int len = esctemplate_expand(t, buf, sizeof(buf), p1, p2);
+  if(len < 0){
+    return "(failed)";
+  }
+  return std::string(buf, len);
+}
+
+// whatever form they took, precompiled capabilities must expand exactly as
+// tiparm() does.
+TEST_CASE("EscapeTemplates") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  const tinfo* ti = &nc_->tcache;
+
+  SUBCASE("MotionsMatchTiparm") {
+    const esctemplate* tmpls[] = {
+      &ti->cuptmpl, &ti->hpatmpl, &ti->vpatmpl, &ti->cuftmpl,
+      &ti->cubtmpl, &ti->cudtmpl, &ti->cuutmpl,
+    };
+    const char* caps[] = {
+      ti->cup, ti->hpa, ti->vpa, ti->cuf, ti->cub, ti->cud, ti->cuu,
+    };
+    REQUIRE(sizeof(tmpls) / sizeof(*tmpls) == sizeof(caps) / sizeof(*caps));
+    for(size_t i = 0 ; i < sizeof(tmpls) / sizeof(*tmpls) ; ++i){
+      CHECK(tmpls[i]->cap == caps[i]);
+      if(caps[i] == nullptr){
+        continue;
+      }
+      for(int p1 = 0 ; p1 < 1100 ; p1 += 7){
+        for(int p2 = 0 ; p2 < 1100 ; p2 += 131){
+          CHECK(std::string(tiparm(caps[i], p1, p2)) == expand(tmpls[i], p1, p2));
+        }
+      }
+    }
+    // the ANSI form of cup, at least, ought compile
+    if(strcmp(ti->cup, "\x1b[%i%p1%d;%p2%dH") == 0){
+      CHECK(ti->cuptmpl.compiled);
+    }
+  }
+
+  SUBCASE("FallbackMatchesTiparm") {
+    esctemplate t = ti->cuptmpl;
+    t.compiled = false;
+    CHECK(std::string(tiparm(ti->cup, 12, 34)) == expand(&t, 12, 34));
+    t.cap = nullptr;
+    CHECK("(failed)" == expand(&t, 12, 34));
+  }
+
+  SUBCASE("TablesMatchTiparm") {
+    const struct {
+      const esctable* table;
+      const char* cap;
+    } tables[] = {
+      { &ti->setaftab, ti->setaf, },
+      { &ti->setabtab, ti->setab, },
+    };
+    for(const auto& t : tables){
+      CHECK((t.cap == nullptr) == (t.table->arena == nullptr));
+      if(t.table->arena == nullptr){
+        continue;
+      }
+      for(int i = 0 ; i < 256 ; ++i){
+        CHECK(std::string(tiparm(t.cap, i)) ==
+              std::string(t.table->arena + t.table->off[i], t.table->len[i]));
+      }
+    }
+    if(ti->sgrtab.arena){
+      for(unsigned i = 0 ; i < 256 ; ++i){
+        std::string sgr = tiparm(ti->sgr, i & NCSTYLE_STANDOUT, i & NCSTYLE_UNDERLINE,
+                                 i & NCSTYLE_REVERSE, i & NCSTYLE_BLINK, i & NCSTYLE_DIM,
+                                 i & NCSTYLE_BOLD, i & NCSTYLE_INVIS, i & NCSTYLE_PROTECT, 0);
+        CHECK(sgr == std::string(ti->sgrtab.arena + ti->sgrtab.off[i], ti->sgrtab.len[i]));
+      }
+    }
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}